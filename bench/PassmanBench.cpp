@@ -0,0 +1,275 @@
+// Scaling benchmark for PasswordManager and PasswordStorage.
+//
+// Builds synthetic vaults of increasing size in a temporary data directory,
+// times the common operations on each, and prints one JSON document so runs
+// can be compared across versions:
+//
+//   passman_bench [--sizes 1000,10000,100000,1000000] [--samples N] [--out FILE]
+
+#include "passman/PasswordManager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* kMasterPassword = "Bench!Master#1";
+const char* kOtherPassword = "Bench!Master#2";
+
+struct Options {
+    std::vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    size_t samples = 200; // For the cheap per-entry operations
+    std::string output;
+};
+
+/**
+ * @brief Latency samples of one operation, in milliseconds
+ */
+class Samples {
+public:
+    template <typename Operation>
+    void time(Operation&& operation) {
+        auto start = Clock::now();
+        operation();
+        values.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+
+    std::string json() const {
+        std::vector<double> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (double value : sorted) {
+            total += value;
+        }
+
+        std::ostringstream out;
+        out << "{\"samples\": " << sorted.size()
+            << ", \"p50_ms\": " << percentile(sorted, 0.50)
+            << ", \"p99_ms\": " << percentile(sorted, 0.99)
+            << ", \"max_ms\": " << (sorted.empty() ? 0.0 : sorted.back())
+            << ", \"mean_ms\": " << (sorted.empty() ? 0.0 : total / sorted.size()) << "}";
+        return out.str();
+    }
+
+private:
+    // Nearest-rank percentile
+    static double percentile(const std::vector<double>& sorted, double fraction) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        size_t rank = static_cast<size_t>(fraction * sorted.size() + 0.999999);
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+
+    std::vector<double> values;
+};
+
+/**
+ * @brief Returns the process's peak resident set size in kilobytes
+ */
+size_t peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss) / 1024; // Bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+unsigned long processId() {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+}
+
+std::string serviceName(size_t i) {
+    return "service-" + std::to_string(i);
+}
+
+std::vector<passman::PasswordRecord> syntheticRecords(size_t count) {
+    std::vector<passman::PasswordRecord> records(count);
+    for (size_t i = 0; i < count; ++i) {
+        records[i].service = serviceName(i);
+        records[i].username = "user" + std::to_string(i % 97) + "@example.com";
+        records[i].password = "pw-" + std::to_string(i * 2654435761u);
+        if (i % 4 == 0) {
+            records[i].serviceLink = "https://login" + std::to_string(i % 13) + ".example.com";
+        }
+    }
+    return records;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        try {
+            if (arg == "--sizes" && hasValue) {
+                options.sizes.clear();
+                std::stringstream list(argv[++i]);
+                std::string size;
+                while (std::getline(list, size, ',')) {
+                    options.sizes.push_back(std::stoull(size));
+                }
+            } else if (arg == "--samples" && hasValue) {
+                options.samples = std::max<size_t>(1, std::stoull(argv[++i]));
+            } else if (arg == "--out" && hasValue) {
+                options.output = argv[++i];
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return !options.sizes.empty();
+}
+
+/**
+ * @brief Benchmarks one vault size and returns its JSON object
+ */
+std::string benchmarkSize(size_t entries, const Options& options, const std::filesystem::path& root) {
+    std::filesystem::path dir = root / ("vault-" + std::to_string(entries));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string dataDir = dir.string() + "/";
+
+    std::map<std::string, Samples> results;
+    std::mt19937_64 random(entries);
+    auto pick = [&]() { return serviceName(random() % entries); };
+
+    {
+        passman::PasswordManager manager(dataDir);
+        manager.setUnlockTarget(std::chrono::milliseconds(1)); // Keep KDF cost out of the vault timings
+        results["initialize"].time([&]() { manager.initialize(kMasterPassword); });
+        manager.authenticate(kMasterPassword);
+
+        auto records = syntheticRecords(entries);
+        results["save_bulk"].time([&]() { manager.addEntries(records); });
+    }
+
+    // A fresh manager per sample, so every load reads and decrypts the whole vault
+    const size_t loadSamples = entries >= 100000 ? 3 : 10;
+    for (size_t i = 0; i < loadSamples; ++i) {
+        passman::PasswordManager manager(dataDir);
+        results["load"].time([&]() {
+            manager.load();
+            manager.authenticate(kMasterPassword);
+        });
+    }
+
+    passman::PasswordManager manager(dataDir);
+    manager.load();
+    manager.authenticate(kMasterPassword);
+
+    for (size_t i = 0; i < options.samples; ++i) {
+        std::string service = "added-" + std::to_string(i);
+        results["add"].time([&]() { manager.addEntry(service, "bench", "added-password"); });
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < options.samples * 10; ++i) {
+        std::string service = pick();
+        results["get"].time([&]() { found += manager.getPassword(service).size(); });
+    }
+
+    for (size_t i = 0; i < options.samples; ++i) {
+        std::string service = "added-" + std::to_string(i);
+        results["remove"].time([&]() { manager.removeEntry(service); });
+    }
+
+    const size_t listSamples = entries >= 100000 ? 10 : 50;
+    for (size_t i = 0; i < listSamples; ++i) {
+        results["list"].time([&]() { found += manager.listServices().size(); });
+    }
+
+    const size_t rekeySamples = entries >= 100000 ? 1 : 3;
+    for (size_t i = 0; i < rekeySamples; ++i) {
+        bool forward = i % 2 == 0;
+        results["change_master_password"].time([&]() {
+            manager.changeMasterPassword(forward ? kMasterPassword : kOtherPassword,
+                                         forward ? kOtherPassword : kMasterPassword);
+        });
+    }
+
+    std::ostringstream out;
+    out << "    {\"entries\": " << entries << ", \"peak_rss_kb\": " << peakRssKb()
+        << ", \"checksum\": " << found << ", \"operations\": {";
+    bool first = true;
+    for (const auto& result : results) {
+        out << (first ? "\n" : ",\n") << "      \"" << result.first << "\": " << result.second.json();
+        first = false;
+    }
+    out << "\n    }}";
+
+    std::filesystem::remove_all(dir);
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: passman_bench [--sizes 1000,10000,...] [--samples N] [--out FILE]\n";
+        return 1;
+    }
+
+    std::filesystem::path root = std::filesystem::temp_directory_path() /
+                                 ("passman_bench-" + std::to_string(processId()));
+    std::string json = "{\n  \"benchmark\": \"passman\",\n  \"results\": [\n";
+    try {
+        for (size_t i = 0; i < options.sizes.size(); ++i) {
+            std::cerr << "Benchmarking " << options.sizes[i] << " entries...\n";
+            json += benchmarkSize(options.sizes[i], options, root);
+            json += i + 1 < options.sizes.size() ? ",\n" : "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        std::filesystem::remove_all(root);
+        return 1;
+    }
+    json += "  ]\n}\n";
+    std::filesystem::remove_all(root);
+
+    if (options.output.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream file(options.output);
+        file << json;
+        if (!file) {
+            std::cerr << "Cannot write " << options.output << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Microbenchmark for CommandParser's tokenizer.
+//
+// Tokenizes a fixed mix of command lines, as a script would feed them, with
+// the single-pass CommandLine tokenizer and with the stringstream version it
+// replaced, and prints one JSON document with nanoseconds per line:
+//
+//   tokenizer_bench [--lines N] [--out FILE]
+
+#include "terminal/CommandParser.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t lines = 1000000;
+    std::string output;
+};
+
+// Typical script lines: short commands, long argument lists, quotes and escapes
+const std::vector<std::string> kLines = {
+    "ls",
+    "cd src/terminal",
+    "cat build.log | grep ERROR | head 20",
+    "copy reports/2024/summary.txt backup/reports/2024/summary.txt",
+    "encrypt \"quarterly report.xlsx\" report.enc \"correct horse battery\"",
+    "find 'R&D notes' &",
+    "grep \"say \\\"hi\\\"\" my\\ file.txt",
+    "passman add example.com alice Tr0ub4dor&3 --tags work,mail,shared,important",
+};
+
+/**
+ * @brief The tokenizer before CommandLine, kept as the baseline
+ */
+std::vector<std::string> streamTokenize(const std::string& input) {
+    std::vector<std::string> tokens;
+    std::string token;
+    bool inQuotes = false;
+    std::stringstream tokenStream;
+
+    for (char c : input) {
+        if (c == '"') {
+            inQuotes = !inQuotes;
+        } else if (c == ' ' && !inQuotes) {
+            token = tokenStream.str();
+            if (!token.empty()) {
+                tokens.push_back(token);
+                tokenStream.str("");
+                tokenStream.clear();
+            }
+        } else {
+            tokenStream << c;
+        }
+    }
+
+    token = tokenStream.str();
+    if (!token.empty()) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+/**
+ * @brief Runs tokenize over options.lines lines and returns nanoseconds per line
+ */
+template <typename Tokenize>
+double nanosPerLine(const Options& options, size_t& checksum, Tokenize&& tokenize) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < options.lines; ++i) {
+        checksum += tokenize(kLines[i % kLines.size()]);
+    }
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    return elapsed.count() / static_cast<double>(std::max<size_t>(1, options.lines));
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        try {
+            if (arg == "--lines" && hasValue) {
+                options.lines = std::max<size_t>(1, std::stoull(argv[++i]));
+            } else if (arg == "--out" && hasValue) {
+                options.output = argv[++i];
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: tokenizer_bench [--lines N] [--out FILE]\n";
+        return 1;
+    }
+
+    CommandParser parser;
+    CommandLine line; // Reused, as a script loop would
+    size_t checksum = 0;
+
+    double stream = nanosPerLine(options, checksum, [](const std::string& input) {
+        return streamTokenize(input).size();
+    });
+    double views = nanosPerLine(options, checksum, [&](const std::string& input) {
+        parser.tokenize(input, line);
+        return line.size();
+    });
+    // What Terminal::processCommand pays: views, then strings for the handler's arguments
+    double handlerArgs = nanosPerLine(options, checksum, [&](const std::string& input) {
+        parser.tokenize(input, line);
+        return line.strings(1).size();
+    });
+
+    std::ostringstream json;
+    json << "{\n  \"benchmark\": \"tokenizer\",\n  \"lines\": " << options.lines
+         << ",\n  \"checksum\": " << checksum
+         << ",\n  \"ns_per_line\": {\"stringstream\": " << stream
+         << ", \"command_line\": " << views
+         << ", \"command_line_with_args\": " << handlerArgs << "}\n}\n";
+
+    if (options.output.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(options.output);
+        file << json.str();
+        if (!file) {
+            std::cerr << "Cannot write " << options.output << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 
@@ -12,6 +13,6 @@ public:
     std::vector<uint8_t> xorEncrypt(const std::vector<uint8_t>& data, const std::string& key) const;
     std::vector<uint8_t> caesarEncrypt(const std::vector<uint8_t>& data, int shift) const;
     std::vector<uint8_t> caesarDecrypt(const std::vector<uint8_t>& data, int shift) const;
-    int generateShift(const std::string& password) const;
-    std::string generateFileKey(const std::string& password, size_t blockSize) const;
+    int generateShift(std::string_view password) const;
+    std::string generateFileKey(std::string_view password, size_t blockSize) const;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <cstdint>
@@ -16,6 +17,10 @@ public:
     bool decryptFile(const std::string& inputFile, const std::string& password, const std::string& outputFile = "") const;
     bool isFileEncrypted(const std::string& filename) const;
 
+    // In-memory variants used when the plaintext must never touch the disk
+    std::vector<uint8_t> encryptData(const std::vector<uint8_t>& data, std::string_view password) const;
+    bool decryptData(const std::vector<uint8_t>& data, std::string_view password, std::vector<uint8_t>& output) const;
+
 private:
     bool readFile(const std::string& filename, std::vector<uint8_t>& data) const;
     bool writeFile(const std::string& filename, const std::vector<uint8_t>& data) const;
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "encryption/FileEncryption.h"
+#include "passman/PasswordKdf.h"
+#include "utils/SecureMemory.h"
+
+namespace passman {
+
+/**
+ * @struct AttachmentRef
+ * @brief What a vault entry records about one attachment
+ */
+struct AttachmentRef {
+    std::string name;
+    uint64_t size = 0;
+    std::string recipe; // Id of the chunk listing the attachment's chunks
+};
+
+/**
+ * @struct ChunkWriteStats
+ * @brief How much of a written blob was new to the store
+ */
+struct ChunkWriteStats {
+    size_t chunks = 0;
+    size_t newChunks = 0;
+    uint64_t storedBytes = 0; // On disk, after compression, for the new chunks
+};
+
+/**
+ * @class ChunkStore
+ * @brief Content-addressed store for attachment data under data/chunks/
+ *
+ * Blobs are split with content-defined chunking (a gear rolling hash), so
+ * an edit only changes the chunks around it. Each chunk is compressed with
+ * Utils::Lz77, encrypted, and stored once under the HMAC of its plaintext.
+ * The HMAC and encryption use a random content key that is itself stored
+ * encrypted under the vault key. Changing the master password therefore
+ * re-wraps that one key instead of rewriting every chunk.
+ */
+class ChunkStore {
+public:
+    static constexpr size_t kMinChunk = 16 * 1024;
+    static constexpr size_t kMaxChunk = 256 * 1024;
+    static constexpr uint64_t kBoundaryMask = (1u << 16) - 1; // About 64 KB chunks on average
+
+    explicit ChunkStore(const std::string& dataDir = "data/");
+    ~ChunkStore();
+
+    ChunkStore(const ChunkStore&) = delete;
+    ChunkStore& operator=(const ChunkStore&) = delete;
+
+    /**
+     * @brief Checks an attachment name: 1-128 letters, digits, '.', '_' or '-'
+     */
+    static bool isValidName(std::string_view name);
+
+    /**
+     * @brief Formats refs as the "name:size:recipe,..." stored in PasswordEntry::attachments
+     */
+    static std::string formatRefs(const std::vector<AttachmentRef>& refs);
+    static bool parseRefs(std::string_view text, std::vector<AttachmentRef>& refs);
+
+    /**
+     * @brief Unwraps the content key, creating one on first use
+     * @param vaultKey The key the vault is encrypted with
+     * @return False if the stored key could not be read or a new one written
+     *
+     * Call under the vault's exclusive lock, so two processes cannot each
+     * create a key and the vault key cannot change underneath. Also removes
+     * temporaries left by key writes that crashed.
+     */
+    bool open(std::string_view vaultKey);
+    bool isOpen() const { return !contentKey.empty(); }
+
+    /**
+     * @brief Forgets the content key
+     */
+    void close();
+
+    /**
+     * @brief Stages the content key re-wrapped under a new vault key
+     * @param staged Receives the key file, written as <path>.tmp for PasswordStorage::commit to
+     *        publish; left alone if no key exists yet
+     * @return False if the stored key could not be read or the staged copy written
+     *
+     * The key file itself is only replaced by the commit that re-keys the
+     * vault, so it can never end up wrapped under a key no master record matches.
+     */
+    bool stageRekey(std::string_view oldVaultKey, std::string_view newVaultKey,
+                    std::vector<std::string>& staged) const;
+
+    /**
+     * @brief Stores a stream as chunks, reading it with bounded memory
+     * @param input The data to store
+     * @param recipe Receives the id to read the blob back with
+     * @param size Receives the number of bytes read from input
+     * @param stats Receives chunk counts, if not null
+     * @return False if the store is closed or a chunk could not be written
+     */
+    bool write(std::istream& input, std::string& recipe, uint64_t& size, ChunkWriteStats* stats = nullptr) const;
+
+    /**
+     * @brief Streams a blob back, verifying every chunk against its id
+     * @return False if a chunk is missing, corrupt or fails verification
+     */
+    bool read(const std::string& recipe, std::ostream& output) const;
+
+private:
+    /**
+     * @brief Returns where the first chunk of data ends
+     */
+    static size_t cutPoint(const uint8_t* data, size_t size);
+
+    std::string chunkId(const uint8_t* data, size_t size) const;
+    std::string chunkPath(const std::string& id) const;
+
+    /**
+     * @brief Compresses, encrypts and writes a chunk unless one with its id exists
+     * @return The bytes written, 0 if the chunk was already stored, or -1 on failure
+     */
+    long long storeChunk(const std::string& id, const uint8_t* data, size_t size) const;
+    bool loadChunk(const std::string& id, std::vector<uint8_t>& data) const;
+
+    const std::string chunkDir;
+    const std::string keyFile;
+    Utils::SecureString contentKey; // Hex, also the chunk encryption password
+    std::unique_ptr<HmacSha256> mac;
+    FileEncryption encryptor;
+};
+
+} // namespace passman
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace passman {
+
+/**
+ * @class DomainTrie
+ * @brief Maps host names to values through a trie of reversed domain labels
+ *
+ * "login.eu.example.com" is stored along com -> example -> eu -> login, so
+ * a lookup walks one edge per label. A stored "*.example.com" matches every
+ * host below example.com but not example.com itself.
+ */
+class DomainTrie {
+public:
+    enum class Match { None, Exact, Domain, Wildcard };
+
+    /**
+     * @brief Extracts the lowercase host from a URL or bare host name
+     * @param url Input such as "https://user@Login.Example.com:8443/path" or "example.com"
+     * @param host Receives the host, e.g. "login.example.com"
+     * @param allowWildcard Accept a leading "*." label, as stored links may use
+     * @return False if no well-formed host could be found
+     */
+    static bool parseHost(std::string_view url, std::string& host, bool allowWildcard = false);
+
+    /**
+     * @brief Returns how many trailing labels form the registrable domain
+     *
+     * Two, or three under a known multi-label public suffix such as co.uk.
+     * This is a small built-in subset of the Public Suffix List.
+     */
+    static size_t registrableLabels(const std::vector<std::string_view>& reversedLabels);
+
+    /**
+     * @brief Stores value under a host from parseHost()
+     * @return A handle to pass to erase()
+     */
+    uint32_t insert(std::string_view host, uint32_t value);
+    void erase(uint32_t handle, uint32_t value);
+    void clear();
+
+    /**
+     * @brief Finds the values stored for the best match of host
+     * @param host A host from parseHost(), without wildcards
+     * @param values Receives the values of the best tier only
+     * @return Exact for the host itself, then Domain for its registrable
+     *         domain, then Wildcard for the most specific covering pattern
+     */
+    Match match(std::string_view host, std::vector<uint32_t>& values) const;
+
+private:
+    struct Node {
+        std::vector<uint32_t> exact;
+        std::vector<uint32_t> wildcard;
+    };
+
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    uint32_t child(uint32_t parent, std::string_view label) const;
+    static std::string edgeKey(uint32_t parent, std::string_view label);
+
+    std::vector<Node> nodes; // nodes[0] is the root
+    std::unordered_map<std::string, uint32_t> edges; // Parent id and label to child id
+};
+
+} // namespace passman
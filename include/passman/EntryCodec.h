@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "passman/EntryStore.h"
+
+namespace passman {
+
+/**
+ * @class EntryCodec
+ * @brief The "service|username|password|link|salt[|tags]" line format of vault files
+ */
+class EntryCodec {
+public:
+    /**
+     * @brief Returns false if field holds a '|' or line break, which would split its line
+     */
+    static bool isStorable(std::string_view field);
+
+    /**
+     * @brief Returns the number of bytes appendLine() writes for entry
+     */
+    static size_t lineSize(const EntryView& entry);
+
+    /**
+     * @brief Appends entry as one newline-terminated line
+     *
+     * The tags field is only written when there are tags, so untagged
+     * entries keep the original five-field line.
+     */
+    static void appendLine(std::string& out, const EntryView& entry);
+
+    /**
+     * @brief Splits one line, without its newline, into views
+     * @return False if the line has fewer than five fields or no salt
+     */
+    static bool parseLine(std::string_view line, EntryView& entry);
+
+    /**
+     * @brief Calls sink with each well-formed line of data; malformed lines are skipped
+     */
+    template <typename Sink>
+    static void parseLines(std::string_view data, Sink&& sink) {
+        size_t pos = 0;
+        while (pos < data.size()) {
+            size_t end = data.find('\n', pos);
+            if (end == std::string_view::npos) {
+                end = data.size();
+            }
+            EntryView entry;
+            if (parseLine(data.substr(pos, end - pos), entry)) {
+                sink(entry);
+            }
+            pos = end + 1;
+        }
+    }
+};
+
+} // namespace passman
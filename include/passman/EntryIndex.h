@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "passman/DomainTrie.h"
+#include "passman/EntryTable.h"
+
+namespace passman {
+
+/**
+ * @class EntryIndex
+ * @brief Secondary indexes on username, tags and service link host
+ *
+ * Every entry gets a small integer id, and each term ("user=alice",
+ * "tag=prod") maps to a sorted posting list of ids. A query intersects the
+ * lists of its terms, starting from the shortest, so its cost depends on
+ * the size of the answer rather than the vault. Terms are matched
+ * ignoring case. The host of each entry's service link is kept in a
+ * DomainTrie for match().
+ */
+class EntryIndex {
+public:
+    /**
+     * @brief Turns user-supplied tags into the stored form
+     * @param tags Tags in any case; each may itself be comma-separated
+     * @param joined Receives the lowercase, sorted, de-duplicated tags joined by commas
+     * @return False if a tag is empty or uses characters other than letters, digits and "-_.:/"
+     */
+    static bool normalizeTags(const std::vector<std::string>& tags, std::string& joined);
+
+    /**
+     * @brief Parses a query such as "user=alice tag=prod"
+     * @param expression Whitespace-separated field=value terms, all of which must match
+     * @param terms Receives the normalized terms
+     * @param error Receives a message when the expression is rejected
+     * @return True if every term names a known field and a value
+     */
+    static bool parseQuery(const std::string& expression, std::vector<std::string>& terms, std::string& error);
+
+    bool built() const { return isBuilt; }
+
+    /**
+     * @brief Indexes every entry of table, replacing the current contents
+     */
+    void build(const EntryTable& table);
+
+    /**
+     * @brief Drops all postings; the index is unbuilt until the next build()
+     */
+    void clear();
+
+    /**
+     * @brief Indexes an entry, replacing the terms of one with the same service name
+     */
+    void add(const EntryView& entry);
+
+    void remove(std::string_view service);
+
+    /**
+     * @brief Returns the services matching all terms from parseQuery(), in no particular order
+     */
+    std::vector<std::string> query(const std::vector<std::string>& terms) const;
+
+    /**
+     * @brief Returns the services whose link best matches host; see DomainTrie::match()
+     */
+    DomainTrie::Match match(std::string_view host, std::vector<std::string>& services) const;
+
+private:
+    using Postings = std::unordered_map<std::string, std::vector<uint32_t>>;
+
+    struct Row {
+        std::string service;
+        std::vector<Postings::value_type*> terms; // Map nodes stay put across rehashes
+        uint32_t domain = kNoDomain;              // DomainTrie handle
+    };
+
+    static constexpr uint32_t kNoDomain = UINT32_MAX;
+
+    void addTerm(uint32_t id, std::string term);
+    void removeTerms(uint32_t id);
+
+    std::vector<Row> rows;                        // Indexed by id
+    std::unordered_map<std::string, uint32_t> ids; // Lowercased service name to id
+    std::vector<uint32_t> freeIds;
+    Postings postings;
+    DomainTrie domains;
+    bool isBuilt = false;
+};
+
+} // namespace passman
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "passman/PasswordTypes.h"
+
+namespace passman {
+
+/**
+ * @struct EntryView
+ * @brief Non-owning view of one stored entry
+ *
+ * Views into an EntryStore stay valid until that store is next modified.
+ */
+struct EntryView {
+    std::string_view service;
+    std::string_view username;
+    std::string_view encryptedPassword;
+    std::string_view serviceLink;
+    std::string_view salt;
+    std::string_view tags;
+    std::string_view attachments;
+
+    EntryView() = default;
+    EntryView(const PasswordEntry& entry)
+        : service(entry.service), username(entry.username), encryptedPassword(entry.encryptedPassword),
+          serviceLink(entry.serviceLink), salt(entry.salt), tags(entry.tags), attachments(entry.attachments) {}
+
+    PasswordEntry toEntry() const {
+        return PasswordEntry{std::string(service), std::string(username), std::string(encryptedPassword),
+                             std::string(serviceLink), std::string(salt), std::string(tags),
+                             std::string(attachments)};
+    }
+};
+
+/**
+ * @class EntryStore
+ * @brief Compact structure-of-arrays table of vault entries
+ *
+ * All string bytes live in one bump arena addressed by 32-bit offsets.
+ * Usernames, service links and tag sets are interned, since most vaults
+ * reuse a handful of them. Lookups go through a flat open-addressing index over
+ * the rows, hashed and compared case-insensitively on the service name, so
+ * no normalized copy of the key is stored.
+ */
+class EntryStore {
+public:
+    EntryStore();
+
+    /**
+     * @brief Hashes a service name as normalizeServiceName() would see it
+     *
+     * FNV-1a over the ASCII-lowercased bytes; also picks the entry's shard.
+     */
+    static uint64_t hashKey(std::string_view service);
+
+    size_t size() const { return hashes.size(); }
+    bool empty() const { return hashes.empty(); }
+    void reserve(size_t count);
+    void clear();
+    void swap(EntryStore& other);
+
+    /**
+     * @brief Looks up an entry by service name, in any letter case
+     */
+    bool find(std::string_view service, EntryView& entry) const;
+
+    /**
+     * @brief Adds an entry, replacing one with the same service name
+     */
+    void insert(const EntryView& entry);
+
+    bool erase(std::string_view service);
+
+    /**
+     * @brief Returns the bytes held by the arena, columns and indexes
+     */
+    size_t memoryUsage() const;
+
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (size_t row = 0; row < hashes.size(); ++row) {
+            visit(view(row));
+        }
+    }
+
+private:
+    struct StringRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    EntryView view(size_t row) const;
+    std::string_view text(StringRef ref) const {
+        return std::string_view(arena.data() + ref.offset, ref.length);
+    }
+    StringRef store(std::string_view text);
+    uint32_t intern(std::string_view text);
+
+    /**
+     * @brief Returns the index slot holding row, or the slot where service would go
+     */
+    size_t findSlot(std::string_view service, uint32_t hash) const;
+    void growIndex();
+    void growInternIndex();
+    void removeSlot(size_t slot);
+    void compact();
+
+    std::vector<char> arena;
+    size_t deadBytes; // Arena bytes no longer referenced by any row
+
+    // Columns, one element per row
+    std::vector<StringRef> services;
+    std::vector<StringRef> secrets;
+    std::vector<StringRef> salts;
+    std::vector<StringRef> attachments;
+    std::vector<uint32_t> usernames; // Intern ids
+    std::vector<uint32_t> links;     // Intern ids
+    std::vector<uint32_t> tags;      // Intern ids
+    std::vector<uint32_t> hashes;    // Low bits of hashKey(service)
+
+    // Interned strings; id 0 is the empty string
+    std::vector<StringRef> interned;
+    std::vector<uint32_t> internHashes;
+    std::vector<uint32_t> internSlots; // id + 1, 0 when empty
+
+    std::vector<uint32_t> slots; // row + 1, 0 when empty
+};
+
+} // namespace passman
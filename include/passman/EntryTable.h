@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "passman/EntryStore.h"
+
+namespace passman {
+
+/**
+ * @class EntryTable
+ * @brief Vault entries partitioned into the shards they are stored in
+ *
+ * Entries are found by service name in any letter case. Each lives in the
+ * shard picked by shardOf(), which matches the shard file it is persisted
+ * to, and every mutation marks its shard dirty so a commit rewrites only
+ * those shards.
+ */
+class EntryTable {
+public:
+    using Shard = EntryStore;
+
+    static constexpr size_t kMinShards = 8;
+    static constexpr size_t kMaxShards = 4096;
+    static constexpr size_t kTargetShardEntries = 8192;
+
+    explicit EntryTable(size_t shardCount = kMinShards);
+
+    /**
+     * @brief Maps a service name to its shard
+     *
+     * Uses EntryStore::hashKey (FNV-1a) rather than std::hash so the
+     * assignment is identical across processes, platforms and standard
+     * libraries.
+     */
+    static size_t shardOf(std::string_view service, size_t shardCount);
+
+    /**
+     * @brief Returns the shard count that keeps shards near kTargetShardEntries
+     */
+    static size_t recommendedShardCount(size_t entryCount);
+
+    size_t shardCount() const { return shards.size(); }
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+
+    size_t memoryUsage() const;
+
+    bool find(std::string_view service, EntryView& entry) const;
+
+    /**
+     * @brief Adds an entry, replacing one with the same service name
+     */
+    void insert(const EntryView& entry);
+    bool erase(std::string_view service);
+
+    Shard& shard(size_t index) { return shards[index]; }
+    const Shard& shard(size_t index) const { return shards[index]; }
+
+    bool isDirty(size_t index) const { return dirty[index] != 0; }
+    bool hasDirtyShards() const;
+    void markAllDirty();
+    void clearDirty();
+
+    /**
+     * @brief Removes every entry and resizes to shardCount clean shards
+     */
+    void clear(size_t shardCount = kMinShards);
+
+    /**
+     * @brief Redistributes the entries over shardCount shards, all dirty
+     */
+    void reshard(size_t shardCount);
+
+    void swap(EntryTable& other);
+
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (const auto& shard : shards) {
+            shard.forEach(visit);
+        }
+    }
+
+private:
+    std::vector<Shard> shards;
+    std::vector<uint8_t> dirty;
+};
+
+} // namespace passman
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace passman {
+
+/**
+ * @class HexCodec
+ * @brief Table-driven lowercase hex encoding and decoding
+ *
+ * Uses SSE2 (or AVX2 when the build enables it) for the bulk of each buffer
+ * and lookup tables for the tail, so no per-byte formatting or parsing calls
+ * are involved.
+ */
+class HexCodec {
+public:
+    /**
+     * @brief Encodes length bytes as 2 * length lowercase hex characters
+     * @param input The bytes to encode
+     * @param length Number of bytes to encode
+     * @param output Destination buffer of at least 2 * length characters
+     */
+    static void encode(const uint8_t* input, size_t length, char* output);
+
+    /**
+     * @brief Decodes length hex characters into length / 2 bytes
+     * @param input The hex characters to decode (either case)
+     * @param length Number of characters, must be even
+     * @param output Destination buffer of at least length / 2 bytes
+     * @return False if length is odd or a non-hex character was found
+     */
+    static bool decode(const char* input, size_t length, uint8_t* output);
+
+    /**
+     * @brief Convenience wrapper returning the hex encoding of a string
+     */
+    static std::string encode(const std::string& input);
+};
+
+} // namespace passman
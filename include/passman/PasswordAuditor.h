@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "passman/PasswordManager.h"
+
+namespace passman {
+
+/**
+ * @struct AuditFinding
+ * @brief A weak entry reported while the audit is still running
+ */
+struct AuditFinding {
+    std::string service;
+    std::string username;
+    bool meetsRules = false; // Utils::validatePasswordStrength
+    double entropyBits = 0.0;
+};
+
+/**
+ * @struct AuditReport
+ * @brief Totals and reuse groups, available once the audit has finished
+ */
+struct AuditReport {
+    size_t entries = 0;
+    size_t weak = 0;
+    std::vector<std::vector<std::string>> reused; // Services sharing one password, per group
+    double seconds = 0.0;
+};
+
+/**
+ * @class PasswordAuditor
+ * @brief Finds reused and weak passwords across the whole vault
+ *
+ * Entries are decrypted in parallel batches and each batch is scored on the
+ * shared pool. Reuse is found by bucketing a keyed hash of every password,
+ * with a key drawn fresh for each run, so plaintexts are never compared
+ * pairwise or kept past their batch.
+ */
+class PasswordAuditor {
+public:
+    using FindingCallback = std::function<void(const AuditFinding&)>;
+
+    /**
+     * @brief Constructor
+     * @param manager An unlocked password manager
+     * @param minEntropyBits Passwords below this estimate are reported as weak
+     */
+    explicit PasswordAuditor(const PasswordManager& manager, double minEntropyBits = 50.0);
+
+    /**
+     * @brief Audits every entry
+     * @param onWeak Called on the calling thread for each weak entry as it is found
+     * @param report Receives the totals and reuse groups
+     * @return False if the vault is locked or could not be decrypted
+     */
+    bool run(const FindingCallback& onWeak, AuditReport& report) const;
+
+    /**
+     * @brief Estimates the entropy of a password in bits
+     *
+     * See Utils::PasswordStrength::estimateEntropy; dictionary words, l33t
+     * spellings and keyboard walks score far lower than their length suggests.
+     */
+    static double estimateEntropy(std::string_view password);
+
+private:
+    const PasswordManager& manager;
+    double minEntropyBits;
+};
+
+} // namespace passman
@@ -1,11 +1,34 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <random>
+#include "passman/PasswordPolicy.h"
+#include "utils/SecureMemory.h"
 
 namespace passman {
 
+/**
+ * @struct CryptoBatch
+ * @brief Results of a batch crypto call packed into one contiguous buffer
+ *
+ * Entry i occupies data[offsets[i], offsets[i + 1]). Reusing a batch across
+ * calls keeps its capacity, so steady-state batches allocate nothing.
+ */
+struct CryptoBatch {
+    std::string data;
+    std::vector<size_t> offsets;
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::string_view operator[](size_t i) const {
+        return std::string_view(data.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    void clear() {
+        data.clear();
+        offsets.clear();
+    }
+};
+
 /**
  * @class PasswordCrypto
  * @brief Handles all cryptographic operations for password management
@@ -24,7 +47,7 @@ public:
      * @param salt The salt to use in hashing
      * @return The hashed string
      */
-    std::string customHash(const std::string& input, const std::string& salt) const;
+    std::string customHash(std::string_view input, const std::string& salt) const;
     
     /**
      * @brief Generates a random salt of specified length
@@ -32,6 +55,14 @@ public:
      * @return The generated salt string
      */
     std::string generateSalt(size_t length = 16) const;
+
+    /**
+     * @brief Generates count salts in one pass over the thread's generator
+     * @param count Number of salts to generate
+     * @param salts Receives the generated salts
+     * @param length The length of each salt
+     */
+    void generateSalts(size_t count, std::vector<std::string>& salts, size_t length = 16) const;
     
     /**
      * @brief Encrypts a password using the provided key
@@ -39,15 +70,34 @@ public:
      * @param key The encryption key (typically master password hash)
      * @return The encrypted password
      */
-    std::string encryptPassword(const std::string& password, const std::string& key) const;
+    std::string encryptPassword(std::string_view password, std::string_view key) const;
     
     /**
      * @brief Decrypts an encrypted password using the provided key
      * @param encryptedPassword The encrypted password to decrypt
      * @param key The decryption key (typically master password hash)
-     * @return The decrypted password
+     * @return The decrypted password in locked memory, or an empty string if the input is not valid hex
      */
-    std::string decryptPassword(const std::string& encryptedPassword, const std::string& key) const;
+    Utils::SecureString decryptPassword(std::string_view encryptedPassword, std::string_view key) const;
+
+    /**
+     * @brief Encrypts a batch of passwords into a single contiguous buffer
+     * @param passwords The passwords to encrypt
+     * @param key The encryption key (typically master password hash)
+     * @param output Receives one encrypted password per input, in order
+     */
+    void encryptMany(const std::vector<std::string_view>& passwords, std::string_view key,
+                     CryptoBatch& output) const;
+
+    /**
+     * @brief Decrypts a batch of encrypted passwords into a single contiguous buffer
+     * @param encryptedPasswords The encrypted passwords to decrypt
+     * @param key The decryption key (typically master password hash)
+     * @param output Receives one decrypted password per input, in order
+     * @return False if any input is not valid hex, in which case output is unspecified
+     */
+    bool decryptMany(const std::vector<std::string_view>& encryptedPasswords, std::string_view key,
+                     CryptoBatch& output) const;
     
     /**
      * @brief Generates a random password of specified length
@@ -55,6 +105,19 @@ public:
      * @return The generated password
      */
     std::string generatePassword(size_t length = 16) const;
+
+    /**
+     * @brief Generates many passwords in parallel
+     * @param count Number of passwords to generate
+     * @param length Length of each password, at least policy.minLength
+     * @param policy Character set and composition rules
+     * @param lines Receives count newline-terminated passwords
+     *
+     * Each worker draws from its own thread-local generator, so throughput
+     * scales with the shared pool.
+     */
+    void generatePasswords(size_t count, size_t length, const PasswordPolicy& policy,
+                           std::string& lines) const;
 };
 
 } // namespace passman
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "encryption/FileEncryption.h"
+#include "passman/EntryStore.h"
+#include "passman/PasswordCrypto.h"
+#include "passman/PasswordKdf.h"
+#include "passman/PasswordTypes.h"
+
+namespace passman {
+
+/**
+ * @struct HistoryChange
+ * @brief The state one commit left an entry in
+ */
+struct HistoryChange {
+    EntryView entry; // Only service is meaningful when removed
+    bool removed = false;
+};
+
+/**
+ * @struct HistoryVersion
+ * @brief One recorded version of an entry
+ */
+struct HistoryVersion {
+    uint64_t generation = 0; // The commit that wrote this version
+    int64_t timestamp = 0;   // Unix time of that commit
+    bool removed = false;
+    PasswordEntry entry;
+};
+
+/**
+ * @class PasswordHistory
+ * @brief Append-only, encrypted record of every committed entry version
+ *
+ * Each commit appends one frame per touched bucket holding only the entries
+ * it changed, as complete entry states, so any version can be read back on
+ * its own without replaying older frames. Entries are spread over
+ * kBuckets files by service name. Every frame starts with a keyed hash of
+ * each service it holds, so a lookup decrypts only the frames that touch
+ * that service.
+ */
+class PasswordHistory {
+public:
+    static constexpr size_t kBuckets = 64;
+
+    explicit PasswordHistory(const std::string& dataDir = "data/");
+
+    /**
+     * @brief Appends the changes made by one commit
+     * @param generation The generation the commit was published as
+     * @param changes At most one change per service
+     * @param vaultKey The key the vault is encrypted with
+     * @return True if every touched bucket was appended to
+     */
+    bool record(uint64_t generation, const std::vector<HistoryChange>& changes, std::string_view vaultKey) const;
+
+    /**
+     * @brief Reads the recorded versions of one service, newest first
+     * @param service The service name, in any letter case
+     * @param vaultKey The key the vault is encrypted with
+     * @param versions Receives the versions
+     * @return False if the bucket file exists but could not be read
+     */
+    bool versions(const std::string& service, std::string_view vaultKey,
+                  std::vector<HistoryVersion>& versions) const;
+
+    /**
+     * @brief Stages the whole history re-encrypted under a new vault key
+     * @param staged Receives each bucket file, written as <path>.tmp for PasswordStorage::commit to publish
+     * @return False if a bucket could not be read or staged; nothing is left staged then
+     *
+     * Frames that do not open under oldKey are dropped. The buckets are only
+     * replaced by the commit that re-keys the vault.
+     */
+    bool stageRekey(std::string_view oldKey, std::string_view newKey, const PasswordCrypto& crypto,
+                    std::vector<std::string>& staged) const;
+
+private:
+    /**
+     * @struct Frame
+     * @brief One commit's changes within a bucket, as stored on disk
+     */
+    struct Frame {
+        std::vector<uint64_t> tags; // serviceTag() of each service in the frame
+        std::vector<uint8_t> payload; // Encrypted "generation time" line followed by +entry / -service lines
+    };
+
+    static size_t bucketOf(std::string_view service);
+    static uint64_t serviceTag(const HmacSha256& mac, std::string_view service);
+    static HmacSha256 tagKey(std::string_view vaultKey);
+
+    std::string bucketPath(size_t bucket) const;
+
+    /**
+     * @brief Reads the complete frames of a bucket; a torn frame left by a crash ends the list
+     */
+    bool readFrames(const std::string& path, std::vector<Frame>& frames) const;
+    static void appendFrame(std::string& out, const Frame& frame);
+
+    /**
+     * @brief Appends a frame, first cutting off any torn frame at the end of the file
+     */
+    bool appendToBucket(size_t bucket, const Frame& frame) const;
+
+    Frame sealFrame(std::vector<uint64_t> tags, const std::string& plain, std::string_view vaultKey) const;
+
+    const std::string historyDir;
+    FileEncryption encryptor;
+};
+
+} // namespace passman
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "utils/SecureMemory.h"
+
+namespace passman {
+
+/**
+ * @class Sha256
+ * @brief Incremental SHA-256 implementation (FIPS 180-4)
+ */
+class Sha256 {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+    static constexpr size_t BLOCK_SIZE = 64;
+    using Digest = std::array<uint8_t, DIGEST_SIZE>;
+
+    Sha256();
+
+    void update(const uint8_t* data, size_t length);
+    void update(const std::string& data);
+    Digest finish();
+
+    /**
+     * @brief Hashes data in one call
+     */
+    static Digest hash(const uint8_t* data, size_t length);
+
+private:
+    friend class HmacSha256;
+    void compress(const uint8_t* block);
+
+    std::array<uint32_t, 8> state;
+    std::array<uint8_t, BLOCK_SIZE> buffer;
+    size_t bufferLength;
+    uint64_t totalLength;
+};
+
+/**
+ * @class HmacSha256
+ * @brief HMAC-SHA256 (RFC 2104) with the keyed pads precomputed
+ *
+ * The inner and outer hash states are derived from the key once, so every
+ * additional message only costs its own compressions. PBKDF2 relies on this.
+ */
+class HmacSha256 {
+public:
+    HmacSha256(const uint8_t* key, size_t keyLength);
+
+    Sha256::Digest compute(const uint8_t* data, size_t length) const;
+
+private:
+    friend class PasswordKdf;
+    Sha256::Digest computeDigest(const Sha256::Digest& message) const;
+
+    Sha256 inner;
+    Sha256 outer;
+};
+
+/**
+ * @struct KdfParams
+ * @brief Cost parameters for master password derivation, stored in master.txt
+ */
+struct KdfParams {
+    std::string algorithm = "pbkdf2-sha256";
+    uint32_t iterations = 600000;
+
+    /**
+     * @brief True for vaults created before the KDF existed (single customHash pass)
+     */
+    bool isLegacy() const { return algorithm == "legacy"; }
+
+    std::string toString() const;
+
+    /**
+     * @brief Reads parameters written by toString(); empty text means legacy
+     * @return False for an unknown algorithm or an iteration count outside
+     *         [PasswordKdf::MIN_ITERATIONS, PasswordKdf::MAX_ITERATIONS]
+     */
+    static bool parse(const std::string& text, KdfParams& params);
+    static KdfParams legacy();
+};
+
+/**
+ * @class PasswordKdf
+ * @brief Derives the master password verifier and vault key with PBKDF2-HMAC-SHA256
+ *
+ * One 64-byte PBKDF2 output is split into a verifier, which is stored in
+ * master.txt, and an encryption key, which is only ever held in memory. The
+ * two 32-byte output blocks are independent and are computed on two lanes in
+ * parallel, halving the wall-clock cost for the same work factor.
+ */
+class PasswordKdf {
+public:
+    static constexpr uint32_t MIN_ITERATIONS = 100000;
+    static constexpr uint32_t MAX_ITERATIONS = 50000000;
+
+    struct DerivedKeys {
+        std::string verifier;
+        Utils::SecureString encryptionKey;
+    };
+
+    /**
+     * @brief Derives the verifier and encryption key for a master password
+     * @param password The master password
+     * @param salt The master salt
+     * @param params The cost parameters
+     * @return Both values hex encoded
+     */
+    static DerivedKeys derive(std::string_view password, const std::string& salt, const KdfParams& params);
+
+    /**
+     * @brief Raw PBKDF2-HMAC-SHA256 (RFC 8018)
+     * @param password The password
+     * @param salt The salt
+     * @param iterations The iteration count
+     * @param output Destination buffer
+     * @param outputLength Number of bytes to derive
+     */
+    static void pbkdf2(std::string_view password, std::string_view salt, uint32_t iterations,
+                       uint8_t* output, size_t outputLength);
+
+    /**
+     * @brief Picks an iteration count that makes derive() take about targetLatency here
+     * @param targetLatency The desired unlock latency on this machine
+     * @return Parameters clamped to [MIN_ITERATIONS, MAX_ITERATIONS]
+     */
+    static KdfParams calibrate(std::chrono::milliseconds targetLatency = std::chrono::milliseconds(300));
+
+    /**
+     * @brief Compares two strings in time independent of where they differ
+     */
+    static bool constantTimeEquals(std::string_view a, std::string_view b);
+};
+
+} // namespace passman
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <istream>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
+#include "passman/ChunkStore.h"
+#include "passman/EntryIndex.h"
+#include "passman/EntryTable.h"
 #include "passman/PasswordCrypto.h"
+#include "passman/PasswordHistory.h"
+#include "passman/PasswordKdf.h"
+#include "passman/PasswordRekeyer.h"
 #include "passman/PasswordStorage.h"
 #include "passman/PasswordTypes.h"
+#include "utils/SecureMemory.h"
 
 namespace passman {
 
@@ -20,16 +31,195 @@ public:
     explicit PasswordManager(const std::string& dataDir = "data/");
     ~PasswordManager() = default;
 
-    bool initialize(const std::string& masterPassword);
-    bool authenticate(const std::string& masterPassword) const;
-    bool changeMasterPassword(const std::string& oldPassword, const std::string& newPassword);
-    bool addEntry(const std::string& service, const std::string& username, const std::string& password);
+    bool initialize(std::string_view masterPassword);
+
+    /**
+     * @brief Verifies the master password and unlocks the vault
+     * @param masterPassword The master password
+     * @return True if the password matched and the entries were loaded
+     *
+     * The derived vault key is cached until lock() so the KDF cost is paid
+     * once per unlock rather than once per operation.
+     */
+    bool authenticate(std::string_view masterPassword);
+
+    /**
+     * @brief Forgets the cached vault key and the decrypted entry table
+     */
+    void lock();
+
+    /**
+     * @brief Checks whether authenticate() has succeeded since the last lock()
+     */
+    bool isUnlocked() const;
+
+    /**
+     * @brief Reloads the vault if another process committed since it was last read
+     * @return False if the newer vault could not be loaded
+     *
+     * Costs a stat of the vault file when nothing changed. If the master
+     * password was changed elsewhere the vault is locked again, since the
+     * cached key no longer opens it.
+     */
+    bool refresh();
+
+    /**
+     * @brief Sets the unlock latency that KDF calibration aims for
+     * @param target Desired time for one key derivation on this machine
+     */
+    void setUnlockTarget(std::chrono::milliseconds target);
+
+    /**
+     * @brief Changes the master password and re-encrypts every entry under it
+     * @param oldPassword The current master password
+     * @param newPassword The new master password
+     * @param progress Optional callback reporting re-key progress
+     * @return True if the re-keyed vault was committed, false if nothing changed
+     */
+    bool changeMasterPassword(std::string_view oldPassword, std::string_view newPassword,
+                              const PasswordRekeyer::ProgressCallback& progress = nullptr);
+
+    bool addEntry(const std::string& service, const std::string& username, std::string_view password,
+                  const std::string& serviceLink = "");
     bool removeEntry(const std::string& service);
-    bool updateEntry(const std::string& service, const std::string& username, const std::string& password);
+    bool updateEntry(const std::string& service, const std::string& username, std::string_view password);
     std::vector<std::string> listServices() const;
     PasswordEntry getEntry(const std::string& service) const;
-    std::string getPassword(const std::string& service) const; // New method to get decrypted password
+
+    /**
+     * @brief Decrypts the password of an entry into locked memory
+     * @return The password, or an empty string if there is no such entry
+     */
+    Utils::SecureString getPassword(const std::string& service) const;
     std::string generatePassword(size_t length = 16) const;
+
+    /**
+     * @brief Replaces the tags of an entry
+     * @param service The entry to tag
+     * @param tags The new tags, possibly comma-separated; empty clears them
+     * @return False if the entry does not exist or a tag is invalid
+     */
+    bool setTags(const std::string& service, const std::vector<std::string>& tags);
+
+    /**
+     * @brief Finds the entries matching a query such as "user=alice tag=prod"
+     * @param expression The query; see EntryIndex::parseQuery()
+     * @param services Receives the matching service names, sorted
+     * @param error Receives a message if the query is invalid
+     * @return False if the query is invalid or the vault is locked
+     *
+     * The username and tag indexes are built by the first query after an
+     * unlock or reload and kept up to date by every mutation after that.
+     */
+    bool query(const std::string& expression, std::vector<std::string>& services, std::string& error);
+
+    /**
+     * @brief Sets the URL an entry is used for
+     * @param service The entry to update
+     * @param serviceLink A URL or host, optionally "*.example.com"; empty clears it
+     * @return False if the entry does not exist or the link has no valid host
+     */
+    bool setServiceLink(const std::string& service, const std::string& serviceLink);
+
+    /**
+     * @brief Finds the entries whose service link best matches a URL
+     * @param url The URL being visited; only its host is used
+     * @param services Receives the matching service names, sorted
+     * @param tier Receives how the best matches relate to the host
+     * @param error Receives a message if the URL has no valid host
+     * @return False if the URL is invalid or the vault is locked
+     *
+     * Exact host matches win over links to the registrable domain, which
+     * win over the most specific wildcard. Uses the same on-demand index as
+     * query().
+     */
+    bool match(const std::string& url, std::vector<std::string>& services, DomainTrie::Match& tier,
+               std::string& error);
+
+    /**
+     * @brief Reads the recorded versions of an entry, newest first
+     * @param service The service name
+     * @param versions Receives one version per commit that changed the entry
+     * @return False if the vault is locked or the history could not be read
+     */
+    bool getHistory(const std::string& service, std::vector<HistoryVersion>& versions) const;
+
+    /**
+     * @brief Puts an entry back the way a past commit left it
+     * @param service The service name
+     * @param generation The version to restore, as listed by getHistory()
+     * @return False if there is no such version or the vault could not be saved
+     *
+     * The restore is itself a new commit, so it can be undone the same way.
+     */
+    bool restoreVersion(const std::string& service, uint64_t generation);
+
+    /**
+     * @brief Stores a file or note with an entry, replacing one with the same name
+     * @param service The entry to attach to
+     * @param name The attachment name; see ChunkStore::isValidName()
+     * @param input The attachment contents
+     * @param stats Receives how much of the data was new to the store, if not null
+     * @return False if the entry does not exist or the data could not be stored
+     *
+     * The data goes to the ChunkStore before the vault is locked for the
+     * commit; the entry itself only records the attachment's recipe.
+     */
+    bool attach(const std::string& service, const std::string& name, std::istream& input,
+                ChunkWriteStats* stats = nullptr);
+
+    /**
+     * @brief Writes an attachment back out
+     * @return False if there is no such attachment or its data fails verification
+     */
+    bool extract(const std::string& service, const std::string& name, std::ostream& output);
+
+    bool detach(const std::string& service, const std::string& name);
+
+    /**
+     * @brief Lists the attachments of an entry
+     * @return False if the entry does not exist
+     */
+    bool listAttachments(const std::string& service, std::vector<AttachmentRef>& refs) const;
+
+    /**
+     * @brief Encrypts and adds many entries at once
+     * @param records The plaintext entries to add, replacing same-named services
+     * @return True if the entries were added and persisted
+     *
+     * Encryption runs in parallel batches on the shared worker pool, and the
+     * vault is saved once for the whole call rather than once per entry.
+     */
+    bool addEntries(const std::vector<PasswordRecord>& records);
+
+    /**
+     * @brief Decrypts every entry in parallel batches and hands them to sink in order
+     * @param sink Called once per batch with the decrypted records
+     * @param batchSize Maximum number of records per call of sink
+     * @return False if the vault is locked or an entry could not be decrypted
+     */
+    bool forEachDecrypted(const std::function<void(const std::vector<PasswordRecord>&)>& sink,
+                          size_t batchSize = 65536) const;
+
+    /**
+     * @brief Defers saving until the matching commitBatch()
+     *
+     * Batches nest; only the outermost commitBatch() writes the vault. The
+     * outermost batch holds the vault's exclusive lock and starts from a
+     * refreshed copy, so other processes cannot commit in between.
+     */
+    void beginBatch();
+
+    /**
+     * @brief Ends a batch started with beginBatch() and saves pending changes
+     * @return True if nothing was pending or the save succeeded
+     */
+    bool commitBatch();
+
+    /**
+     * @brief Returns the number of stored entries
+     */
+    size_t size() const { return passwords.size(); }
     
     /**
      * @brief Checks if a master password has been set up
@@ -47,19 +237,13 @@ private:
     /**
      * @brief Verifies if the input password matches the master password
      * @param inputPassword The password to verify
+     * @param derivedKey Receives the vault key derived from the password, if not null
      * @return True if the password matches, false otherwise
      */
-    bool verifyMasterPassword(const std::string& inputPassword) const;
+    bool verifyMasterPassword(std::string_view inputPassword, Utils::SecureString* derivedKey = nullptr) const;
     
     /**
-     * @brief Converts a service name to lowercase for case-insensitive lookup
-     * @param service The service name to convert
-     * @return The lowercase version of the service name
-     */
-    std::string getServiceKey(const std::string& service) const;
-    
-    /**
-     * @brief Loads passwords from storage
+     * @brief Loads the master record, and the entries if the vault is unlocked
      * @return True if loading was successful, false otherwise
      */
     bool loadPasswords();
@@ -68,13 +252,61 @@ private:
      * @brief Saves passwords to storage
      * @return True if saving was successful, false otherwise
      */
-    bool savePasswords() const;
+    bool savePasswords();
+
+    /**
+     * @brief Applies change to the entry table inside a batch and saves it
+     * @param change Returns true if it modified the table
+     * @return True if the vault was unlocked, changed and saved
+     */
+    bool mutate(const std::function<bool()>& change);
+
+    bool replaceMasterPassword(std::string_view oldPassword, std::string_view newPassword,
+                               const PasswordRekeyer::ProgressCallback& progress);
+
+    /**
+     * @brief Drops the cached key and entries without touching batch state
+     */
+    void forgetKey();
+
+    /**
+     * @brief Opens the chunk store with the vault key on first use after an unlock, under the exclusive vault lock
+     */
+    bool openChunks();
+
+    /**
+     * @brief Inserts or erases an entry, keeping the index current if it is built
+     */
+    void putEntry(const EntryView& entry);
+    bool dropEntry(const std::string& service);
+
+    /**
+     * @brief Appends the entries changed since the last commit to the history
+     *
+     * History is best effort: a failure here never fails the commit itself.
+     */
+    void recordHistory();
+
+    /**
+     * @brief Drops the index and pending changes after passwords is replaced wholesale
+     */
+    void resetTableState();
 
     std::string masterPasswordHash;
     std::string masterSalt;
-    std::unordered_map<std::string, PasswordEntry> passwords;
+    KdfParams kdfParams;
+    Utils::SecureString encryptionKey; // Held in locked memory while unlocked
+    std::chrono::milliseconds unlockTarget;
+    size_t batchDepth;
+    bool dirty;
+    EntryTable passwords; // Looked up by service name, ignoring case
+    EntryIndex index;     // Built on demand by query()
+    std::vector<std::string> pendingChanges; // Services changed since the last commit
+    VaultStamp vaultStamp; // The commit passwords was loaded from
     PasswordCrypto crypto;
     PasswordStorage storage;
+    PasswordHistory history;
+    ChunkStore chunks; // Attachment data, opened by openChunks()
 };
 
 } // namespace passman
\ No newline at end of file
@@ -2,17 +2,52 @@
 
 #include "passman/PasswordManager.h"
 #include "utils/Utils.h"
+#include <iostream>
+#include <ostream>
 #include <string>
 #include <vector>
 
 class PasswordManagerOperations {
 public:
-    PasswordManagerOperations();
+    /**
+     * @param dataDir Directory of the vault the commands work on
+     */
+    explicit PasswordManagerOperations(const std::string& dataDir = "data/");
     ~PasswordManagerOperations() = default;
 
-    void passman(const std::vector<std::string>& args);
+    /**
+     * @brief Runs the interactive menu, or one subcommand when args are given
+     * @param out Receives the subcommand's results; prompts and the menu stay on the console
+     * @return False if the vault could not be unlocked or the subcommand failed
+     */
+    bool passman(const std::vector<std::string>& args, std::ostream& out = std::cout);
 
 private:
+    bool unlock();
+
+    // Non-interactive subcommands; each returns false on failure
+    bool runSubcommand(const std::vector<std::string>& args);
+    bool getCommand(const std::vector<std::string>& args);
+    bool addCommand(const std::vector<std::string>& args);
+    bool removeCommand(const std::vector<std::string>& args);
+    bool listCommand(const std::vector<std::string>& args);
+    bool tagCommand(const std::vector<std::string>& args);
+    bool queryCommand(const std::vector<std::string>& args);
+    bool urlCommand(const std::vector<std::string>& args);
+    bool matchCommand(const std::vector<std::string>& args);
+    bool historyCommand(const std::vector<std::string>& args);
+    bool restoreCommand(const std::vector<std::string>& args);
+    bool attachCommand(const std::vector<std::string>& args);
+    bool attachmentsCommand(const std::vector<std::string>& args);
+    bool extractCommand(const std::vector<std::string>& args);
+    bool detachCommand(const std::vector<std::string>& args);
+    bool noteCommand(const std::vector<std::string>& args);
+    bool generateCommand(const std::vector<std::string>& args);
+    bool batchCommand(const std::vector<std::string>& args);
+    bool auditCommand(const std::vector<std::string>& args);
+    bool importPasswords(const std::vector<std::string>& args);
+    bool exportPasswords(const std::vector<std::string>& args);
+
     void addPassword();
     void getPassword();
     void listServices();
@@ -22,5 +57,8 @@ private:
     void changeMasterPassword();
 
     passman::PasswordManager passwordManager;
+    passman::PasswordCrypto crypto;
     bool initialized;
+    Utils::SecureString scriptedPassword; // From SECURESHELL_PASSMAN_PASSWORD, removed from the environment
+    std::ostream* output; // Where the current subcommand writes
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace passman {
+
+/**
+ * @struct PasswordPolicy
+ * @brief Character set and composition rules for generated passwords
+ */
+struct PasswordPolicy {
+    std::string name = "full";
+    std::string charset = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz!@#$%^&*()-=_+";
+    bool requireAllClasses = false; // At least one lowercase, uppercase, digit and symbol
+    size_t minLength = 1;
+
+    /**
+     * @brief Checks a candidate against the composition rules
+     */
+    bool accepts(std::string_view password) const;
+
+    /**
+     * @brief Looks up a policy by name
+     * @param name One of the names listed by names()
+     * @param policy Receives the policy
+     * @return False if the name is unknown
+     */
+    static bool parse(const std::string& name, PasswordPolicy& policy);
+
+    /**
+     * @brief Returns the known policy names for usage messages
+     */
+    static std::string names();
+};
+
+} // namespace passman
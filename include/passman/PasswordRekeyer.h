@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "passman/EntryTable.h"
+#include "passman/PasswordCrypto.h"
+#include "passman/PasswordTypes.h"
+
+namespace passman {
+
+/**
+ * @class PasswordRekeyer
+ * @brief Re-encrypts every vault entry under a new master key
+ *
+ * Entries are decrypted with the old key and encrypted with the new one in
+ * parallel batches on the shared worker pool. The input vault is never
+ * modified, so a failed or abandoned re-key leaves it fully usable.
+ */
+class PasswordRekeyer {
+public:
+    /**
+     * @brief Callback receiving the number of re-keyed entries and the total
+     *
+     * Always invoked on the thread that called rekey(), never on a worker.
+     */
+    using ProgressCallback = std::function<void(size_t completed, size_t total)>;
+
+    /**
+     * @brief Constructor
+     * @param crypto The crypto implementation used for both keys
+     * @param batchSize Number of entries handed to a worker at a time
+     */
+    explicit PasswordRekeyer(const PasswordCrypto& crypto, size_t batchSize = 4096);
+
+    /**
+     * @brief Produces a copy of the vault encrypted under newKey
+     * @param passwords The entries encrypted under oldKey
+     * @param oldKey The key the entries are currently encrypted with
+     * @param newKey The key to re-encrypt the entries with
+     * @param rekeyed Receives the re-encrypted entries, with every shard dirty
+     * @param progress Optional progress callback
+     * @return True if every entry was re-encrypted
+     */
+    bool rekey(const EntryTable& passwords,
+               std::string_view oldKey,
+               std::string_view newKey,
+               EntryTable& rekeyed,
+               const ProgressCallback& progress = nullptr) const;
+
+private:
+    const PasswordCrypto& crypto;
+    size_t batchSize;
+};
+
+} // namespace passman
@@ -1,20 +1,44 @@
 #pragma once
 
+#include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 #include "encryption/FileEncryption.h"
+#include "passman/EntryTable.h"
+#include "passman/PasswordKdf.h"
 #include "passman/PasswordTypes.h"
+#include "passman/VaultLock.h"
 
 namespace passman {
 
-// No need for forward declaration of PasswordManager anymore
+/**
+ * @struct VaultStamp
+ * @brief Identifies the committed vault an instance last read or wrote
+ *
+ * The manifest's size and modification time give a cheap first check;
+ * the generation from its header settles whether another process
+ * actually committed.
+ */
+struct VaultStamp {
+    bool exists = false;
+    std::uintmax_t size = 0;
+    std::filesystem::file_time_type modified{};
+    uint64_t generation = 0;
+};
 
 /**
  * @class PasswordStorage
  * @brief Handles file I/O operations for password management
  * 
  * This class is responsible for loading and saving password data to disk,
- * including encryption and decryption of the password file.
+ * including encryption and decryption of the vault. Entries are stored in
+ * encrypted shard files under vault/, listed by a plaintext manifest, so a
+ * commit rewrites only the shards that changed. Reads hold a
+ * shared VaultLock and writes an exclusive one, unless the caller already
+ * holds the lock through hold().
  */
 class PasswordStorage {
 public:
@@ -29,41 +53,175 @@ public:
      * @brief Loads master password information from disk
      * @param masterPasswordHash Reference to store the loaded master password hash
      * @param masterSalt Reference to store the loaded master salt
+     * @param kdfParams Reference to store the KDF parameters (legacy if none are recorded)
      * @return True if loading was successful, false otherwise
      */
-    bool loadMasterPassword(std::string& masterPasswordHash, std::string& masterSalt) const;
+    bool loadMasterPassword(std::string& masterPasswordHash, std::string& masterSalt,
+                            KdfParams& kdfParams) const;
     
+    /**
+     * @brief Checks whether master.txt exists, whether or not it can be parsed
+     *
+     * A damaged record must not look like a fresh install, or setting up a
+     * new master password would overwrite the vault.
+     */
+    bool hasMasterRecord() const;
+
     /**
      * @brief Saves master password information to disk
      * @param masterPasswordHash The master password hash to save
      * @param masterSalt The master salt to save
+     * @param kdfParams The KDF parameters the hash was derived with
      * @return True if saving was successful, false otherwise
      */
-    bool saveMasterPassword(const std::string& masterPasswordHash, const std::string& masterSalt) const;
+    bool saveMasterPassword(const std::string& masterPasswordHash, const std::string& masterSalt,
+                            const KdfParams& kdfParams) const;
     
     /**
      * @brief Loads password entries from disk
      * @param passwords Reference to store the loaded password entries
-     * @param masterPasswordHash The master password hash for decryption
+     * @param vaultKey The key derived from the master password
+     * @param stamp Receives the stamp of the vault that was read
      * @return True if loading was successful, false otherwise
+     *
+     * Shards are read and decrypted in parallel. A vault still in the single
+     * passwords.txt layout is loaded with every shard dirty, so the next
+     * commit migrates it.
      */
-    bool loadPasswords(std::unordered_map<std::string, PasswordEntry>& passwords, 
-                      const std::string& masterPasswordHash) const;
-    
+    bool loadPasswords(EntryTable& passwords, std::string_view vaultKey, VaultStamp& stamp) const;
+
     /**
-     * @brief Saves password entries to disk
-     * @param passwords The password entries to save
-     * @param masterPasswordHash The master password hash for encryption
-     * @return True if saving was successful, false otherwise
+     * @brief Atomically publishes the dirty shards, the manifest and the master password file
+     * @param passwords The password entries to save; only dirty shards are written
+     * @param vaultKey The key derived from the master password
+     * @param masterPasswordHash The master password hash to save
+     * @param masterSalt The master salt to save
+     * @param kdfParams The KDF parameters the hash was derived with
+     * @param stamp The vault the caller's entries came from; updated to the new commit
+     * @param staged Further files the caller wrote and synced as <path>.tmp, published along with the vault
+     * @return True if the commit reached disk, false if the previous vault was kept
+     *
+     * All files are staged first and then published behind a commit journal, so
+     * a crash can never leave a vault encrypted under a different master password
+     * than the one recorded in master.txt. The commit is refused if another
+     * process committed since stamp was taken. The caller's staged files are
+     * removed when the commit fails.
      */
-    bool savePasswords(const std::unordered_map<std::string, PasswordEntry>& passwords, 
-                      const std::string& masterPasswordHash) const;
+    bool commit(const EntryTable& passwords,
+                std::string_view vaultKey,
+                const std::string& masterPasswordHash,
+                const std::string& masterSalt,
+                const KdfParams& kdfParams,
+                VaultStamp& stamp,
+                const std::vector<std::string>& staged = {}) const;
+
+    /**
+     * @brief Checks whether another process committed since stamp was taken
+     * @param stamp The caller's stamp; its file attributes are refreshed when unchanged
+     * @return True if the vault generation on disk differs from stamp
+     *
+     * Only stats the vault file unless its size or modification time moved,
+     * in which case the header is read to compare generations.
+     */
+    bool hasChangedSince(VaultStamp& stamp) const;
+
+    /**
+     * @brief Acquires the vault lock until the matching release()
+     * @param mode Shared to keep a multi-step read consistent, Exclusive for read-modify-write
+     * @return True if the lock is held
+     *
+     * Holds nest. A nested hold keeps the mode of the outermost one. A
+     * shared hold first rolls forward any commit a crashed writer left, and
+     * an exclusive one does so once it has the lock, so files staged under
+     * it never overwrite those of a pending commit.
+     */
+    bool hold(VaultLock::Mode mode) const;
+
+    /**
+     * @brief Releases a hold() once the outermost hold is released
+     */
+    void release() const;
 
 private:
+    /**
+     * @struct Manifest
+     * @brief Parsed vault/manifest: the commit generation and shard layout
+     */
+    struct Manifest {
+        uint64_t generation = 0;
+        size_t shardCount = 0;
+    };
+
+    /**
+     * @brief Rolls forward a commit whose journal was written before a crash
+     * @return True if no commit is pending afterwards
+     */
+    bool recoverPendingCommit() const;
+
+    /**
+     * @brief Rolls forward a pending commit under a temporary exclusive lock
+     * @return True if no commit is pending afterwards
+     *
+     * Must not be called while holding the lock, which would deadlock.
+     */
+    bool rollForward() const;
+
+    /**
+     * @brief Deletes files staged by a commit that never reached its journal
+     */
+    void discardStagedFiles() const;
+
+    bool readManifest(Manifest& manifest) const;
+    bool loadLegacyVault(EntryTable& passwords, std::string_view vaultKey) const;
+    bool loadShard(size_t index, EntryTable::Shard& shard, std::string_view vaultKey) const;
+    std::string shardPath(size_t index) const;
+
+    /**
+     * @brief Returns the file whose stamp identifies the current commit
+     */
+    const std::string& stampPath() const;
+
+    /**
+     * @brief Takes the vault lock for one operation unless hold() already covers it
+     * @param mode The mode the operation needs
+     * @param lock Receives the lock to keep alive for the operation; stays null under a hold
+     * @return False if the lock could not be taken in that mode
+     */
+    bool acquire(VaultLock::Mode mode, std::unique_ptr<VaultLock>& lock) const;
+
+    /**
+     * @brief Takes the shared lock for a read after rolling forward any pending commit
+     * @param lock Receives the lock to keep alive for the read; stays null under a hold
+     * @return False if the lock could not be taken or a commit is still pending
+     *
+     * A pending commit under a shared hold fails the read rather than
+     * exposing a half-published vault.
+     */
+    bool acquireRecovered(std::unique_ptr<VaultLock>& lock) const;
+
+    /**
+     * @brief Stats the vault file and reads the generation from its header
+     */
+    VaultStamp readStamp() const;
+
+    std::string serializeShard(const EntryTable::Shard& shard) const;
+    bool writeShardFile(const std::string& path, const EntryTable::Shard& shard,
+                        std::string_view vaultKey) const;
+    bool writeManifestFile(const std::string& path, const Manifest& manifest) const;
+    bool writeMasterFile(const std::string& path, const std::string& masterPasswordHash,
+                         const std::string& masterSalt, const KdfParams& kdfParams) const;
+    bool replaceFile(const std::string& from, const std::string& to) const;
+
     const std::string dataDir;
-    const std::string passwordFile;
+    const std::string shardDir;
+    const std::string manifestFile;
+    const std::string passwordFile; // Single-file layout from before sharding
     const std::string masterFile;
+    const std::string journalFile;
+    const std::string lockFile;
     FileEncryption encryptor;
+    mutable std::unique_ptr<VaultLock> heldLock;
+    mutable size_t holdDepth;
 };
 
 } // namespace passman
\ No newline at end of file
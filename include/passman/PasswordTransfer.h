@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "passman/PasswordManager.h"
+#include "passman/PasswordTypes.h"
+
+namespace passman {
+
+enum class TransferFormat {
+    Csv,
+    Json
+};
+
+/**
+ * @struct TransferStats
+ * @brief Counters reported by an import or export run
+ */
+struct TransferStats {
+    size_t processed = 0;
+    size_t skipped = 0;
+    double seconds = 0.0;
+};
+
+/**
+ * @class PasswordTransfer
+ * @brief Streams credentials between the vault and CSV/JSON files
+ *
+ * Imports read the file in fixed-size chunks and parse records as they go,
+ * handing them to PasswordManager::addEntries in batches so encryption runs
+ * in parallel while memory stays bounded. The whole import is committed with
+ * a single save. Column names follow common browser and password manager
+ * exports (name/title, url/uri, username/login, password).
+ */
+class PasswordTransfer {
+public:
+    /**
+     * @brief Constructor
+     * @param manager An unlocked password manager
+     * @param batchSize Number of records parsed before a batch is encrypted
+     */
+    explicit PasswordTransfer(PasswordManager& manager, size_t batchSize = 16384);
+
+    /**
+     * @brief Picks a format from a file extension (.csv or .json)
+     * @return False if the extension is not recognised
+     */
+    static bool formatFromPath(const std::string& path, TransferFormat& format);
+
+    /**
+     * @brief Imports every record in a file into the vault
+     * @param path The file to read
+     * @param format The file format
+     * @param stats Receives the number of imported and skipped records
+     * @param error Receives a description of the failure, if any
+     * @return True if the file was parsed and the vault saved
+     */
+    bool importFile(const std::string& path, TransferFormat format, TransferStats& stats, std::string& error);
+
+    /**
+     * @brief Writes every vault entry, decrypted, to a file
+     * @param path The file to write
+     * @param format The file format
+     * @param stats Receives the number of exported records
+     * @param error Receives a description of the failure, if any
+     * @return True if every entry was written
+     */
+    bool exportFile(const std::string& path, TransferFormat format, TransferStats& stats, std::string& error);
+
+private:
+    PasswordManager& manager;
+    size_t batchSize;
+};
+
+} // namespace passman
@@ -1,9 +1,21 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
 #include <string>
 
 namespace passman {
 
+/**
+ * @brief Lowercases a service name; entry tables are keyed by this form
+ */
+inline std::string normalizeServiceName(const std::string& service) {
+    std::string key = service;
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c){ return std::tolower(c); });
+    return key;
+}
+
 /**
  * @struct PasswordEntry
  * @brief Structure to hold password entry information
@@ -14,6 +26,19 @@ struct PasswordEntry {
     std::string encryptedPassword;
     std::string serviceLink;
     std::string salt;
+    std::string tags; // Comma-separated, lowercase and sorted; see EntryIndex::normalizeTags()
+    std::string attachments; // "name:size:recipe" refs into the ChunkStore; see ChunkStore::formatRefs()
+};
+
+/**
+ * @struct PasswordRecord
+ * @brief Plaintext view of an entry used for bulk import, export and batch commands
+ */
+struct PasswordRecord {
+    std::string service;
+    std::string username;
+    std::string password;
+    std::string serviceLink;
 };
 
 } // namespace passman
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+
+namespace passman {
+
+/**
+ * @class VaultLock
+ * @brief Advisory inter-process lock on the vault's lock file
+ *
+ * Readers take the lock shared and writers take it exclusive, so several
+ * SecureShell instances can read the vault at once while commits are
+ * serialized. The lock is released when the object is destroyed.
+ */
+class VaultLock {
+public:
+    enum class Mode {
+        Shared,
+        Exclusive
+    };
+
+    /**
+     * @brief Blocks until the lock is acquired in the requested mode
+     * @param path Lock file, created if it does not exist
+     * @param mode Shared for readers, Exclusive for writers
+     */
+    VaultLock(const std::string& path, Mode mode);
+    ~VaultLock();
+
+    VaultLock(const VaultLock&) = delete;
+    VaultLock& operator=(const VaultLock&) = delete;
+
+    /**
+     * @brief Checks whether the lock was acquired
+     * @return False if the lock file could not be opened or locked
+     */
+    bool isHeld() const { return held; }
+
+    Mode mode() const { return lockMode; }
+
+private:
+#ifdef _WIN32
+    void* handle;
+#else
+    int fd;
+#endif
+    Mode lockMode;
+    bool held;
+};
+
+} // namespace passman
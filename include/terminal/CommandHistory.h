@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "utils/MappedFile.h"
+
+/**
+ * @class CommandHistory
+ * @brief Persistent, append-only command history with reverse search
+ *
+ * The history file holds one command per line and is only ever appended
+ * to. Opening it maps the file instead of reading it: stepping back with
+ * the up arrow finds line breaks backwards from the end, as far as the
+ * user goes. A trigram index of the mapped lines is built on a background
+ * thread, so an incremental search stays fast over millions of lines.
+ * Commands added this session are kept in memory as well as appended.
+ */
+class CommandHistory {
+public:
+    CommandHistory() = default;
+    ~CommandHistory();
+
+    CommandHistory(const CommandHistory&) = delete;
+    CommandHistory& operator=(const CommandHistory&) = delete;
+
+    /**
+     * @brief Maps an existing history file and starts indexing it
+     * @param path File to read and append to; created on the first add
+     * @return False if the file exists but cannot be mapped, or cannot be appended to
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Records a command, unless it repeats the one before
+     */
+    void add(std::string_view line);
+
+    /**
+     * @brief Returns a command by age
+     * @param age 0 for the newest command, 1 for the one before, and so on
+     * @param line Receives the command; valid while the history is open
+     * @return False once age goes past the oldest command
+     */
+    bool entry(size_t age, std::string_view& line);
+
+    /**
+     * @brief Finds a recent command containing query
+     * @param query Text to look for, case-sensitive
+     * @param skip Number of newer matches to pass over, for repeated Ctrl-R
+     * @param match Receives the command; valid while the history is open
+     * @return False if fewer than skip + 1 commands match
+     *
+     * A match equal to the one found just before it is not counted again.
+     */
+    bool search(std::string_view query, size_t skip, std::string_view& match);
+
+private:
+    struct Postings {
+        std::vector<uint8_t> deltas; // Varint gaps between ascending line numbers
+        uint32_t last = 0;
+        uint32_t count = 0;
+    };
+
+    /**
+     * @brief Lines of the mapped file, oldest first, and the lines holding each trigram
+     */
+    struct TrigramIndex {
+        std::vector<std::string_view> lines;
+        std::unordered_map<uint32_t, Postings> postings;
+    };
+
+    static void buildIndex(std::string_view text, TrigramIndex& index);
+    static std::vector<uint32_t> decode(const Postings& postings);
+    const TrigramIndex& readyIndex();
+
+    Utils::MappedFile mapped;
+    std::deque<std::string> session; // Added since open, oldest first; a deque keeps views valid
+    std::vector<std::string_view> recent; // Mapped lines found so far by entry(), newest first
+    size_t unscanned = 0; // Bytes of the mapping before the oldest line in recent
+    TrigramIndex index;
+    std::future<void> indexed;
+    std::ofstream appender;
+};
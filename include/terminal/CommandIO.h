@@ -0,0 +1,110 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+/**
+ * @class ByteChannel
+ * @brief Bounded single-producer, single-consumer byte pipe between two stages
+ *
+ * write() blocks while the buffer is full, so a fast producer is held to the
+ * pace of its consumer. Once the reader closes its end, writes fail at once,
+ * which is how a stage that stops early (head) stops the stages before it.
+ */
+class ByteChannel {
+public:
+    static constexpr size_t kDefaultCapacity = 64 * 1024;
+
+    explicit ByteChannel(size_t capacity = kDefaultCapacity);
+
+    /**
+     * @brief Writes all of data, waiting for room as needed
+     * @return False if the reader has closed the channel
+     */
+    bool write(const char* data, size_t size);
+
+    /**
+     * @brief Reads up to size bytes, waiting until some are available
+     * @return Bytes read, 0 once the writer has closed and the buffer is empty
+     */
+    size_t read(char* data, size_t size);
+
+    void closeWrite();
+    void closeRead();
+
+private:
+    std::vector<char> buffer;
+    size_t head = 0; // Next byte to read
+    size_t used = 0;
+    bool writerClosed = false;
+    bool readerClosed = false;
+    std::mutex mutex;
+    std::condition_variable readable;
+    std::condition_variable writable;
+};
+
+/**
+ * @class ChannelStreamBuf
+ * @brief Adapts one end of a ByteChannel to std::istream or std::ostream
+ *
+ * When the reader has gone away, overflow fails and the ostream goes bad;
+ * commands check their output stream to stop producing.
+ */
+class ChannelStreamBuf : public std::streambuf {
+public:
+    ChannelStreamBuf(ByteChannel& channel, bool writer);
+    ~ChannelStreamBuf() override;
+
+protected:
+    int_type overflow(int_type c) override;
+    int sync() override;
+    int_type underflow() override;
+
+private:
+    bool flush();
+
+    ByteChannel& channel;
+    bool writer;
+    char buffer[4096];
+};
+
+/**
+ * @class CommandIO
+ * @brief Per-thread input and output of the command being run
+ *
+ * Commands write results to CommandIO::out() instead of std::cout and, when
+ * they can take piped data, read it from CommandIO::in(). Outside a
+ * pipeline out() is std::cout and in() is null. Interactive prompts and
+ * confirmations keep using the console directly.
+ */
+class CommandIO {
+public:
+    /**
+     * @class Scope
+     * @brief Redirects the calling thread's command IO until destroyed
+     */
+    class Scope {
+    public:
+        Scope(std::istream* input, std::ostream* output);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        std::istream* previousInput;
+        std::ostream* previousOutput;
+    };
+
+    static std::ostream& out();
+
+    /**
+     * @brief Piped input of the current command, or null if it has none
+     */
+    static std::istream* in();
+};
@@ -14,36 +14,43 @@ public:
     explicit CommandImplementation(Terminal& terminal);
     ~CommandImplementation();
     
-    void help() const;
-    void exit();
-    void cd(const std::vector<std::string>& args);
-    void ls(const std::vector<std::string>& args);
-    void copy(const std::vector<std::string>& args);
-    void move(const std::vector<std::string>& args);
-    void rename(const std::vector<std::string>& args);
-    void create_directory(const std::vector<std::string>& args);
-    void create_file(const std::vector<std::string>& args);
-    void display_permission(const std::vector<std::string>& args);
-    void get_current_directory(const std::vector<std::string>& args);
-    void remove(const std::vector<std::string>& args);
-    void cat(const std::vector<std::string>& args);
-    void write(const std::vector<std::string>& args);
-    void grep(const std::vector<std::string>& args);
-    void head(const std::vector<std::string>& args);
-    void tree(const std::vector<std::string>& args);
-    void find(const std::vector<std::string>& args);
-    void stat(const std::vector<std::string>& args);
-    void compile(const std::vector<std::string>& args);
-    void passman(const std::vector<std::string>& args);
-    void encrypt(const std::vector<std::string>& args);
-    void decrypt(const std::vector<std::string>& args);
-    void system_info(const std::vector<std::string>& args);
+    // Each command prints its own errors and returns false if it failed
+    bool help() const;
+    bool exit();
+    bool cd(const std::vector<std::string>& args);
+    bool ls(const std::vector<std::string>& args);
+    bool copy(const std::vector<std::string>& args);
+    bool move(const std::vector<std::string>& args);
+    bool rename(const std::vector<std::string>& args);
+    bool create_directory(const std::vector<std::string>& args);
+    bool create_file(const std::vector<std::string>& args);
+    bool display_permission(const std::vector<std::string>& args);
+    bool get_current_directory(const std::vector<std::string>& args);
+    bool remove(const std::vector<std::string>& args);
+    bool cat(const std::vector<std::string>& args);
+    bool write(const std::vector<std::string>& args);
+    bool grep(const std::vector<std::string>& args);
+    bool head(const std::vector<std::string>& args);
+    bool tree(const std::vector<std::string>& args);
+    bool find(const std::vector<std::string>& args);
+    bool stat(const std::vector<std::string>& args);
+    bool compile(const std::vector<std::string>& args);
+    bool passman(const std::vector<std::string>& args);
+    bool encrypt(const std::vector<std::string>& args);
+    bool decrypt(const std::vector<std::string>& args);
+    bool system_info(const std::vector<std::string>& args);
+    bool source(const std::vector<std::string>& args);
+    bool jobs(const std::vector<std::string>& args);
+    bool wait(const std::vector<std::string>& args);
+    bool fg(const std::vector<std::string>& args);
+    bool kill(const std::vector<std::string>& args);
 
 private:
     Terminal& terminal;
     FileOperations* fileOperations;
     PasswordManagerOperations* passwordOperations;
-    void compileAndRun(const std::string& filename);
+    bool compileAndRun(const std::string& filename);
+    bool parseJobId(const std::string& arg, int& id) const; // Prints an error if arg is not a job id
 };
 
 
@@ -1,28 +1,101 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <unordered_map>
+#include "CommandTrie.h"
+
+/**
+ * @class CommandLine
+ * @brief The words of one command line, as views into a buffer it owns
+ *
+ * Quotes and escapes are resolved in place, so tokenizing a line costs one
+ * copy of it however many words it has. Reusing an instance for the next
+ * line keeps its capacity. Not copyable, since the views point into it.
+ */
+class CommandLine {
+public:
+    CommandLine() = default;
+    CommandLine(const CommandLine&) = delete;
+    CommandLine& operator=(const CommandLine&) = delete;
+
+    bool empty() const { return tokens.empty(); }
+    size_t size() const { return tokens.size(); }
+    std::string_view operator[](size_t index) const { return tokens[index]; }
+    std::vector<std::string_view>::const_iterator begin() const { return tokens.begin(); }
+    std::vector<std::string_view>::const_iterator end() const { return tokens.end(); }
+
+    /**
+     * @brief Copies the words from index first on into strings, as command handlers take them
+     */
+    std::vector<std::string> strings(size_t first = 0) const;
+
+private:
+    friend class CommandParser;
+
+    std::string buffer;
+    std::vector<std::string_view> tokens;
+};
 
 class CommandParser {
     friend class
     CommandParserTest;
 public:
-    using CommandFunction = std::function<void(const std::vector<std::string>&)>;
+    /**
+     * @brief A command handler; it prints its own errors and returns false if it failed
+     */
+    using CommandFunction = std::function<bool(const std::vector<std::string>&)>;
 
     CommandParser();
     ~CommandParser() = default;
 
     void registerCommand(const std::string& command, CommandFunction handler);
+
+    /**
+     * @brief Runs a registered command
+     * @return False if the command is unknown, its handler failed or it threw
+     */
     bool executeCommand(const std::string& command, const std::vector<std::string>& args);
     std::vector<std::string> parseInput(const std::string& input) const;
+
+    /**
+     * @brief Splits a line into words in one pass
+     *
+     * Words are separated by spaces or tabs. Double quotes group words and
+     * allow \" and \\ inside; single quotes take everything up to the next
+     * single quote literally. Outside quotes a backslash escapes a space,
+     * tab, quote, backslash, '|' or '&' and is kept before anything else,
+     * so Windows paths such as C:\Users need no doubling.
+     *
+     * @param input Line to split
+     * @param line Receives the words, replacing what it held
+     */
+    void tokenize(std::string_view input, CommandLine& line) const;
+
+    /**
+     * @brief Splits a line into pipeline stages at each unquoted, unescaped '|'
+     */
+    std::vector<std::string> splitPipeline(const std::string& input) const;
+
+    /**
+     * @brief Removes a trailing unquoted, unescaped '&', as in "find . log &"
+     * @return True if the line asked to run in the background
+     */
+    bool stripBackground(std::string& input) const;
     bool isValidCommand(const std::string& command) const;
     std::vector<std::pair<std::string, std::string>> getCommandList() const;
 
+    /**
+     * @brief Prefix tree of every command name, for per-keystroke lookups
+     */
+    const CommandTrie& getCommandTrie() const { return commandNames; }
+
 private:
     std::unordered_map<std::string, CommandFunction> commands;
     std::unordered_map<std::string, std::string> commandDescriptions;
+    CommandTrie commandNames; // Keys of commandDescriptions
 
     void initializeDefaultCommands();
     std::vector<std::string> splitString(const std::string& input, char delimiter = ' ') const;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class CommandTrie
+ * @brief Prefix tree over command names, built as commands are registered
+ *
+ * Lookups cost one step per character regardless of how many commands
+ * exist. A Cursor follows the line as it is typed, so the input loop can
+ * tell after every key press whether the line still spells out a command.
+ */
+class CommandTrie {
+public:
+    /**
+     * @class Cursor
+     * @brief Position in the trie of the characters typed so far
+     *
+     * push() and pop() mirror typing and backspacing one character. Node
+     * indices stay valid when more commands are inserted, so a cursor may
+     * outlive later registrations.
+     */
+    class Cursor {
+    public:
+        explicit Cursor(const CommandTrie& trie);
+
+        void push(char c);
+        void pop();
+        void reset();
+
+        /**
+         * @brief True while the typed text is a prefix of some command
+         */
+        bool isPrefix() const { return node() >= 0; }
+
+        /**
+         * @brief True if the typed text is exactly a command name
+         */
+        bool isCommand() const;
+
+        size_t length() const { return path.size(); }
+
+    private:
+        int32_t node() const { return path.empty() ? 0 : path.back(); }
+
+        const CommandTrie* trie;
+        std::vector<int32_t> path; // Node after each typed character, -1 once off the trie
+    };
+
+    CommandTrie();
+
+    void insert(std::string_view name);
+    bool contains(std::string_view name) const;
+    bool hasPrefix(std::string_view prefix) const;
+
+    /**
+     * @brief Appends every name starting with prefix to names, in sorted order
+     */
+    void complete(std::string_view prefix, std::vector<std::string>& names) const;
+
+    Cursor cursor() const { return Cursor(*this); }
+
+private:
+    struct Node {
+        std::vector<std::pair<char, int32_t>> children; // Sorted by character
+        bool terminal = false;
+    };
+
+    int32_t child(int32_t node, char c) const;
+    int32_t find(std::string_view prefix) const;
+    void collect(int32_t node, std::string& name, std::vector<std::string>& names) const;
+
+    std::vector<Node> nodes;
+};
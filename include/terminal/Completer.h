@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CommandParser.h"
+#include "DirectoryCache.h"
+
+/**
+ * @struct Completion
+ * @brief Result of completing the last word of an input line
+ */
+struct Completion {
+    std::string line;                    // The input, extended as far as the matches agree
+    std::vector<std::string> candidates; // Every match, set when more than one remains
+};
+
+/**
+ * @class Completer
+ * @brief Tab completion for command names, aliases and paths
+ *
+ * The first word of a line completes against the command trie and the
+ * aliases, later words against the file system through a DirectoryCache.
+ * Directories complete with a trailing '/', and a word containing a space
+ * is wrapped in the double quotes parseInput understands.
+ */
+class Completer {
+public:
+    Completer(const CommandParser& parser, const std::unordered_map<std::string, std::string>& aliases);
+
+    Completion complete(const std::string& line);
+
+private:
+    void completeCommand(const std::string& word, std::vector<std::string>& names) const;
+
+    const CommandParser& parser;
+    const std::unordered_map<std::string, std::string>& aliases;
+    DirectoryCache directories;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class DirectoryCache
+ * @brief Sorted snapshots of directory listings for path completion
+ *
+ * A directory is read once and its names kept sorted, so each lookup is a
+ * binary search for the prefix range. A snapshot is reused until the
+ * directory's modification time changes. A snapshot taken within a couple
+ * of seconds of that time is read again on next use, because a change in
+ * the same timestamp tick would otherwise go unnoticed. Only the most
+ * recently used directories are kept.
+ */
+class DirectoryCache {
+public:
+    struct Entry {
+        std::string name;
+        bool directory = false;
+    };
+
+    explicit DirectoryCache(size_t maxDirectories = 32);
+
+    /**
+     * @brief Finds the entries of a directory whose names start with prefix
+     * @param directory Directory to list, relative to the current one or absolute
+     * @param prefix Leading characters to match; dot files only match a prefix starting with '.'
+     * @param matches Receives the matching entries in name order
+     * @return False if the directory cannot be read
+     */
+    bool lookup(const std::filesystem::path& directory, std::string_view prefix, std::vector<Entry>& matches);
+
+    /**
+     * @brief Number of directory reads so far, as opposed to cache hits
+     */
+    size_t scans() const { return scanCount; }
+
+private:
+    struct Snapshot {
+        std::filesystem::file_time_type modified;
+        bool racy = false; // Taken too close to modified to trust
+        uint64_t lastUse = 0;
+        std::vector<Entry> entries;
+    };
+
+    const Snapshot* snapshot(const std::filesystem::path& directory);
+    bool scan(const std::filesystem::path& directory, std::filesystem::file_time_type modified, Snapshot& snapshot);
+
+    size_t maxDirectories;
+    std::unordered_map<std::string, Snapshot> snapshots; // Keyed by absolute path
+    uint64_t useCounter = 0;
+    size_t scanCount = 0;
+};
@@ -8,26 +8,27 @@
 class FileOperations {
 public:
     FileOperations();
-    
-    void cd(const std::vector<std::string>& args);
-    void ls(const std::vector<std::string>& args);
-    void copy(const std::vector<std::string>& args);
-    void move(const std::vector<std::string>& args);
-    void rename(const std::vector<std::string>& args);
-    void create_directory(const std::vector<std::string>& args);
-    void create_file(const std::vector<std::string>& args);
-    void display_permission(const std::vector<std::string>& args);
-    void get_current_directory(const std::vector<std::string>& args);
-    void remove(const std::vector<std::string>& args);
-    void cat(const std::vector<std::string>& args);
-    void write(const std::vector<std::string>& args);
-    void grep(const std::vector<std::string>& args);
-    void head(const std::vector<std::string>& args);
-    void tree(const std::vector<std::string>& args);
-    void find(const std::vector<std::string>& args);
-    void stat(const std::vector<std::string>& args);
+
+    // Each command prints its own errors and returns false if it failed
+    bool cd(const std::vector<std::string>& args);
+    bool ls(const std::vector<std::string>& args);
+    bool copy(const std::vector<std::string>& args);
+    bool move(const std::vector<std::string>& args);
+    bool rename(const std::vector<std::string>& args);
+    bool create_directory(const std::vector<std::string>& args);
+    bool create_file(const std::vector<std::string>& args);
+    bool display_permission(const std::vector<std::string>& args);
+    bool get_current_directory(const std::vector<std::string>& args);
+    bool remove(const std::vector<std::string>& args);
+    bool cat(const std::vector<std::string>& args);
+    bool write(const std::vector<std::string>& args);
+    bool grep(const std::vector<std::string>& args);
+    bool head(const std::vector<std::string>& args);
+    bool tree(const std::vector<std::string>& args);
+    bool find(const std::vector<std::string>& args);
+    bool stat(const std::vector<std::string>& args);
 
 private:
     void printDirectoryTree(const std::string& path, const std::string& prefix, int maxDepth, int currentDepth);
-    void findFiles(const std::string& directory, const std::string& pattern);
+    bool findFiles(const std::string& directory, const std::string& pattern);
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "utils/ThreadPool.h"
+
+/**
+ * @class JobControl
+ * @brief Runs command lines in the background and keeps their output
+ *
+ * Each job runs on a work-stealing pool of its own, so a long job never
+ * holds up the shared pool the password manager decrypts with. Whatever a
+ * job writes to CommandIO::out() is kept in a buffer of its own until wait
+ * or fg shows it, or until the job is reported as finished before the next
+ * prompt. Cancelling sets a flag that file and encryption loops poll, so a
+ * job stops at its next checkpoint rather than being torn down mid-write.
+ */
+class JobControl {
+public:
+    enum class JobState { Queued, Running, Done, Failed, Cancelled };
+
+    struct JobInfo {
+        int id;
+        std::string command;
+        JobState state;
+    };
+
+    /**
+     * @brief Runs one command line, returning false if it failed
+     */
+    using Runner = std::function<bool(const std::string&)>;
+
+    /**
+     * @param runner Called on a pool thread for each job
+     * @param threadCount Number of jobs that may run at once, or 0 for the hardware concurrency
+     */
+    explicit JobControl(Runner runner, size_t threadCount = 0);
+
+    /**
+     * @brief Cancels every job and waits for them to stop
+     */
+    ~JobControl();
+
+    JobControl(const JobControl&) = delete;
+    JobControl& operator=(const JobControl&) = delete;
+
+    /**
+     * @brief Queues a command line to run in the background
+     * @return The job's id, counting up from 1
+     */
+    int start(const std::string& line);
+
+    /**
+     * @brief Returns the jobs not yet reported as finished, oldest first
+     */
+    std::vector<JobInfo> list() const;
+
+    /**
+     * @brief Asks a job to stop at its next cancellation checkpoint
+     * @return False if there is no job with that id
+     */
+    bool cancel(int id);
+
+    /**
+     * @brief Streams a job's output until it finishes, then forgets the job
+     * @param id Job to wait for
+     * @param out Receives the output as it is produced and a final status line
+     * @param state Receives how the job ended, or its current state if out stopped taking output
+     * @return False if there is no job with that id
+     */
+    bool wait(int id, std::ostream& out, JobState* state = nullptr);
+
+    /**
+     * @brief Writes a status line and the output of each job that finished unseen
+     */
+    void reportFinished(std::ostream& out);
+
+    /**
+     * @brief Returns the id of the most recently started job still known, or 0
+     */
+    int latest() const;
+
+    /**
+     * @brief Returns true if the calling thread is running one of the jobs
+     */
+    static bool insideJob();
+
+    static const char* stateName(JobState state);
+
+private:
+    struct Job {
+        int id;
+        std::string command;
+        JobState state = JobState::Queued;
+        std::atomic<bool> cancelRequested{false};
+        std::string output;  // Written but not shown yet
+        size_t dropped = 0;  // Bytes discarded while output was full
+    };
+    class OutputBuffer;
+
+    static constexpr size_t kMaxBufferedOutput = 1 << 20;
+
+    void run(const std::shared_ptr<Job>& job);
+    void append(Job& job, const char* data, size_t size);
+    static bool finished(const Job& job);
+    static void writeStatus(std::ostream& out, const Job& job);
+
+    Runner runner;
+    std::map<int, std::shared_ptr<Job>> jobs;
+    int nextId = 1;
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    Utils::ThreadPool pool; // Declared last, so it is joined before the jobs go away
+};
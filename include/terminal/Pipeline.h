@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "CommandParser.h"
+
+/**
+ * @struct PipelineStage
+ * @brief One resolved command of a pipeline
+ */
+struct PipelineStage {
+    std::string command;
+    std::vector<std::string> args;
+};
+
+/**
+ * @class Pipeline
+ * @brief Runs commands connected by '|', each stage on its own thread
+ *
+ * Adjacent stages are joined by a bounded ByteChannel, so data streams
+ * through as it is produced and memory stays flat however much flows.
+ * When a stage returns, its input is closed; the stage feeding it then
+ * fails its next write and stops early, as in "cat big.log | head 20".
+ */
+class Pipeline {
+public:
+    /**
+     * @brief Runs the stages and waits for all of them
+     * @param parser Parser the commands are registered with
+     * @param stages Commands in order, at least one
+     * @param output Where the last stage writes
+     * @return False if any stage's command failed
+     */
+    static bool run(CommandParser& parser, const std::vector<PipelineStage>& stages, std::ostream& output);
+};
@@ -1,20 +1,34 @@
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <istream>
 #include <memory>
 #include <unordered_map>
 #include "CommandParser.h"
+#include "JobControl.h"
 
 
 class CommandImplementation;
+class Completer;
+class CommandHistory;
+class TerminalBackend;
+struct PipelineStage;
 
 class Terminal {
     friend class
     CommandImplementationTest;
     friend class
     CompileAndRunTest;
+    friend class
+    TerminalTest;
 public:
     Terminal();
+
+    /**
+     * @brief Creates a terminal whose interactive loop reads and draws through console
+     */
+    explicit Terminal(TerminalBackend& console);
     ~Terminal();
 
     void start();
@@ -22,18 +36,66 @@ public:
     bool isRunning() const;
 
     const CommandParser& getCommandParser() const { return *commandParser; }
+    JobControl& getJobControl() { return *jobControl; }
+
+    /**
+     * @brief Runs one line without the interactive loop, as for "SecureShell -c"
+     * @return False if a command was unknown or failed
+     */
+    bool runLine(const std::string& line);
+
+    /**
+     * @brief Runs a script line by line without prompt, highlighting or colors
+     *
+     * Blank lines and lines starting with '#' are skipped, and an exit
+     * command ends the script. Also used by the source command.
+     *
+     * @param script Stream of commands, one per line
+     * @param name Shown with the line number when the script stops on an error
+     * @return False if any line failed
+     */
+    bool runScript(std::istream& script, const std::string& name);
+
+    /**
+     * @brief Makes runScript stop at the first failing line
+     */
+    void setExitOnError(bool enabled) { exitOnError = enabled; }
     
 private:
-    void processCommand(const std::string& input);
+    bool processCommand(const std::string& input);
+    bool runPipeline(const std::vector<std::string>& segments);
+    bool resolveStages(const std::vector<std::string>& segments, std::vector<PipelineStage>& stages) const;
+    bool startJob(const std::string& line);
+    /**
+     * @brief Returns true for commands that change state the whole shell shares
+     *
+     * The vault, the working directory, aliases and script nesting are not
+     * guarded, so these never run beside each other or in the background.
+     */
+    static bool changesShellState(const std::string& command);
     void initializeCommands();
+    /**
+     * @brief Edits one line at the prompt
+     * @return False if input ended or the terminal was stopped
+     */
+    bool readLine(std::string& input);
     void displayPrompt() const;
-    void executeCommand(const std::string& command, const std::vector<std::string>& args);
+    bool executeCommand(const std::string& command, const std::vector<std::string>& args);
     void compileAndRun(const std::string& filename);
     void displayHelp() const;
+    void listCandidates(const std::vector<std::string>& candidates) const;
+    bool reverseSearch(std::string& line);
+    bool shouldRemember(const std::string& line) const;
 
 
-    bool running;
+    std::atomic<bool> running; // Background jobs may run exit
+    bool exitOnError = false;
+    int scriptDepth = 0; // Nesting of source commands
+    TerminalBackend& console;
     std::unique_ptr<CommandParser> commandParser;
     std::unique_ptr<CommandImplementation> commandImpl;
     std::unordered_map<std::string, std::string> aliases;
+    std::unique_ptr<Completer> completer; // Declared after aliases, which it refers to
+    std::unique_ptr<CommandHistory> history;
+    std::unique_ptr<JobControl> jobControl; // Declared last, so jobs stop before anything they use goes
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#ifndef _WIN32
+#include <termios.h>
+#endif
+
+/**
+ * @class TerminalBackend
+ * @brief Keyboard input and batched screen output for the line editor
+ *
+ * Output is collected in a frame and sent with flush(), one write for
+ * everything drawn in response to the keys read so far. Colors are ANSI
+ * sequences in the same frame; only a Windows console without virtual
+ * terminal support falls back to SetConsoleTextAttribute. Keys are read in
+ * bulk and decoded into the codes below, so arrows look the same whichever
+ * platform or escape sequence produced them.
+ */
+class TerminalBackend {
+public:
+    enum Key : int {
+        None = -2,       // Nothing typed within the wait, or a sequence with no meaning here
+        EndOfInput = -1, // Input closed, as at the end of a piped script
+        Enter = '\r',
+        Backspace = '\b',
+        Tab = '\t',
+        Escape = 27,
+        Up = 0x100,
+        Down,
+        Left,
+        Right,
+        Home,
+        End,
+        Delete,
+    };
+
+    enum class Color { Default, Banner, Prompt, Command };
+
+    /**
+     * @class RawMode
+     * @brief Reads keys one at a time without echo until destroyed
+     *
+     * Commands run between lines get the console back in its usual mode,
+     * so their own prompts keep working.
+     */
+    class RawMode {
+    public:
+        explicit RawMode(TerminalBackend& backend);
+        ~RawMode();
+
+        RawMode(const RawMode&) = delete;
+        RawMode& operator=(const RawMode&) = delete;
+
+    private:
+        TerminalBackend& backend;
+        bool entered;
+    };
+
+    virtual ~TerminalBackend() = default;
+
+    /**
+     * @brief Returns the backend for the process's console
+     */
+    static TerminalBackend& console();
+
+    /**
+     * @brief Waits for the next key
+     * @param timeoutMs Longest wait in milliseconds, or -1 to wait for a key
+     * @return A character (0 to 255), a Key, None or EndOfInput
+     */
+    virtual int readKey(int timeoutMs = -1) = 0;
+
+    /**
+     * @brief Returns true if keys already read are waiting to be decoded
+     *
+     * The editor flushes once this is false, so a paste is drawn as one frame.
+     */
+    virtual bool hasPendingInput() const = 0;
+
+    void write(std::string_view text) { frame.append(text.data(), text.size()); }
+    void write(char c) { frame.push_back(c); }
+    virtual void setColor(Color color);
+
+    /**
+     * @brief Sends the frame to the screen in one write
+     */
+    void flush();
+
+    /**
+     * @brief Number of writes flush() has made, for measuring batching
+     */
+    size_t writeCount() const { return writes; }
+
+protected:
+    virtual bool enterRawMode() = 0;
+    virtual void leaveRawMode() = 0;
+    virtual void emit(std::string_view bytes) = 0;
+
+    std::string frame;
+
+private:
+    size_t writes = 0;
+};
+
+#ifndef _WIN32
+
+/**
+ * @class PosixTerminalBackend
+ * @brief termios raw mode on a pair of file descriptors
+ *
+ * Input is read up to 4 KB at a time and ANSI escape sequences for the
+ * arrow and editing keys are decoded. When the input is not a terminal,
+ * as with a pipe, raw mode is skipped and bytes are decoded the same way.
+ */
+class PosixTerminalBackend : public TerminalBackend {
+public:
+    PosixTerminalBackend(int inputFd, int outputFd);
+    ~PosixTerminalBackend() override;
+
+    int readKey(int timeoutMs = -1) override;
+    bool hasPendingInput() const override { return start < end; }
+
+protected:
+    bool enterRawMode() override;
+    void leaveRawMode() override;
+    void emit(std::string_view bytes) override;
+
+private:
+    bool fill(int timeoutMs);
+    int decodeEscape();
+
+    int inputFd;
+    int outputFd;
+    bool closed = false;
+    bool raw = false;
+    termios savedMode;
+    char input[4096];
+    size_t start = 0;
+    size_t end = 0;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+
+namespace Utils {
+
+/**
+ * @class OperationCancelled
+ * @brief Thrown from a cancellation checkpoint once a stop was requested
+ */
+class OperationCancelled : public std::runtime_error {
+public:
+    OperationCancelled() : std::runtime_error("Operation cancelled") {}
+};
+
+/**
+ * @class Cancellation
+ * @brief Per-thread flag that long-running loops poll to stop early
+ *
+ * A background job installs its flag with a Scope on the thread running it.
+ * Loops over files and buffers call requested() or checkpoint() every so
+ * often; outside a Scope neither ever reports a stop.
+ */
+class Cancellation {
+public:
+    /**
+     * @class Scope
+     * @brief Watches a flag on the calling thread until destroyed
+     */
+    class Scope {
+    public:
+        explicit Scope(const std::atomic<bool>* flag);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const std::atomic<bool>* previous;
+    };
+
+    /**
+     * @brief Returns the flag watched by the calling thread, or null
+     */
+    static const std::atomic<bool>* current();
+
+    /**
+     * @brief Returns true if the current operation should stop
+     */
+    static bool requested();
+
+    /**
+     * @brief Throws OperationCancelled if the current operation should stop
+     */
+    static void checkpoint();
+};
+
+} // namespace Utils
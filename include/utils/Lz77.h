@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Utils {
+
+/**
+ * @class Lz77
+ * @brief Small, fast LZ77 block compressor in the style of LZ4
+ *
+ * Each sequence is a token byte (literal count high nibble, match length
+ * minus 4 low nibble, 15 meaning more length bytes follow), the literals,
+ * then a 16-bit little-endian match offset. The block ends with a
+ * literals-only sequence. Matches are found through a single hash table
+ * probe per position, trading ratio for speed.
+ */
+class Lz77 {
+public:
+    /**
+     * @brief Compresses size bytes, replacing the contents of output
+     */
+    static void compress(const uint8_t* input, size_t size, std::vector<uint8_t>& output);
+
+    /**
+     * @brief Decompresses a block produced by compress()
+     * @param input The compressed block
+     * @param size Its length in bytes
+     * @param originalSize The exact decompressed length
+     * @param output Receives the decompressed bytes
+     * @return False if the block is malformed or does not decode to originalSize bytes
+     */
+    static bool decompress(const uint8_t* input, size_t size, size_t originalSize, std::vector<uint8_t>& output);
+};
+
+} // namespace Utils
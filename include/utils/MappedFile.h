@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Utils {
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory map of a whole file
+ *
+ * Pages are read in by the operating system as they are touched, so opening
+ * a large file costs the same as opening a small one. The view covers the
+ * file as it was when opened; later appends are not seen.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file, replacing any file mapped before
+     * @return False if the file cannot be opened or mapped
+     */
+    bool open(const std::string& path);
+
+    void close();
+
+    /**
+     * @brief Contents of the file, empty if none is mapped
+     */
+    std::string_view view() const { return std::string_view(data, size); }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
+} // namespace Utils
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace Utils {
+
+/**
+ * @class PasswordStrength
+ * @brief Table-driven password classification and entropy estimation
+ *
+ * Both functions make a single pass over the password through a constexpr
+ * 256-entry character table, so they are cheap enough to run on every entry
+ * of a bulk import or audit.
+ */
+class PasswordStrength {
+public:
+    enum CharClass : uint8_t {
+        Lower = 1,
+        Upper = 2,
+        Digit = 4,
+        Symbol = 8, // Printable ASCII punctuation
+        Other = 16, // Spaces, control characters and non-ASCII bytes
+        Letter = Lower | Upper
+    };
+
+    /**
+     * @brief Returns the CharClass bits of every character in the password
+     */
+    static uint8_t classify(std::string_view password);
+
+    /**
+     * @brief Estimates the entropy of a password in bits
+     *
+     * Finds the cheapest way to cover the password with dictionary words and
+     * single characters. A word costs log2 of its rank in the embedded list of
+     * common passwords, words and keyboard walks, plus a bit for each l33t
+     * substitution (p@ssw0rd) and for capitalisation. A single character costs
+     * log2 of the character classes in use, or nothing when it repeats or
+     * continues a sequence (aaa, abc, 321).
+     */
+    static double estimateEntropy(std::string_view password);
+};
+
+} // namespace Utils
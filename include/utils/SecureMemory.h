@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+
+namespace Utils {
+
+/**
+ * @brief Zeroes memory in a way the compiler may not optimize away
+ */
+void secureWipe(void* data, size_t size);
+
+/**
+ * @class SecurePool
+ * @brief Fixed region of locked memory handed out in power-of-two size classes
+ *
+ * The region is reserved once and locked into RAM (mlock, or VirtualLock on
+ * Windows) so secrets held in it never reach swap. Released blocks are
+ * wiped and kept on a free list per size class, so steady-state use never
+ * touches the heap. Requests larger than kMaxBlock, or made once the region
+ * is used up, fall back to the heap; those blocks are still wiped on release
+ * but are not locked.
+ */
+class SecurePool {
+public:
+    static constexpr size_t kPoolSize = 64 * 1024; // Within the default RLIMIT_MEMLOCK
+    static constexpr size_t kMinBlock = 16;
+    static constexpr size_t kMaxBlock = 4096;
+
+    struct Stats {
+        size_t poolSize = 0;
+        bool locked = false;   // Whether the region could be locked into RAM
+        size_t blocksInUse = 0;
+        size_t heapBlocks = 0; // Blocks that did not fit in the region, in use now
+    };
+
+    /**
+     * @brief Returns the process-wide pool
+     *
+     * The pool is never destroyed, so secrets in static objects may still be
+     * released into it during exit.
+     */
+    static SecurePool& shared();
+
+    SecurePool(const SecurePool&) = delete;
+    SecurePool& operator=(const SecurePool&) = delete;
+
+    /**
+     * @brief Allocates a zero-filled block
+     * @param size Bytes needed
+     * @param capacity Receives the usable size of the block, at least size
+     */
+    void* allocate(size_t size, size_t& capacity);
+
+    /**
+     * @brief Wipes a block and returns it to its free list
+     * @param block A block from allocate()
+     * @param capacity The capacity allocate() reported for it
+     */
+    void release(void* block, size_t capacity);
+
+    Stats stats() const;
+
+private:
+    static constexpr size_t kClasses = 9; // 16 bytes to 4 KB
+
+    SecurePool();
+
+    static size_t classOf(size_t size);
+    bool owns(const void* block) const;
+
+    uint8_t* region;
+    size_t used;
+    bool locked;
+    void* freeLists[kClasses]; // Each free block starts with the next one's address
+    size_t blocksInUse;
+    size_t heapBlocks;
+    mutable std::mutex mutex;
+};
+
+/**
+ * @class SecureBuffer
+ * @brief Move-only byte buffer in SecurePool memory, wiped when released
+ */
+class SecureBuffer {
+public:
+    SecureBuffer() = default;
+    explicit SecureBuffer(size_t size);
+    ~SecureBuffer();
+
+    SecureBuffer(SecureBuffer&& other) noexcept;
+    SecureBuffer& operator=(SecureBuffer&& other) noexcept;
+    SecureBuffer(const SecureBuffer&) = delete;
+    SecureBuffer& operator=(const SecureBuffer&) = delete;
+
+    uint8_t* data() { return bytes; }
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+    size_t capacity() const { return reserved; }
+    bool empty() const { return length == 0; }
+
+    /**
+     * @brief Changes the size, keeping the contents; new bytes are zero
+     *
+     * Growing past the capacity moves the contents to a larger block and
+     * wipes the old one.
+     */
+    void resize(size_t size);
+
+    /**
+     * @brief Wipes the contents and returns the block to the pool
+     */
+    void clear();
+
+private:
+    uint8_t* bytes = nullptr;
+    size_t length = 0;
+    size_t reserved = 0;
+};
+
+/**
+ * @class SecureString
+ * @brief Move-only, NUL-terminated string in SecurePool memory
+ *
+ * Used for decrypted passwords and keys. Converts to std::string_view so it
+ * can be passed where a key or password is read; copying one out into a
+ * std::string should be left to the final consumer, such as the terminal.
+ */
+class SecureString {
+public:
+    SecureString() = default;
+    explicit SecureString(std::string_view text);
+
+    SecureString(SecureString&&) noexcept = default;
+    SecureString& operator=(SecureString&&) noexcept = default;
+
+    const char* data() const { return buffer.empty() ? "" : reinterpret_cast<const char*>(buffer.data()); }
+    char* data() { return reinterpret_cast<char*>(buffer.data()); }
+    const char* c_str() const { return data(); }
+    size_t size() const { return buffer.empty() ? 0 : buffer.size() - 1; }
+    bool empty() const { return size() == 0; }
+
+    char& operator[](size_t i) { return data()[i]; }
+    char operator[](size_t i) const { return data()[i]; }
+
+    std::string_view view() const { return std::string_view(data(), size()); }
+    operator std::string_view() const { return view(); }
+
+    void assign(std::string_view text);
+    void append(std::string_view text);
+    void push_back(char c);
+    void pop_back();
+    void resize(size_t size);
+    void clear() { buffer.clear(); }
+
+    /**
+     * @brief Compares in time independent of where the strings differ
+     */
+    bool equals(std::string_view other) const;
+
+    friend bool operator==(const SecureString& a, const SecureString& b) { return a.view() == b.view(); }
+    friend bool operator==(const SecureString& a, std::string_view b) { return a.view() == b; }
+    friend bool operator!=(const SecureString& a, std::string_view b) { return a.view() != b; }
+    friend bool operator==(std::string_view a, const SecureString& b) { return a == b.view(); }
+    friend bool operator!=(std::string_view a, const SecureString& b) { return a != b.view(); }
+    friend std::ostream& operator<<(std::ostream& out, const SecureString& text) { return out << text.view(); }
+
+private:
+    SecureBuffer buffer; // size() + 1 bytes, the last one NUL
+};
+
+} // namespace Utils
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Utils {
+
+/**
+ * @class SecureRandom
+ * @brief Buffered ChaCha20 CSPRNG, one instance per thread
+ *
+ * Each thread's generator is seeded once from the operating system
+ * (getrandom, or BCryptGenRandom on Windows) and then produces output in
+ * 4 KB blocks. The first 32 bytes of every block become the next key, so
+ * bytes already handed out cannot be recovered from a later state. A
+ * pthread_atfork handler makes the forked child reseed on its next draw.
+ */
+class SecureRandom {
+public:
+    /**
+     * @brief Returns the calling thread's generator
+     */
+    static SecureRandom& local();
+
+    SecureRandom(const SecureRandom&) = delete;
+    SecureRandom& operator=(const SecureRandom&) = delete;
+
+    /**
+     * @brief Fills a buffer with random bytes
+     */
+    void fill(uint8_t* output, size_t size);
+
+    /**
+     * @brief Returns a uniformly distributed value in [0, bound)
+     * @param bound Exclusive upper bound, must be non-zero
+     */
+    uint32_t uniform(uint32_t bound);
+
+    /**
+     * @brief Writes length characters drawn uniformly from charset
+     * @param charset Between 1 and 256 candidate characters
+     * @param output Receives exactly length characters
+     *
+     * Uses byte rejection sampling, so there is no modulo bias for
+     * character sets whose size does not divide 256.
+     */
+    void sample(std::string_view charset, char* output, size_t length);
+
+    std::string sample(std::string_view charset, size_t length);
+
+private:
+    SecureRandom();
+    ~SecureRandom();
+
+    void reseed();
+    void checkFork();
+    void refill();
+
+    static constexpr size_t kBufferSize = 4096;
+
+    uint32_t key[8];
+    uint8_t buffer[kBufferSize];
+    size_t position;
+    unsigned forkGeneration; // Forks seen when last seeded
+};
+
+} // namespace Utils
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utils {
+
+/**
+ * @class ThreadPool
+ * @brief Fixed-size, work-stealing pool of worker threads
+ *
+ * Each worker owns a deque. Tasks submitted from a worker go on its own
+ * deque and are taken newest first, which keeps nested work hot in cache;
+ * tasks submitted from other threads go on a shared queue. An idle worker
+ * takes from the shared queue, then steals the oldest task of another
+ * worker. parallelFor() splits an index range into batches and runs
+ * queued tasks itself while it waits, so it may be called from inside a
+ * task (a background job that decrypts in bulk) without deadlocking.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Creates a pool with the given number of workers
+     * @param threadCount Number of workers, or 0 to use the hardware concurrency
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queues a task for execution on a worker thread
+     * @param task The callable to run
+     * @return A future that becomes ready once the task has finished
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return result;
+    }
+
+    /**
+     * @brief Runs body(begin, end) over [0, count) in batches of batchSize
+     * @param count Number of items to process
+     * @param batchSize Maximum number of items handed to a single call of body
+     * @param body Callable invoked once per batch, possibly concurrently
+     *
+     * Exceptions thrown by body are rethrown on the calling thread once all
+     * batches have finished.
+     */
+    void parallelFor(size_t count, size_t batchSize,
+                     const std::function<void(size_t begin, size_t end)>& body);
+
+    /**
+     * @brief Returns the number of worker threads
+     */
+    size_t size() const { return workers.size(); }
+
+    /**
+     * @brief Returns a process-wide pool sized to the hardware concurrency
+     */
+    static ThreadPool& shared();
+
+private:
+    struct WorkQueue {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    void enqueue(std::function<void()> task);
+    void workerLoop(size_t index);
+    bool takeTask(size_t index, std::function<void()>& task);
+
+    /**
+     * @brief Runs one queued task on the calling thread, if there is one
+     */
+    bool runPendingTask();
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> local; // One per worker
+    WorkQueue injected;                            // Submitted from outside the pool
+    std::atomic<long> queued;                      // Tasks waiting in any queue
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool stopping;
+};
+
+} // namespace Utils
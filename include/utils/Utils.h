@@ -1,10 +1,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <random>
 #include <chrono>
 #include <filesystem>
+#include "utils/SecureMemory.h"
 
 namespace Utils {
     // File and path operations
@@ -13,6 +15,8 @@ namespace Utils {
     std::string getCurrentDirectory();
     bool changeDirectory(const std::string& path);
     std::vector<std::string> listDirectory(const std::string& path);
+    bool syncFile(const std::string& path);      // Waits until the file's contents reach the disk
+    bool syncDirectory(const std::string& path); // Same for names created, renamed or removed in it; no-op on Windows
 
     // String operations
     std::string trim(const std::string& str);
@@ -20,11 +24,16 @@ namespace Utils {
     std::string toLower(const std::string& str);
     std::string toUpper(const std::string& str);
 
+    // Splits a command line into words as the shell does (see CommandParser::tokenize);
+    // buffer receives a copy of input that the words point into
+    void splitWords(std::string_view input, std::string& buffer, std::vector<std::string_view>& words);
+    bool isWordEscapable(char c); // Escaped by a backslash outside quotes in splitWords
+
     // Random number generation
     std::string generateRandomString(size_t length);
     
     // Password utilities
-    std::string readMaskedPassword();
-    bool validatePasswordStrength(const std::string& password);
+    SecureString readMaskedPassword(); // Typed straight into locked memory
+    bool validatePasswordStrength(std::string_view password);
 
 };
\ No newline at end of file
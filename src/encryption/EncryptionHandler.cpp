@@ -1,14 +1,27 @@
 #include "encryption/EncryptionHandler.h"
+#include "utils/Cancellation.h"
+#include <algorithm>
 #include <stdexcept>
 
+namespace {
+
+// Bytes processed between cancellation checks, so a large file stops promptly
+constexpr size_t kCheckpointInterval = 1 << 20;
+
+} // namespace
+
 EncryptionHandler::EncryptionHandler() {}
 
 std::vector<uint8_t> EncryptionHandler::xorEncrypt(const std::vector<uint8_t>& data, const std::string& key) const {
     std::vector<uint8_t> result = data;
     const size_t keyLength = key.length();
     
-    for (size_t i = 0; i < data.size(); ++i) {
-        result[i] = data[i] ^ static_cast<uint8_t>(key[i % keyLength]);
+    for (size_t start = 0; start < data.size(); start += kCheckpointInterval) {
+        Utils::Cancellation::checkpoint();
+        const size_t end = std::min(data.size(), start + kCheckpointInterval);
+        for (size_t i = start; i < end; ++i) {
+            result[i] = data[i] ^ static_cast<uint8_t>(key[i % keyLength]);
+        }
     }
     
     return result;
@@ -17,8 +30,12 @@ std::vector<uint8_t> EncryptionHandler::xorEncrypt(const std::vector<uint8_t>& d
 std::vector<uint8_t> EncryptionHandler::caesarEncrypt(const std::vector<uint8_t>& data, int shift) const {
     std::vector<uint8_t> result = data;
     
-    for (size_t i = 0; i < data.size(); ++i) {
-        result[i] = static_cast<uint8_t>((static_cast<int>(data[i]) + shift) % 256);
+    for (size_t start = 0; start < data.size(); start += kCheckpointInterval) {
+        Utils::Cancellation::checkpoint();
+        const size_t end = std::min(data.size(), start + kCheckpointInterval);
+        for (size_t i = start; i < end; ++i) {
+            result[i] = static_cast<uint8_t>((static_cast<int>(data[i]) + shift) % 256);
+        }
     }
     
     return result;
@@ -27,14 +44,18 @@ std::vector<uint8_t> EncryptionHandler::caesarEncrypt(const std::vector<uint8_t>
 std::vector<uint8_t> EncryptionHandler::caesarDecrypt(const std::vector<uint8_t>& data, int shift) const {
     std::vector<uint8_t> result = data;
     
-    for (size_t i = 0; i < data.size(); ++i) {
-        result[i] = static_cast<uint8_t>((static_cast<int>(data[i]) - shift + 256) % 256);
+    for (size_t start = 0; start < data.size(); start += kCheckpointInterval) {
+        Utils::Cancellation::checkpoint();
+        const size_t end = std::min(data.size(), start + kCheckpointInterval);
+        for (size_t i = start; i < end; ++i) {
+            result[i] = static_cast<uint8_t>((static_cast<int>(data[i]) - shift + 256) % 256);
+        }
     }
     
     return result;
 }
 
-int EncryptionHandler::generateShift(const std::string& password) const {
+int EncryptionHandler::generateShift(std::string_view password) const {
     int shift = 0;
     for (char c : password) {
         shift += static_cast<int>(c);
@@ -42,10 +63,11 @@ int EncryptionHandler::generateShift(const std::string& password) const {
     return (shift % 255) + 1; // Ensure shift is between 1-255
 }
 
-std::string EncryptionHandler::generateFileKey(const std::string& password, size_t blockSize) const {
-    std::string key = password;
-    while (key.length() < blockSize) {
-        key += password;
+std::string EncryptionHandler::generateFileKey(std::string_view password, size_t blockSize) const {
+    // Built in place: the key is the password repeated, so avoid leaving partial copies behind
+    std::string key(blockSize, '\0');
+    for (size_t i = 0; i < blockSize && !password.empty(); ++i) {
+        key[i] = password[i % password.size()];
     }
-    return key.substr(0, blockSize);
+    return key;
 }
\ No newline at end of file
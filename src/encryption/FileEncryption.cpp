@@ -1,5 +1,6 @@
 #include "encryption/FileEncryption.h"
 #include "encryption/EncryptionHandler.h"
+#include "utils/SecureMemory.h"
 #include <fstream>
 #include <stdexcept>
 #include <vector>
@@ -56,6 +57,47 @@ bool FileEncryption::isFileEncrypted(const std::string& filename) const {
     return false;
 }
 
+std::vector<uint8_t> FileEncryption::encryptData(const std::vector<uint8_t>& data, std::string_view password) const {
+    std::vector<uint8_t> finalData(ENCRYPTION_MARKER.begin(), ENCRYPTION_MARKER.end());
+    finalData.insert(finalData.end(), data.begin(), data.end());
+
+    // Use EncryptionHandler for encryption operations
+    std::string key = encryptionHandler->generateFileKey(password, BLOCK_SIZE);
+    int shift = encryptionHandler->generateShift(password);
+
+    auto xorResult = encryptionHandler->xorEncrypt(finalData, key);
+    Utils::secureWipe(&key[0], key.size());
+    Utils::secureWipe(finalData.data(), finalData.size());
+    return encryptionHandler->caesarEncrypt(xorResult, shift);
+}
+
+bool FileEncryption::decryptData(const std::vector<uint8_t>& data, std::string_view password, std::vector<uint8_t>& output) const {
+    if (data.size() < ENCRYPTION_MARKER.length()) {
+        return false;
+    }
+
+    // Use EncryptionHandler for decryption operations
+    std::string key = encryptionHandler->generateFileKey(password, BLOCK_SIZE);
+    int shift = encryptionHandler->generateShift(password);
+
+    auto caesarResult = encryptionHandler->caesarDecrypt(data, shift);
+    auto xorResult = encryptionHandler->xorEncrypt(caesarResult, key); // XOR is its own inverse
+    Utils::secureWipe(&key[0], key.size());
+
+    if (xorResult.size() < ENCRYPTION_MARKER.length()) {
+        return false;
+    }
+
+    std::string decryptedMarker(xorResult.begin(), xorResult.begin() + ENCRYPTION_MARKER.length());
+    if (decryptedMarker != ENCRYPTION_MARKER) {
+        return false;
+    }
+
+    output.assign(xorResult.begin() + ENCRYPTION_MARKER.length(), xorResult.end());
+    Utils::secureWipe(xorResult.data(), xorResult.size());
+    return true;
+}
+
 bool FileEncryption::encryptFile(const std::string& inputFile, const std::string& outputFile, const std::string& password) const {
     try {
         std::vector<uint8_t> data;
@@ -63,18 +105,7 @@ bool FileEncryption::encryptFile(const std::string& inputFile, const std::string
             return false;
         }
         
-        std::vector<uint8_t> markerData(ENCRYPTION_MARKER.begin(), ENCRYPTION_MARKER.end());
-        std::vector<uint8_t> finalData = markerData;
-        finalData.insert(finalData.end(), data.begin(), data.end());
-        
-        // Use EncryptionHandler for encryption operations
-        std::string key = encryptionHandler->generateFileKey(password, BLOCK_SIZE);
-        int shift = encryptionHandler->generateShift(password);
-        
-        auto xorResult = encryptionHandler->xorEncrypt(finalData, key);
-        auto caesarResult = encryptionHandler->caesarEncrypt(xorResult, shift);
-        
-        return writeFile(outputFile, caesarResult);
+        return writeFile(outputFile, encryptData(data, password));
     } catch (const std::exception& e) {
         return false;
     }
@@ -87,30 +118,13 @@ bool FileEncryption::decryptFile(const std::string& inputFile, const std::string
             return false;
         }
         
-        if (data.size() < ENCRYPTION_MARKER.length()) {
+        std::vector<uint8_t> finalData;
+        if (!decryptData(data, password, finalData)) {
             return false;
         }
         
-        // Use EncryptionHandler for decryption operations
-        std::string key = encryptionHandler->generateFileKey(password, BLOCK_SIZE);
-        int shift = encryptionHandler->generateShift(password);
-        
-        auto caesarResult = encryptionHandler->caesarDecrypt(data, shift);
-        auto xorResult = encryptionHandler->xorEncrypt(caesarResult, key); // XOR is its own inverse
-        
-        if (xorResult.size() < ENCRYPTION_MARKER.length()) {
-            return false;
-        }
-        
-        std::string decryptedMarker(xorResult.begin(), xorResult.begin() + ENCRYPTION_MARKER.length());
-        if (decryptedMarker != ENCRYPTION_MARKER) {
-            return false;
-        }
-        
-        std::vector<uint8_t> finalData(xorResult.begin() + ENCRYPTION_MARKER.length(), xorResult.end());
-        
         return writeFile(outputFile, finalData);
     } catch (const std::exception& e) {
         return false;
     }
-}
\ No newline at end of file
+}
@@ -1,13 +1,58 @@
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
 #include "terminal/Terminal.h"
 
-int main() {
+namespace {
+
+void printUsage() {
+    std::cerr << "Usage: SecureShell                 Start the interactive terminal\n"
+              << "       SecureShell [-e] -c <line>  Run one command line\n"
+              << "       SecureShell [-e] <script>   Run a script, one command per line\n"
+              << "  -e  Stop at the first failing command\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
     try {
         auto terminal = std::make_unique<Terminal>();
-        terminal->start();
-        
-        return 0;
+        if (argc == 1) {
+            terminal->start();
+            return 0;
+        }
+
+        int arg = 1;
+        if (std::string(argv[arg]) == "-e") {
+            terminal->setExitOnError(true);
+            ++arg;
+        }
+        if (arg >= argc) {
+            printUsage();
+            return 2;
+        }
+
+        // Exit status 1 when any command failed, for use from automation
+        std::string mode = argv[arg];
+        if (mode == "-c") {
+            if (arg + 1 >= argc) {
+                printUsage();
+                return 2;
+            }
+            return terminal->runLine(argv[arg + 1]) ? 0 : 1;
+        }
+        if (mode == "-h" || mode == "--help") {
+            printUsage();
+            return 0;
+        }
+
+        std::ifstream script(mode);
+        if (!script.is_open()) {
+            std::cerr << "Cannot open script '" << mode << "'\n";
+            return 2;
+        }
+        return terminal->runScript(script, mode) ? 0 : 1;
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
         return 1;
@@ -0,0 +1,453 @@
+#include "passman/ChunkStore.h"
+#include "passman/HexCodec.h"
+#include "utils/Lz77.h"
+#include "utils/SecureRandom.h"
+#include "utils/ThreadPool.h"
+#include "utils/Utils.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+namespace passman {
+
+namespace {
+
+constexpr size_t kReadWindow = 4 * 1024 * 1024;
+constexpr size_t kIdLength = 64; // Hex HMAC-SHA256
+constexpr char kRecipeHeader[] = "SSREC 1\n";
+
+// Per-byte values for the gear rolling hash, fixed so chunk boundaries
+// (and with them deduplication) are stable across builds
+constexpr std::array<uint64_t, 256> makeGearTable() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x5353484541524348ull;
+    for (auto& value : table) {
+        state += 0x9e3779b97f4a7c15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        value = z ^ (z >> 31);
+    }
+    return table;
+}
+
+constexpr std::array<uint64_t, 256> kGear = makeGearTable();
+
+bool isHexId(std::string_view id) {
+    return id.size() == kIdLength && std::all_of(id.begin(), id.end(), [](unsigned char c) {
+        return std::isdigit(c) || (c >= 'a' && c <= 'f');
+    });
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Writes through a uniquely named temporary so readers never see a partial file
+bool writeFileAtomically(const std::string& path, const std::vector<uint8_t>& data) {
+    std::string staged = path + ".tmp" + std::to_string(Utils::SecureRandom::local().uniform(UINT32_MAX));
+    std::ofstream stream(staged, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        return false;
+    }
+    stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    stream.close();
+
+    std::error_code ec;
+    if (stream.fail() || !Utils::syncFile(staged)) {
+        std::filesystem::remove(staged, ec);
+        return false;
+    }
+    std::filesystem::rename(staged, path, ec);
+    if (ec) {
+        std::filesystem::remove(staged, ec);
+        return false;
+    }
+    return Utils::syncDirectory(std::filesystem::path(path).parent_path().string());
+}
+
+} // namespace
+
+ChunkStore::ChunkStore(const std::string& dataDir)
+    : chunkDir(dataDir + "chunks/"),
+      keyFile(dataDir + "chunks/key") {
+}
+
+ChunkStore::~ChunkStore() {
+    close();
+}
+
+bool ChunkStore::isValidName(std::string_view name) {
+    return !name.empty() && name.size() <= 128 && std::all_of(name.begin(), name.end(), [](unsigned char c) {
+        return std::isalnum(c) || c == '.' || c == '_' || c == '-';
+    });
+}
+
+std::string ChunkStore::formatRefs(const std::vector<AttachmentRef>& refs) {
+    std::string text;
+    for (const auto& ref : refs) {
+        if (!text.empty()) {
+            text += ',';
+        }
+        text += ref.name + ':' + std::to_string(ref.size) + ':' + ref.recipe;
+    }
+    return text;
+}
+
+bool ChunkStore::parseRefs(std::string_view text, std::vector<AttachmentRef>& refs) {
+    refs.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = std::min(text.find(',', start), text.size());
+        std::string_view item = text.substr(start, end - start);
+        start = end + 1;
+
+        size_t first = item.find(':');
+        size_t second = first == std::string_view::npos ? first : item.find(':', first + 1);
+        if (second == std::string_view::npos) {
+            return false;
+        }
+        AttachmentRef ref;
+        ref.name = std::string(item.substr(0, first));
+        ref.recipe = std::string(item.substr(second + 1));
+        std::string size(item.substr(first + 1, second - first - 1));
+        if (!isValidName(ref.name) || !isHexId(ref.recipe) || size.empty() ||
+            !std::all_of(size.begin(), size.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return false;
+        }
+        ref.size = std::stoull(size);
+        refs.push_back(std::move(ref));
+    }
+    return true;
+}
+
+bool ChunkStore::open(std::string_view vaultKey) {
+    close();
+
+    // key.tmp<N> is a crashed write of a new key; key.tmp itself belongs to the vault commit
+    std::error_code ec;
+    const std::string stray = std::filesystem::path(keyFile).filename().string() + ".tmp";
+    for (std::filesystem::directory_iterator it(chunkDir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.size() > stray.size() && name.compare(0, stray.size(), stray) == 0) {
+            std::error_code removeError;
+            std::filesystem::remove(it->path(), removeError);
+        }
+    }
+
+    std::vector<uint8_t> stored;
+    Utils::SecureString key;
+    if (readFile(keyFile, stored)) {
+        std::vector<uint8_t> plain;
+        if (!encryptor.decryptData(stored, vaultKey, plain)) {
+            return false;
+        }
+        key.assign(std::string_view(reinterpret_cast<const char*>(plain.data()), plain.size()));
+        Utils::secureWipe(plain.data(), plain.size());
+        if (!isHexId(key)) {
+            return false;
+        }
+    } else {
+        uint8_t raw[32];
+        Utils::SecureRandom::local().fill(raw, sizeof(raw));
+        key.resize(kIdLength);
+        HexCodec::encode(raw, sizeof(raw), key.data());
+        Utils::secureWipe(raw, sizeof(raw));
+
+        std::filesystem::create_directories(chunkDir, ec);
+        std::vector<uint8_t> plain(key.data(), key.data() + key.size());
+        bool written = writeFileAtomically(keyFile, encryptor.encryptData(plain, vaultKey));
+        Utils::secureWipe(plain.data(), plain.size());
+        if (!written) {
+            return false;
+        }
+    }
+
+    contentKey = std::move(key);
+    mac = std::make_unique<HmacSha256>(reinterpret_cast<const uint8_t*>(contentKey.data()), contentKey.size());
+    return true;
+}
+
+void ChunkStore::close() {
+    contentKey.clear();
+    mac.reset();
+}
+
+bool ChunkStore::stageRekey(std::string_view oldVaultKey, std::string_view newVaultKey,
+                            std::vector<std::string>& staged) const {
+    std::vector<uint8_t> stored;
+    if (!readFile(keyFile, stored)) {
+        return true; // No attachments yet
+    }
+    std::vector<uint8_t> plain;
+    if (!encryptor.decryptData(stored, oldVaultKey, plain)) {
+        return false;
+    }
+    std::vector<uint8_t> wrapped = encryptor.encryptData(plain, newVaultKey);
+    Utils::secureWipe(plain.data(), plain.size());
+
+    std::string path = keyFile + ".tmp";
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        return false;
+    }
+    stream.write(reinterpret_cast<const char*>(wrapped.data()), static_cast<std::streamsize>(wrapped.size()));
+    stream.close();
+    if (stream.fail() || !Utils::syncFile(path)) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return false;
+    }
+    staged.push_back(keyFile);
+    return true;
+}
+
+bool ChunkStore::write(std::istream& input, std::string& recipe, uint64_t& size, ChunkWriteStats* stats) const {
+    if (!isOpen()) {
+        return false;
+    }
+
+    ChunkWriteStats totals;
+    std::string recipeText;
+    std::vector<uint8_t> buffer(kReadWindow);
+    size_t filled = 0;
+    bool eof = false;
+    size = 0;
+
+    while (true) {
+        if (!eof) {
+            input.read(reinterpret_cast<char*>(buffer.data() + filled), static_cast<std::streamsize>(buffer.size() - filled));
+            size_t count = static_cast<size_t>(input.gcount());
+            filled += count;
+            size += count;
+            if (input.eof()) {
+                eof = true;
+            } else if (!input) {
+                return false;
+            }
+        }
+
+        // Only cut where the boundary cannot depend on bytes not read yet
+        std::vector<std::pair<size_t, size_t>> spans;
+        size_t pos = 0;
+        while (pos < filled && (eof || filled - pos >= kMaxChunk)) {
+            size_t length = cutPoint(buffer.data() + pos, filled - pos);
+            spans.emplace_back(pos, length);
+            pos += length;
+        }
+
+        std::vector<std::string> ids(spans.size());
+        Utils::ThreadPool::shared().parallelFor(spans.size(), 4, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                ids[i] = chunkId(buffer.data() + spans[i].first, spans[i].second);
+            }
+        });
+
+        // Store each distinct chunk once, even when a blob repeats itself
+        std::vector<size_t> unique;
+        std::unordered_set<std::string> seen;
+        for (size_t i = 0; i < spans.size(); ++i) {
+            if (seen.insert(ids[i]).second) {
+                unique.push_back(i);
+            }
+        }
+        std::vector<long long> written(unique.size());
+        Utils::ThreadPool::shared().parallelFor(unique.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto& span = spans[unique[i]];
+                written[i] = storeChunk(ids[unique[i]], buffer.data() + span.first, span.second);
+            }
+        });
+        for (long long bytes : written) {
+            if (bytes < 0) {
+                return false;
+            }
+            if (bytes > 0) {
+                ++totals.newChunks;
+                totals.storedBytes += static_cast<uint64_t>(bytes);
+            }
+        }
+
+        for (size_t i = 0; i < spans.size(); ++i) {
+            recipeText += ids[i] + ' ' + std::to_string(spans[i].second) + '\n';
+        }
+        totals.chunks += spans.size();
+
+        std::memmove(buffer.data(), buffer.data() + pos, filled - pos);
+        filled -= pos;
+        if (eof && filled == 0) {
+            break;
+        }
+    }
+
+    recipeText = kRecipeHeader + std::to_string(size) + '\n' + recipeText;
+    recipe = chunkId(reinterpret_cast<const uint8_t*>(recipeText.data()), recipeText.size());
+    long long bytes = storeChunk(recipe, reinterpret_cast<const uint8_t*>(recipeText.data()), recipeText.size());
+    if (bytes < 0) {
+        return false;
+    }
+    if (stats) {
+        *stats = totals;
+    }
+    return true;
+}
+
+bool ChunkStore::read(const std::string& recipe, std::ostream& output) const {
+    std::vector<uint8_t> recipeData;
+    if (!isOpen() || !isHexId(recipe) || !loadChunk(recipe, recipeData)) {
+        return false;
+    }
+
+    std::string_view text(reinterpret_cast<const char*>(recipeData.data()), recipeData.size());
+    const size_t headerLength = sizeof(kRecipeHeader) - 1;
+    if (text.compare(0, headerLength, kRecipeHeader) != 0) {
+        return false;
+    }
+    text.remove_prefix(headerLength);
+
+    std::vector<std::pair<std::string, size_t>> chunks;
+    uint64_t expected = 0;
+    bool first = true;
+    while (!text.empty()) {
+        size_t newline = std::min(text.find('\n'), text.size());
+        std::string line(text.substr(0, newline));
+        text.remove_prefix(std::min(newline + 1, text.size()));
+        try {
+            if (first) {
+                expected = std::stoull(line);
+                first = false;
+                continue;
+            }
+            size_t space = line.find(' ');
+            if (space != kIdLength || !isHexId(line.substr(0, space))) {
+                return false;
+            }
+            chunks.emplace_back(line.substr(0, space), std::stoull(line.substr(space + 1)));
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    // Fetch a few chunks at a time in parallel, writing them out in order
+    const size_t batch = 16;
+    std::vector<std::vector<uint8_t>> loaded(batch);
+    uint64_t total = 0;
+    for (size_t start = 0; start < chunks.size(); start += batch) {
+        size_t count = std::min(batch, chunks.size() - start);
+        std::atomic<bool> valid{true};
+        Utils::ThreadPool::shared().parallelFor(count, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto& chunk = chunks[start + i];
+                if (!loadChunk(chunk.first, loaded[i]) || loaded[i].size() != chunk.second) {
+                    valid = false;
+                }
+            }
+        });
+        if (!valid) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            output.write(reinterpret_cast<const char*>(loaded[i].data()), static_cast<std::streamsize>(loaded[i].size()));
+            total += loaded[i].size();
+        }
+        if (!output) {
+            return false;
+        }
+    }
+    return total == expected;
+}
+
+size_t ChunkStore::cutPoint(const uint8_t* data, size_t size) {
+    if (size <= kMinChunk) {
+        return size;
+    }
+    size_t limit = std::min(size, kMaxChunk);
+    uint64_t hash = 0;
+    for (size_t i = kMinChunk; i < limit; ++i) {
+        hash = (hash << 1) + kGear[data[i]];
+        if ((hash & kBoundaryMask) == 0) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+std::string ChunkStore::chunkId(const uint8_t* data, size_t size) const {
+    auto digest = mac->compute(data, size);
+    std::string id(kIdLength, '\0');
+    HexCodec::encode(digest.data(), digest.size(), &id[0]);
+    return id;
+}
+
+std::string ChunkStore::chunkPath(const std::string& id) const {
+    return chunkDir + id.substr(0, 2) + "/" + id;
+}
+
+long long ChunkStore::storeChunk(const std::string& id, const uint8_t* data, size_t size) const {
+    std::string path = chunkPath(id);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+        return 0;
+    }
+
+    // Stored as a flag, the original size, then the body: compressed if that helps
+    std::vector<uint8_t> compressed;
+    Utils::Lz77::compress(data, size, compressed);
+    bool useCompressed = compressed.size() < size;
+    std::vector<uint8_t> plain;
+    plain.reserve(5 + (useCompressed ? compressed.size() : size));
+    plain.push_back(useCompressed ? 'Z' : 'R');
+    for (size_t i = 0; i < 4; ++i) {
+        plain.push_back(static_cast<uint8_t>((size >> (8 * i)) & 0xff));
+    }
+    if (useCompressed) {
+        plain.insert(plain.end(), compressed.begin(), compressed.end());
+    } else {
+        plain.insert(plain.end(), data, data + size);
+    }
+
+    std::vector<uint8_t> encrypted = encryptor.encryptData(plain, contentKey);
+    std::filesystem::create_directories(chunkDir + id.substr(0, 2), ec);
+    if (!writeFileAtomically(path, encrypted)) {
+        return -1;
+    }
+    return static_cast<long long>(encrypted.size());
+}
+
+bool ChunkStore::loadChunk(const std::string& id, std::vector<uint8_t>& data) const {
+    std::vector<uint8_t> stored;
+    std::vector<uint8_t> plain;
+    if (!readFile(chunkPath(id), stored) || !encryptor.decryptData(stored, contentKey, plain) || plain.size() < 5) {
+        return false;
+    }
+
+    size_t size = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        size |= static_cast<size_t>(plain[1 + i]) << (8 * i);
+    }
+    if (plain[0] == 'Z') {
+        if (!Utils::Lz77::decompress(plain.data() + 5, plain.size() - 5, size, data)) {
+            return false;
+        }
+    } else if (plain[0] == 'R' && plain.size() - 5 == size) {
+        data.assign(plain.begin() + 5, plain.end());
+    } else {
+        return false;
+    }
+
+    // The id is a MAC of the content, so this also catches tampering
+    return chunkId(data.data(), data.size()) == id;
+}
+
+} // namespace passman
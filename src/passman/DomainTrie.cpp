@@ -0,0 +1,188 @@
+#include "passman/DomainTrie.h"
+#include <algorithm>
+#include <cctype>
+
+namespace passman {
+
+namespace {
+
+// Second-level labels that are public suffixes under common country codes
+const char* const kMultiLabelSuffixes[] = {
+    "ac.uk", "co.uk", "gov.uk", "org.uk", "com.au", "net.au", "org.au", "co.jp", "ne.jp",
+    "co.nz", "com.br", "com.cn", "co.in", "co.za", "com.mx", "com.tr", "co.kr", "com.sg",
+};
+
+std::vector<std::string_view> reversedLabels(std::string_view host) {
+    std::vector<std::string_view> labels;
+    size_t end = host.size();
+    while (true) {
+        size_t dot = host.rfind('.', end == 0 ? 0 : end - 1);
+        if (dot == std::string_view::npos || end == 0) {
+            labels.push_back(host.substr(0, end));
+            break;
+        }
+        labels.push_back(host.substr(dot + 1, end - dot - 1));
+        end = dot;
+    }
+    return labels;
+}
+
+bool isHostCharacter(unsigned char c) {
+    return std::isalnum(c) || c == '-' || c == '_' || c == ':';
+}
+
+} // namespace
+
+bool DomainTrie::parseHost(std::string_view url, std::string& host, bool allowWildcard) {
+    while (!url.empty() && std::isspace(static_cast<unsigned char>(url.front()))) {
+        url.remove_prefix(1);
+    }
+    while (!url.empty() && std::isspace(static_cast<unsigned char>(url.back()))) {
+        url.remove_suffix(1);
+    }
+
+    size_t scheme = url.find("://");
+    if (scheme != std::string_view::npos) {
+        url.remove_prefix(scheme + 3);
+    }
+    url = url.substr(0, url.find_first_of("/?#"));
+    size_t at = url.rfind('@');
+    if (at != std::string_view::npos) {
+        url.remove_prefix(at + 1);
+    }
+    if (!url.empty() && url.front() == '[') {
+        size_t close = url.find(']');
+        if (close == std::string_view::npos) {
+            return false;
+        }
+        url = url.substr(1, close - 1);
+    } else {
+        url = url.substr(0, url.find(':'));
+    }
+    if (!url.empty() && url.back() == '.') {
+        url.remove_suffix(1);
+    }
+    if (url.empty()) {
+        return false;
+    }
+
+    host.resize(url.size());
+    std::transform(url.begin(), url.end(), host.begin(),
+                   [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+
+    std::string_view rest = host;
+    if (allowWildcard && rest.size() > 2 && rest.compare(0, 2, "*.") == 0) {
+        rest.remove_prefix(2);
+    }
+    for (std::string_view label : reversedLabels(rest)) {
+        if (label.empty() || !std::all_of(label.begin(), label.end(),
+                                          [](unsigned char c){ return isHostCharacter(c); })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t DomainTrie::registrableLabels(const std::vector<std::string_view>& reversedLabels) {
+    if (reversedLabels.size() >= 3) {
+        std::string suffix;
+        suffix.append(reversedLabels[1]).append(".").append(reversedLabels[0]);
+        for (const char* known : kMultiLabelSuffixes) {
+            if (suffix == known) {
+                return 3;
+            }
+        }
+    }
+    return std::min<size_t>(2, reversedLabels.size());
+}
+
+uint32_t DomainTrie::insert(std::string_view host, uint32_t value) {
+    if (nodes.empty()) {
+        nodes.emplace_back();
+    }
+
+    bool wildcard = host.size() > 2 && host.compare(0, 2, "*.") == 0;
+    if (wildcard) {
+        host.remove_prefix(2);
+    }
+
+    uint32_t node = 0;
+    for (std::string_view label : reversedLabels(host)) {
+        auto inserted = edges.try_emplace(edgeKey(node, label), static_cast<uint32_t>(nodes.size()));
+        if (inserted.second) {
+            nodes.emplace_back();
+        }
+        node = inserted.first->second;
+    }
+
+    (wildcard ? nodes[node].wildcard : nodes[node].exact).push_back(value);
+    return node << 1 | (wildcard ? 1u : 0u);
+}
+
+void DomainTrie::erase(uint32_t handle, uint32_t value) {
+    auto& values = (handle & 1) ? nodes[handle >> 1].wildcard : nodes[handle >> 1].exact;
+    auto it = std::find(values.begin(), values.end(), value);
+    if (it != values.end()) {
+        *it = values.back();
+        values.pop_back();
+    }
+}
+
+void DomainTrie::clear() {
+    nodes.clear();
+    edges.clear();
+}
+
+DomainTrie::Match DomainTrie::match(std::string_view host, std::vector<uint32_t>& values) const {
+    values.clear();
+    if (nodes.empty()) {
+        return Match::None;
+    }
+
+    auto labels = reversedLabels(host);
+    size_t registrable = registrableLabels(labels);
+    uint32_t domainNode = kNone;
+    uint32_t wildcardNode = kNone;
+    uint32_t node = 0;
+    size_t depth = 0;
+    for (; depth < labels.size(); ++depth) {
+        node = child(node, labels[depth]);
+        if (node == kNone) {
+            break;
+        }
+        if (depth + 1 == registrable && registrable < labels.size()) {
+            domainNode = node;
+        }
+        // "*.x" covers hosts strictly below x
+        if (depth + 1 < labels.size() && !nodes[node].wildcard.empty()) {
+            wildcardNode = node;
+        }
+    }
+
+    if (depth == labels.size() && !nodes[node].exact.empty()) {
+        values = nodes[node].exact;
+        return Match::Exact;
+    }
+    if (domainNode != kNone && !nodes[domainNode].exact.empty()) {
+        values = nodes[domainNode].exact;
+        return Match::Domain;
+    }
+    if (wildcardNode != kNone) {
+        values = nodes[wildcardNode].wildcard;
+        return Match::Wildcard;
+    }
+    return Match::None;
+}
+
+uint32_t DomainTrie::child(uint32_t parent, std::string_view label) const {
+    auto it = edges.find(edgeKey(parent, label));
+    return it == edges.end() ? kNone : it->second;
+}
+
+std::string DomainTrie::edgeKey(uint32_t parent, std::string_view label) {
+    std::string key(reinterpret_cast<const char*>(&parent), sizeof(parent));
+    key.append(label);
+    return key;
+}
+
+} // namespace passman
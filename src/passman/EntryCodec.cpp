@@ -0,0 +1,71 @@
+#include "passman/EntryCodec.h"
+
+namespace passman {
+
+bool EntryCodec::isStorable(std::string_view field) {
+    return field.find_first_of("|\r\n") == std::string_view::npos;
+}
+
+size_t EntryCodec::lineSize(const EntryView& entry) {
+    return entry.service.size() + entry.username.size() + entry.encryptedPassword.size() +
+           entry.serviceLink.size() + entry.salt.size() +
+           (entry.tags.empty() && entry.attachments.empty() ? 0 : entry.tags.size() + 1) +
+           (entry.attachments.empty() ? 0 : entry.attachments.size() + 1) + 5;
+}
+
+void EntryCodec::appendLine(std::string& out, const EntryView& entry) {
+    out.append(entry.service).push_back('|');
+    out.append(entry.username).push_back('|');
+    out.append(entry.encryptedPassword).push_back('|');
+    out.append(entry.serviceLink).push_back('|');
+    out.append(entry.salt);
+    if (!entry.tags.empty() || !entry.attachments.empty()) {
+        out.push_back('|');
+        out.append(entry.tags);
+    }
+    if (!entry.attachments.empty()) {
+        out.push_back('|');
+        out.append(entry.attachments);
+    }
+    out.push_back('\n');
+}
+
+bool EntryCodec::parseLine(std::string_view line, EntryView& entry) {
+    std::string_view fields[4];
+    for (auto& field : fields) {
+        size_t separator = line.find('|');
+        if (separator == std::string_view::npos) {
+            return false;
+        }
+        field = line.substr(0, separator);
+        line.remove_prefix(separator + 1);
+    }
+    if (line.empty()) {
+        return false;
+    }
+
+    // Tags and then attachments were added as optional fields after the salt
+    std::string_view tags;
+    std::string_view attachments;
+    size_t separator = line.find('|');
+    if (separator != std::string_view::npos) {
+        tags = line.substr(separator + 1);
+        line = line.substr(0, separator);
+        separator = tags.find('|');
+        if (separator != std::string_view::npos) {
+            attachments = tags.substr(separator + 1);
+            tags = tags.substr(0, separator);
+        }
+    }
+
+    entry.service = fields[0];
+    entry.username = fields[1];
+    entry.encryptedPassword = fields[2];
+    entry.serviceLink = fields[3];
+    entry.salt = line;
+    entry.tags = tags;
+    entry.attachments = attachments;
+    return true;
+}
+
+} // namespace passman
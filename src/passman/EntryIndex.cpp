@@ -0,0 +1,210 @@
+#include "passman/EntryIndex.h"
+#include <algorithm>
+#include <cctype>
+
+namespace passman {
+
+namespace {
+
+std::string lowercase(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+bool isTagCharacter(unsigned char c) {
+    return std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == ':' || c == '/';
+}
+
+} // namespace
+
+bool EntryIndex::normalizeTags(const std::vector<std::string>& tags, std::string& joined) {
+    std::vector<std::string> parts;
+    for (const auto& tag : tags) {
+        size_t start = 0;
+        while (start <= tag.size()) {
+            size_t comma = std::min(tag.find(',', start), tag.size());
+            std::string part = lowercase(std::string_view(tag).substr(start, comma - start));
+            if (part.empty() || !std::all_of(part.begin(), part.end(),
+                                             [](unsigned char c){ return isTagCharacter(c); })) {
+                return false;
+            }
+            parts.push_back(std::move(part));
+            start = comma + 1;
+        }
+    }
+
+    std::sort(parts.begin(), parts.end());
+    parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+    joined.clear();
+    for (const auto& part : parts) {
+        if (!joined.empty()) {
+            joined += ',';
+        }
+        joined += part;
+    }
+    return true;
+}
+
+bool EntryIndex::parseQuery(const std::string& expression, std::vector<std::string>& terms, std::string& error) {
+    terms.clear();
+    size_t pos = 0;
+    while (pos < expression.size()) {
+        if (std::isspace(static_cast<unsigned char>(expression[pos]))) {
+            ++pos;
+            continue;
+        }
+        size_t end = pos;
+        while (end < expression.size() && !std::isspace(static_cast<unsigned char>(expression[end]))) {
+            ++end;
+        }
+        std::string term = lowercase(std::string_view(expression).substr(pos, end - pos));
+        pos = end;
+
+        size_t equals = term.find('=');
+        std::string field = term.substr(0, std::min(equals, term.size()));
+        if (equals == std::string::npos || equals + 1 == term.size()) {
+            error = "Expected field=value, got '" + term + "'";
+            return false;
+        }
+        if (field != "user" && field != "tag") {
+            error = "Unknown field '" + field + "' (expected user or tag)";
+            return false;
+        }
+        terms.push_back(std::move(term));
+    }
+
+    if (terms.empty()) {
+        error = "Empty query";
+        return false;
+    }
+    return true;
+}
+
+void EntryIndex::build(const EntryTable& table) {
+    clear();
+    rows.reserve(table.size());
+    ids.reserve(table.size());
+    table.forEach([&](const EntryView& entry) {
+        add(entry);
+    });
+    isBuilt = true;
+}
+
+void EntryIndex::clear() {
+    rows.clear();
+    ids.clear();
+    freeIds.clear();
+    postings.clear();
+    domains.clear();
+    isBuilt = false;
+}
+
+void EntryIndex::add(const EntryView& entry) {
+    std::string key = lowercase(entry.service);
+    uint32_t id;
+    auto existing = ids.find(key);
+    if (existing != ids.end()) {
+        id = existing->second;
+        removeTerms(id);
+    } else {
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+        } else {
+            id = static_cast<uint32_t>(rows.size());
+            rows.emplace_back();
+        }
+        ids.emplace(std::move(key), id);
+    }
+    rows[id].service.assign(entry.service);
+
+    if (!entry.username.empty()) {
+        addTerm(id, "user=" + lowercase(entry.username));
+    }
+    size_t start = 0;
+    while (start < entry.tags.size()) {
+        size_t comma = std::min(entry.tags.find(',', start), entry.tags.size());
+        addTerm(id, "tag=" + std::string(entry.tags.substr(start, comma - start)));
+        start = comma + 1;
+    }
+
+    std::string host;
+    if (!entry.serviceLink.empty() && DomainTrie::parseHost(entry.serviceLink, host, true)) {
+        rows[id].domain = domains.insert(host, id);
+    }
+}
+
+void EntryIndex::remove(std::string_view service) {
+    auto it = ids.find(lowercase(service));
+    if (it == ids.end()) {
+        return;
+    }
+    uint32_t id = it->second;
+    removeTerms(id);
+    rows[id].service.clear();
+    freeIds.push_back(id);
+    ids.erase(it);
+}
+
+std::vector<std::string> EntryIndex::query(const std::vector<std::string>& terms) const {
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (const auto& term : terms) {
+        auto it = postings.find(term);
+        if (it == postings.end()) {
+            return {};
+        }
+        lists.push_back(&it->second);
+    }
+    if (lists.empty()) {
+        return {};
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    std::vector<std::string> services;
+    for (uint32_t id : *lists[0]) {
+        bool matches = std::all_of(lists.begin() + 1, lists.end(), [id](const auto* list) {
+            return std::binary_search(list->begin(), list->end(), id);
+        });
+        if (matches) {
+            services.push_back(rows[id].service);
+        }
+    }
+    return services;
+}
+
+DomainTrie::Match EntryIndex::match(std::string_view host, std::vector<std::string>& services) const {
+    std::vector<uint32_t> matched;
+    DomainTrie::Match tier = domains.match(host, matched);
+    services.clear();
+    for (uint32_t id : matched) {
+        services.push_back(rows[id].service);
+    }
+    return tier;
+}
+
+void EntryIndex::addTerm(uint32_t id, std::string term) {
+    auto& node = *postings.try_emplace(std::move(term)).first;
+    auto& list = node.second;
+    // Fresh ids are the largest yet, so bulk builds append
+    list.insert(std::upper_bound(list.begin(), list.end(), id), id);
+    rows[id].terms.push_back(&node);
+}
+
+void EntryIndex::removeTerms(uint32_t id) {
+    for (auto* node : rows[id].terms) {
+        auto& list = node->second;
+        list.erase(std::lower_bound(list.begin(), list.end(), id));
+        if (list.empty()) {
+            postings.erase(node->first);
+        }
+    }
+    rows[id].terms.clear();
+    if (rows[id].domain != kNoDomain) {
+        domains.erase(rows[id].domain, id);
+        rows[id].domain = kNoDomain;
+    }
+}
+
+} // namespace passman
@@ -0,0 +1,358 @@
+#include "passman/EntryStore.h"
+#include <limits>
+#include <stdexcept>
+
+namespace passman {
+
+namespace {
+
+constexpr size_t kInitialSlots = 16;
+constexpr size_t kMinCompactBytes = 1 << 16;
+
+inline unsigned char asciiLower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+}
+
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (asciiLower(static_cast<unsigned char>(a[i])) != asciiLower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline uint32_t hashText(std::string_view text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+// Smallest power of two slot count that keeps count entries under 75% load
+size_t slotsFor(size_t count) {
+    size_t capacity = kInitialSlots;
+    while (count * 4 > capacity * 3) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+} // namespace
+
+EntryStore::EntryStore() {
+    clear();
+}
+
+uint64_t EntryStore::hashKey(std::string_view service) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : service) {
+        hash ^= asciiLower(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void EntryStore::reserve(size_t count) {
+    services.reserve(count);
+    secrets.reserve(count);
+    salts.reserve(count);
+    attachments.reserve(count);
+    usernames.reserve(count);
+    links.reserve(count);
+    tags.reserve(count);
+    hashes.reserve(count);
+    if (slotsFor(count) > slots.size()) {
+        slots.assign(slotsFor(count), 0);
+        for (size_t row = 0; row < hashes.size(); ++row) {
+            size_t mask = slots.size() - 1;
+            size_t slot = hashes[row] & mask;
+            while (slots[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = static_cast<uint32_t>(row + 1);
+        }
+    }
+}
+
+void EntryStore::clear() {
+    arena.clear();
+    arena.shrink_to_fit();
+    deadBytes = 0;
+    services.clear();
+    secrets.clear();
+    salts.clear();
+    attachments.clear();
+    usernames.clear();
+    links.clear();
+    tags.clear();
+    hashes.clear();
+    interned.assign(1, StringRef{0, 0});
+    internHashes.assign(1, 0);
+    internSlots.assign(kInitialSlots, 0);
+    slots.assign(kInitialSlots, 0);
+}
+
+void EntryStore::swap(EntryStore& other) {
+    arena.swap(other.arena);
+    std::swap(deadBytes, other.deadBytes);
+    services.swap(other.services);
+    secrets.swap(other.secrets);
+    salts.swap(other.salts);
+    attachments.swap(other.attachments);
+    usernames.swap(other.usernames);
+    links.swap(other.links);
+    tags.swap(other.tags);
+    hashes.swap(other.hashes);
+    interned.swap(other.interned);
+    internHashes.swap(other.internHashes);
+    internSlots.swap(other.internSlots);
+    slots.swap(other.slots);
+}
+
+bool EntryStore::find(std::string_view service, EntryView& entry) const {
+    size_t slot = findSlot(service, static_cast<uint32_t>(hashKey(service)));
+    if (slots[slot] == 0) {
+        return false;
+    }
+    entry = view(slots[slot] - 1);
+    return true;
+}
+
+void EntryStore::insert(const EntryView& entry) {
+    // Growing the arena would invalidate views into it, so copy those first
+    const char* begin = arena.data();
+    const char* end = arena.data() + arena.size();
+    for (std::string_view field : {entry.service, entry.username, entry.encryptedPassword,
+                                   entry.serviceLink, entry.salt, entry.tags, entry.attachments}) {
+        if (!field.empty() && field.data() >= begin && field.data() < end) {
+            PasswordEntry copy = entry.toEntry();
+            insert(EntryView(copy));
+            return;
+        }
+    }
+
+    uint32_t hash = static_cast<uint32_t>(hashKey(entry.service));
+    size_t slot = findSlot(entry.service, hash);
+    size_t row;
+    if (slots[slot] != 0) {
+        row = slots[slot] - 1;
+        deadBytes += services[row].length + secrets[row].length + salts[row].length + attachments[row].length;
+    } else {
+        if (hashes.size() >= std::numeric_limits<uint32_t>::max() - 1) {
+            throw std::length_error("Vault shard holds too many entries");
+        }
+        if ((hashes.size() + 1) * 4 > slots.size() * 3) {
+            growIndex();
+            slot = findSlot(entry.service, hash);
+        }
+        row = hashes.size();
+        services.emplace_back();
+        secrets.emplace_back();
+        salts.emplace_back();
+        attachments.emplace_back();
+        usernames.emplace_back();
+        links.emplace_back();
+        tags.emplace_back();
+        hashes.push_back(hash);
+        slots[slot] = static_cast<uint32_t>(row + 1);
+    }
+
+    services[row] = store(entry.service);
+    secrets[row] = store(entry.encryptedPassword);
+    salts[row] = store(entry.salt);
+    attachments[row] = store(entry.attachments);
+    usernames[row] = intern(entry.username);
+    links[row] = intern(entry.serviceLink);
+    tags[row] = intern(entry.tags);
+
+    if (deadBytes > kMinCompactBytes && deadBytes * 2 > arena.size()) {
+        compact();
+    }
+}
+
+bool EntryStore::erase(std::string_view service) {
+    size_t slot = findSlot(service, static_cast<uint32_t>(hashKey(service)));
+    if (slots[slot] == 0) {
+        return false;
+    }
+
+    size_t row = slots[slot] - 1;
+    deadBytes += services[row].length + secrets[row].length + salts[row].length + attachments[row].length;
+    removeSlot(slot);
+
+    // Fill the hole with the last row so the columns stay dense
+    size_t last = hashes.size() - 1;
+    if (row != last) {
+        size_t mask = slots.size() - 1;
+        size_t lastSlot = hashes[last] & mask;
+        while (slots[lastSlot] != last + 1) {
+            lastSlot = (lastSlot + 1) & mask;
+        }
+        slots[lastSlot] = static_cast<uint32_t>(row + 1);
+
+        services[row] = services[last];
+        secrets[row] = secrets[last];
+        salts[row] = salts[last];
+        attachments[row] = attachments[last];
+        usernames[row] = usernames[last];
+        links[row] = links[last];
+        tags[row] = tags[last];
+        hashes[row] = hashes[last];
+    }
+    services.pop_back();
+    secrets.pop_back();
+    salts.pop_back();
+    attachments.pop_back();
+    usernames.pop_back();
+    links.pop_back();
+    tags.pop_back();
+    hashes.pop_back();
+
+    if (deadBytes > kMinCompactBytes && deadBytes * 2 > arena.size()) {
+        compact();
+    }
+    return true;
+}
+
+size_t EntryStore::memoryUsage() const {
+    return arena.capacity() +
+           (services.capacity() + secrets.capacity() + salts.capacity() + attachments.capacity() +
+            interned.capacity()) * sizeof(StringRef) +
+           (usernames.capacity() + links.capacity() + tags.capacity() + hashes.capacity() + internHashes.capacity() +
+            internSlots.capacity() + slots.capacity()) * sizeof(uint32_t);
+}
+
+EntryView EntryStore::view(size_t row) const {
+    EntryView entry;
+    entry.service = text(services[row]);
+    entry.username = text(interned[usernames[row]]);
+    entry.encryptedPassword = text(secrets[row]);
+    entry.serviceLink = text(interned[links[row]]);
+    entry.salt = text(salts[row]);
+    entry.tags = text(interned[tags[row]]);
+    entry.attachments = text(attachments[row]);
+    return entry;
+}
+
+EntryStore::StringRef EntryStore::store(std::string_view text) {
+    if (arena.size() + text.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Vault shard exceeds 4 GB");
+    }
+    StringRef ref{static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(text.size())};
+    arena.insert(arena.end(), text.begin(), text.end());
+    return ref;
+}
+
+uint32_t EntryStore::intern(std::string_view value) {
+    if (value.empty()) {
+        return 0;
+    }
+
+    uint32_t hash = hashText(value);
+    size_t mask = internSlots.size() - 1;
+    size_t slot = hash & mask;
+    while (internSlots[slot] != 0) {
+        uint32_t id = internSlots[slot] - 1;
+        if (internHashes[id] == hash && text(interned[id]) == value) {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (interned.size() * 4 > internSlots.size() * 3) {
+        growInternIndex();
+        mask = internSlots.size() - 1;
+        slot = hash & mask;
+        while (internSlots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    uint32_t id = static_cast<uint32_t>(interned.size());
+    interned.push_back(store(value));
+    internHashes.push_back(hash);
+    internSlots[slot] = id + 1;
+    return id;
+}
+
+size_t EntryStore::findSlot(std::string_view service, uint32_t hash) const {
+    size_t mask = slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        uint32_t value = slots[slot];
+        if (value == 0) {
+            return slot;
+        }
+        size_t row = value - 1;
+        if (hashes[row] == hash && equalsIgnoreCase(text(services[row]), service)) {
+            return slot;
+        }
+    }
+}
+
+void EntryStore::growIndex() {
+    slots.assign(slots.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for (size_t row = 0; row < hashes.size(); ++row) {
+        size_t slot = hashes[row] & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = static_cast<uint32_t>(row + 1);
+    }
+}
+
+void EntryStore::growInternIndex() {
+    internSlots.assign(internSlots.size() * 2, 0);
+    size_t mask = internSlots.size() - 1;
+    for (size_t id = 1; id < interned.size(); ++id) {
+        size_t slot = internHashes[id] & mask;
+        while (internSlots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        internSlots[slot] = static_cast<uint32_t>(id + 1);
+    }
+}
+
+void EntryStore::removeSlot(size_t slot) {
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    size_t mask = slots.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; slots[next] != 0; next = (next + 1) & mask) {
+        size_t home = hashes[slots[next] - 1] & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    }
+    slots[hole] = 0;
+}
+
+void EntryStore::compact() {
+    std::vector<char> old;
+    old.swap(arena);
+    arena.reserve(old.size() - deadBytes);
+
+    auto relocate = [&](StringRef& ref) {
+        StringRef moved{static_cast<uint32_t>(arena.size()), ref.length};
+        arena.insert(arena.end(), old.data() + ref.offset, old.data() + ref.offset + ref.length);
+        ref = moved;
+    };
+    for (size_t row = 0; row < hashes.size(); ++row) {
+        relocate(services[row]);
+        relocate(secrets[row]);
+        relocate(salts[row]);
+        relocate(attachments[row]);
+    }
+    for (size_t id = 1; id < interned.size(); ++id) {
+        relocate(interned[id]);
+    }
+    deadBytes = 0;
+}
+
+} // namespace passman
@@ -0,0 +1,93 @@
+#include "passman/EntryTable.h"
+#include <algorithm>
+
+namespace passman {
+
+EntryTable::EntryTable(size_t shardCount) {
+    clear(shardCount);
+}
+
+size_t EntryTable::shardOf(std::string_view service, size_t shardCount) {
+    return static_cast<size_t>(EntryStore::hashKey(service) % shardCount);
+}
+
+size_t EntryTable::recommendedShardCount(size_t entryCount) {
+    size_t count = kMinShards;
+    while (count < kMaxShards && count * kTargetShardEntries < entryCount) {
+        count *= 2;
+    }
+    return count;
+}
+
+size_t EntryTable::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards) {
+        total += shard.size();
+    }
+    return total;
+}
+
+size_t EntryTable::memoryUsage() const {
+    size_t total = shards.capacity() * sizeof(Shard) + dirty.capacity();
+    for (const auto& shard : shards) {
+        total += shard.memoryUsage();
+    }
+    return total;
+}
+
+bool EntryTable::find(std::string_view service, EntryView& entry) const {
+    return shards[shardOf(service, shards.size())].find(service, entry);
+}
+
+void EntryTable::insert(const EntryView& entry) {
+    size_t index = shardOf(entry.service, shards.size());
+    shards[index].insert(entry);
+    dirty[index] = 1;
+}
+
+bool EntryTable::erase(std::string_view service) {
+    size_t index = shardOf(service, shards.size());
+    if (!shards[index].erase(service)) {
+        return false;
+    }
+    dirty[index] = 1;
+    return true;
+}
+
+bool EntryTable::hasDirtyShards() const {
+    return std::find(dirty.begin(), dirty.end(), 1) != dirty.end();
+}
+
+void EntryTable::markAllDirty() {
+    std::fill(dirty.begin(), dirty.end(), 1);
+}
+
+void EntryTable::clearDirty() {
+    std::fill(dirty.begin(), dirty.end(), 0);
+}
+
+void EntryTable::clear(size_t shardCount) {
+    shardCount = std::max<size_t>(1, shardCount);
+    shards.clear();
+    shards.resize(shardCount);
+    dirty.assign(shardCount, 0);
+}
+
+void EntryTable::reshard(size_t shardCount) {
+    std::vector<Shard> old;
+    old.swap(shards);
+    clear(shardCount);
+    for (const auto& shard : old) {
+        shard.forEach([&](const EntryView& entry) {
+            shards[shardOf(entry.service, shards.size())].insert(entry);
+        });
+    }
+    markAllDirty();
+}
+
+void EntryTable::swap(EntryTable& other) {
+    shards.swap(other.shards);
+    dirty.swap(other.dirty);
+}
+
+} // namespace passman
@@ -0,0 +1,165 @@
+#include "passman/HexCodec.h"
+#include <array>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PASSMAN_HEX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define PASSMAN_HEX_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace passman {
+
+namespace {
+
+constexpr char kDigits[] = "0123456789abcdef";
+
+// Two output characters per input byte, indexed by the byte value
+constexpr std::array<char, 512> makeEncodeTable() {
+    std::array<char, 512> table{};
+    for (int i = 0; i < 256; ++i) {
+        table[i * 2] = kDigits[i >> 4];
+        table[i * 2 + 1] = kDigits[i & 0x0F];
+    }
+    return table;
+}
+
+// Nibble value per character, 0xFF for anything that is not a hex digit
+constexpr std::array<uint8_t, 256> makeDecodeTable() {
+    std::array<uint8_t, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        table[i] = 0xFF;
+    }
+    for (int i = 0; i < 10; ++i) {
+        table['0' + i] = static_cast<uint8_t>(i);
+    }
+    for (int i = 0; i < 6; ++i) {
+        table['a' + i] = static_cast<uint8_t>(10 + i);
+        table['A' + i] = static_cast<uint8_t>(10 + i);
+    }
+    return table;
+}
+
+constexpr std::array<char, 512> kEncodeTable = makeEncodeTable();
+constexpr std::array<uint8_t, 256> kDecodeTable = makeDecodeTable();
+
+#ifdef PASSMAN_HEX_SSE2
+// Maps 16 nibbles (0-15) to their ASCII hex digits
+inline __m128i nibblesToHex(__m128i nibbles) {
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i letterOffset = _mm_set1_epi8('a' - '0' - 10);
+    __m128i isLetter = _mm_cmpgt_epi8(nibbles, nine);
+    __m128i ascii = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+    return _mm_add_epi8(ascii, _mm_and_si128(isLetter, letterOffset));
+}
+
+// Maps 16 ASCII characters to nibbles, setting invalid to all ones where a
+// character is not a hex digit
+inline __m128i hexToNibbles(__m128i chars, __m128i& invalid) {
+    const __m128i zero = _mm_set1_epi8('0' - 1);
+    const __m128i nine = _mm_set1_epi8('9' + 1);
+    const __m128i lowerA = _mm_set1_epi8('a' - 1);
+    const __m128i lowerF = _mm_set1_epi8('f' + 1);
+
+    __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(chars, zero), _mm_cmplt_epi8(chars, nine));
+    __m128i lowered = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(lowered, lowerA), _mm_cmplt_epi8(lowered, lowerF));
+
+    __m128i digitValue = _mm_and_si128(isDigit, _mm_sub_epi8(chars, _mm_set1_epi8('0')));
+    __m128i letterValue = _mm_and_si128(isLetter, _mm_sub_epi8(lowered, _mm_set1_epi8('a' - 10)));
+
+    invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(isDigit, isLetter), _mm_set1_epi8(-1)));
+    return _mm_or_si128(digitValue, letterValue);
+}
+#endif
+
+} // namespace
+
+void HexCodec::encode(const uint8_t* input, size_t length, char* output) {
+    size_t i = 0;
+
+#ifdef PASSMAN_HEX_AVX2
+    const __m256i lowMask256 = _mm256_set1_epi8(0x0F);
+    const __m256i nine256 = _mm256_set1_epi8(9);
+    const __m256i letterOffset256 = _mm256_set1_epi8('a' - '0' - 10);
+    const __m256i ascii0 = _mm256_set1_epi8('0');
+    for (; i + 32 <= length; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), lowMask256);
+        __m256i low = _mm256_and_si256(bytes, lowMask256);
+        high = _mm256_add_epi8(_mm256_add_epi8(high, ascii0),
+                               _mm256_and_si256(_mm256_cmpgt_epi8(high, nine256), letterOffset256));
+        low = _mm256_add_epi8(_mm256_add_epi8(low, ascii0),
+                              _mm256_and_si256(_mm256_cmpgt_epi8(low, nine256), letterOffset256));
+        // unpack works per 128-bit lane, so fix the lane order afterwards
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i * 2),
+                            _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i * 2 + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+#endif
+
+#ifdef PASSMAN_HEX_SSE2
+    const __m128i lowMask = _mm_set1_epi8(0x0F);
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i high = nibblesToHex(_mm_and_si128(_mm_srli_epi16(bytes, 4), lowMask));
+        __m128i low = nibblesToHex(_mm_and_si128(bytes, lowMask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2 + 16), _mm_unpackhi_epi8(high, low));
+    }
+#endif
+
+    for (; i < length; ++i) {
+        const char* pair = &kEncodeTable[static_cast<size_t>(input[i]) * 2];
+        output[i * 2] = pair[0];
+        output[i * 2 + 1] = pair[1];
+    }
+}
+
+bool HexCodec::decode(const char* input, size_t length, uint8_t* output) {
+    if (length % 2 != 0) {
+        return false;
+    }
+
+    const size_t outputLength = length / 2;
+    size_t i = 0;
+
+#ifdef PASSMAN_HEX_SSE2
+    __m128i invalid = _mm_setzero_si128();
+    const __m128i lowByte = _mm_set1_epi16(0x00FF);
+    for (; i + 16 <= outputLength; i += 16) {
+        __m128i first = hexToNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2)), invalid);
+        __m128i second = hexToNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2 + 16)), invalid);
+        // Each 16-bit lane holds (high nibble, low nibble) in memory order
+        first = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, lowByte), 4), _mm_srli_epi16(first, 8));
+        second = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, lowByte), 4), _mm_srli_epi16(second, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packus_epi16(first, second));
+    }
+    if (_mm_movemask_epi8(invalid) != 0) {
+        return false;
+    }
+#endif
+
+    uint8_t bad = 0;
+    for (; i < outputLength; ++i) {
+        uint8_t high = kDecodeTable[static_cast<uint8_t>(input[i * 2])];
+        uint8_t low = kDecodeTable[static_cast<uint8_t>(input[i * 2 + 1])];
+        bad |= static_cast<uint8_t>((high | low) & 0xF0);
+        output[i] = static_cast<uint8_t>((high << 4) | (low & 0x0F));
+    }
+    return bad == 0;
+}
+
+std::string HexCodec::encode(const std::string& input) {
+    std::string result(input.size() * 2, '\0');
+    encode(reinterpret_cast<const uint8_t*>(input.data()), input.size(), &result[0]);
+    return result;
+}
+
+} // namespace passman
@@ -0,0 +1,118 @@
+#include "passman/PasswordAuditor.h"
+#include "passman/PasswordKdf.h"
+#include "utils/PasswordStrength.h"
+#include "utils/SecureRandom.h"
+#include "utils/ThreadPool.h"
+#include "utils/Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+namespace passman {
+
+namespace {
+
+struct Fingerprint {
+    uint64_t high;
+    uint64_t low;
+
+    bool operator==(const Fingerprint& other) const {
+        return high == other.high && low == other.low;
+    }
+};
+
+struct FingerprintHash {
+    size_t operator()(const Fingerprint& fingerprint) const {
+        return static_cast<size_t>(fingerprint.low); // Already uniformly distributed
+    }
+};
+
+} // namespace
+
+PasswordAuditor::PasswordAuditor(const PasswordManager& manager, double minEntropyBits)
+    : manager(manager), minEntropyBits(minEntropyBits) {
+}
+
+bool PasswordAuditor::run(const FindingCallback& onWeak, AuditReport& report) const {
+    auto start = std::chrono::steady_clock::now();
+    report = AuditReport{};
+
+    // Fingerprints are only comparable within this run
+    uint8_t key[32];
+    Utils::SecureRandom::local().fill(key, sizeof(key));
+    const HmacSha256 mac(key, sizeof(key));
+    std::memset(key, 0, sizeof(key));
+
+    std::unordered_map<Fingerprint, std::vector<size_t>, FingerprintHash> buckets;
+    std::vector<std::string> labels;
+    std::vector<Fingerprint> fingerprints;
+    std::vector<AuditFinding> findings;
+    std::vector<uint8_t> weak;
+
+    bool success = manager.forEachDecrypted([&](const std::vector<PasswordRecord>& records) {
+        fingerprints.resize(records.size());
+        findings.resize(records.size());
+        weak.assign(records.size(), 0);
+
+        Utils::ThreadPool::shared().parallelFor(records.size(), 1024, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const std::string& password = records[i].password;
+                auto digest = mac.compute(reinterpret_cast<const uint8_t*>(password.data()), password.size());
+                std::memcpy(&fingerprints[i].high, digest.data(), sizeof(uint64_t));
+                std::memcpy(&fingerprints[i].low, digest.data() + sizeof(uint64_t), sizeof(uint64_t));
+
+                bool meetsRules = Utils::validatePasswordStrength(password);
+                double entropy = estimateEntropy(password);
+                if (!meetsRules || entropy < minEntropyBits) {
+                    weak[i] = 1;
+                    findings[i] = AuditFinding{records[i].service, records[i].username, meetsRules, entropy};
+                }
+            }
+        });
+
+        for (size_t i = 0; i < records.size(); ++i) {
+            buckets[fingerprints[i]].push_back(labels.size());
+            labels.push_back(records[i].service);
+            if (weak[i]) {
+                ++report.weak;
+                if (onWeak) {
+                    onWeak(findings[i]);
+                }
+            }
+        }
+        report.entries += records.size();
+    }, 16384);
+
+    if (!success) {
+        return false;
+    }
+
+    for (const auto& bucket : buckets) {
+        if (bucket.second.size() < 2) {
+            continue;
+        }
+        std::vector<std::string> services;
+        services.reserve(bucket.second.size());
+        for (size_t index : bucket.second) {
+            services.push_back(labels[index]);
+        }
+        std::sort(services.begin(), services.end());
+        report.reused.push_back(std::move(services));
+    }
+
+    // Largest groups first, they are the most urgent to rotate
+    std::sort(report.reused.begin(), report.reused.end(),
+              [](const std::vector<std::string>& a, const std::vector<std::string>& b) {
+                  return a.size() != b.size() ? a.size() > b.size() : a.front() < b.front();
+              });
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+double PasswordAuditor::estimateEntropy(std::string_view password) {
+    return Utils::PasswordStrength::estimateEntropy(password);
+}
+
+} // namespace passman
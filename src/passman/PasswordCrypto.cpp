@@ -1,11 +1,55 @@
 #include "passman/PasswordCrypto.h"
-#include <sstream>
-#include <iomanip>
+#include "passman/HexCodec.h"
+#include "utils/SecureRandom.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
 
 namespace passman {
 
-std::string PasswordCrypto::customHash(const std::string& input, const std::string& salt) const {
-    std::string combined = input + salt;
+namespace {
+
+// XORs data with the repeating key, continuing from keyIndex
+inline void xorWithKey(uint8_t* data, size_t length, std::string_view key, size_t& keyIndex) {
+    if (key.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        data[i] ^= static_cast<uint8_t>(key[keyIndex]);
+        if (++keyIndex == key.length()) {
+            keyIndex = 0;
+        }
+    }
+}
+
+// Encrypts length bytes of plain text into 2 * length hex characters at output
+void encryptInto(const char* plain, size_t length, std::string_view key, char* output) {
+    uint8_t block[256];
+    size_t keyIndex = 0;
+    for (size_t offset = 0; offset < length; offset += sizeof(block)) {
+        size_t count = std::min(sizeof(block), length - offset);
+        std::copy(plain + offset, plain + offset + count, block);
+        xorWithKey(block, count, key, keyIndex);
+        HexCodec::encode(block, count, output + offset * 2);
+    }
+    Utils::secureWipe(block, sizeof(block));
+}
+
+// Decrypts length hex characters into length / 2 bytes at output
+bool decryptInto(const char* encrypted, size_t length, std::string_view key, char* output) {
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(output);
+    if (!HexCodec::decode(encrypted, length, bytes)) {
+        return false;
+    }
+    size_t keyIndex = 0;
+    xorWithKey(bytes, length / 2, key, keyIndex);
+    return true;
+}
+
+} // namespace
+
+std::string PasswordCrypto::customHash(std::string_view input, const std::string& salt) const {
+    Utils::SecureString combined(input);
+    combined.append(salt);
     std::vector<uint8_t> hash(32, 0); // 256-bit hash output
     
     // Initial mixing
@@ -13,7 +57,7 @@ std::string PasswordCrypto::customHash(const std::string& input, const std::stri
     uint32_t h2 = 0xbb67ae85;
 
     // Process each character
-    for (size_t i = 0; i < combined.length(); ++i) {
+    for (size_t i = 0; i < combined.size(); ++i) {
         h1 = ((h1 << 5) | (h1 >> 27)) + static_cast<uint8_t>(combined[i]);
         h2 = ((h2 >> 3) | (h2 << 29)) ^ static_cast<uint8_t>(combined[i]);
 
@@ -29,72 +73,99 @@ std::string PasswordCrypto::customHash(const std::string& input, const std::stri
     }
 
     // Convert to hex string
-    std::stringstream ss;
-    for (uint8_t byte : hash) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
-    }
-    return ss.str();
+    std::string result(hash.size() * 2, '\0');
+    HexCodec::encode(hash.data(), hash.size(), &result[0]);
+    return result;
 }
 
 std::string PasswordCrypto::generateSalt(size_t length) const {
     static const std::string chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, chars.length() - 1);
-
-    std::string salt;
-    salt.reserve(length);
-    for (size_t i = 0; i < length; ++i) {
-        salt += chars[dis(gen)];
-    }
-    return salt;
+    return Utils::SecureRandom::local().sample(chars, length);
 }
 
-std::string PasswordCrypto::encryptPassword(const std::string& password, const std::string& key) const {
-    // Simple encryption using the provided key
-    std::string result;
-    result.reserve(password.length() * 2); // Reserve space for hex encoding
-
-    for (size_t i = 0; i < password.length(); ++i) {
-        // XOR with a byte from the key
-        char encrypted = password[i] ^ key[i % key.length()];
-        // Convert to hex for safe storage
-        char hex[3];
-        sprintf_s(hex, "%02x", static_cast<unsigned char>(encrypted));
-        result += hex;
+void PasswordCrypto::generateSalts(size_t count, std::vector<std::string>& salts, size_t length) const {
+    static const std::string chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    auto& random = Utils::SecureRandom::local();
+
+    salts.resize(count);
+    for (auto& salt : salts) {
+        salt.resize(length);
+        random.sample(chars, &salt[0], length);
     }
+}
 
+std::string PasswordCrypto::encryptPassword(std::string_view password, std::string_view key) const {
+    // XOR with the key, then hex encode for safe storage
+    std::string result(password.length() * 2, '\0');
+    encryptInto(password.data(), password.length(), key, &result[0]);
     return result;
 }
 
-std::string PasswordCrypto::decryptPassword(const std::string& encryptedPassword, const std::string& key) const {
-    std::string result;
-    result.reserve(encryptedPassword.length() / 2);
-
-    for (size_t i = 0; i < encryptedPassword.length(); i += 2) {
-        // Convert from hex
-        std::string byteStr = encryptedPassword.substr(i, 2);
-        char byte = static_cast<char>(std::stoi(byteStr, nullptr, 16));
-        // XOR with a byte from the key
-        char decrypted = byte ^ key[(i/2) % key.length()];
-        result += decrypted;
+Utils::SecureString PasswordCrypto::decryptPassword(std::string_view encryptedPassword, std::string_view key) const {
+    // Decrypted straight into pool memory; the plaintext never sits on the heap
+    Utils::SecureString result;
+    result.resize(encryptedPassword.length() / 2);
+    if (!decryptInto(encryptedPassword.data(), encryptedPassword.length(), key, result.data())) {
+        result.clear();
     }
-    
     return result;
 }
 
+void PasswordCrypto::encryptMany(const std::vector<std::string_view>& passwords, std::string_view key,
+                                 CryptoBatch& output) const {
+    output.offsets.resize(passwords.size() + 1);
+    size_t total = 0;
+    for (size_t i = 0; i < passwords.size(); ++i) {
+        output.offsets[i] = total;
+        total += passwords[i].size() * 2;
+    }
+    output.offsets[passwords.size()] = total;
+    output.data.resize(total);
+
+    for (size_t i = 0; i < passwords.size(); ++i) {
+        encryptInto(passwords[i].data(), passwords[i].size(), key, &output.data[output.offsets[i]]);
+    }
+}
+
+bool PasswordCrypto::decryptMany(const std::vector<std::string_view>& encryptedPasswords, std::string_view key,
+                                 CryptoBatch& output) const {
+    output.offsets.resize(encryptedPasswords.size() + 1);
+    size_t total = 0;
+    for (size_t i = 0; i < encryptedPasswords.size(); ++i) {
+        output.offsets[i] = total;
+        total += encryptedPasswords[i].size() / 2;
+    }
+    output.offsets[encryptedPasswords.size()] = total;
+    output.data.resize(total);
+
+    bool success = true;
+    for (size_t i = 0; i < encryptedPasswords.size(); ++i) {
+        success &= decryptInto(encryptedPasswords[i].data(), encryptedPasswords[i].size(), key,
+                               &output.data[output.offsets[i]]);
+    }
+    return success;
+}
+
 std::string PasswordCrypto::generatePassword(size_t length) const {
     static const std::string chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz!@#$%^&*";
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, chars.length() - 1);
-    
-    std::string password;
-    password.reserve(length);
-    for (size_t i = 0; i < length; ++i) {
-        password += chars[dis(gen)];
-    }
-    return password;
+    return Utils::SecureRandom::local().sample(chars, length);
+}
+
+void PasswordCrypto::generatePasswords(size_t count, size_t length, const PasswordPolicy& policy,
+                                       std::string& lines) const {
+    const size_t stride = length + 1;
+    lines.resize(count * stride);
+    Utils::ThreadPool::shared().parallelFor(count, 16384, [&](size_t begin, size_t end) {
+        auto& random = Utils::SecureRandom::local();
+        for (size_t i = begin; i < end; ++i) {
+            char* password = &lines[i * stride];
+            // Redraw whole candidates so composition rules do not skew the distribution
+            do {
+                random.sample(policy.charset, password, length);
+            } while (!policy.accepts(std::string_view(password, length)));
+            password[length] = '\n';
+        }
+    });
 }
 
 } // namespace passman
\ No newline at end of file
@@ -0,0 +1,390 @@
+#include "passman/PasswordHistory.h"
+#include "passman/EntryCodec.h"
+#include "utils/ThreadPool.h"
+#include "utils/Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace passman {
+
+namespace {
+
+// Frame layout: magic, tag count, tags, payload length, payload; integers little-endian
+constexpr char kFrameMagic[4] = {'S', 'S', 'H', 'F'};
+constexpr size_t kFrameHeaderSize = sizeof(kFrameMagic) + sizeof(uint32_t);
+
+void putInteger(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t getInteger(const uint8_t* data, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+// Returns the length of the prefix of the file made of complete frames
+uint64_t completeLength(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return 0;
+    }
+    file.seekg(0, std::ios::end);
+    uint64_t size = static_cast<uint64_t>(file.tellg());
+
+    uint64_t pos = 0;
+    uint8_t header[kFrameHeaderSize];
+    uint8_t length[sizeof(uint32_t)];
+    while (pos + kFrameHeaderSize <= size) {
+        file.seekg(static_cast<std::streamoff>(pos));
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+            std::memcmp(header, kFrameMagic, sizeof(kFrameMagic)) != 0) {
+            break;
+        }
+        uint64_t lengthAt = pos + kFrameHeaderSize + getInteger(header + sizeof(kFrameMagic), 4) * sizeof(uint64_t);
+        if (lengthAt + sizeof(length) > size) {
+            break;
+        }
+        file.seekg(static_cast<std::streamoff>(lengthAt));
+        if (!file.read(reinterpret_cast<char*>(length), sizeof(length))) {
+            break;
+        }
+        uint64_t end = lengthAt + sizeof(length) + getInteger(length, 4);
+        if (end > size) {
+            break;
+        }
+        pos = end;
+    }
+    return pos;
+}
+
+// Parses the "generation time" line that starts every frame
+bool parseFrameHeader(std::string_view line, uint64_t& generation, int64_t& timestamp) {
+    size_t space = line.find(' ');
+    if (space == std::string_view::npos || space == 0 || space + 1 == line.size()) {
+        return false;
+    }
+    try {
+        generation = std::stoull(std::string(line.substr(0, space)));
+        timestamp = std::stoll(std::string(line.substr(space + 1)));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+bool sameService(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && normalizeServiceName(std::string(a)) == normalizeServiceName(std::string(b));
+}
+
+} // namespace
+
+PasswordHistory::PasswordHistory(const std::string& dataDir)
+    : historyDir(dataDir + "history/") {
+}
+
+bool PasswordHistory::record(uint64_t generation, const std::vector<HistoryChange>& changes,
+                             std::string_view vaultKey) const {
+    if (changes.empty()) {
+        return true;
+    }
+
+    std::vector<std::vector<const HistoryChange*>> buckets(kBuckets);
+    for (const auto& change : changes) {
+        buckets[bucketOf(change.entry.service)].push_back(&change);
+    }
+
+    std::string header = std::to_string(generation) + " " + std::to_string(static_cast<int64_t>(std::time(nullptr))) + "\n";
+    const HmacSha256 mac = tagKey(vaultKey);
+    std::vector<Frame> frames(kBuckets);
+    Utils::ThreadPool::shared().parallelFor(kBuckets, 1, [&](size_t begin, size_t end) {
+        for (size_t bucket = begin; bucket < end; ++bucket) {
+            if (buckets[bucket].empty()) {
+                continue;
+            }
+            std::vector<uint64_t> tags;
+            std::string plain = header;
+            for (const HistoryChange* change : buckets[bucket]) {
+                tags.push_back(serviceTag(mac, change->entry.service));
+                if (change->removed) {
+                    plain.push_back('-');
+                    plain.append(change->entry.service).push_back('\n');
+                } else {
+                    plain.push_back('+');
+                    EntryCodec::appendLine(plain, change->entry);
+                }
+            }
+            frames[bucket] = sealFrame(std::move(tags), plain, vaultKey);
+        }
+    });
+
+    std::error_code ec;
+    std::filesystem::create_directories(historyDir, ec);
+    bool success = true;
+    for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        if (!buckets[bucket].empty() && !appendToBucket(bucket, frames[bucket])) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool PasswordHistory::versions(const std::string& service, std::string_view vaultKey,
+                               std::vector<HistoryVersion>& versions) const {
+    versions.clear();
+    std::vector<Frame> frames;
+    if (!readFrames(bucketPath(bucketOf(service)), frames)) {
+        return false;
+    }
+
+    const uint64_t tag = serviceTag(tagKey(vaultKey), service);
+    std::vector<uint8_t> decrypted;
+    for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+        if (std::find(frame->tags.begin(), frame->tags.end(), tag) == frame->tags.end() ||
+            !encryptor.decryptData(frame->payload, vaultKey, decrypted)) {
+            continue;
+        }
+
+        std::string_view plain(reinterpret_cast<const char*>(decrypted.data()), decrypted.size());
+        size_t newline = plain.find('\n');
+        HistoryVersion version;
+        if (newline == std::string_view::npos ||
+            !parseFrameHeader(plain.substr(0, newline), version.generation, version.timestamp)) {
+            continue;
+        }
+        plain.remove_prefix(newline + 1);
+
+        while (!plain.empty()) {
+            newline = std::min(plain.find('\n'), plain.size());
+            std::string_view line = plain.substr(0, newline);
+            plain.remove_prefix(std::min(newline + 1, plain.size()));
+            if (line.empty()) {
+                continue;
+            }
+
+            EntryView entry;
+            if (line[0] == '-' && sameService(line.substr(1), service)) {
+                version.removed = true;
+                version.entry = PasswordEntry{};
+                version.entry.service = std::string(line.substr(1));
+                versions.push_back(version);
+                break;
+            }
+            if (line[0] == '+' && EntryCodec::parseLine(line.substr(1), entry) &&
+                sameService(entry.service, service)) {
+                version.removed = false;
+                version.entry = entry.toEntry();
+                versions.push_back(version);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+bool PasswordHistory::stageRekey(std::string_view oldKey, std::string_view newKey, const PasswordCrypto& crypto,
+                                 std::vector<std::string>& staged) const {
+    const HmacSha256 mac = tagKey(newKey);
+    std::atomic<bool> success{true};
+    std::vector<char> written(kBuckets, 0);
+    Utils::ThreadPool::shared().parallelFor(kBuckets, 1, [&](size_t begin, size_t end) {
+        std::vector<Frame> frames;
+        std::vector<uint8_t> decrypted;
+        CryptoBatch plain;
+        CryptoBatch reencrypted;
+        for (size_t bucket = begin; bucket < end; ++bucket) {
+            std::string path = bucketPath(bucket);
+            std::error_code ec;
+            if (!std::filesystem::exists(path, ec)) {
+                continue;
+            }
+            if (!readFrames(path, frames)) {
+                success = false;
+                continue;
+            }
+
+            std::string out;
+            for (const auto& frame : frames) {
+                if (!encryptor.decryptData(frame.payload, oldKey, decrypted)) {
+                    continue; // Not readable under the old key either; nothing to carry over
+                }
+                std::string_view text(reinterpret_cast<const char*>(decrypted.data()), decrypted.size());
+                size_t newline = std::min(text.find('\n'), text.size());
+                std::string rebuilt(text.substr(0, newline));
+                rebuilt.push_back('\n');
+                text.remove_prefix(std::min(newline + 1, text.size()));
+
+                // Re-encrypt the secrets of this frame in one batch
+                std::vector<std::string_view> lines;
+                std::vector<EntryView> entries;
+                std::vector<std::string_view> secrets;
+                while (!text.empty()) {
+                    newline = std::min(text.find('\n'), text.size());
+                    std::string_view line = text.substr(0, newline);
+                    text.remove_prefix(std::min(newline + 1, text.size()));
+                    EntryView entry;
+                    if (line.size() > 1 && line[0] == '+' && EntryCodec::parseLine(line.substr(1), entry)) {
+                        entries.push_back(entry);
+                        secrets.push_back(entry.encryptedPassword);
+                    } else if (line.size() > 1 && line[0] == '-') {
+                        lines.push_back(line);
+                    }
+                }
+                if (!crypto.decryptMany(secrets, oldKey, plain)) {
+                    continue;
+                }
+                std::vector<std::string_view> passwords;
+                for (size_t i = 0; i < plain.size(); ++i) {
+                    passwords.push_back(plain[i]);
+                }
+                crypto.encryptMany(passwords, newKey, reencrypted);
+
+                std::vector<uint64_t> tags;
+                for (size_t i = 0; i < entries.size(); ++i) {
+                    entries[i].encryptedPassword = reencrypted[i];
+                    rebuilt.push_back('+');
+                    EntryCodec::appendLine(rebuilt, entries[i]);
+                    tags.push_back(serviceTag(mac, entries[i].service));
+                }
+                for (std::string_view line : lines) {
+                    rebuilt.append(line).push_back('\n');
+                    tags.push_back(serviceTag(mac, line.substr(1)));
+                }
+                appendFrame(out, sealFrame(std::move(tags), rebuilt, newKey));
+            }
+
+            std::string tmp = path + ".tmp";
+            std::ofstream stream(tmp, std::ios::binary | std::ios::trunc);
+            stream.write(out.data(), static_cast<std::streamsize>(out.size()));
+            stream.close();
+            written[bucket] = 1;
+            if (stream.fail() || !Utils::syncFile(tmp)) {
+                success = false;
+            }
+        }
+    });
+
+    for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        if (!written[bucket]) {
+            continue;
+        }
+        if (success) {
+            staged.push_back(bucketPath(bucket));
+        } else {
+            std::error_code ec;
+            std::filesystem::remove(bucketPath(bucket) + ".tmp", ec);
+        }
+    }
+    return success;
+}
+
+size_t PasswordHistory::bucketOf(std::string_view service) {
+    return static_cast<size_t>(EntryStore::hashKey(service) % kBuckets);
+}
+
+uint64_t PasswordHistory::serviceTag(const HmacSha256& mac, std::string_view service) {
+    std::string key = normalizeServiceName(std::string(service));
+    auto digest = mac.compute(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    return getInteger(digest.data(), sizeof(uint64_t));
+}
+
+HmacSha256 PasswordHistory::tagKey(std::string_view vaultKey) {
+    // Domain-separated from the vault key's other uses
+    Utils::SecureString key("history-tag:");
+    key.append(vaultKey);
+    return HmacSha256(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+}
+
+std::string PasswordHistory::bucketPath(size_t bucket) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "bucket-%03zu.hist", bucket);
+    return historyDir + name;
+}
+
+bool PasswordHistory::readFrames(const std::string& path, std::vector<Frame>& frames) const {
+    frames.clear();
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return !std::filesystem::exists(path); // No history yet
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    while (pos + kFrameHeaderSize <= data.size() &&
+           std::memcmp(data.data() + pos, kFrameMagic, sizeof(kFrameMagic)) == 0) {
+        size_t tagCount = static_cast<size_t>(getInteger(data.data() + pos + sizeof(kFrameMagic), 4));
+        size_t lengthAt = pos + kFrameHeaderSize + tagCount * sizeof(uint64_t);
+        if (lengthAt + sizeof(uint32_t) > data.size()) {
+            break;
+        }
+        size_t payloadAt = lengthAt + sizeof(uint32_t);
+        size_t payloadLength = static_cast<size_t>(getInteger(data.data() + lengthAt, 4));
+        if (payloadAt + payloadLength > data.size()) {
+            break;
+        }
+
+        Frame frame;
+        frame.tags.resize(tagCount);
+        for (size_t i = 0; i < tagCount; ++i) {
+            frame.tags[i] = getInteger(data.data() + pos + kFrameHeaderSize + i * sizeof(uint64_t), 8);
+        }
+        frame.payload.assign(data.begin() + payloadAt, data.begin() + payloadAt + payloadLength);
+        frames.push_back(std::move(frame));
+        pos = payloadAt + payloadLength;
+    }
+    return true;
+}
+
+void PasswordHistory::appendFrame(std::string& out, const Frame& frame) {
+    out.append(kFrameMagic, sizeof(kFrameMagic));
+    putInteger(out, frame.tags.size(), 4);
+    for (uint64_t tag : frame.tags) {
+        putInteger(out, tag, 8);
+    }
+    putInteger(out, frame.payload.size(), 4);
+    out.append(reinterpret_cast<const char*>(frame.payload.data()), frame.payload.size());
+}
+
+bool PasswordHistory::appendToBucket(size_t bucket, const Frame& frame) const {
+    std::string path = bucketPath(bucket);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+        uint64_t complete = completeLength(path);
+        if (complete != std::filesystem::file_size(path, ec)) {
+            std::filesystem::resize_file(path, complete, ec);
+            if (ec) {
+                return false;
+            }
+        }
+    }
+
+    std::string bytes;
+    appendFrame(bytes, frame);
+    std::ofstream stream(path, std::ios::binary | std::ios::app);
+    if (!stream.is_open()) {
+        return false;
+    }
+    stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    stream.close();
+    return !stream.fail();
+}
+
+PasswordHistory::Frame PasswordHistory::sealFrame(std::vector<uint64_t> tags, const std::string& plain,
+                                                  std::string_view vaultKey) const {
+    Frame frame;
+    frame.tags = std::move(tags);
+    frame.payload = encryptor.encryptData(std::vector<uint8_t>(plain.begin(), plain.end()), vaultKey);
+    return frame;
+}
+
+} // namespace passman
@@ -0,0 +1,314 @@
+#include "passman/PasswordKdf.h"
+#include "passman/HexCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace passman {
+
+namespace {
+
+constexpr uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotateRight(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+inline void storeBigEndian32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+}
+
+// A 32-byte message following one 64-byte block is always 768 bits long,
+// so the padded final block for it has a fixed layout.
+inline void padDigestBlock(uint8_t* block, const Sha256::Digest& message) {
+    std::memcpy(block, message.data(), Sha256::DIGEST_SIZE);
+    block[32] = 0x80;
+    std::memset(block + 33, 0, 29);
+    block[62] = 0x03;
+    block[63] = 0x00;
+}
+
+} // namespace
+
+Sha256::Sha256()
+    : state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      buffer{},
+      bufferLength(0),
+      totalLength(0) {
+}
+
+void Sha256::compress(const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+        uint32_t choose = (e & f) ^ (~e & g);
+        uint32_t temp1 = h + s1 + choose + kRoundConstants[i] + w[i];
+        uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t temp2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256::update(const uint8_t* data, size_t length) {
+    totalLength += length;
+    if (bufferLength > 0) {
+        size_t take = std::min(length, BLOCK_SIZE - bufferLength);
+        std::memcpy(buffer.data() + bufferLength, data, take);
+        bufferLength += take;
+        data += take;
+        length -= take;
+        if (bufferLength == BLOCK_SIZE) {
+            compress(buffer.data());
+            bufferLength = 0;
+        }
+    }
+    while (length >= BLOCK_SIZE) {
+        compress(data);
+        data += BLOCK_SIZE;
+        length -= BLOCK_SIZE;
+    }
+    if (length > 0) {
+        std::memcpy(buffer.data(), data, length);
+        bufferLength = length;
+    }
+}
+
+void Sha256::update(const std::string& data) {
+    update(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+Sha256::Digest Sha256::finish() {
+    uint64_t bitLength = totalLength * 8;
+    uint8_t padding[BLOCK_SIZE * 2] = {0x80};
+    size_t padLength = (bufferLength < 56) ? (56 - bufferLength) : (120 - bufferLength);
+    for (int i = 0; i < 8; ++i) {
+        padding[padLength + i] = static_cast<uint8_t>(bitLength >> (56 - i * 8));
+    }
+    update(padding, padLength + 8);
+
+    Digest digest;
+    for (int i = 0; i < 8; ++i) {
+        storeBigEndian32(digest.data() + i * 4, state[i]);
+    }
+    return digest;
+}
+
+Sha256::Digest Sha256::hash(const uint8_t* data, size_t length) {
+    Sha256 sha;
+    sha.update(data, length);
+    return sha.finish();
+}
+
+HmacSha256::HmacSha256(const uint8_t* key, size_t keyLength) {
+    uint8_t block[Sha256::BLOCK_SIZE] = {};
+    if (keyLength > Sha256::BLOCK_SIZE) {
+        Sha256::Digest hashed = Sha256::hash(key, keyLength);
+        std::memcpy(block, hashed.data(), hashed.size());
+    } else if (keyLength > 0) {
+        std::memcpy(block, key, keyLength);
+    }
+
+    uint8_t pad[Sha256::BLOCK_SIZE];
+    for (size_t i = 0; i < Sha256::BLOCK_SIZE; ++i) {
+        pad[i] = block[i] ^ 0x36;
+    }
+    inner.update(pad, sizeof(pad));
+    for (size_t i = 0; i < Sha256::BLOCK_SIZE; ++i) {
+        pad[i] = block[i] ^ 0x5c;
+    }
+    outer.update(pad, sizeof(pad));
+    std::memset(block, 0, sizeof(block));
+}
+
+Sha256::Digest HmacSha256::compute(const uint8_t* data, size_t length) const {
+    Sha256 innerHash = inner;
+    innerHash.update(data, length);
+    Sha256::Digest innerDigest = innerHash.finish();
+
+    Sha256 outerHash = outer;
+    outerHash.update(innerDigest.data(), innerDigest.size());
+    return outerHash.finish();
+}
+
+Sha256::Digest HmacSha256::computeDigest(const Sha256::Digest& message) const {
+    // Fast path for 32-byte messages: exactly one compression per hash
+    uint8_t block[Sha256::BLOCK_SIZE];
+
+    Sha256 innerHash = inner;
+    padDigestBlock(block, message);
+    innerHash.compress(block);
+    Sha256::Digest innerDigest;
+    for (int i = 0; i < 8; ++i) {
+        storeBigEndian32(innerDigest.data() + i * 4, innerHash.state[i]);
+    }
+
+    Sha256 outerHash = outer;
+    padDigestBlock(block, innerDigest);
+    outerHash.compress(block);
+    Sha256::Digest result;
+    for (int i = 0; i < 8; ++i) {
+        storeBigEndian32(result.data() + i * 4, outerHash.state[i]);
+    }
+    return result;
+}
+
+std::string KdfParams::toString() const {
+    if (isLegacy()) {
+        return algorithm;
+    }
+    return algorithm + ":" + std::to_string(iterations);
+}
+
+bool KdfParams::parse(const std::string& text, KdfParams& params) {
+    if (text.empty() || text == "legacy") {
+        params = legacy();
+        return true;
+    }
+
+    size_t colon = text.find(':');
+    if (colon == std::string::npos || text.substr(0, colon) != "pbkdf2-sha256") {
+        return false;
+    }
+
+    std::string digits = text.substr(colon + 1);
+    if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    try {
+        unsigned long iterations = std::stoul(digits);
+        // A count below the floor would let whoever can edit master.txt make the password cheap to guess
+        if (iterations < PasswordKdf::MIN_ITERATIONS || iterations > PasswordKdf::MAX_ITERATIONS) {
+            return false;
+        }
+        params.algorithm = "pbkdf2-sha256";
+        params.iterations = static_cast<uint32_t>(iterations);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+KdfParams KdfParams::legacy() {
+    KdfParams params;
+    params.algorithm = "legacy";
+    params.iterations = 1;
+    return params;
+}
+
+void PasswordKdf::pbkdf2(std::string_view password, std::string_view salt, uint32_t iterations,
+                         uint8_t* output, size_t outputLength) {
+    const HmacSha256 hmac(reinterpret_cast<const uint8_t*>(password.data()), password.size());
+    const size_t blockCount = (outputLength + Sha256::DIGEST_SIZE - 1) / Sha256::DIGEST_SIZE;
+
+    auto deriveBlock = [&](uint32_t blockIndex) {
+        std::vector<uint8_t> first(salt.begin(), salt.end());
+        first.resize(salt.size() + 4);
+        storeBigEndian32(first.data() + salt.size(), blockIndex);
+
+        Sha256::Digest u = hmac.compute(first.data(), first.size());
+        Sha256::Digest t = u;
+        for (uint32_t i = 1; i < iterations; ++i) {
+            u = hmac.computeDigest(u);
+            for (size_t j = 0; j < t.size(); ++j) {
+                t[j] ^= u[j];
+            }
+        }
+
+        size_t offset = (blockIndex - 1) * Sha256::DIGEST_SIZE;
+        size_t count = std::min(Sha256::DIGEST_SIZE, outputLength - offset);
+        std::memcpy(output + offset, t.data(), count);
+    };
+
+    // Output blocks are independent; run all but the first on extra lanes
+    std::vector<std::future<void>> lanes;
+    for (size_t block = 2; block <= blockCount; ++block) {
+        lanes.push_back(std::async(std::launch::async, deriveBlock, static_cast<uint32_t>(block)));
+    }
+    deriveBlock(1);
+    for (auto& lane : lanes) {
+        lane.get();
+    }
+}
+
+PasswordKdf::DerivedKeys PasswordKdf::derive(std::string_view password, const std::string& salt,
+                                             const KdfParams& params) {
+    uint8_t derived[Sha256::DIGEST_SIZE * 2];
+    pbkdf2(password, salt, params.iterations, derived, sizeof(derived));
+
+    DerivedKeys keys;
+    keys.verifier.resize(Sha256::DIGEST_SIZE * 2);
+    keys.encryptionKey.resize(Sha256::DIGEST_SIZE * 2);
+    HexCodec::encode(derived, Sha256::DIGEST_SIZE, &keys.verifier[0]);
+    HexCodec::encode(derived + Sha256::DIGEST_SIZE, Sha256::DIGEST_SIZE, keys.encryptionKey.data());
+    Utils::secureWipe(derived, sizeof(derived));
+    return keys;
+}
+
+KdfParams PasswordKdf::calibrate(std::chrono::milliseconds targetLatency) {
+    // Time a short run with the same lane layout as derive() and extrapolate
+    const uint32_t probeIterations = 20000;
+    uint8_t scratch[Sha256::DIGEST_SIZE * 2];
+    auto start = std::chrono::steady_clock::now();
+    pbkdf2("calibration", "calibration-salt", probeIterations, scratch, sizeof(scratch));
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    KdfParams params;
+    double perIteration = static_cast<double>(std::max<long long>(elapsed, 1)) / probeIterations;
+    double target = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::microseconds>(targetLatency).count());
+    double iterations = target / perIteration;
+    iterations = std::max<double>(iterations, MIN_ITERATIONS);
+    iterations = std::min<double>(iterations, MAX_ITERATIONS);
+    params.iterations = static_cast<uint32_t>(iterations);
+    return params;
+}
+
+bool PasswordKdf::constantTimeEquals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    unsigned char diff = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        diff |= static_cast<unsigned char>(a[i] ^ b[i]);
+    }
+    return diff == 0;
+}
+
+} // namespace passman
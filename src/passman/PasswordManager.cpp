@@ -1,140 +1,663 @@
 #include "passman/PasswordManager.h"
+#include "passman/EntryCodec.h"
+#include "utils/ThreadPool.h"
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <unordered_set>
 
 namespace passman {
 
 PasswordManager::PasswordManager(const std::string& dataDir)
-    : storage(dataDir) {
+    : unlockTarget(std::chrono::milliseconds(300)),
+      batchDepth(0),
+      dirty(false),
+      storage(dataDir),
+      history(dataDir),
+      chunks(dataDir) {
 }
 
-bool PasswordManager::initialize(const std::string& masterPassword) {
+bool PasswordManager::initialize(std::string_view masterPassword) {
+    if (hasMasterPassword()) {
+        return false;
+    }
+
+    kdfParams = PasswordKdf::calibrate(unlockTarget);
     masterSalt = crypto.generateSalt();
-    masterPasswordHash = crypto.customHash(masterPassword, masterSalt);
+    auto keys = PasswordKdf::derive(masterPassword, masterSalt, kdfParams);
+    masterPasswordHash = keys.verifier;
+    encryptionKey = std::move(keys.encryptionKey);
+    passwords.clear();
+    passwords.markAllDirty();
+    resetTableState();
+    vaultStamp = VaultStamp{};
+    return savePasswords();
+}
+
+bool PasswordManager::authenticate(std::string_view masterPassword) {
+    refresh();
+
+    Utils::SecureString derivedKey;
+    if (!verifyMasterPassword(masterPassword, &derivedKey)) {
+        return false;
+    }
+
+    // Already unlocked with this key, the cached entries are current
+    if (isUnlocked() && PasswordKdf::constantTimeEquals(derivedKey, encryptionKey)) {
+        return true;
+    }
+
+    EntryTable loaded;
+    if (!storage.loadPasswords(loaded, derivedKey, vaultStamp)) {
+        return false;
+    }
+    passwords.swap(loaded);
+    resetTableState();
+    encryptionKey = std::move(derivedKey);
+
+    // Vaults from before the KDF use the stored hash as their key; move them
+    // onto a derived key now that we have the password in hand. A vault still
+    // in the single-file layout loads fully dirty and is rewritten as shards.
+    if (kdfParams.isLegacy()) {
+        changeMasterPassword(masterPassword, masterPassword);
+    } else if (passwords.hasDirtyShards()) {
+        mutate([]() { return true; });
+    }
+    return true;
+}
+
+void PasswordManager::lock() {
+    if (batchDepth > 0) {
+        storage.release();
+    }
+    batchDepth = 0;
+    dirty = false;
+    forgetKey();
+}
+
+void PasswordManager::forgetKey() {
+    encryptionKey.clear();
+    chunks.close();
+    passwords.clear();
+    resetTableState();
+    vaultStamp = VaultStamp{};
+}
+
+bool PasswordManager::refresh() {
+    if (isUnlocked() && !storage.hasChangedSince(vaultStamp)) {
+        return true;
+    }
     return loadPasswords();
 }
 
-bool PasswordManager::authenticate(const std::string& masterPassword) const {
-    return verifyMasterPassword(masterPassword);
+bool PasswordManager::isUnlocked() const {
+    return !encryptionKey.empty();
 }
 
-bool PasswordManager::verifyMasterPassword(const std::string& inputPassword) const {
-    return crypto.customHash(inputPassword, masterSalt) == masterPasswordHash;
+void PasswordManager::setUnlockTarget(std::chrono::milliseconds target) {
+    unlockTarget = target;
 }
 
-bool PasswordManager::changeMasterPassword(const std::string& oldPassword, const std::string& newPassword) {
-    if (!verifyMasterPassword(oldPassword) || newPassword.empty()) {
+bool PasswordManager::verifyMasterPassword(std::string_view inputPassword, Utils::SecureString* derivedKey) const {
+    if (masterPasswordHash.empty()) {
         return false;
     }
 
-    std::string newSalt = crypto.generateSalt();
-    std::string newHash = crypto.customHash(newPassword, newSalt);
+    if (kdfParams.isLegacy()) {
+        std::string hash = crypto.customHash(inputPassword, masterSalt);
+        if (!PasswordKdf::constantTimeEquals(hash, masterPasswordHash)) {
+            return false;
+        }
+        if (derivedKey) {
+            derivedKey->assign(hash);
+        }
+        return true;
+    }
 
-    std::string oldHash = masterPasswordHash;
-    std::string oldSalt = masterSalt;
+    auto keys = PasswordKdf::derive(inputPassword, masterSalt, kdfParams);
+    if (!PasswordKdf::constantTimeEquals(keys.verifier, masterPasswordHash)) {
+        return false;
+    }
+    if (derivedKey) {
+        *derivedKey = std::move(keys.encryptionKey);
+    }
+    return true;
+}
 
-    masterPasswordHash = newHash;
-    masterSalt = newSalt;
+bool PasswordManager::changeMasterPassword(std::string_view oldPassword, std::string_view newPassword,
+                                           const PasswordRekeyer::ProgressCallback& progress) {
+    beginBatch();
+    bool changed = replaceMasterPassword(oldPassword, newPassword, progress);
+    commitBatch();
+    return changed;
+}
 
-    if (!savePasswords()) {
-        masterPasswordHash = oldHash;
-        masterSalt = oldSalt;
+bool PasswordManager::replaceMasterPassword(std::string_view oldPassword, std::string_view newPassword,
+                                            const PasswordRekeyer::ProgressCallback& progress) {
+    if (newPassword.empty() || !authenticate(oldPassword)) {
         return false;
     }
 
+    KdfParams newParams = PasswordKdf::calibrate(unlockTarget);
+    std::string newSalt = crypto.generateSalt();
+    auto newKeys = PasswordKdf::derive(newPassword, newSalt, newParams);
+
+    // Entries are still encrypted under the old key; re-encrypt a copy so the
+    // live vault stays valid until the new one has been committed.
+    EntryTable rekeyed;
+    PasswordRekeyer rekeyer(crypto);
+    if (!rekeyer.rekey(passwords, encryptionKey, newKeys.encryptionKey, rekeyed, progress)) {
+        return false;
+    }
+
+    // The history and the attachment key are re-encrypted alongside and published by the same commit
+    std::vector<std::string> staged;
+    if (!history.stageRekey(encryptionKey, newKeys.encryptionKey, crypto, staged) ||
+        !chunks.stageRekey(encryptionKey, newKeys.encryptionKey, staged)) {
+        std::error_code ec;
+        for (const auto& path : staged) {
+            std::filesystem::remove(path + ".tmp", ec);
+        }
+        return false;
+    }
+    if (!storage.commit(rekeyed, newKeys.encryptionKey, newKeys.verifier, newSalt, newParams, vaultStamp, staged)) {
+        return false;
+    }
+
+    passwords.swap(rekeyed);
+    passwords.clearDirty();
+    masterPasswordHash = newKeys.verifier;
+    masterSalt = newSalt;
+    kdfParams = newParams;
+    encryptionKey = std::move(newKeys.encryptionKey);
+    recordHistory(); // Changes made earlier in this batch went out with the re-keyed commit
     return true;
 }
 
-bool PasswordManager::addEntry(const std::string& service, const std::string& username, const std::string& password) {
-    std::string salt = crypto.generateSalt();
-    PasswordEntry entry{
-        service,
-        username,
-        crypto.encryptPassword(password, masterPasswordHash), // Use encryption with master password hash as key
-        "", // serviceLink is empty by default
-        salt
-    };
+bool PasswordManager::addEntry(const std::string& service, const std::string& username, std::string_view password,
+                               const std::string& serviceLink) {
+    if (!EntryCodec::isStorable(service) || !EntryCodec::isStorable(username) ||
+        !EntryCodec::isStorable(serviceLink)) {
+        return false;
+    }
 
-    passwords[service] = entry;
-    return savePasswords();
+    return mutate([&]() {
+        std::string salt = crypto.generateSalt();
+        PasswordEntry entry{
+            service,
+            username,
+            crypto.encryptPassword(password, encryptionKey), // Use encryption with the derived vault key
+            serviceLink,
+            salt,
+            "", // No tags
+            ""  // No attachments
+        };
+
+        putEntry(entry);
+        return true;
+    });
 }
 
 bool PasswordManager::removeEntry(const std::string& service) {
-    for (auto it = passwords.begin(); it != passwords.end(); ++it) {
-        if (getServiceKey(it->first) == getServiceKey(service)) {
-            passwords.erase(it);
-            return savePasswords();
-        }
-    }
-    return false;
+    return mutate([&]() {
+        return dropEntry(service);
+    });
 }
 
-    // Directly modifying entry instead of calling addEntry
-bool PasswordManager::updateEntry(const std::string& service, const std::string& username, const std::string& password) {
-    for (auto it = passwords.begin(); it != passwords.end(); ++it) {
-        if (getServiceKey(it->first) == getServiceKey(service)) {
-            std::string originalService = it->first;
-            return addEntry(originalService, username, password);
-        }
+bool PasswordManager::updateEntry(const std::string& service, const std::string& username, std::string_view password) {
+    if (!EntryCodec::isStorable(username)) {
+        return false;
     }
-    return false;
+
+    return mutate([&]() {
+        EntryView current;
+        if (!passwords.find(service, current)) {
+            return false;
+        }
+        PasswordEntry entry = current.toEntry();
+        entry.username = username;
+        entry.encryptedPassword = crypto.encryptPassword(password, encryptionKey);
+        entry.salt = crypto.generateSalt();
+        putEntry(entry);
+        return true;
+    });
 }
 
 std::vector<std::string> PasswordManager::listServices() const {
     std::vector<std::string> services;
     services.reserve(passwords.size());
-    for (const auto& pair : passwords) {
-        services.push_back(pair.first);
-    }
+    passwords.forEach([&](const EntryView& entry) {
+        services.emplace_back(entry.service);
+    });
     return services;
 }
 
 PasswordEntry PasswordManager::getEntry(const std::string& service) const {
-    for (const auto& pair : passwords) {
-        if (getServiceKey(pair.first) == getServiceKey(service)) {
-            return pair.second;
-        }
+    EntryView entry;
+    if (!passwords.find(service, entry)) {
+        return PasswordEntry{};
     }
-    return PasswordEntry{};
+    return entry.toEntry();
 }
 
 std::string PasswordManager::generatePassword(size_t length) const {
     return crypto.generatePassword(length);
 }
 
+bool PasswordManager::setTags(const std::string& service, const std::vector<std::string>& tags) {
+    std::string joined;
+    if (!EntryIndex::normalizeTags(tags, joined)) {
+        return false;
+    }
+
+    return mutate([&]() {
+        EntryView current;
+        if (!passwords.find(service, current)) {
+            return false;
+        }
+        PasswordEntry entry = current.toEntry();
+        entry.tags = joined;
+        putEntry(entry);
+        return true;
+    });
+}
+
+bool PasswordManager::query(const std::string& expression, std::vector<std::string>& services, std::string& error) {
+    std::vector<std::string> terms;
+    if (!EntryIndex::parseQuery(expression, terms, error)) {
+        return false;
+    }
+    if (!isUnlocked()) {
+        error = "The vault is locked";
+        return false;
+    }
+
+    if (!index.built()) {
+        index.build(passwords);
+    }
+    services = index.query(terms);
+    std::sort(services.begin(), services.end());
+    return true;
+}
+
+bool PasswordManager::setServiceLink(const std::string& service, const std::string& serviceLink) {
+    std::string host;
+    if (!EntryCodec::isStorable(serviceLink) ||
+        (!serviceLink.empty() && !DomainTrie::parseHost(serviceLink, host, true))) {
+        return false;
+    }
+
+    return mutate([&]() {
+        EntryView current;
+        if (!passwords.find(service, current)) {
+            return false;
+        }
+        PasswordEntry entry = current.toEntry();
+        entry.serviceLink = serviceLink;
+        putEntry(entry);
+        return true;
+    });
+}
+
+bool PasswordManager::match(const std::string& url, std::vector<std::string>& services, DomainTrie::Match& tier,
+                            std::string& error) {
+    std::string host;
+    if (!DomainTrie::parseHost(url, host)) {
+        error = "No valid host in '" + url + "'";
+        return false;
+    }
+    if (!isUnlocked()) {
+        error = "The vault is locked";
+        return false;
+    }
+
+    if (!index.built()) {
+        index.build(passwords);
+    }
+    tier = index.match(host, services);
+    std::sort(services.begin(), services.end());
+    return true;
+}
+
+bool PasswordManager::addEntries(const std::vector<PasswordRecord>& records) {
+    if (!isUnlocked()) {
+        return false;
+    }
+    for (const auto& record : records) {
+        if (!EntryCodec::isStorable(record.service) || !EntryCodec::isStorable(record.username) ||
+            !EntryCodec::isStorable(record.serviceLink)) {
+            return false;
+        }
+    }
+
+    const size_t batchSize = 4096;
+    std::vector<PasswordEntry> entries(records.size());
+    Utils::ThreadPool::shared().parallelFor(records.size(), batchSize, [&](size_t begin, size_t end) {
+        std::vector<std::string_view> inputs;
+        inputs.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            inputs.emplace_back(records[i].password);
+        }
+
+        CryptoBatch encrypted;
+        crypto.encryptMany(inputs, encryptionKey, encrypted);
+        std::vector<std::string> salts;
+        crypto.generateSalts(end - begin, salts);
+        for (size_t i = begin; i < end; ++i) {
+            entries[i] = PasswordEntry{
+                records[i].service,
+                records[i].username,
+                std::string(encrypted[i - begin]),
+                records[i].serviceLink,
+                std::move(salts[i - begin]),
+                "", // No tags
+                ""  // No attachments
+            };
+        }
+    });
+
+    // Encryption above runs outside the vault lock; only the merge needs it
+    return mutate([&]() {
+        for (const auto& entry : entries) {
+            putEntry(entry);
+        }
+        return true;
+    });
+}
+
+bool PasswordManager::forEachDecrypted(const std::function<void(const std::vector<PasswordRecord>&)>& sink,
+                                       size_t batchSize) const {
+    if (!isUnlocked()) {
+        return false;
+    }
+
+    batchSize = std::max<size_t>(1, batchSize);
+    std::vector<EntryView> entries;
+    entries.reserve(passwords.size());
+    passwords.forEach([&](const EntryView& entry) {
+        entries.push_back(entry);
+    });
+
+    std::vector<PasswordRecord> records;
+    for (size_t start = 0; start < entries.size(); start += batchSize) {
+        size_t count = std::min(batchSize, entries.size() - start);
+        records.assign(count, PasswordRecord{});
+
+        std::atomic<bool> valid{true};
+        Utils::ThreadPool::shared().parallelFor(count, 4096, [&](size_t begin, size_t end) {
+            std::vector<std::string_view> inputs;
+            inputs.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                inputs.emplace_back(entries[start + i].encryptedPassword);
+            }
+
+            CryptoBatch plain;
+            if (!crypto.decryptMany(inputs, encryptionKey, plain)) {
+                valid = false;
+            }
+            for (size_t i = begin; i < end; ++i) {
+                const EntryView& entry = entries[start + i];
+                records[i] = PasswordRecord{std::string(entry.service), std::string(entry.username),
+                                            std::string(plain[i - begin]), std::string(entry.serviceLink)};
+            }
+        });
+
+        if (!valid) {
+            return false;
+        }
+        sink(records);
+    }
+    return true;
+}
+
+void PasswordManager::beginBatch() {
+    if (batchDepth++ == 0) {
+        storage.hold(VaultLock::Mode::Exclusive);
+        refresh();
+    }
+}
+
+bool PasswordManager::commitBatch() {
+    if (batchDepth == 0) {
+        return false;
+    }
+    if (--batchDepth > 0) {
+        return true;
+    }
+
+    bool saved = !dirty || savePasswords();
+    if (saved) {
+        dirty = false;
+    }
+    storage.release();
+    return saved;
+}
+
+bool PasswordManager::mutate(const std::function<bool()>& change) {
+    beginBatch();
+    bool changed = isUnlocked() && change();
+    if (changed) {
+        dirty = true;
+    }
+    bool saved = commitBatch();
+    return changed && saved;
+}
+
 bool PasswordManager::loadPasswords() {
-    if (storage.loadMasterPassword(masterPasswordHash, masterSalt)) {
-        return storage.loadPasswords(passwords, masterPasswordHash);
+    // Read the master record and the entries from the same commit
+    if (!storage.hold(VaultLock::Mode::Shared)) {
+        return false;
+    }
+
+    std::string hash, salt;
+    KdfParams params;
+    if (!storage.loadMasterPassword(hash, salt, params)) {
+        storage.release();
+        return true; // New file is not an error
+    }
+    if (isUnlocked() && hash != masterPasswordHash) {
+        forgetKey(); // Re-keyed by another process, the cached key no longer opens the vault
+    }
+    masterPasswordHash = hash;
+    masterSalt = salt;
+    kdfParams = params;
+
+    bool success = true;
+    if (isUnlocked()) {
+        EntryTable loaded;
+        success = storage.loadPasswords(loaded, encryptionKey, vaultStamp);
+        if (success) {
+            passwords.swap(loaded);
+            resetTableState();
+        }
     }
-    return true; // New file is not an error
+    storage.release();
+    return success;
 }
 
-bool PasswordManager::savePasswords() const {
-    if (!storage.saveMasterPassword(masterPasswordHash, masterSalt)) {
+bool PasswordManager::savePasswords() {
+    if (!isUnlocked()) {
+        return false;
+    }
+
+    // Split shards that have grown well past their target size
+    size_t shardCount = EntryTable::recommendedShardCount(passwords.size());
+    if (shardCount > passwords.shardCount() * 2) {
+        passwords.reshard(shardCount);
+    }
+
+    if (!storage.commit(passwords, encryptionKey, masterPasswordHash, masterSalt, kdfParams, vaultStamp)) {
         return false;
     }
-    return storage.savePasswords(passwords, masterPasswordHash);
+    passwords.clearDirty();
+    recordHistory();
+    return true;
+}
+
+Utils::SecureString PasswordManager::getPassword(const std::string& service) const {
+    EntryView entry;
+    if (!passwords.find(service, entry)) {
+        return Utils::SecureString();
+    }
+    return crypto.decryptPassword(entry.encryptedPassword, encryptionKey);
 }
 
-std::string PasswordManager::getPassword(const std::string& service) const {
-    for (const auto& pair : passwords) {
-        if (getServiceKey(pair.first) == getServiceKey(service)) {
-            return crypto.decryptPassword(pair.second.encryptedPassword, masterPasswordHash);
+bool PasswordManager::getHistory(const std::string& service, std::vector<HistoryVersion>& versions) const {
+    if (!isUnlocked()) {
+        return false;
+    }
+    return history.versions(service, encryptionKey, versions);
+}
+
+bool PasswordManager::restoreVersion(const std::string& service, uint64_t generation) {
+    std::vector<HistoryVersion> versions;
+    if (!getHistory(service, versions)) {
+        return false;
+    }
+    auto version = std::find_if(versions.begin(), versions.end(), [generation](const HistoryVersion& v) {
+        return v.generation == generation;
+    });
+    if (version == versions.end()) {
+        return false;
+    }
+
+    return mutate([&]() {
+        if (version->removed) {
+            return dropEntry(service);
+        }
+        putEntry(version->entry);
+        return true;
+    });
+}
+
+bool PasswordManager::attach(const std::string& service, const std::string& name, std::istream& input,
+                             ChunkWriteStats* stats) {
+    if (!ChunkStore::isValidName(name) || getEntry(service).service.empty() || !openChunks()) {
+        return false;
+    }
+
+    // Chunks are content-addressed, so storing them needs no vault lock
+    AttachmentRef ref;
+    ref.name = name;
+    if (!chunks.write(input, ref.recipe, ref.size, stats)) {
+        return false;
+    }
+
+    return mutate([&]() {
+        EntryView current;
+        std::vector<AttachmentRef> refs;
+        if (!passwords.find(service, current) || !ChunkStore::parseRefs(current.attachments, refs)) {
+            return false;
+        }
+        auto existing = std::find_if(refs.begin(), refs.end(), [&](const AttachmentRef& r) { return r.name == name; });
+        if (existing != refs.end()) {
+            *existing = ref;
+        } else {
+            refs.push_back(ref);
+        }
+        PasswordEntry entry = current.toEntry();
+        entry.attachments = ChunkStore::formatRefs(refs);
+        putEntry(entry);
+        return true;
+    });
+}
+
+bool PasswordManager::extract(const std::string& service, const std::string& name, std::ostream& output) {
+    std::vector<AttachmentRef> refs;
+    if (!listAttachments(service, refs) || !openChunks()) {
+        return false;
+    }
+    auto ref = std::find_if(refs.begin(), refs.end(), [&](const AttachmentRef& r) { return r.name == name; });
+    return ref != refs.end() && chunks.read(ref->recipe, output);
+}
+
+bool PasswordManager::detach(const std::string& service, const std::string& name) {
+    return mutate([&]() {
+        EntryView current;
+        std::vector<AttachmentRef> refs;
+        if (!passwords.find(service, current) || !ChunkStore::parseRefs(current.attachments, refs)) {
+            return false;
+        }
+        auto existing = std::find_if(refs.begin(), refs.end(), [&](const AttachmentRef& r) { return r.name == name; });
+        if (existing == refs.end()) {
+            return false;
+        }
+        // The chunks stay, older versions in the history may still refer to them
+        refs.erase(existing);
+        PasswordEntry entry = current.toEntry();
+        entry.attachments = ChunkStore::formatRefs(refs);
+        putEntry(entry);
+        return true;
+    });
+}
+
+bool PasswordManager::listAttachments(const std::string& service, std::vector<AttachmentRef>& refs) const {
+    EntryView entry;
+    return passwords.find(service, entry) && ChunkStore::parseRefs(entry.attachments, refs);
+}
+
+bool PasswordManager::openChunks() {
+    if (!isUnlocked() || chunks.isOpen()) {
+        return isUnlocked();
+    }
+
+    // Under the exclusive lock no other process can create the content key
+    // or re-key the vault; a re-key since our last read locks us out here
+    beginBatch();
+    bool opened = isUnlocked() && chunks.open(encryptionKey);
+    commitBatch();
+    return opened;
+}
+
+void PasswordManager::putEntry(const EntryView& entry) {
+    if (index.built()) {
+        index.add(entry);
+    }
+    passwords.insert(entry);
+    pendingChanges.emplace_back(entry.service);
+}
+
+bool PasswordManager::dropEntry(const std::string& service) {
+    if (index.built()) {
+        index.remove(service);
+    }
+    if (!passwords.erase(service)) {
+        return false;
+    }
+    pendingChanges.push_back(service);
+    return true;
+}
+
+void PasswordManager::recordHistory() {
+    if (pendingChanges.empty()) {
+        return;
+    }
+
+    std::unordered_set<std::string> seen;
+    std::vector<HistoryChange> changes;
+    changes.reserve(pendingChanges.size());
+    for (const auto& service : pendingChanges) {
+        if (!seen.insert(normalizeServiceName(service)).second) {
+            continue;
+        }
+        HistoryChange change;
+        change.removed = !passwords.find(service, change.entry);
+        if (change.removed) {
+            change.entry.service = service;
         }
+        changes.push_back(change);
     }
-    return "";
+    history.record(vaultStamp.generation, changes, encryptionKey);
+    pendingChanges.clear();
 }
 
-std::string PasswordManager::getServiceKey(const std::string& service) const {
-    std::string key = service;
-    std::transform(key.begin(), key.end(), key.begin(),
-                   [](unsigned char c){ return std::tolower(c); });
-    return key;
+void PasswordManager::resetTableState() {
+    index.clear();
+    pendingChanges.clear();
 }
 
 bool PasswordManager::hasMasterPassword() const {
-    std::string tempHash, tempSalt;
-    return storage.loadMasterPassword(tempHash, tempSalt);
+    return storage.hasMasterRecord();
 }
 
 bool PasswordManager::load() {
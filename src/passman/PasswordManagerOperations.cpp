@@ -1,53 +1,45 @@
 #include "passman/PasswordManagerOperations.h"
+#include "passman/PasswordAuditor.h"
+#include "passman/PasswordTransfer.h"
+#include "utils/Utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
-PasswordManagerOperations::PasswordManagerOperations() : initialized(false) {}
+PasswordManagerOperations::PasswordManagerOperations(const std::string& dataDir)
+    : passwordManager(dataDir), initialized(false), output(&std::cout) {
+    // Taken out of the environment before the shell starts any program, so
+    // nothing it runs inherits the master password
+    if (const char* fromEnvironment = std::getenv("SECURESHELL_PASSMAN_PASSWORD")) {
+        scriptedPassword.assign(fromEnvironment);
+#ifdef _WIN32
+        _putenv_s("SECURESHELL_PASSMAN_PASSWORD", "");
+#else
+        unsetenv("SECURESHELL_PASSMAN_PASSWORD");
+#endif
+    }
+}
 
-void PasswordManagerOperations::passman(const std::vector<std::string>& args) {
-    bool masterPasswordExists = passwordManager.hasMasterPassword();
-    
-    if (!masterPasswordExists && !initialized) {
-        std::cout << "Password Manager - First Time Setup\n";
-        std::cout << "\nPlease create a master password: ";
-        std::string masterPassword = Utils::readMaskedPassword();
-        
-        if (masterPassword.empty()) {
-            std::cout << "Master password cannot be empty.\n";
-            return;
-        }
-        
-        if (!Utils::validatePasswordStrength(masterPassword)) {
-            std::cout << "Password is too weak.\nIt must be at least 8 characters long and contain letters, special characters and numbers.\n";
-            return;
-        }
-        
-        if (passwordManager.initialize(masterPassword)) {
-            std::cout << "Password Manager initialized successfully.\n";
-            initialized = true;
-        } else {
-            std::cout << "Failed to initialize Password Manager.\n";
-            return;
-        }
-    } else {
-        if (masterPasswordExists && !initialized) {
-            passwordManager.load();
-            initialized = true;
-        }
+bool PasswordManagerOperations::passman(const std::vector<std::string>& args, std::ostream& out) {
+    output = &out;
 
-        std::cout << "\n====  Password Manager  =====\n\n";
-        std::cout << "Enter master password: ";
-        std::string masterPassword = Utils::readMaskedPassword();
-        
-        if (!passwordManager.authenticate(masterPassword)) {
-            std::cout << "\nAuthentication failed. Incorrect master password.\n";
-            return;
-        }
-        
-        std::cout << "\n***  Authentication successful ***\n\n";
-        std::cout << "***  Welcome to Password Manager ***\n";
+    // Generating passwords touches no vault data and needs no unlock
+    if (!args.empty() && args[0] == "gen") {
+        return generateCommand(args);
+    }
 
+    if (!unlock()) {
+        return false;
     }
-    
+
+    if (!args.empty()) {
+        return runSubcommand(args);
+    }
+
     bool running = true;
     while (running) {
         std::cout << "\nPassword Manager Commands:\n";
@@ -63,6 +55,12 @@ void PasswordManagerOperations::passman(const std::vector<std::string>& args) {
         
         std::string choice;
         std::getline(std::cin, choice);
+
+        passwordManager.refresh();
+        if (!passwordManager.isUnlocked()) {
+            std::cout << "The master password was changed in another session. Please unlock again.\n";
+            break;
+        }
         
         if (choice == "1") {
             addPassword();
@@ -80,16 +78,743 @@ void PasswordManagerOperations::passman(const std::vector<std::string>& args) {
             changeMasterPassword();
         } else if (choice == "8") {
             std::cout << "Exiting Password Manager...\n";
+            passwordManager.lock();
             running = false;
         } else {
             std::cout << "Invalid choice. Please try again.\n";
         }
     }
+    return true;
+}
+
+bool PasswordManagerOperations::unlock() {
+    // Subcommands keep the vault unlocked until "passman lock"; pick up
+    // anything another shell committed in the meantime
+    if (passwordManager.isUnlocked() && passwordManager.refresh() && passwordManager.isUnlocked()) {
+        return true;
+    }
+
+    bool masterPasswordExists = passwordManager.hasMasterPassword();
+    
+    if (!masterPasswordExists && !initialized) {
+        std::cout << "Password Manager - First Time Setup\n";
+        std::cout << "\nPlease create a master password: ";
+        Utils::SecureString masterPassword = Utils::readMaskedPassword();
+        
+        if (masterPassword.empty()) {
+            std::cout << "Master password cannot be empty.\n";
+            return false;
+        }
+        
+        if (!Utils::validatePasswordStrength(masterPassword)) {
+            std::cout << "Password is too weak.\nIt must be at least 8 characters long and contain letters, special characters and numbers.\n";
+            return false;
+        }
+        
+        if (passwordManager.initialize(masterPassword)) {
+            std::cout << "Password Manager initialized successfully.\n";
+            initialized = true;
+        } else {
+            std::cout << "Failed to initialize Password Manager.\n";
+            return false;
+        }
+    } else {
+        if (masterPasswordExists && !initialized) {
+            passwordManager.load();
+            initialized = true;
+        }
+
+        // Scripts can supply the master password instead of typing it
+        if (!scriptedPassword.empty()) {
+            if (!passwordManager.authenticate(scriptedPassword)) {
+                std::cout << "Authentication failed. Incorrect master password.\n";
+                return false;
+            }
+            return true;
+        }
+
+        std::cout << "\n====  Password Manager  =====\n\n";
+        std::cout << "Enter master password: ";
+        Utils::SecureString masterPassword = Utils::readMaskedPassword();
+        
+        if (!passwordManager.authenticate(masterPassword)) {
+            std::cout << "\nAuthentication failed. Incorrect master password.\n";
+            return false;
+        }
+        
+        std::cout << "\n***  Authentication successful ***\n\n";
+        std::cout << "***  Welcome to Password Manager ***\n";
+
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::runSubcommand(const std::vector<std::string>& args) {
+    const std::string& command = args[0];
+    if (command == "get") {
+        return getCommand(args);
+    } else if (command == "add") {
+        return addCommand(args);
+    } else if (command == "rm") {
+        return removeCommand(args);
+    } else if (command == "ls") {
+        return listCommand(args);
+    } else if (command == "tag") {
+        return tagCommand(args);
+    } else if (command == "query") {
+        return queryCommand(args);
+    } else if (command == "url") {
+        return urlCommand(args);
+    } else if (command == "match") {
+        return matchCommand(args);
+    } else if (command == "history") {
+        return historyCommand(args);
+    } else if (command == "restore") {
+        return restoreCommand(args);
+    } else if (command == "attach") {
+        return attachCommand(args);
+    } else if (command == "attachments") {
+        return attachmentsCommand(args);
+    } else if (command == "extract") {
+        return extractCommand(args);
+    } else if (command == "detach") {
+        return detachCommand(args);
+    } else if (command == "note") {
+        return noteCommand(args);
+    } else if (command == "gen") {
+        return generateCommand(args);
+    } else if (command == "batch") {
+        return batchCommand(args);
+    } else if (command == "audit") {
+        return auditCommand(args);
+    } else if (command == "import") {
+        return importPasswords(args);
+    } else if (command == "export") {
+        return exportPasswords(args);
+    } else if (command == "lock") {
+        passwordManager.lock();
+        *output << "Password Manager locked.\n";
+        return true;
+    }
+
+    *output << "Unknown passman command: " << command << "\n";
+    *output << "Usage: passman [get <service> [password|username|url|tags]\n"
+            << "               | add <service> <username> [password] [--url URL] | rm <service> | ls [filter]\n"
+            << "               | tag <service> [tag...] | query <terms> | url <service> [URL] | match <URL>\n"
+            << "               | history <service> | restore <service> <version>\n"
+            << "               | attach <service> <file> [name] | attachments <service>\n"
+            << "               | extract <service> <name> [file] | detach <service> <name> | note <service> [text]\n"
+            << "               | gen [length] [--count N] [--policy NAME]\n"
+            << "               | batch <file> | audit | import <file> | export <file> | lock]\n";
+    return false;
+}
+
+bool PasswordManagerOperations::getCommand(const std::vector<std::string>& args) {
+    if (args.size() < 2 || args.size() > 3) {
+        *output << "Usage: passman get <service> [password|username|url|tags]\n";
+        return false;
+    }
+
+    auto entry = passwordManager.getEntry(args[1]);
+    if (entry.service.empty()) {
+        *output << "No password found for service: " << args[1] << "\n";
+        return false;
+    }
+
+    std::string field = args.size() == 3 ? args[2] : "password";
+    if (field == "password") {
+        *output << passwordManager.getPassword(entry.service) << "\n";
+    } else if (field == "username") {
+        *output << entry.username << "\n";
+    } else if (field == "url") {
+        *output << entry.serviceLink << "\n";
+    } else if (field == "tags") {
+        *output << entry.tags << "\n";
+    } else {
+        *output << "Unknown field: " << field << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::addCommand(const std::vector<std::string>& args) {
+    std::vector<std::string> positional;
+    std::string url;
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--url" && i + 1 < args.size()) {
+            url = args[++i];
+        } else {
+            positional.push_back(args[i]);
+        }
+    }
+    if (positional.size() < 2 || positional.size() > 3) {
+        *output << "Usage: passman add <service> <username> [password] [--url URL]\n";
+        return false;
+    }
+
+    std::string host;
+    if (!url.empty() && !passman::DomainTrie::parseHost(url, host, true)) {
+        *output << "Invalid URL: " << url << "\n";
+        return false;
+    }
+
+    std::string password = positional.size() == 3 ? positional[2] : "";
+    if (password.empty()) {
+        password = Utils::generateRandomString(16);
+        *output << "Generated password for " << positional[0] << ": " << password << "\n";
+    }
+
+    if (!passwordManager.addEntry(positional[0], positional[1], password, url)) {
+        *output << "Failed to add password for " << positional[0] << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::removeCommand(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        *output << "Usage: passman rm <service>\n";
+        return false;
+    }
+
+    if (!passwordManager.removeEntry(args[1])) {
+        *output << "Failed to remove password. Service not found: " << args[1] << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::listCommand(const std::vector<std::string>& args) {
+    if (args.size() > 2) {
+        *output << "Usage: passman ls [filter]\n";
+        return false;
+    }
+
+    std::string filter = args.size() == 2 ? Utils::toLower(args[1]) : "";
+    auto services = passwordManager.listServices();
+    std::sort(services.begin(), services.end());
+
+    std::string out;
+    for (const auto& service : services) {
+        if (filter.empty() || Utils::toLower(service).find(filter) != std::string::npos) {
+            out += service;
+            out += '\n';
+        }
+    }
+    *output << out;
+    return true;
+}
+
+bool PasswordManagerOperations::tagCommand(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        *output << "Usage: passman tag <service> [tag...]\n";
+        return false;
+    }
+
+    std::vector<std::string> tags(args.begin() + 2, args.end());
+    std::string joined;
+    if (!passman::EntryIndex::normalizeTags(tags, joined)) {
+        *output << "Invalid tag. Tags may only use letters, digits and -_.:/\n";
+        return false;
+    }
+    if (!passwordManager.setTags(args[1], tags)) {
+        *output << "Failed to tag. Service not found: " << args[1] << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::queryCommand(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        *output << "Usage: passman query 'user=<username> tag=<tag> ...'\n";
+        return false;
+    }
+
+    // Terms may arrive as one quoted argument or several
+    std::string expression;
+    for (size_t i = 1; i < args.size(); ++i) {
+        expression += args[i];
+        expression += ' ';
+    }
+
+    std::vector<std::string> services;
+    std::string error;
+    if (!passwordManager.query(expression, services, error)) {
+        *output << "Query failed: " << error << "\n";
+        return false;
+    }
+
+    std::string out;
+    for (const auto& service : services) {
+        out += service;
+        out += '\n';
+    }
+    *output << out;
+    return true;
+}
+
+bool PasswordManagerOperations::urlCommand(const std::vector<std::string>& args) {
+    if (args.size() < 2 || args.size() > 3) {
+        *output << "Usage: passman url <service> [URL]\n";
+        return false;
+    }
+
+    std::string url = args.size() == 3 ? args[2] : "";
+    std::string host;
+    if (!url.empty() && !passman::DomainTrie::parseHost(url, host, true)) {
+        *output << "Invalid URL: " << url << "\n";
+        return false;
+    }
+    if (!passwordManager.setServiceLink(args[1], url)) {
+        *output << "Failed to set URL. Service not found: " << args[1] << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::matchCommand(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        *output << "Usage: passman match <URL>\n";
+        return false;
+    }
+
+    std::vector<std::string> services;
+    passman::DomainTrie::Match tier;
+    std::string error;
+    if (!passwordManager.match(args[1], services, tier, error)) {
+        *output << "Match failed: " << error << "\n";
+        return false;
+    }
+
+    if (services.empty()) {
+        *output << "No entry matches " << args[1] << "\n";
+        return false;
+    }
+
+    const char* label = tier == passman::DomainTrie::Match::Exact ? "exact"
+                      : tier == passman::DomainTrie::Match::Domain ? "domain"
+                      : "wildcard";
+    std::string out;
+    for (const auto& service : services) {
+        out += service;
+        out += '\t';
+        out += label;
+        out += '\n';
+    }
+    *output << out;
+    return true;
+}
+
+bool PasswordManagerOperations::historyCommand(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        *output << "Usage: passman history <service>\n";
+        return false;
+    }
+
+    std::vector<passman::HistoryVersion> versions;
+    if (!passwordManager.getHistory(args[1], versions)) {
+        *output << "Failed to read the history of " << args[1] << ".\n";
+        return false;
+    }
+    if (versions.empty()) {
+        *output << "No recorded history for " << args[1] << ".\n";
+        return false;
+    }
+
+    bool exists = !passwordManager.getEntry(args[1]).service.empty();
+    for (size_t i = 0; i < versions.size(); ++i) {
+        const auto& version = versions[i];
+        std::time_t time = static_cast<std::time_t>(version.timestamp);
+        char date[32] = "";
+        if (const std::tm* local = std::localtime(&time)) {
+            std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", local);
+        }
+
+        *output << "v" << version.generation << "  " << date << "  ";
+        if (version.removed) {
+            *output << "(removed)";
+        } else {
+            *output << version.entry.username;
+            if (!version.entry.serviceLink.empty()) {
+                *output << "  " << version.entry.serviceLink;
+            }
+        }
+        if (i == 0 && exists != version.removed) {
+            *output << "  (current)";
+        }
+        *output << "\n";
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::restoreCommand(const std::vector<std::string>& args) {
+    if (args.size() != 3) {
+        *output << "Usage: passman restore <service> <version>\n";
+        return false;
+    }
+
+    std::string text = args[2];
+    if (!text.empty() && (text[0] == 'v' || text[0] == 'V')) {
+        text.erase(0, 1);
+    }
+    uint64_t generation = 0;
+    try {
+        size_t used = 0;
+        generation = std::stoull(text, &used);
+        if (used != text.size()) {
+            throw std::invalid_argument(text);
+        }
+    } catch (const std::exception&) {
+        *output << "Invalid version: " << args[2] << "\n";
+        return false;
+    }
+
+    if (!passwordManager.restoreVersion(args[1], generation)) {
+        *output << "Failed to restore " << args[1] << " to v" << generation
+                << ". See 'passman history " << args[1] << "' for its versions.\n";
+        return false;
+    }
+    *output << "Restored " << args[1] << " to v" << generation << ".\n";
+    return true;
+}
+
+bool PasswordManagerOperations::attachCommand(const std::vector<std::string>& args) {
+    if (args.size() < 3 || args.size() > 4) {
+        *output << "Usage: passman attach <service> <file> [name]\n";
+        return false;
+    }
+
+    std::string name = args.size() == 4 ? args[3] : std::filesystem::path(args[2]).filename().string();
+    if (!passman::ChunkStore::isValidName(name)) {
+        *output << "Invalid attachment name: " << name << ". Names may only use letters, digits and ._-\n";
+        return false;
+    }
+    std::ifstream file(args[2], std::ios::binary);
+    if (!file.is_open()) {
+        *output << "Cannot open file: " << args[2] << "\n";
+        return false;
+    }
+
+    passman::ChunkWriteStats stats;
+    if (!passwordManager.attach(args[1], name, file, &stats)) {
+        *output << "Failed to attach " << args[2] << " to " << args[1] << ".\n";
+        return false;
+    }
+    *output << "Attached " << name << " to " << args[1] << " (" << stats.newChunks << " of "
+            << stats.chunks << " chunks new, " << stats.storedBytes << " bytes stored).\n";
+    return true;
+}
+
+bool PasswordManagerOperations::attachmentsCommand(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        *output << "Usage: passman attachments <service>\n";
+        return false;
+    }
+
+    std::vector<passman::AttachmentRef> refs;
+    if (!passwordManager.listAttachments(args[1], refs)) {
+        *output << "No password found for service: " << args[1] << "\n";
+        return false;
+    }
+
+    std::string out;
+    for (const auto& ref : refs) {
+        out += ref.name;
+        out += '\t';
+        out += std::to_string(ref.size);
+        out += '\n';
+    }
+    *output << out;
+    return true;
+}
+
+bool PasswordManagerOperations::extractCommand(const std::vector<std::string>& args) {
+    if (args.size() < 3 || args.size() > 4) {
+        *output << "Usage: passman extract <service> <name> [file]\n";
+        return false;
+    }
+
+    bool extracted;
+    if (args.size() == 4) {
+        std::ofstream file(args[3], std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            *output << "Cannot write file: " << args[3] << "\n";
+            return false;
+        }
+        extracted = passwordManager.extract(args[1], args[2], file);
+    } else {
+        extracted = passwordManager.extract(args[1], args[2], *output);
+    }
+
+    if (!extracted) {
+        *output << "Failed to extract " << args[2] << " from " << args[1] << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::detachCommand(const std::vector<std::string>& args) {
+    if (args.size() != 3) {
+        *output << "Usage: passman detach <service> <name>\n";
+        return false;
+    }
+
+    if (!passwordManager.detach(args[1], args[2])) {
+        *output << "No attachment " << args[2] << " on " << args[1] << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::noteCommand(const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        *output << "Usage: passman note <service> [text...]\n";
+        return false;
+    }
+
+    // A note is just the attachment named "note"
+    if (args.size() == 2) {
+        std::ostringstream note;
+        if (!passwordManager.extract(args[1], "note", note)) {
+            *output << "No note on " << args[1] << ".\n";
+            return false;
+        }
+        *output << note.str() << "\n";
+        return true;
+    }
+
+    std::string text;
+    for (size_t i = 2; i < args.size(); ++i) {
+        if (i > 2) {
+            text += ' ';
+        }
+        text += args[i];
+    }
+    std::istringstream input(text);
+    if (!passwordManager.attach(args[1], "note", input)) {
+        *output << "Failed to save the note. Service not found: " << args[1] << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PasswordManagerOperations::generateCommand(const std::vector<std::string>& args) {
+    const char* usage = "Usage: passman gen [length] [--count N] [--length L] [--policy NAME]\n";
+    size_t length = 16;
+    size_t count = 1;
+    passman::PasswordPolicy policy;
+
+    auto parseNumber = [](const std::string& text, size_t& value) {
+        try {
+            size_t used = 0;
+            value = std::stoul(text, &used);
+            return used == text.size();
+        } catch (const std::exception&) {
+            return false;
+        }
+    };
+
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if ((arg == "--count" || arg == "-n") && hasValue) {
+            if (!parseNumber(args[++i], count) || count == 0) {
+                *output << "Invalid count: " << args[i] << "\n";
+                return false;
+            }
+        } else if ((arg == "--length" || arg == "-l") && hasValue) {
+            if (!parseNumber(args[++i], length)) {
+                *output << "Invalid length: " << args[i] << "\n";
+                return false;
+            }
+        } else if ((arg == "--policy" || arg == "-p") && hasValue) {
+            if (!passman::PasswordPolicy::parse(args[++i], policy)) {
+                *output << "Unknown policy: " << args[i] << " (expected " << passman::PasswordPolicy::names() << ")\n";
+                return false;
+            }
+        } else if (arg[0] != '-' && parseNumber(arg, length)) {
+            continue;
+        } else {
+            *output << usage;
+            return false;
+        }
+    }
+
+    if (length < std::max<size_t>(policy.minLength, 4) || length > 1024) {
+        *output << "Password length must be between " << std::max<size_t>(policy.minLength, 4) << " and 1024.\n";
+        return false;
+    }
+
+    // Generate and write in chunks so huge counts stream with bounded memory
+    const size_t chunkSize = 1 << 20;
+    std::string lines;
+    for (size_t done = 0; done < count && *output; done += chunkSize) {
+        size_t chunk = std::min(chunkSize, count - done);
+        crypto.generatePasswords(chunk, length, policy, lines);
+        output->write(lines.data(), static_cast<std::streamsize>(lines.size()));
+    }
+    output->flush();
+    return true;
+}
+
+bool PasswordManagerOperations::batchCommand(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        *output << "Usage: passman batch <file>\n";
+        return false;
+    }
+
+    std::ifstream file(args[1]);
+    if (!file.is_open()) {
+        *output << "Error: Cannot open file '" << args[1] << "'\n";
+        return false;
+    }
+
+    // Every operation in the file shares this unlock and a single save
+    passwordManager.beginBatch();
+    size_t lineNumber = 0;
+    size_t executed = 0;
+    size_t failed = 0;
+    std::string line;
+    std::string buffer;
+    std::vector<std::string_view> words;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back(); // Written on Windows
+        }
+        // Quoted exactly as when typed at the prompt
+        Utils::splitWords(line, buffer, words);
+        if (words.empty() || (!words[0].empty() && words[0].front() == '#')) {
+            continue;
+        }
+        std::vector<std::string> lineArgs(words.begin(), words.end());
+        if (lineArgs[0] == "passman") {
+            lineArgs.erase(lineArgs.begin());
+            if (lineArgs.empty()) {
+                continue;
+            }
+        }
+
+        bool success;
+        if (lineArgs[0] == "batch" || lineArgs[0] == "lock") {
+            *output << "'" << lineArgs[0] << "' is not allowed inside a batch file.\n";
+            success = false;
+        } else {
+            success = runSubcommand(lineArgs);
+        }
+
+        ++executed;
+        if (!success) {
+            ++failed;
+            *output << "  (line " << lineNumber << ")\n";
+        }
+    }
+
+    if (!passwordManager.commitBatch()) {
+        *output << "Failed to save the vault. No changes from '" << args[1] << "' were written.\n";
+        return false;
+    }
+
+    *output << "Batch complete: " << executed << " operations, " << failed << " failed.\n";
+    return failed == 0;
+}
+
+bool PasswordManagerOperations::auditCommand(const std::vector<std::string>& args) {
+    if (args.size() != 1) {
+        *output << "Usage: passman audit\n";
+        return false;
+    }
+
+    *output << "Auditing " << passwordManager.size() << " entries...\n";
+    passman::PasswordAuditor auditor(passwordManager);
+    passman::AuditReport report;
+    std::ostream& out = *output;
+    bool success = auditor.run([&out](const passman::AuditFinding& finding) {
+        out << "WEAK    " << finding.service;
+        if (!finding.username.empty()) {
+            out << " (" << finding.username << ")";
+        }
+        out << ": " << (finding.meetsRules ? "low entropy" : "fails strength rules")
+            << ", ~" << static_cast<int>(finding.entropyBits) << " bits\n";
+    }, report);
+
+    if (!success) {
+        *output << "Audit failed: the vault could not be decrypted.\n";
+        return false;
+    }
+
+    size_t reusedEntries = 0;
+    for (const auto& group : report.reused) {
+        reusedEntries += group.size();
+        *output << "REUSED  " << group.size() << " services share a password: ";
+        for (size_t i = 0; i < group.size(); ++i) {
+            *output << (i ? ", " : "") << group[i];
+        }
+        *output << "\n";
+    }
+
+    *output << "\nAudited " << report.entries << " entries in " << report.seconds << "s: "
+            << report.weak << " weak, " << reusedEntries << " reused across "
+            << report.reused.size() << " groups.\n";
+    return true;
+}
+
+bool PasswordManagerOperations::importPasswords(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        *output << "Usage: passman import <file.csv|file.json>\n";
+        return false;
+    }
+
+    passman::TransferFormat format;
+    if (!passman::PasswordTransfer::formatFromPath(args[1], format)) {
+        *output << "Unsupported file type. Use a .csv or .json file.\n";
+        return false;
+    }
+
+    passman::PasswordTransfer transfer(passwordManager);
+    passman::TransferStats stats;
+    std::string error;
+    bool success = transfer.importFile(args[1], format, stats, error);
+
+    *output << "Imported " << stats.processed << " entries";
+    if (stats.skipped > 0) {
+        *output << " (" << stats.skipped << " skipped without a name or password, or with '|' or a line break in a field)";
+    }
+    *output << " in " << stats.seconds << "s.\n";
+    if (!success) {
+        *output << "Import failed: " << error << "\n";
+    }
+    return success;
+}
+
+bool PasswordManagerOperations::exportPasswords(const std::vector<std::string>& args) {
+    if (args.size() != 2) {
+        *output << "Usage: passman export <file.csv|file.json>\n";
+        return false;
+    }
+
+    passman::TransferFormat format;
+    if (!passman::PasswordTransfer::formatFromPath(args[1], format)) {
+        *output << "Unsupported file type. Use a .csv or .json file.\n";
+        return false;
+    }
+
+    *output << "Warning: the exported file contains every password in plain text.\n";
+
+    passman::PasswordTransfer transfer(passwordManager);
+    passman::TransferStats stats;
+    std::string error;
+    if (!transfer.exportFile(args[1], format, stats, error)) {
+        *output << "Export failed: " << error << "\n";
+        return false;
+    }
+    *output << "Exported " << stats.processed << " entries to '" << args[1] << "' in " << stats.seconds << "s.\n";
+    return true;
 }
 
 void PasswordManagerOperations::addPassword() {
     std::cout << "\n---- Add password ----\n\n";
-    std::string service, username, password;
+    std::string service, username;
     
     std::cout << "Enter service name: ";
     std::getline(std::cin, service);
@@ -103,10 +828,10 @@ void PasswordManagerOperations::addPassword() {
     std::getline(std::cin, username);
     
     std::cout << "Enter password (or leave empty to generate): ";
-    password = Utils::readMaskedPassword();
+    Utils::SecureString password = Utils::readMaskedPassword();
     
     if (password.empty()) {
-        password = Utils::generateRandomString(12);
+        password.assign(Utils::generateRandomString(12));
         std::cout << "Generated password: " << password << "\n";
     }
     
@@ -186,7 +911,7 @@ void PasswordManagerOperations::removePassword() {
 
 void PasswordManagerOperations::updatePassword() {
     std::cout << "\n---- Update password ----\n\n";
-    std::string service, username, password;
+    std::string service, username;
     
     std::cout << "Enter service name: ";
     std::getline(std::cin, service);
@@ -212,10 +937,10 @@ void PasswordManagerOperations::updatePassword() {
     }
     
     std::cout << "Enter new password (leave empty to generate): ";
-    password = Utils::readMaskedPassword();
+    Utils::SecureString password = Utils::readMaskedPassword();
     
     if (password.empty()) {
-        password = Utils::generateRandomString(12);
+        password.assign(Utils::generateRandomString(12));
         std::cout << "Generated password: " << password << "\n";
     }
     
@@ -255,7 +980,7 @@ void PasswordManagerOperations::generatePassword() {
 void PasswordManagerOperations::changeMasterPassword() {
     std::cout << "\n---- Change master password ----\n\n";
     std::cout << "Enter current master password: ";
-    std::string currentPassword = Utils::readMaskedPassword();
+    Utils::SecureString currentPassword = Utils::readMaskedPassword();
     
     if (!passwordManager.authenticate(currentPassword)) {
         std::cout << "Authentication failed. Incorrect master password.\n";
@@ -263,7 +988,7 @@ void PasswordManagerOperations::changeMasterPassword() {
     }
     
     std::cout << "Enter new master password: ";
-    std::string newPassword = Utils::readMaskedPassword();
+    Utils::SecureString newPassword = Utils::readMaskedPassword();
     
     if (newPassword.empty()) {
         std::cout << "New master password cannot be empty.\n";
@@ -276,14 +1001,25 @@ void PasswordManagerOperations::changeMasterPassword() {
     }
     
     std::cout << "Confirm new master password: ";
-    std::string confirmPassword = Utils::readMaskedPassword();
+    Utils::SecureString confirmPassword = Utils::readMaskedPassword();
     
-    if (newPassword != confirmPassword) {
+    if (!newPassword.equals(confirmPassword)) {
         std::cout << "Passwords do not match.\n";
         return;
     }
     
-    if (passwordManager.changeMasterPassword(currentPassword, newPassword)) {
+    auto reportProgress = [](size_t completed, size_t total) {
+        if (total == 0) {
+            return;
+        }
+        std::cout << "\rRe-encrypting vault: " << (completed * 100 / total) << "% ("
+                  << completed << "/" << total << ")" << std::flush;
+    };
+
+    bool changed = passwordManager.changeMasterPassword(currentPassword, newPassword, reportProgress);
+    std::cout << "\n";
+
+    if (changed) {
         std::cout << "Master password changed successfully.\n";
     } else {
         std::cout << "Failed to change master password.\n";
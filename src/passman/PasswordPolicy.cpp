@@ -0,0 +1,58 @@
+#include "passman/PasswordPolicy.h"
+#include <cctype>
+
+namespace passman {
+
+namespace {
+
+constexpr char kDigits[] = "0123456789";
+constexpr char kLetters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+constexpr char kSymbols[] = "!@#$%^&*()-=_+";
+
+} // namespace
+
+bool PasswordPolicy::accepts(std::string_view password) const {
+    if (password.size() < minLength) {
+        return false;
+    }
+    if (!requireAllClasses) {
+        return true;
+    }
+
+    bool lower = false, upper = false, digit = false, symbol = false;
+    for (unsigned char c : password) {
+        lower |= std::islower(c) != 0;
+        upper |= std::isupper(c) != 0;
+        digit |= std::isdigit(c) != 0;
+        symbol |= std::ispunct(c) != 0;
+    }
+    return lower && upper && digit && symbol;
+}
+
+bool PasswordPolicy::parse(const std::string& name, PasswordPolicy& policy) {
+    PasswordPolicy parsed;
+    parsed.name = name;
+    if (name == "full") {
+        parsed.charset = std::string(kDigits) + kLetters + kSymbols;
+    } else if (name == "strong") {
+        parsed.charset = std::string(kDigits) + kLetters + kSymbols;
+        parsed.requireAllClasses = true;
+        parsed.minLength = 4;
+    } else if (name == "alnum") {
+        parsed.charset = std::string(kDigits) + kLetters;
+    } else if (name == "pin") {
+        parsed.charset = kDigits;
+    } else if (name == "hex") {
+        parsed.charset = "0123456789abcdef";
+    } else {
+        return false;
+    }
+    policy = parsed;
+    return true;
+}
+
+std::string PasswordPolicy::names() {
+    return "full, strong, alnum, pin, hex";
+}
+
+} // namespace passman
@@ -0,0 +1,90 @@
+#include "passman/PasswordRekeyer.h"
+#include "utils/ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+namespace passman {
+
+PasswordRekeyer::PasswordRekeyer(const PasswordCrypto& crypto, size_t batchSize)
+    : crypto(crypto), batchSize(batchSize == 0 ? 1 : batchSize) {
+}
+
+bool PasswordRekeyer::rekey(const EntryTable& passwords,
+                            std::string_view oldKey,
+                            std::string_view newKey,
+                            EntryTable& rekeyed,
+                            const ProgressCallback& progress) const {
+    if (oldKey.empty() || newKey.empty()) {
+        return false;
+    }
+
+    const size_t total = passwords.size();
+    std::vector<EntryView> entries;
+    entries.reserve(total);
+    passwords.forEach([&](const EntryView& entry) {
+        entries.push_back(entry);
+    });
+
+    // Workers only write to their own slots, so no locking is needed
+    std::vector<std::string> reencrypted(total);
+    std::atomic<size_t> completed{0};
+
+    auto& pool = Utils::ThreadPool::shared();
+    auto work = std::async(std::launch::async, [&]() {
+        pool.parallelFor(total, batchSize, [&](size_t begin, size_t end) {
+            std::vector<std::string_view> inputs;
+            inputs.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                inputs.emplace_back(entries[i].encryptedPassword);
+            }
+
+            CryptoBatch plain, encrypted;
+            if (!crypto.decryptMany(inputs, oldKey, plain)) {
+                throw std::runtime_error("vault entry is not valid ciphertext");
+            }
+            inputs.clear();
+            for (size_t j = 0; j < plain.size(); ++j) {
+                inputs.push_back(plain[j]);
+            }
+            crypto.encryptMany(inputs, newKey, encrypted);
+
+            for (size_t j = 0; j < encrypted.size(); ++j) {
+                reencrypted[begin + j].assign(encrypted[j]);
+            }
+            completed.fetch_add(end - begin, std::memory_order_relaxed);
+        });
+    });
+
+    // Report progress from the caller's thread while the pool works
+    while (work.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready) {
+        if (progress) {
+            progress(completed.load(std::memory_order_relaxed), total);
+        }
+    }
+
+    try {
+        work.get();
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    // Every shard changes under the new key, including empty ones
+    EntryTable result(passwords.shardCount());
+    for (size_t i = 0; i < total; ++i) {
+        EntryView entry = entries[i];
+        entry.encryptedPassword = reencrypted[i];
+        result.insert(entry);
+    }
+    result.markAllDirty();
+    rekeyed.swap(result);
+
+    if (progress) {
+        progress(total, total);
+    }
+    return true;
+}
+
+} // namespace passman
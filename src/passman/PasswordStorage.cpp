@@ -1,138 +1,550 @@
 #include "passman/PasswordStorage.h"
+#include "passman/EntryCodec.h"
+#include "utils/ThreadPool.h"
+#include "utils/Utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
-#include <sstream>
 #include <filesystem>
+#include <set>
 
 namespace passman {
 
+namespace {
+
+// Plaintext first line of the manifest (and of the old single-file vault);
+// a legacy vault without it is generation 0
+constexpr char kVaultHeader[] = "SSVAULT ";
+constexpr size_t kVaultHeaderLength = sizeof(kVaultHeader) - 1;
+
+// Splits the header off raw vault bytes, returning where the ciphertext starts
+size_t parseVaultHeader(const char* data, size_t size, uint64_t& generation) {
+    generation = 0;
+    if (size < kVaultHeaderLength || std::memcmp(data, kVaultHeader, kVaultHeaderLength) != 0) {
+        return 0;
+    }
+
+    size_t pos = kVaultHeaderLength;
+    while (pos < size && data[pos] >= '0' && data[pos] <= '9') {
+        generation = generation * 10 + static_cast<uint64_t>(data[pos] - '0');
+        ++pos;
+    }
+    return pos < size && data[pos] == '\n' ? pos + 1 : size;
+}
+
+bool readWholeFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+} // namespace
+
 PasswordStorage::PasswordStorage(const std::string& dataDir)
     : dataDir(dataDir),
+      shardDir(dataDir + "vault/"),
+      manifestFile(dataDir + "vault/manifest"),
       passwordFile(dataDir + "passwords.txt"),
-      masterFile(dataDir + "master.txt") {
+      masterFile(dataDir + "master.txt"),
+      journalFile(dataDir + "commit.journal"),
+      lockFile(dataDir + "vault.lock"),
+      holdDepth(0) {
     std::filesystem::create_directories(dataDir);
+
+    VaultLock lock(lockFile, VaultLock::Mode::Exclusive);
+    if (recoverPendingCommit()) {
+        discardStagedFiles();
+    }
 }
 
-bool PasswordStorage::loadMasterPassword(std::string& masterPasswordHash, std::string& masterSalt) const {
+bool PasswordStorage::loadMasterPassword(std::string& masterPasswordHash, std::string& masterSalt,
+                                         KdfParams& kdfParams) const {
+    std::unique_ptr<VaultLock> lock;
+    if (!acquireRecovered(lock)) {
+        return false;
+    }
+
     std::ifstream masterFile(this->masterFile);
     if (!masterFile.is_open()) {
         return false;
     }
-    
-    std::string storedHash, storedSalt;
+
+    std::string storedHash, storedSalt, storedParams;
     std::getline(masterFile, storedHash);
     std::getline(masterFile, storedSalt);
+    std::getline(masterFile, storedParams); // Absent for vaults that predate the KDF
     masterFile.close();
-    
-    if (storedHash.empty() || storedSalt.empty()) {
+
+    KdfParams params;
+    if (storedHash.empty() || storedSalt.empty() || !KdfParams::parse(storedParams, params)) {
         return false;
     }
-    
+
     masterPasswordHash = storedHash;
     masterSalt = storedSalt;
+    kdfParams = params;
     return true;
 }
 
-bool PasswordStorage::saveMasterPassword(const std::string& masterPasswordHash, const std::string& masterSalt) const {
+bool PasswordStorage::hasMasterRecord() const {
+    std::error_code ec;
+    return std::filesystem::exists(masterFile, ec);
+}
+
+bool PasswordStorage::saveMasterPassword(const std::string& masterPasswordHash, const std::string& masterSalt,
+                                         const KdfParams& kdfParams) const {
     std::filesystem::create_directories(dataDir);
-    
-    std::ofstream masterFileStream(masterFile);
-    if (!masterFileStream.is_open()) {
+
+    std::unique_ptr<VaultLock> lock;
+    if (!acquire(VaultLock::Mode::Exclusive, lock)) {
+        return false;
+    }
+
+    std::string tempFile = masterFile + ".tmp";
+    if (!writeMasterFile(tempFile, masterPasswordHash, masterSalt, kdfParams)) {
+        return false;
+    }
+    return replaceFile(tempFile, masterFile) && Utils::syncDirectory(dataDir);
+}
+
+bool PasswordStorage::loadPasswords(EntryTable& passwords, std::string_view vaultKey, VaultStamp& stamp) const {
+    std::unique_ptr<VaultLock> lock;
+    if (!acquireRecovered(lock)) {
+        return false;
+    }
+
+    stamp = readStamp();
+    Manifest manifest;
+    if (!readManifest(manifest)) {
+        return loadLegacyVault(passwords, vaultKey);
+    }
+
+    // Each worker fills only its own shard, so no locking is needed
+    EntryTable loaded(manifest.shardCount);
+    std::atomic<bool> valid{true};
+    Utils::ThreadPool::shared().parallelFor(manifest.shardCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!loadShard(i, loaded.shard(i), vaultKey)) {
+                valid = false;
+            }
+        }
+    });
+    if (!valid) {
         return false;
     }
-    
-    masterFileStream << masterPasswordHash << '\n' << masterSalt;
-    masterFileStream.close();
+
+    passwords.swap(loaded);
     return true;
 }
 
-    // Optimized to decrypt password data in memory instead of temp files
-bool PasswordStorage::loadPasswords(
-    std::unordered_map<std::string, PasswordEntry>& passwords,
-    const std::string& masterPasswordHash) const {
-    
-    std::ifstream file(passwordFile, std::ios::binary);
-    if (!file.is_open()) {
-        return true; // New file is not an error
+bool PasswordStorage::loadLegacyVault(EntryTable& passwords, std::string_view vaultKey) const {
+    EntryTable loaded;
+    std::vector<uint8_t> fileData;
+    if (readWholeFile(passwordFile, fileData)) {
+        uint64_t generation;
+        size_t dataStart = parseVaultHeader(reinterpret_cast<const char*>(fileData.data()),
+                                            fileData.size(), generation);
+        std::vector<uint8_t> encryptedData(fileData.begin() + dataStart, fileData.end());
+        if (!encryptedData.empty()) {
+            std::vector<uint8_t> decryptedData;
+            if (!encryptor.decryptData(encryptedData, vaultKey, decryptedData)) {
+                return false;
+            }
+            std::string_view data(reinterpret_cast<const char*>(decryptedData.data()), decryptedData.size());
+            size_t count = static_cast<size_t>(std::count(data.begin(), data.end(), '\n'));
+            loaded.clear(EntryTable::recommendedShardCount(count));
+            EntryCodec::parseLines(data, [&](const EntryView& entry) { loaded.insert(entry); });
+        }
     }
 
-    std::string encryptedData;
-    std::getline(file, encryptedData);
-    file.close();
+    // Nothing of this layout is in vault/ yet; the next commit writes every shard
+    loaded.markAllDirty();
+    passwords.swap(loaded);
+    return true;
+}
 
+bool PasswordStorage::loadShard(size_t index, EntryTable::Shard& shard, std::string_view vaultKey) const {
+    std::vector<uint8_t> encryptedData;
+    if (!readWholeFile(shardPath(index), encryptedData)) {
+        return false;
+    }
     if (encryptedData.empty()) {
-        return true; // Empty file is not an error
-    }
-
-    std::string tempInputFile = dataDir + "temp_encrypted.dat";
-    std::string tempOutputFile = dataDir + "temp_decrypted.dat";
-    
-    std::ofstream tempInput(tempInputFile);
-    tempInput << encryptedData;
-    tempInput.close();
-    
-    if (!encryptor.decryptFile(tempInputFile, tempOutputFile, masterPasswordHash)) {
-        std::remove(tempInputFile.c_str());
-        return false;
-    }
-    
-    std::ifstream tempOutput(tempOutputFile);
-    std::stringstream buffer;
-    buffer << tempOutput.rdbuf();
-    std::string decryptedData = buffer.str();
-    tempOutput.close();
-    
-    std::remove(tempInputFile.c_str());
-    std::remove(tempOutputFile.c_str());
-    
-    std::istringstream dataStream(decryptedData);
+        return true;
+    }
+
+    std::vector<uint8_t> decryptedData;
+    if (!encryptor.decryptData(encryptedData, vaultKey, decryptedData)) {
+        return false;
+    }
+
+    std::string_view data(reinterpret_cast<const char*>(decryptedData.data()), decryptedData.size());
+    EntryStore loaded;
+    loaded.reserve(static_cast<size_t>(std::count(data.begin(), data.end(), '\n')));
+    EntryCodec::parseLines(data, [&](const EntryView& entry) { loaded.insert(entry); });
+    shard.swap(loaded);
+    return true;
+}
+
+bool PasswordStorage::commit(
+    const EntryTable& passwords,
+    std::string_view vaultKey,
+    const std::string& masterPasswordHash,
+    const std::string& masterSalt,
+    const KdfParams& kdfParams,
+    VaultStamp& stamp,
+    const std::vector<std::string>& staged) const {
+
+    std::error_code ec;
+    std::vector<std::string> publish(staged);
+    auto discard = [&]() {
+        for (const auto& path : publish) {
+            std::filesystem::remove(path + ".tmp", ec);
+        }
+    };
+
+    std::unique_ptr<VaultLock> lock;
+    if (!acquire(VaultLock::Mode::Exclusive, lock) || !recoverPendingCommit()) {
+        discard();
+        return false;
+    }
+
+    // Refuse to overwrite a commit made by another process since our last read
+    VaultStamp current = readStamp();
+    if (current.generation != stamp.generation) {
+        discard();
+        return false;
+    }
+
+    std::filesystem::create_directories(shardDir, ec);
+
+    Manifest previous;
+    bool sameLayout = readManifest(previous) && previous.shardCount == passwords.shardCount();
+    Manifest manifest;
+    manifest.generation = current.generation + 1;
+    manifest.shardCount = passwords.shardCount();
+
+    std::vector<size_t> dirtyShards;
+    for (size_t i = 0; i < passwords.shardCount(); ++i) {
+        if (passwords.isDirty(i) || !sameLayout) {
+            dirtyShards.push_back(i);
+        }
+    }
+
+    // Stage every file next to its target. Until the journal exists a crash
+    // leaves the previous vault untouched and the staged files are discarded.
+    std::atomic<bool> shardsStaged{true};
+    Utils::ThreadPool::shared().parallelFor(dirtyShards.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            size_t index = dirtyShards[i];
+            if (!writeShardFile(shardPath(index) + ".tmp", passwords.shard(index), vaultKey)) {
+                shardsStaged = false;
+            }
+        }
+    });
+
+    for (size_t index : dirtyShards) {
+        publish.push_back(shardPath(index));
+    }
+    publish.push_back(manifestFile);
+    publish.push_back(masterFile);
+
+    // Staged names must reach the disk before the journal that points at them
+    std::set<std::string> directories = {shardDir, dataDir};
+    for (const auto& path : staged) {
+        directories.insert(std::filesystem::path(path).parent_path().string());
+    }
+    bool written = shardsStaged &&
+                   writeManifestFile(manifestFile + ".tmp", manifest) &&
+                   writeMasterFile(masterFile + ".tmp", masterPasswordHash, masterSalt, kdfParams);
+    for (const auto& directory : directories) {
+        written = written && Utils::syncDirectory(directory);
+    }
+    if (!written) {
+        discard();
+        return false;
+    }
+
+    // Files the new layout no longer uses: the single-file vault and shards
+    // beyond the new shard count
+    std::vector<std::string> obsolete;
+    if (std::filesystem::exists(passwordFile, ec)) {
+        obsolete.push_back(passwordFile);
+    }
+    if (!sameLayout) {
+        for (size_t i = manifest.shardCount; i < std::max(previous.shardCount, manifest.shardCount); ++i) {
+            obsolete.push_back(shardPath(i));
+        }
+    }
+
+    // Once the journal is written the commit is durable and any interrupted
+    // renames are rolled forward on the next load.
+    std::ofstream journal(journalFile, std::ios::trunc);
+    if (journal.is_open()) {
+        for (const auto& path : publish) {
+            journal << "publish " << path << '\n';
+        }
+        for (const auto& path : obsolete) {
+            journal << "remove " << path << '\n';
+        }
+        journal.close();
+    }
+    if (!journal || journal.fail() || !Utils::syncFile(journalFile) || !Utils::syncDirectory(dataDir)) {
+        std::filesystem::remove(journalFile, ec);
+        discard();
+        return false;
+    }
+
+    if (!recoverPendingCommit()) {
+        return false;
+    }
+    stamp = readStamp();
+    return true;
+}
+
+bool PasswordStorage::recoverPendingCommit() const {
+    std::error_code ec;
+    std::ifstream journal(journalFile);
+    if (!journal.is_open()) {
+        return true;
+    }
+
+    std::vector<std::string> publish, obsolete;
     std::string line;
-    while (std::getline(dataStream, line)) {
-        std::istringstream lineStream(line);
-        std::string service, username, encryptedPassword, serviceLink, salt;
-        
-        if (std::getline(lineStream, service, '|') &&
-            std::getline(lineStream, username, '|') &&
-            std::getline(lineStream, encryptedPassword, '|') &&
-            std::getline(lineStream, serviceLink, '|') &&
-            std::getline(lineStream, salt)) {
-            passwords[service] = PasswordEntry{
-                service, username, encryptedPassword, serviceLink, salt
-            };
+    while (std::getline(journal, line)) {
+        if (line == "commit") {
+            // Journal written before sharding: the vault file and master file
+            publish.push_back(passwordFile);
+            publish.push_back(masterFile);
+        } else if (line.compare(0, 8, "publish ") == 0) {
+            publish.push_back(line.substr(8));
+        } else if (line.compare(0, 7, "remove ") == 0) {
+            obsolete.push_back(line.substr(7));
         }
     }
+    journal.close();
 
+    bool success = true;
+    std::set<std::string> directories;
+    for (const auto& path : publish) {
+        if (std::filesystem::exists(path + ".tmp", ec)) {
+            success = replaceFile(path + ".tmp", path) && success;
+            directories.insert(std::filesystem::path(path).parent_path().string());
+        }
+    }
+    // The renames must be durable before the journal that could redo them goes
+    for (const auto& directory : directories) {
+        success = Utils::syncDirectory(directory) && success;
+    }
+    if (!success) {
+        return false;
+    }
+    for (const auto& path : obsolete) {
+        std::filesystem::remove(path, ec);
+    }
+    std::filesystem::remove(journalFile, ec);
     return true;
 }
 
-bool PasswordStorage::savePasswords(
-    const std::unordered_map<std::string, PasswordEntry>& passwords,
-    const std::string& masterPasswordHash) const {
-    
-    std::filesystem::create_directories(dataDir);
-    
-    std::ostringstream stream;
-    for (const auto& pair : passwords) {
-        const auto& entry = pair.second;
-        stream << entry.service << '|'
-               << entry.username << '|'
-               << entry.encryptedPassword << '|'
-               << entry.serviceLink << '|'
-               << entry.salt << '\n';
+void PasswordStorage::discardStagedFiles() const {
+    std::error_code ec;
+    std::filesystem::remove(passwordFile + ".tmp", ec);
+    std::filesystem::remove(masterFile + ".tmp", ec);
+    // Staged by a master password change along with the vault
+    std::filesystem::remove(dataDir + "chunks/key.tmp", ec);
+    for (const std::string& dir : {shardDir, dataDir + "history/"}) {
+        for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path().extension() == ".tmp") {
+                std::error_code removeError;
+                std::filesystem::remove(it->path(), removeError);
+            }
+        }
     }
+}
 
-    std::string tempFile = dataDir + "temp_passwords.dat";
-    std::ofstream tempStream(tempFile);
-    if (!tempStream.is_open()) {
+bool PasswordStorage::hasChangedSince(VaultStamp& stamp) const {
+    std::error_code ec;
+    const std::string& path = stampPath();
+    bool exists = std::filesystem::exists(path, ec);
+    if (exists == stamp.exists &&
+        (!exists || (std::filesystem::file_size(path, ec) == stamp.size &&
+                     std::filesystem::last_write_time(path, ec) == stamp.modified))) {
         return false;
     }
-    tempStream << stream.str();
-    tempStream.close();
 
-    bool success = encryptor.encryptFile(tempFile, masterPasswordHash, passwordFile);
-    
-    std::remove(tempFile.c_str());
-    
-    return success;
+    // The file moved; only a new generation means another process committed
+    std::unique_ptr<VaultLock> lock;
+    if (!acquire(VaultLock::Mode::Shared, lock)) {
+        return true;
+    }
+    VaultStamp current = readStamp();
+    if (current.generation != stamp.generation) {
+        return true;
+    }
+    stamp = current;
+    return false;
+}
+
+bool PasswordStorage::hold(VaultLock::Mode mode) const {
+    if (holdDepth == 0) {
+        if (mode == VaultLock::Mode::Shared && !rollForward()) {
+            return false;
+        }
+        auto lock = std::make_unique<VaultLock>(lockFile, mode);
+        if (!lock->isHeld() || (mode == VaultLock::Mode::Exclusive && !recoverPendingCommit())) {
+            return false;
+        }
+        heldLock = std::move(lock);
+    }
+    ++holdDepth;
+    return true;
+}
+
+void PasswordStorage::release() const {
+    if (holdDepth > 0 && --holdDepth == 0) {
+        heldLock.reset();
+    }
+}
+
+bool PasswordStorage::acquire(VaultLock::Mode mode, std::unique_ptr<VaultLock>& lock) const {
+    if (heldLock) {
+        // A shared hold cannot be upgraded without deadlocking on our own lock
+        return mode == VaultLock::Mode::Shared || heldLock->mode() == VaultLock::Mode::Exclusive;
+    }
+    lock = std::make_unique<VaultLock>(lockFile, mode);
+    return lock->isHeld();
+}
+
+bool PasswordStorage::acquireRecovered(std::unique_ptr<VaultLock>& lock) const {
+    std::error_code ec;
+    if (heldLock) {
+        // A shared hold rolled forward when it was taken; one still pending cannot be repaired under it
+        return heldLock->mode() == VaultLock::Mode::Exclusive ? recoverPendingCommit()
+                                                              : !std::filesystem::exists(journalFile, ec);
+    }
+    return rollForward() && acquire(VaultLock::Mode::Shared, lock) && !std::filesystem::exists(journalFile, ec);
+}
+
+bool PasswordStorage::rollForward() const {
+    std::error_code ec;
+    if (!std::filesystem::exists(journalFile, ec)) {
+        return true;
+    }
+    // Recovery renames shards that readers holding the shared lock may be reading
+    VaultLock exclusive(lockFile, VaultLock::Mode::Exclusive);
+    return exclusive.isHeld() && recoverPendingCommit();
+}
+
+const std::string& PasswordStorage::stampPath() const {
+    std::error_code ec;
+    return std::filesystem::exists(manifestFile, ec) ? manifestFile : passwordFile;
+}
+
+VaultStamp PasswordStorage::readStamp() const {
+    VaultStamp stamp;
+    std::error_code ec;
+    const std::string& path = stampPath();
+    stamp.exists = std::filesystem::exists(path, ec);
+    if (!stamp.exists) {
+        return stamp;
+    }
+    stamp.size = std::filesystem::file_size(path, ec);
+    stamp.modified = std::filesystem::last_write_time(path, ec);
+
+    std::ifstream file(path, std::ios::binary);
+    char header[32];
+    file.read(header, sizeof(header));
+    parseVaultHeader(header, static_cast<size_t>(file.gcount()), stamp.generation);
+    return stamp;
+}
+
+bool PasswordStorage::readManifest(Manifest& manifest) const {
+    std::ifstream file(manifestFile);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string header, layout;
+    std::getline(file, header);
+    std::getline(file, layout);
+    header.push_back('\n');
+    if (parseVaultHeader(header.data(), header.size(), manifest.generation) == 0 ||
+        layout.compare(0, 7, "shards ") != 0) {
+        return false;
+    }
+
+    try {
+        manifest.shardCount = std::stoul(layout.substr(7));
+    } catch (const std::exception&) {
+        return false;
+    }
+    return manifest.shardCount > 0 && manifest.shardCount <= EntryTable::kMaxShards;
+}
+
+std::string PasswordStorage::shardPath(size_t index) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "shard-%04zu.dat", index);
+    return shardDir + name;
+}
+
+std::string PasswordStorage::serializeShard(const EntryTable::Shard& shard) const {
+    size_t totalSize = 0;
+    shard.forEach([&](const EntryView& entry) {
+        totalSize += EntryCodec::lineSize(entry);
+    });
+
+    std::string data;
+    data.reserve(totalSize);
+    shard.forEach([&](const EntryView& entry) {
+        EntryCodec::appendLine(data, entry);
+    });
+    return data;
+}
+
+bool PasswordStorage::writeShardFile(const std::string& path, const EntryTable::Shard& shard,
+                                     std::string_view vaultKey) const {
+    std::string plain = serializeShard(shard);
+    std::vector<uint8_t> encrypted = encryptor.encryptData(
+        std::vector<uint8_t>(plain.begin(), plain.end()), vaultKey);
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        return false;
+    }
+    stream.write(reinterpret_cast<const char*>(encrypted.data()), encrypted.size());
+    stream.close();
+    return !stream.fail() && Utils::syncFile(path);
+}
+
+bool PasswordStorage::writeManifestFile(const std::string& path, const Manifest& manifest) const {
+    std::ofstream stream(path, std::ios::trunc);
+    if (!stream.is_open()) {
+        return false;
+    }
+    stream << kVaultHeader << manifest.generation << '\n' << "shards " << manifest.shardCount << '\n';
+    stream.close();
+    return !stream.fail() && Utils::syncFile(path);
+}
+
+bool PasswordStorage::writeMasterFile(const std::string& path, const std::string& masterPasswordHash,
+                                      const std::string& masterSalt, const KdfParams& kdfParams) const {
+    std::ofstream stream(path, std::ios::trunc);
+    if (!stream.is_open()) {
+        return false;
+    }
+    stream << masterPasswordHash << '\n' << masterSalt << '\n' << kdfParams.toString();
+    stream.close();
+    return !stream.fail() && Utils::syncFile(path);
+}
+
+bool PasswordStorage::replaceFile(const std::string& from, const std::string& to) const {
+    std::error_code ec;
+    std::filesystem::rename(from, to, ec);
+    return !ec;
 }
 
-}
\ No newline at end of file
+} // namespace passman
@@ -0,0 +1,678 @@
+#include "passman/PasswordTransfer.h"
+#include "passman/EntryCodec.h"
+#include "utils/Utils.h"
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+#include <utility>
+
+namespace passman {
+
+namespace {
+
+/**
+ * Buffered character source over an input stream, so the parsers below
+ * never hold more than one chunk of the file in memory.
+ */
+class ChunkReader {
+public:
+    explicit ChunkReader(std::istream& input) : input(input), buffer(1 << 16), position(0), length(0), offset(0) {}
+
+    int peek() {
+        if (position == length && !fill()) {
+            return EOF;
+        }
+        return static_cast<unsigned char>(buffer[position]);
+    }
+
+    int get() {
+        int c = peek();
+        if (c != EOF) {
+            ++position;
+            ++offset;
+        }
+        return c;
+    }
+
+    /**
+     * Appends characters to out up to, but not including, the first one for
+     * which stops[c] is set. Copies whole runs out of the buffer at a time.
+     */
+    void appendUntil(const bool (&stops)[256], std::string& out) {
+        while (true) {
+            if (position == length && !fill()) {
+                return;
+            }
+            size_t end = position;
+            while (end < length && !stops[static_cast<unsigned char>(buffer[end])]) {
+                ++end;
+            }
+            out.append(buffer.data() + position, end - position);
+            offset += end - position;
+            position = end;
+            if (position < length) {
+                return;
+            }
+        }
+    }
+
+    size_t consumed() const { return offset; }
+
+private:
+    bool fill() {
+        input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        length = static_cast<size_t>(input.gcount());
+        position = 0;
+        return length > 0;
+    }
+
+    std::istream& input;
+    std::vector<char> buffer;
+    size_t position;
+    size_t length;
+    size_t offset;
+};
+
+struct StopSet {
+    bool stops[256] = {};
+    StopSet(std::initializer_list<char> chars) {
+        for (char c : chars) {
+            stops[static_cast<unsigned char>(c)] = true;
+        }
+    }
+};
+
+const StopSet kCsvUnquotedStops{',', '"', '\r', '\n'};
+const StopSet kCsvQuotedStops{'"'};
+const StopSet kJsonStringStops{'"', '\\'};
+
+void skipByteOrderMark(ChunkReader& reader) {
+    if (reader.peek() == 0xEF) {
+        reader.get();
+        if (reader.peek() == 0xBB) reader.get();
+        if (reader.peek() == 0xBF) reader.get();
+    }
+}
+
+/**
+ * Reads one RFC 4180 row. Quoted fields may contain separators, doubled
+ * quotes and line breaks. Returns false once the input is exhausted.
+ */
+bool readCsvRow(ChunkReader& reader, std::vector<std::string>& fields) {
+    fields.clear();
+    if (reader.peek() == EOF) {
+        return false;
+    }
+
+    std::string field;
+    bool inQuotes = false;
+    while (true) {
+        reader.appendUntil(inQuotes ? kCsvQuotedStops.stops : kCsvUnquotedStops.stops, field);
+        int c = reader.get();
+        if (c == EOF) {
+            fields.push_back(std::move(field));
+            return true;
+        }
+        if (inQuotes) {
+            // Only a quote stops a quoted run
+            if (reader.peek() == '"') {
+                field.push_back('"');
+                reader.get();
+            } else {
+                inQuotes = false;
+            }
+        } else if (c == '"') {
+            inQuotes = true;
+        } else if (c == ',') {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else {
+            if (c == '\r' && reader.peek() == '\n') {
+                reader.get();
+            }
+            fields.push_back(std::move(field));
+            return true;
+        }
+    }
+}
+
+enum class Column { Service, Url, Username, Password, Ignored };
+
+Column classifyColumn(const std::string& name) {
+    static const std::vector<std::pair<Column, std::vector<std::string>>> aliases = {
+        {Column::Service, {"name", "title", "service", "account"}},
+        {Column::Url, {"url", "uri", "login_uri", "website", "origin", "hostname"}},
+        {Column::Username, {"username", "login", "login_username", "user", "email"}},
+        {Column::Password, {"password", "login_password", "pass"}},
+    };
+
+    std::string key = Utils::toLower(Utils::trim(name));
+    for (const auto& [column, names] : aliases) {
+        if (std::find(names.begin(), names.end(), key) != names.end()) {
+            return column;
+        }
+    }
+    return Column::Ignored;
+}
+
+std::string hostFromUrl(const std::string& url) {
+    size_t start = url.find("://");
+    start = (start == std::string::npos) ? 0 : start + 3;
+    size_t end = url.find_first_of("/?#:", start);
+    std::string host = url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    size_t at = host.rfind('@');
+    if (at != std::string::npos) {
+        host = host.substr(at + 1);
+    }
+    return host;
+}
+
+/**
+ * Turns parsed fields into records, naming services after the URL host when
+ * the export has no name column and disambiguating repeated names so that
+ * several accounts for one site are all kept.
+ */
+class RecordBuilder {
+public:
+    bool build(std::string service, std::string url, std::string username, std::string password,
+               PasswordRecord& record) {
+        service = Utils::trim(service);
+        if (service.empty()) {
+            service = hostFromUrl(url);
+        }
+        if (service.empty() || password.empty()) {
+            return false;
+        }
+        // The vault stores these between '|' separators, one entry per line
+        if (!EntryCodec::isStorable(service) || !EntryCodec::isStorable(username) || !EntryCodec::isStorable(url)) {
+            return false;
+        }
+
+        std::string key = Utils::toLower(service);
+        if (!seen.insert(key).second) {
+            std::string base = username.empty() ? service : service + " (" + username + ")";
+            std::string candidate = base;
+            for (int suffix = 2; !seen.insert(Utils::toLower(candidate)).second; ++suffix) {
+                candidate = base + " #" + std::to_string(suffix);
+            }
+            service = candidate;
+        }
+
+        record.service = std::move(service);
+        record.username = std::move(username);
+        record.password = std::move(password);
+        record.serviceLink = std::move(url);
+        return true;
+    }
+
+private:
+    std::unordered_set<std::string> seen;
+};
+
+/**
+ * Minimal JSON reader. Records are small, so each array element is parsed
+ * into a flat key/value list, while the enclosing array is streamed.
+ */
+class JsonReader {
+public:
+    using Fields = std::vector<std::pair<std::string, std::string>>;
+
+    explicit JsonReader(ChunkReader& reader) : reader(reader) {}
+
+    void skipWhitespace() {
+        int c = reader.peek();
+        while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            reader.get();
+            c = reader.peek();
+        }
+    }
+
+    bool expect(char expected) {
+        skipWhitespace();
+        if (reader.peek() != expected) {
+            return false;
+        }
+        reader.get();
+        return true;
+    }
+
+    int peek() {
+        skipWhitespace();
+        return reader.peek();
+    }
+
+    bool parseString(std::string& out) {
+        out.clear();
+        if (!expect('"')) {
+            return false;
+        }
+        while (true) {
+            reader.appendUntil(kJsonStringStops.stops, out);
+            int c = reader.get();
+            if (c == EOF) {
+                return false;
+            }
+            if (c == '"') {
+                return true;
+            }
+            c = reader.get();
+            switch (c) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    uint32_t codePoint;
+                    if (!parseHex4(codePoint)) {
+                        return false;
+                    }
+                    if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                        uint32_t low;
+                        if (reader.get() != '\\' || reader.get() != 'u' || !parseHex4(low) ||
+                            low < 0xDC00 || low > 0xDFFF) {
+                            return false;
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+    }
+
+    /**
+     * Parses any value. Scalars are stored under key in fields (first one
+     * wins); objects are flattened into fields and arrays contribute their
+     * first element.
+     */
+    bool parseValue(const std::string& key, Fields* fields, int depth = 0) {
+        if (depth > 64) {
+            return false;
+        }
+        int c = peek();
+        if (c == '{') {
+            reader.get();
+            if (peek() == '}') {
+                reader.get();
+                return true;
+            }
+            std::string member;
+            do {
+                if (!parseString(member) || !expect(':')) {
+                    return false;
+                }
+                if (!parseValue(Utils::toLower(member), fields, depth + 1)) {
+                    return false;
+                }
+            } while (expect(','));
+            return expect('}');
+        }
+        if (c == '[') {
+            reader.get();
+            if (peek() == ']') {
+                reader.get();
+                return true;
+            }
+            bool first = true;
+            do {
+                if (!parseValue(key, first ? fields : nullptr, depth + 1)) {
+                    return false;
+                }
+                first = false;
+            } while (expect(','));
+            return expect(']');
+        }
+        if (c == '"') {
+            std::string value;
+            if (!parseString(value)) {
+                return false;
+            }
+            store(fields, key, std::move(value));
+            return true;
+        }
+
+        // Numbers, booleans and null: keep the literal text
+        std::string literal;
+        c = reader.peek();
+        while (c != EOF && c != ',' && c != '}' && c != ']' && c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            literal.push_back(static_cast<char>(reader.get()));
+            c = reader.peek();
+        }
+        if (literal.empty()) {
+            return false;
+        }
+        if (literal != "null") {
+            store(fields, key, std::move(literal));
+        }
+        return true;
+    }
+
+    size_t consumed() const { return reader.consumed(); }
+
+private:
+    static void store(Fields* fields, const std::string& key, std::string value) {
+        if (!fields || key.empty()) {
+            return;
+        }
+        for (const auto& field : *fields) {
+            if (field.first == key) {
+                return;
+            }
+        }
+        fields->emplace_back(key, std::move(value));
+    }
+
+    bool parseHex4(uint32_t& value) {
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            int c = reader.get();
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            out.push_back(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+
+    ChunkReader& reader;
+};
+
+void appendCsvField(std::string& out, const std::string& value) {
+    if (value.find_first_of(",\"\r\n") == std::string::npos) {
+        out += value;
+        return;
+    }
+    out.push_back('"');
+    for (char c : value) {
+        if (c == '"') {
+            out.push_back('"');
+        }
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+void appendJsonString(std::string& out, const std::string& value) {
+    static const char digits[] = "0123456789abcdef";
+    out.push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out.push_back(digits[(c >> 4) & 0x0F]);
+                    out.push_back(digits[c & 0x0F]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+} // namespace
+
+PasswordTransfer::PasswordTransfer(PasswordManager& manager, size_t batchSize)
+    : manager(manager), batchSize(batchSize == 0 ? 1 : batchSize) {
+}
+
+bool PasswordTransfer::formatFromPath(const std::string& path, TransferFormat& format) {
+    std::string extension = Utils::toLower(Utils::getFileExtension(path));
+    if (extension == ".csv") {
+        format = TransferFormat::Csv;
+        return true;
+    }
+    if (extension == ".json") {
+        format = TransferFormat::Json;
+        return true;
+    }
+    return false;
+}
+
+bool PasswordTransfer::importFile(const std::string& path, TransferFormat format, TransferStats& stats,
+                                  std::string& error) {
+    auto start = std::chrono::steady_clock::now();
+    stats = TransferStats{};
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "cannot open '" + path + "'";
+        return false;
+    }
+
+    ChunkReader reader(file);
+    skipByteOrderMark(reader);
+    RecordBuilder builder;
+    std::vector<PasswordRecord> batch;
+    batch.reserve(batchSize);
+
+    manager.beginBatch();
+    bool ok = true;
+
+    auto flush = [&]() {
+        if (!batch.empty()) {
+            ok = ok && manager.addEntries(batch);
+            stats.processed += batch.size();
+            batch.clear();
+        }
+    };
+
+    auto accept = [&](std::string service, std::string url, std::string username, std::string password) {
+        PasswordRecord record;
+        if (builder.build(std::move(service), std::move(url), std::move(username), std::move(password), record)) {
+            batch.push_back(std::move(record));
+            if (batch.size() >= batchSize) {
+                flush();
+            }
+        } else {
+            ++stats.skipped;
+        }
+    };
+
+    if (format == TransferFormat::Csv) {
+        std::vector<std::string> row;
+        std::vector<Column> columns;
+        if (!readCsvRow(reader, row)) {
+            error = "file is empty";
+            ok = false;
+        } else {
+            for (const auto& name : row) {
+                columns.push_back(classifyColumn(name));
+            }
+            if (std::find(columns.begin(), columns.end(), Column::Password) == columns.end()) {
+                error = "CSV header has no password column";
+                ok = false;
+            }
+        }
+
+        while (ok && readCsvRow(reader, row)) {
+            if (row.size() == 1 && row[0].empty()) {
+                continue; // Blank line
+            }
+            std::string fields[4];
+            for (size_t i = 0; i < row.size() && i < columns.size(); ++i) {
+                if (columns[i] != Column::Ignored && fields[static_cast<int>(columns[i])].empty()) {
+                    fields[static_cast<int>(columns[i])] = std::move(row[i]);
+                }
+            }
+            accept(std::move(fields[0]), std::move(fields[1]), std::move(fields[2]), std::move(fields[3]));
+        }
+    } else {
+        JsonReader json(reader);
+        auto readRecords = [&]() -> bool {
+            if (!json.expect('[')) {
+                return false;
+            }
+            if (json.peek() == ']') {
+                reader.get();
+                return true;
+            }
+            do {
+                JsonReader::Fields fields;
+                if (!json.parseValue("", &fields)) {
+                    return false;
+                }
+                std::string values[4];
+                for (auto& [key, value] : fields) {
+                    Column column = classifyColumn(key);
+                    if (column != Column::Ignored && values[static_cast<int>(column)].empty()) {
+                        values[static_cast<int>(column)] = std::move(value);
+                    }
+                }
+                accept(std::move(values[0]), std::move(values[1]), std::move(values[2]), std::move(values[3]));
+            } while (ok && json.expect(','));
+            return json.expect(']');
+        };
+
+        bool parsed;
+        if (json.peek() == '{') {
+            // Wrapped exports keep the records under a well-known key
+            static const std::vector<std::string> containers = {"items", "entries", "passwords", "logins"};
+            reader.get();
+            parsed = true;
+            bool found = false;
+            std::string key;
+            do {
+                if (json.peek() == '}') {
+                    break;
+                }
+                if (!json.parseString(key) || !json.expect(':')) {
+                    parsed = false;
+                    break;
+                }
+                key = Utils::toLower(key);
+                if (!found && json.peek() == '[' &&
+                    std::find(containers.begin(), containers.end(), key) != containers.end()) {
+                    found = true;
+                    parsed = readRecords();
+                } else {
+                    parsed = json.parseValue("", nullptr);
+                }
+            } while (parsed && ok && json.expect(','));
+            parsed = parsed && json.expect('}');
+            if (parsed && !found) {
+                error = "JSON object has no items array";
+                ok = false;
+            }
+        } else {
+            parsed = readRecords();
+        }
+
+        if (!parsed && ok) {
+            error = "invalid JSON near byte " + std::to_string(json.consumed());
+            ok = false;
+        }
+    }
+
+    flush();
+    // Commit even after a parse error so the valid prefix isn't silently lost
+    bool committed = manager.commitBatch();
+    if (!committed && error.empty()) {
+        error = "failed to save the vault";
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok && committed;
+}
+
+bool PasswordTransfer::exportFile(const std::string& path, TransferFormat format, TransferStats& stats,
+                                  std::string& error) {
+    auto start = std::chrono::steady_clock::now();
+    stats = TransferStats{};
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        error = "cannot create '" + path + "'";
+        return false;
+    }
+
+    // The export holds plaintext secrets, keep it private to the owner
+    std::error_code ec;
+    std::filesystem::permissions(path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+                                 std::filesystem::perm_options::replace, ec);
+
+    std::string out;
+    bool first = true;
+    out += (format == TransferFormat::Csv) ? "name,url,username,password\n" : "[\n";
+
+    bool ok = manager.forEachDecrypted([&](const std::vector<PasswordRecord>& records) {
+        for (const auto& record : records) {
+            if (format == TransferFormat::Csv) {
+                appendCsvField(out, record.service);
+                out.push_back(',');
+                appendCsvField(out, record.serviceLink);
+                out.push_back(',');
+                appendCsvField(out, record.username);
+                out.push_back(',');
+                appendCsvField(out, record.password);
+                out.push_back('\n');
+            } else {
+                out += first ? "  {\"name\": " : ",\n  {\"name\": ";
+                appendJsonString(out, record.service);
+                out += ", \"url\": ";
+                appendJsonString(out, record.serviceLink);
+                out += ", \"username\": ";
+                appendJsonString(out, record.username);
+                out += ", \"password\": ";
+                appendJsonString(out, record.password);
+                out.push_back('}');
+            }
+            first = false;
+        }
+        stats.processed += records.size();
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        out.clear();
+    });
+
+    if (format == TransferFormat::Json) {
+        out += first ? "]\n" : "\n]\n";
+    }
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    file.close();
+
+    if (!ok) {
+        error = "vault is locked or corrupted";
+    } else if (file.fail()) {
+        error = "failed to write '" + path + "'";
+        ok = false;
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+} // namespace passman
@@ -0,0 +1,71 @@
+#include "passman/VaultLock.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace passman {
+
+#ifdef _WIN32
+
+VaultLock::VaultLock(const std::string& path, Mode mode)
+    : handle(INVALID_HANDLE_VALUE), lockMode(mode), held(false) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    handle = file;
+
+    OVERLAPPED overlapped = {};
+    DWORD flags = mode == Mode::Exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0;
+    held = LockFileEx(file, flags, 0, MAXDWORD, MAXDWORD, &overlapped) != 0;
+}
+
+VaultLock::~VaultLock() {
+    if (handle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    if (held) {
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(static_cast<HANDLE>(handle), 0, MAXDWORD, MAXDWORD, &overlapped);
+    }
+    CloseHandle(static_cast<HANDLE>(handle));
+}
+
+#else
+
+VaultLock::VaultLock(const std::string& path, Mode mode)
+    : fd(-1), lockMode(mode), held(false) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return;
+    }
+
+    int operation = mode == Mode::Exclusive ? LOCK_EX : LOCK_SH;
+    int result;
+    do {
+        result = ::flock(fd, operation);
+    } while (result != 0 && errno == EINTR);
+    held = result == 0;
+}
+
+VaultLock::~VaultLock() {
+    if (fd < 0) {
+        return;
+    }
+    if (held) {
+        ::flock(fd, LOCK_UN);
+    }
+    ::close(fd);
+}
+
+#endif
+
+} // namespace passman
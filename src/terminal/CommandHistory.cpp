@@ -0,0 +1,215 @@
+#include "terminal/CommandHistory.h"
+#include <filesystem>
+
+namespace {
+
+// Queries with a trigram this common are answered by scanning from the newest line
+constexpr size_t kScanRatio = 16;
+
+uint32_t trigram(std::string_view text, size_t at) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(text[at])) << 16 |
+           static_cast<uint32_t>(static_cast<uint8_t>(text[at + 1])) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(text[at + 2]));
+}
+
+} // namespace
+
+CommandHistory::~CommandHistory() {
+    // The index refers into the mapping, so it must be finished before either goes
+    if (indexed.valid()) {
+        indexed.wait();
+    }
+}
+
+bool CommandHistory::open(const std::string& path) {
+    if (indexed.valid()) {
+        indexed.wait();
+    }
+    session.clear();
+    recent.clear();
+    index = TrigramIndex();
+    appender.close();
+
+    std::error_code error;
+    bool exists = std::filesystem::exists(path, error);
+    if (exists && !mapped.open(path)) {
+        return false;
+    }
+    if (!exists) {
+        mapped.close();
+        std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        if (!parent.empty()) {
+            std::filesystem::create_directories(parent, error);
+        }
+    }
+    std::string_view text = mapped.view();
+    unscanned = text.size();
+
+    indexed = std::async(std::launch::async, [this, text]() { buildIndex(text, index); });
+
+    appender.open(path, std::ios::app | std::ios::binary);
+    if (!text.empty() && text.back() != '\n') {
+        appender << '\n'; // Finish a line cut short, so the next command starts its own
+    }
+    return appender.is_open();
+}
+
+void CommandHistory::add(std::string_view line) {
+    std::string_view newest;
+    if (line.empty() || (entry(0, newest) && newest == line)) {
+        return;
+    }
+    session.emplace_back(line);
+    if (appender.is_open()) {
+        appender << line << '\n';
+        appender.flush(); // Kept even if the shell is closed with the window
+    }
+}
+
+bool CommandHistory::entry(size_t age, std::string_view& line) {
+    if (age < session.size()) {
+        line = session[session.size() - 1 - age];
+        return true;
+    }
+    age -= session.size();
+
+    // Walk back from the end of the file only as far as has been asked for
+    std::string_view text = mapped.view();
+    while (recent.size() <= age) {
+        size_t end = unscanned;
+        while (end > 0 && (text[end - 1] == '\n' || text[end - 1] == '\r')) {
+            --end;
+        }
+        if (end == 0) {
+            unscanned = 0;
+            return false;
+        }
+        size_t start = text.rfind('\n', end - 1);
+        start = start == std::string_view::npos ? 0 : start + 1;
+        recent.push_back(text.substr(start, end - start));
+        unscanned = start;
+    }
+    line = recent[age];
+    return true;
+}
+
+bool CommandHistory::search(std::string_view query, size_t skip, std::string_view& match) {
+    if (query.empty()) {
+        return false;
+    }
+
+    size_t found = 0;
+    std::string_view previous;
+    auto consider = [&](std::string_view line) {
+        if (line.find(query) == std::string_view::npos || (found > 0 && line == previous)) {
+            return false;
+        }
+        previous = line;
+        if (found++ == skip) {
+            match = line;
+            return true;
+        }
+        return false;
+    };
+
+    for (auto it = session.rbegin(); it != session.rend(); ++it) {
+        if (consider(*it)) {
+            return true;
+        }
+    }
+
+    // Only lines holding the query's rarest trigram can match
+    const TrigramIndex& lines = readyIndex();
+    const Postings* rarest = nullptr;
+    for (size_t i = 0; i + 3 <= query.size(); ++i) {
+        auto it = lines.postings.find(trigram(query, i));
+        if (it == lines.postings.end()) {
+            return false;
+        }
+        if (!rarest || it->second.count < rarest->count) {
+            rarest = &it->second;
+        }
+    }
+
+    if (rarest && rarest->count * kScanRatio < lines.lines.size()) {
+        std::vector<uint32_t> candidates = decode(*rarest);
+        for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+            if (consider(lines.lines[*it])) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Short or common queries match often, so the newest lines soon find one
+    for (size_t i = lines.lines.size(); i-- > 0;) {
+        if (consider(lines.lines[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const CommandHistory::TrigramIndex& CommandHistory::readyIndex() {
+    if (indexed.valid()) {
+        indexed.wait();
+    }
+    return index;
+}
+
+void CommandHistory::buildIndex(std::string_view text, TrigramIndex& index) {
+    index.postings.reserve(1 << 16);
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t end = text.find('\n', position);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        size_t stop = end;
+        if (stop > position && text[stop - 1] == '\r') {
+            --stop;
+        }
+
+        if (stop > position) {
+            std::string_view line = text.substr(position, stop - position);
+            uint32_t id = static_cast<uint32_t>(index.lines.size());
+            index.lines.push_back(line);
+
+            for (size_t i = 0; i + 3 <= line.size(); ++i) {
+                Postings& postings = index.postings[trigram(line, i)];
+                if (postings.count > 0 && postings.last == id) {
+                    continue; // Seen earlier in this line
+                }
+                uint32_t gap = postings.count > 0 ? id - postings.last : id;
+                while (gap >= 0x80) {
+                    postings.deltas.push_back(static_cast<uint8_t>(gap | 0x80));
+                    gap >>= 7;
+                }
+                postings.deltas.push_back(static_cast<uint8_t>(gap));
+                postings.last = id;
+                ++postings.count;
+            }
+        }
+        position = end + 1;
+    }
+}
+
+std::vector<uint32_t> CommandHistory::decode(const Postings& postings) {
+    std::vector<uint32_t> ids;
+    ids.reserve(postings.count);
+    uint32_t id = 0;
+    uint32_t gap = 0;
+    int shift = 0;
+    for (uint8_t byte : postings.deltas) {
+        gap |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (byte & 0x80) {
+            shift += 7;
+            continue;
+        }
+        id += gap;
+        ids.push_back(id);
+        gap = 0;
+        shift = 0;
+    }
+    return ids;
+}
@@ -0,0 +1,131 @@
+#include "terminal/CommandIO.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+thread_local std::istream* currentInput = nullptr;
+thread_local std::ostream* currentOutput = nullptr;
+
+} // namespace
+
+ByteChannel::ByteChannel(size_t capacity) : buffer(std::max<size_t>(1, capacity)) {
+}
+
+bool ByteChannel::write(const char* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (size > 0) {
+        writable.wait(lock, [this]() { return readerClosed || used < buffer.size(); });
+        if (readerClosed) {
+            return false;
+        }
+
+        // Copy into the free space, which may wrap around the end
+        size_t tail = (head + used) % buffer.size();
+        size_t chunk = std::min(size, std::min(buffer.size() - used, buffer.size() - tail));
+        std::memcpy(buffer.data() + tail, data, chunk);
+        used += chunk;
+        data += chunk;
+        size -= chunk;
+        readable.notify_one();
+    }
+    return true;
+}
+
+size_t ByteChannel::read(char* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex);
+    readable.wait(lock, [this]() { return writerClosed || used > 0; });
+
+    size_t total = 0;
+    while (total < size && used > 0) {
+        size_t chunk = std::min(size - total, std::min(used, buffer.size() - head));
+        std::memcpy(data + total, buffer.data() + head, chunk);
+        head = (head + chunk) % buffer.size();
+        used -= chunk;
+        total += chunk;
+    }
+    if (total > 0) {
+        writable.notify_one();
+    }
+    return total;
+}
+
+void ByteChannel::closeWrite() {
+    std::lock_guard<std::mutex> lock(mutex);
+    writerClosed = true;
+    readable.notify_all();
+}
+
+void ByteChannel::closeRead() {
+    std::lock_guard<std::mutex> lock(mutex);
+    readerClosed = true;
+    used = 0; // Nobody will read what is left
+    writable.notify_all();
+}
+
+ChannelStreamBuf::ChannelStreamBuf(ByteChannel& channel, bool writer) : channel(channel), writer(writer) {
+    if (writer) {
+        setp(buffer, buffer + sizeof(buffer));
+    } else {
+        setg(buffer, buffer, buffer);
+    }
+}
+
+ChannelStreamBuf::~ChannelStreamBuf() {
+    if (writer) {
+        flush();
+    }
+}
+
+ChannelStreamBuf::int_type ChannelStreamBuf::overflow(int_type c) {
+    if (!writer || !flush()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int ChannelStreamBuf::sync() {
+    return !writer || flush() ? 0 : -1;
+}
+
+ChannelStreamBuf::int_type ChannelStreamBuf::underflow() {
+    if (writer) {
+        return traits_type::eof();
+    }
+    size_t count = channel.read(buffer, sizeof(buffer));
+    if (count == 0) {
+        return traits_type::eof();
+    }
+    setg(buffer, buffer, buffer + count);
+    return traits_type::to_int_type(buffer[0]);
+}
+
+bool ChannelStreamBuf::flush() {
+    size_t pending = static_cast<size_t>(pptr() - pbase());
+    setp(buffer, buffer + sizeof(buffer));
+    return pending == 0 || channel.write(buffer, pending);
+}
+
+CommandIO::Scope::Scope(std::istream* input, std::ostream* output)
+    : previousInput(currentInput), previousOutput(currentOutput) {
+    currentInput = input;
+    currentOutput = output;
+}
+
+CommandIO::Scope::~Scope() {
+    currentInput = previousInput;
+    currentOutput = previousOutput;
+}
+
+std::ostream& CommandIO::out() {
+    return currentOutput ? *currentOutput : std::cout;
+}
+
+std::istream* CommandIO::in() {
+    return currentInput;
+}
@@ -1,11 +1,14 @@
 #include "terminal/CommandImplementation.h"
 #include "terminal/FileOperations.h"
+#include "terminal/CommandIO.h"
 #include "passman/PasswordManagerOperations.h"
 #include "encryption/FileEncryption.h"
+#include "utils/Cancellation.h"
 
-#include <windows.h>
 #include <iostream>
 #include <filesystem>
+#include <fstream>
+#include <stdexcept>
 
 CommandImplementation::CommandImplementation(Terminal& terminal) 
     : terminal(terminal), 
@@ -17,22 +20,25 @@ CommandImplementation::~CommandImplementation() {
     delete passwordOperations;
 }
 
-void CommandImplementation::help() const {
-    std::cout << "Available commands:\n";
+bool CommandImplementation::help() const {
+    std::ostream& out = CommandIO::out();
+    out << "Available commands:\n";
     auto commands = terminal.getCommandParser().getCommandList();
     for (const auto& [cmd, desc] : commands) {
-        std::cout << cmd << "\t" << desc << "\n";
+        out << cmd << "\t" << desc << "\n";
     }
+    return true;
 }
 
-void CommandImplementation::exit() {
+bool CommandImplementation::exit() {
     terminal.stop();
+    return true;
 }
 
-void CommandImplementation::encrypt(const std::vector<std::string>& args) {
+bool CommandImplementation::encrypt(const std::vector<std::string>& args) {
     if (args.size() != 3) {
         std::cout << "Usage: encrypt <input_file> <output_file> <password>\n";
-        return;
+        return false;
     }
 
     std::string inputFile = args[0];
@@ -41,7 +47,7 @@ void CommandImplementation::encrypt(const std::vector<std::string>& args) {
 
     if (!std::filesystem::exists(inputFile)) {
         std::cout << "Error: Input file '" << inputFile << "' does not exist.\n";
-        return;
+        return false;
     }
 
     if (std::filesystem::exists(outputFile)) {
@@ -52,22 +58,27 @@ void CommandImplementation::encrypt(const std::vector<std::string>& args) {
 
         if (tolower(choice) != 'y') {
             std::cout << "Encryption cancelled.\n";
-            return;
+            return true; // Declining is not an error
         }
     }
 
     FileEncryption fileEncryptor;
     if (fileEncryptor.encryptFile(inputFile, outputFile, password)) {
         std::cout << "File encrypted successfully and saved to '" << outputFile << "'.\n";
+        return true;
+    }
+    if (Utils::Cancellation::requested()) {
+        std::cout << "Encryption cancelled.\n";
     } else {
         std::cout << "Failed to encrypt the file.\n";
     }
+    return false;
 }
 
-void CommandImplementation::decrypt(const std::vector<std::string>& args) {
+bool CommandImplementation::decrypt(const std::vector<std::string>& args) {
     if (args.size() != 3) {
         std::cout << "Usage: decrypt <input_file> <output_file> <password>\n";
-        return;
+        return false;
     }
 
     std::string inputFile = args[0];
@@ -76,7 +87,7 @@ void CommandImplementation::decrypt(const std::vector<std::string>& args) {
 
     if (!std::filesystem::exists(inputFile)) {
         std::cout << "Error: Input file '" << inputFile << "' does not exist.\n";
-        return;
+        return false;
     }
 
     if (std::filesystem::exists(outputFile)) {
@@ -87,7 +98,7 @@ void CommandImplementation::decrypt(const std::vector<std::string>& args) {
 
         if (tolower(choice) != 'y') {
             std::cout << "Decryption cancelled.\n";
-            return;
+            return true; // Declining is not an error
         }
     }
 
@@ -95,31 +106,39 @@ void CommandImplementation::decrypt(const std::vector<std::string>& args) {
     
     if (!fileEncryptor.isFileEncrypted(inputFile)) {
         std::cout << "Failed to decrypt the file: The file does not appear to be encrypted.\n";
-        return;
+        return false;
     }
     
     if (fileEncryptor.decryptFile(inputFile, outputFile, password)) {
         std::cout << "File decrypted successfully and saved to '" << outputFile << "'.\n";
+        return true;
+    }
+    if (Utils::Cancellation::requested()) {
+        std::cout << "Decryption cancelled.\n";
     } else {
         std::cout << "File Decryption Unsuccessful: Incorrect Password\n";
     }
+    return false;
 }
 
 // File operation methods delegated to FileOperations class
-void CommandImplementation::cd(const std::vector<std::string>& args) { fileOperations->cd(args); }
-void CommandImplementation::ls(const std::vector<std::string>& args) { fileOperations->ls(args); }
-void CommandImplementation::copy(const std::vector<std::string>& args) { fileOperations->copy(args); }
-void CommandImplementation::move(const std::vector<std::string>& args) { fileOperations->move(args); }
-void CommandImplementation::rename(const std::vector<std::string>& args) { fileOperations->rename(args); }
-void CommandImplementation::create_directory(const std::vector<std::string>& args) { fileOperations->create_directory(args); }
-void CommandImplementation::create_file(const std::vector<std::string>& args) { fileOperations->create_file(args); }
-void CommandImplementation::display_permission(const std::vector<std::string>& args) { fileOperations->display_permission(args); }
-void CommandImplementation::get_current_directory(const std::vector<std::string>& args) { fileOperations->get_current_directory(args); }
-void CommandImplementation::remove(const std::vector<std::string>& args) { fileOperations->remove(args); }
-void CommandImplementation::write(const std::vector<std::string>& args) { fileOperations->write(args); }
+bool CommandImplementation::cd(const std::vector<std::string>& args) { return fileOperations->cd(args); }
+bool CommandImplementation::ls(const std::vector<std::string>& args) { return fileOperations->ls(args); }
+bool CommandImplementation::copy(const std::vector<std::string>& args) { return fileOperations->copy(args); }
+bool CommandImplementation::move(const std::vector<std::string>& args) { return fileOperations->move(args); }
+bool CommandImplementation::rename(const std::vector<std::string>& args) { return fileOperations->rename(args); }
+bool CommandImplementation::create_directory(const std::vector<std::string>& args) { return fileOperations->create_directory(args); }
+bool CommandImplementation::create_file(const std::vector<std::string>& args) { return fileOperations->create_file(args); }
+bool CommandImplementation::display_permission(const std::vector<std::string>& args) { return fileOperations->display_permission(args); }
+bool CommandImplementation::get_current_directory(const std::vector<std::string>& args) { return fileOperations->get_current_directory(args); }
+bool CommandImplementation::remove(const std::vector<std::string>& args) { return fileOperations->remove(args); }
+bool CommandImplementation::write(const std::vector<std::string>& args) { return fileOperations->write(args); }
+bool CommandImplementation::cat(const std::vector<std::string>& args) { return fileOperations->cat(args); }
+bool CommandImplementation::grep(const std::vector<std::string>& args) { return fileOperations->grep(args); }
+bool CommandImplementation::head(const std::vector<std::string>& args) { return fileOperations->head(args); }
 // Encryption methods have been implemented in the encrypt/decrypt methods at the top of the file
 
-void CommandImplementation::compileAndRun(const std::string& filename) {
+bool CommandImplementation::compileAndRun(const std::string& filename) {
     std::string ext = Utils::getFileExtension(filename);
     bool autoExecute = true;
     std::string command;
@@ -158,21 +177,18 @@ void CommandImplementation::compileAndRun(const std::string& filename) {
             std::string className = filename.substr(0, filename.length() - ext.length());
             command = "java " + className;
             std::cout << "Running Java class: " << command << "\n";
-            system(command.c_str());
-            return;
+            return system(command.c_str()) == 0;
         }
     }
     else if (ext == ".py") {
         command = "python " + filename;
         std::cout << "Running Python script: " << command << "\n";
-        system(command.c_str());
-        return; // Return early as we've already executed
+        return system(command.c_str()) == 0; // Return early as we've already executed
     }
     else if (ext == ".js") {
         command = "node " + filename;
         std::cout << "Running JavaScript file: " << command << "\n";
-        system(command.c_str());
-        return; // Return early as we've already executed
+        return system(command.c_str()) == 0; // Return early as we've already executed
     }
     else if (ext == ".rs") {
         std::string compiler = "rustc";
@@ -188,26 +204,29 @@ void CommandImplementation::compileAndRun(const std::string& filename) {
     else {
         std::cout << "Unsupported file extension: " << ext << "\n";
         std::cout << "Supported extensions: .cpp, .cc, .c, .java, .py, .js, .rs\n";
-        return;
+        return false;
     }
 
-    if (result == 0 && autoExecute && !outfile.empty()) {
-        std::cout << "Executing: " << outfile << "\n";
-        system(outfile.c_str());
-    } else if (result != 0) {
+    if (result != 0) {
         std::cout << "Compilation failed with error code: " << result << "\n";
+        return false;
+    }
+    if (autoExecute && !outfile.empty()) {
+        std::cout << "Executing: " << outfile << "\n";
+        return system(outfile.c_str()) == 0;
     }
+    return true;
 }
 
-void CommandImplementation::compile(const std::vector<std::string>& args) {
+bool CommandImplementation::compile(const std::vector<std::string>& args) {
     if (args.empty()) {
         std::cout << "Usage: compile <filename>\n";
-        return;
+        return false;
     }
-    compileAndRun(args[0]);
+    return compileAndRun(args[0]);
 }
 
-void CommandImplementation::system_info(const std::vector<std::string>& args) {
+bool CommandImplementation::system_info(const std::vector<std::string>&) {
     std::cout << "\n==== System Information ====\n";
     
     #ifdef _WIN32
@@ -254,165 +273,220 @@ void CommandImplementation::system_info(const std::vector<std::string>& args) {
     #endif
     
     std::cout << "\n==== End of System Information ====\n";
+    return true;
 }
 
 // Password manager operations delegated to PasswordManagerOperations class
-void CommandImplementation::passman(const std::vector<std::string>& args) { passwordOperations->passman(args); }
-
-void CommandImplementation::cat(const std::vector<std::string>& args) {
-    if (args.empty()) {
-        std::cout << "Usage: cat <filename>\n";
-        return;
-    }
-
-    std::ifstream file(args[0]);
-    if (!file) {
-        std::cout << "Error: Cannot open file '" << args[0] << "'\n";
-        return;
-    }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::cout << line << '\n';
-    }
-}
-
-void CommandImplementation::grep(const std::vector<std::string>& args) {
-    if (args.size() < 2) {
-        std::cout << "Usage: grep <pattern> <filename>\n";
-        return;
-    }
-
-    std::string pattern = args[0];
-    std::string filename = args[1];
-    std::ifstream file(filename);
-
-    if (!file) {
-        std::cout << "Error: Cannot open file '" << filename << "'\n";
-        return;
-    }
-
-    std::string line;
-    int lineNum = 0;
-    while (std::getline(file, line)) {
-        lineNum++;
-        if (line.find(pattern) != std::string::npos) {
-            std::cout << lineNum << ": " << line << '\n';
-        }
-    }
-}
-
-void CommandImplementation::head(const std::vector<std::string>& args) {
-    if (args.empty()) {
-        std::cout << "Usage: head <filename> [number_of_lines]\n";
-        return;
-    }
-
-    std::string filename = args[0];
-    int numLines = args.size() > 1 ? std::stoi(args[1]) : 10;
-
-    std::ifstream file(filename);
-    if (!file) {
-        std::cout << "Error: Cannot open file '" << filename << "'\n";
-        return;
-    }
-
-    std::string line;
-    int count = 0;
-    while (std::getline(file, line) && count < numLines) {
-        std::cout << line << '\n';
-        count++;
-    }
+bool CommandImplementation::passman(const std::vector<std::string>& args) {
+    return passwordOperations->passman(args, CommandIO::out());
 }
 
-void CommandImplementation::tree(const std::vector<std::string>& args) {
+bool CommandImplementation::tree(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
     std::string path = args.empty() ? "." : args[0];
 
+    bool succeeded = true;
     std::function<void(const std::filesystem::path&, std::string)> printTree;
     printTree = [&](const std::filesystem::path& path, std::string prefix) {
         try {
             for (const auto& entry : std::filesystem::directory_iterator(path)) {
-                std::cout << prefix << "|-- " << entry.path().filename().string() << '\n';
+                if (!out || Utils::Cancellation::requested()) {
+                    return;
+                }
+                out << prefix << "|-- " << entry.path().filename().string() << '\n';
                 if (entry.is_directory()) {
                     printTree(entry.path(), prefix + "|   ");
                 }
             }
         } catch (const std::filesystem::filesystem_error& e) {
-            std::cout << "Error accessing directory: " << e.what() << '\n';
+            out << "Error accessing directory: " << e.what() << '\n';
+            succeeded = false;
         }
     };
 
-    std::cout << path << '\n';
+    out << path << '\n';
     printTree(path, "");
+    return succeeded;
 }
 
-void CommandImplementation::find(const std::vector<std::string>& args) {
+bool CommandImplementation::find(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
     if (args.empty()) {
-        std::cout << "Usage: find <pattern>\n";
-        return;
+        out << "Usage: find <pattern>\n";
+        return false;
     }
 
     std::string pattern = args[0];
+    bool succeeded = true;
     std::function<void(const std::filesystem::path&)> searchFiles;
 
     searchFiles = [&](const std::filesystem::path& path) {
         try {
             for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+                if (!out || Utils::Cancellation::requested()) {
+                    break; // A downstream stage has finished, or the job was cancelled
+                }
                 if (entry.path().filename().string().find(pattern) != std::string::npos) {
-                    std::cout << entry.path().string() << '\n';
+                    out << entry.path().string() << '\n';
                 }
             }
         } catch (const std::filesystem::filesystem_error& e) {
-            std::cout << "Error searching files: " << e.what() << '\n';
+            out << "Error searching files: " << e.what() << '\n';
+            succeeded = false;
         }
     };
 
     searchFiles(".");
+    return succeeded;
 }
 
 // Removed duplicate system_info implementation
 
-void CommandImplementation::stat(const std::vector<std::string>& args){
+bool CommandImplementation::stat(const std::vector<std::string>& args){
+    std::ostream& out = CommandIO::out();
     if (args.empty()) {
-        std::cout << "Usage: stat <filename/directory>\n";
-        return;
+        out << "Usage: stat <filename/directory>\n";
+        return false;
     }
 
     std::filesystem::path path = args[0];
     try {
         if (!std::filesystem::exists(path)) {
-            std::cout << "Error: '" << path.string() << "' does not exist.\n";
-            return;
+            out << "Error: '" << path.string() << "' does not exist.\n";
+            return false;
         }
 
         std::filesystem::file_status status = std::filesystem::status(path);
         auto lastWriteTime = std::filesystem::last_write_time(path);
         auto fileSize = std::filesystem::is_regular_file(path) ? std::filesystem::file_size(path) : 0;
 
-        std::cout << "  File: " << path.filename().string() << "\n";
-        std::cout << "  Path: " << std::filesystem::absolute(path).string() << "\n";
-        std::cout << "  Size: " << fileSize << " bytes\n";
+        out << "  File: " << path.filename().string() << "\n";
+        out << "  Path: " << std::filesystem::absolute(path).string() << "\n";
+        out << "  Size: " << fileSize << " bytes\n";
 
-        std::cout << "  Type: ";
-        if (std::filesystem::is_regular_file(path)) std::cout << "Regular file\n";
-        else if (std::filesystem::is_directory(path)) std::cout << "Directory\n";
-        else if (std::filesystem::is_symlink(path)) std::cout << "Symbolic link\n";
-        else std::cout << "Other\n";
+        out << "  Type: ";
+        if (std::filesystem::is_regular_file(path)) out << "Regular file\n";
+        else if (std::filesystem::is_directory(path)) out << "Directory\n";
+        else if (std::filesystem::is_symlink(path)) out << "Symbolic link\n";
+        else out << "Other\n";
 
-        std::cout << "  Permissions: ";
+        out << "  Permissions: ";
         auto perms = status.permissions();
-        std::cout << ((perms & std::filesystem::perms::owner_read) != std::filesystem::perms::none ? "r" : "-");
-        std::cout << ((perms & std::filesystem::perms::owner_write) != std::filesystem::perms::none ? "w" : "-");
-        std::cout << ((perms & std::filesystem::perms::owner_exec) != std::filesystem::perms::none ? "x" : "-");
-        std::cout << ((perms & std::filesystem::perms::group_read) != std::filesystem::perms::none ? "r" : "-");
-        std::cout << ((perms & std::filesystem::perms::group_write) != std::filesystem::perms::none ? "w" : "-");
-        std::cout << ((perms & std::filesystem::perms::group_exec) != std::filesystem::perms::none ? "x" : "-");
-        std::cout << ((perms & std::filesystem::perms::others_read) != std::filesystem::perms::none ? "r" : "-");
-        std::cout << ((perms & std::filesystem::perms::others_write) != std::filesystem::perms::none ? "w" : "-");
-        std::cout << ((perms & std::filesystem::perms::others_exec) != std::filesystem::perms::none ? "x" : "-");
-        std::cout << "\n";
-
+        out << ((perms & std::filesystem::perms::owner_read) != std::filesystem::perms::none ? "r" : "-");
+        out << ((perms & std::filesystem::perms::owner_write) != std::filesystem::perms::none ? "w" : "-");
+        out << ((perms & std::filesystem::perms::owner_exec) != std::filesystem::perms::none ? "x" : "-");
+        out << ((perms & std::filesystem::perms::group_read) != std::filesystem::perms::none ? "r" : "-");
+        out << ((perms & std::filesystem::perms::group_write) != std::filesystem::perms::none ? "w" : "-");
+        out << ((perms & std::filesystem::perms::group_exec) != std::filesystem::perms::none ? "x" : "-");
+        out << ((perms & std::filesystem::perms::others_read) != std::filesystem::perms::none ? "r" : "-");
+        out << ((perms & std::filesystem::perms::others_write) != std::filesystem::perms::none ? "w" : "-");
+        out << ((perms & std::filesystem::perms::others_exec) != std::filesystem::perms::none ? "x" : "-");
+        out << "\n";
+        return true;
     } catch (const std::filesystem::filesystem_error& e) {
-        std::cout << "Error getting file properties: " << e.what() << "\n";
+        out << "Error getting file properties: " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool CommandImplementation::source(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cout << "Usage: source <script>\n";
+        return false;
+    }
+
+    std::ifstream script(args[0]);
+    if (!script.is_open()) {
+        std::cerr << "Could not open script '" << args[0] << "'\n";
+        return false;
+    }
+    // Failing lines fail the source command, so an enclosing script can stop on it
+    return terminal.runScript(script, args[0]);
+}
+
+bool CommandImplementation::jobs(const std::vector<std::string>&) {
+    std::ostream& out = CommandIO::out();
+    for (const auto& job : terminal.getJobControl().list()) {
+        out << "[" << job.id << "] " << JobControl::stateName(job.state) << "  " << job.command << "\n";
+    }
+    return true;
+}
+
+bool CommandImplementation::wait(const std::vector<std::string>& args) {
+    // A job waiting on jobs could hold every pool thread and never finish
+    if (JobControl::insideJob()) {
+        std::cerr << "wait cannot be used inside a background job\n";
+        return false;
+    }
+
+    // Succeeds only if every job waited for finished, so -e scripts stop on a failed one
+    JobControl& jobControl = terminal.getJobControl();
+    JobControl::JobState state = JobControl::JobState::Done;
+    bool succeeded = true;
+    if (args.empty()) {
+        for (const auto& job : jobControl.list()) {
+            if (jobControl.wait(job.id, CommandIO::out(), &state)) {
+                succeeded = succeeded && state != JobControl::JobState::Failed &&
+                            state != JobControl::JobState::Cancelled;
+            }
+        }
+        return succeeded;
+    }
+
+    int id = 0;
+    if (!parseJobId(args[0], id)) {
+        return false;
+    }
+    if (!jobControl.wait(id, CommandIO::out(), &state)) {
+        std::cerr << "No such job: " << args[0] << "\n";
+        return false;
+    }
+    return state != JobControl::JobState::Failed && state != JobControl::JobState::Cancelled;
+}
+
+bool CommandImplementation::fg(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        int latest = terminal.getJobControl().latest();
+        if (latest == 0) {
+            std::cerr << "No background jobs\n";
+            return false;
+        }
+        return wait({std::to_string(latest)});
+    }
+    return wait(args);
+}
+
+bool CommandImplementation::kill(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cout << "Usage: kill <job id>\n";
+        return false;
+    }
+
+    int id = 0;
+    if (!parseJobId(args[0], id)) {
+        return false;
+    }
+    if (!terminal.getJobControl().cancel(id)) {
+        std::cerr << "No such job: " << args[0] << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool CommandImplementation::parseJobId(const std::string& arg, int& id) const {
+    // Accepts "2" and the "%2" form other shells use
+    std::string text = arg;
+    if (!text.empty() && text[0] == '%') {
+        text.erase(0, 1);
+    }
+    try {
+        size_t used = 0;
+        id = std::stoi(text, &used);
+        if (used == text.size()) {
+            return true;
+        }
+    } catch (const std::exception&) {
     }
+    std::cerr << "Invalid job id: " << arg << "\n";
+    return false;
 }
@@ -1,8 +1,37 @@
 #include "terminal/CommandParser.h"
 #include "utils/Utils.h"
+#include "utils/Cancellation.h"
 #include <algorithm>
 #include <iostream>
-#include <sstream>
+
+namespace {
+
+/**
+ * @brief Calls visit(i) for each character that is neither quoted nor escaped,
+ *        following the same rules as CommandParser::tokenize
+ */
+template <typename Visit>
+void forEachUnquoted(std::string_view input, Visit&& visit) {
+    char quote = 0;
+    for (size_t i = 0; i < input.size(); ++i) {
+        char c = input[i];
+        if (quote != 0) {
+            if (c == quote) {
+                quote = 0;
+            } else if (quote == '"' && c == '\\' && i + 1 < input.size() && (input[i + 1] == '"' || input[i + 1] == '\\')) {
+                ++i;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '\\' && i + 1 < input.size() && Utils::isWordEscapable(input[i + 1])) {
+            ++i;
+        } else {
+            visit(i);
+        }
+    }
+}
+
+} // namespace
 
 CommandParser::CommandParser() {
     initializeDefaultCommands();
@@ -13,6 +42,7 @@ void CommandParser::registerCommand(const std::string& command, CommandFunction
     
     if (commandDescriptions.find(command) == commandDescriptions.end()) {
         commandDescriptions[command] = "";
+        commandNames.insert(command);
     }
 }
 
@@ -23,8 +53,9 @@ bool CommandParser::executeCommand(const std::string& command, const std::vector
     }
 
     try {
-        it->second(args);
-        return true;
+        return it->second(args);
+    } catch (const Utils::OperationCancelled&) {
+        return false; // The job that ran it reports the cancellation
     } catch (const std::exception& e) {
         std::cerr << "Error executing command: " << e.what() << std::endl;
         return false;
@@ -32,32 +63,57 @@ bool CommandParser::executeCommand(const std::string& command, const std::vector
 }
 
 std::vector<std::string> CommandParser::parseInput(const std::string& input) const {
-    std::vector<std::string> tokens;
-    std::string token;
-    bool inQuotes = false;
-    std::stringstream tokenStream;
-
-    for (char c : input) {
-        if (c == '"') {
-            inQuotes = !inQuotes;
-        } else if (c == ' ' && !inQuotes) {
-            token = tokenStream.str();
-            if (!token.empty()) {
-                tokens.push_back(token);
-                tokenStream.str("");
-                tokenStream.clear();
-            }
-        } else {
-            tokenStream << c;
+    CommandLine line;
+    tokenize(input, line);
+    return line.strings();
+}
+
+void CommandParser::tokenize(std::string_view input, CommandLine& line) const {
+    Utils::splitWords(input, line.buffer, line.tokens);
+}
+
+std::vector<std::string> CommandLine::strings(size_t first) const {
+    std::vector<std::string> result;
+    if (first < tokens.size()) {
+        result.reserve(tokens.size() - first);
+        for (size_t i = first; i < tokens.size(); ++i) {
+            result.emplace_back(tokens[i]);
         }
     }
+    return result;
+}
 
-    token = tokenStream.str();
-    if (!token.empty()) {
-        tokens.push_back(token);
+std::vector<std::string> CommandParser::splitPipeline(const std::string& input) const {
+    std::vector<std::string> stages;
+    size_t start = 0;
+    forEachUnquoted(input, [&](size_t i) {
+        if (input[i] == '|') {
+            stages.push_back(input.substr(start, i - start));
+            start = i + 1;
+        }
+    });
+    stages.push_back(input.substr(start));
+
+    return stages;
+}
+
+bool CommandParser::stripBackground(std::string& input) const {
+    size_t last = input.find_last_not_of(" \t");
+    if (last == std::string::npos || input[last] != '&') {
+        return false;
+    }
+
+    // The '&' counts only if the scan sees it, so not quoted or escaped
+    bool unquoted = false;
+    forEachUnquoted(input, [&](size_t i) {
+        unquoted = i == last;
+    });
+    if (!unquoted) {
+        return false;
     }
 
-    return tokens;
+    input.erase(last);
+    return true;
 }
 
 bool CommandParser::isValidCommand(const std::string& command) const {
@@ -100,10 +156,16 @@ void CommandParser::initializeDefaultCommands() {
         {"find", "Find files matching a pattern"},
         {"sysinfo", "Display system information"},
         {"stat", "Display file or directory status"},
+        {"source", "Run the commands in a script file"},
+        {"jobs", "List background jobs started with a trailing '&'"},
+        {"wait", "Wait for a background job, or all of them, and show its output"},
+        {"fg", "Follow a background job's output until it finishes"},
+        {"kill", "Cancel a background job"},
     };
     
     for (const auto& [cmd, _] : commandDescriptions) {
-        commands[cmd] = [](const std::vector<std::string>&) {};
+        commands[cmd] = [](const std::vector<std::string>&) { return true; };
+        commandNames.insert(cmd);
     }
 }
 
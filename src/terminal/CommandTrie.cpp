@@ -0,0 +1,99 @@
+#include "terminal/CommandTrie.h"
+#include <algorithm>
+
+CommandTrie::CommandTrie() : nodes(1) {
+}
+
+void CommandTrie::insert(std::string_view name) {
+    int32_t node = 0;
+    for (char c : name) {
+        auto& children = nodes[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), c,
+                                   [](const std::pair<char, int32_t>& edge, char key) { return edge.first < key; });
+        if (it != children.end() && it->first == c) {
+            node = it->second;
+            continue;
+        }
+        int32_t next = static_cast<int32_t>(nodes.size());
+        children.insert(it, {c, next});
+        nodes.emplace_back(); // May move children; it is not touched again
+        node = next;
+    }
+    nodes[node].terminal = true;
+}
+
+bool CommandTrie::contains(std::string_view name) const {
+    int32_t node = find(name);
+    return node >= 0 && nodes[node].terminal;
+}
+
+bool CommandTrie::hasPrefix(std::string_view prefix) const {
+    return find(prefix) >= 0;
+}
+
+void CommandTrie::complete(std::string_view prefix, std::vector<std::string>& names) const {
+    int32_t node = find(prefix);
+    if (node >= 0) {
+        std::string name(prefix);
+        collect(node, name, names);
+    }
+}
+
+void CommandTrie::collect(int32_t node, std::string& name, std::vector<std::string>& names) const {
+    // A name sorts before its extensions, and children are already in order
+    if (nodes[node].terminal) {
+        names.push_back(name);
+    }
+    for (const auto& edge : nodes[node].children) {
+        name.push_back(edge.first);
+        collect(edge.second, name, names);
+        name.pop_back();
+    }
+}
+
+int32_t CommandTrie::child(int32_t node, char c) const {
+    for (const auto& edge : nodes[node].children) {
+        if (edge.first == c) {
+            return edge.second;
+        }
+        if (edge.first > c) {
+            break;
+        }
+    }
+    return -1;
+}
+
+int32_t CommandTrie::find(std::string_view prefix) const {
+    int32_t node = 0;
+    for (char c : prefix) {
+        node = child(node, c);
+        if (node < 0) {
+            break;
+        }
+    }
+    return node;
+}
+
+CommandTrie::Cursor::Cursor(const CommandTrie& trie) : trie(&trie) {
+    path.reserve(64);
+}
+
+void CommandTrie::Cursor::push(char c) {
+    int32_t current = node();
+    path.push_back(current < 0 ? -1 : trie->child(current, c));
+}
+
+void CommandTrie::Cursor::pop() {
+    if (!path.empty()) {
+        path.pop_back();
+    }
+}
+
+void CommandTrie::Cursor::reset() {
+    path.clear();
+}
+
+bool CommandTrie::Cursor::isCommand() const {
+    int32_t current = node();
+    return current >= 0 && trie->nodes[current].terminal;
+}
@@ -0,0 +1,94 @@
+#include "terminal/Completer.h"
+#include <algorithm>
+
+Completer::Completer(const CommandParser& parser, const std::unordered_map<std::string, std::string>& aliases)
+    : parser(parser), aliases(aliases) {
+}
+
+Completion Completer::complete(const std::string& line) {
+    Completion result;
+    result.line = line;
+
+    // Find where the last word starts, treating quotes the way parseInput does
+    size_t wordStart = 0;
+    bool firstWord = true;
+    char quote = 0;
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (quote != 0) {
+            if (line[i] == quote) {
+                quote = 0;
+            }
+        } else if (line[i] == '"' || line[i] == '\'') {
+            quote = line[i];
+        } else if (line[i] == ' ') {
+            if (i > wordStart) {
+                firstWord = false;
+            }
+            wordStart = i + 1;
+        }
+    }
+
+    std::string word = line.substr(wordStart);
+    bool quoted = word.find_first_of("\"'") != std::string::npos;
+    word.erase(std::remove_if(word.begin(), word.end(), [](char c) { return c == '"' || c == '\''; }),
+               word.end());
+
+    std::string directoryPart;
+    std::vector<std::string> names;
+    std::vector<bool> isDirectory;
+    if (firstWord) {
+        completeCommand(word, names);
+        isDirectory.assign(names.size(), false);
+    } else {
+        size_t separator = word.find_last_of("/\\");
+        if (separator != std::string::npos) {
+            directoryPart = word.substr(0, separator + 1);
+        }
+        std::vector<DirectoryCache::Entry> entries;
+        directories.lookup(directoryPart.empty() ? "." : directoryPart, word.substr(directoryPart.size()), entries);
+        for (auto& entry : entries) {
+            names.push_back(std::move(entry.name));
+            isDirectory.push_back(entry.directory);
+        }
+    }
+    if (names.empty()) {
+        return result;
+    }
+
+    // Names are sorted, so the first and last bound the common prefix
+    const std::string& first = names.front();
+    const std::string& last = names.back();
+    size_t common = 0;
+    while (common < first.size() && common < last.size() && first[common] == last[common]) {
+        ++common;
+    }
+
+    std::string replacement = directoryPart + first.substr(0, common);
+    bool needsQuotes = quoted || replacement.find(' ') != std::string::npos;
+    std::string completed = (needsQuotes ? "\"" : "") + replacement;
+    if (names.size() == 1) {
+        if (isDirectory[0]) {
+            completed += '/';
+        } else {
+            completed += needsQuotes ? "\" " : " ";
+        }
+    } else {
+        for (size_t i = 0; i < names.size(); ++i) {
+            result.candidates.push_back(isDirectory[i] ? names[i] + '/' : names[i]);
+        }
+    }
+
+    result.line = line.substr(0, wordStart) + completed;
+    return result;
+}
+
+void Completer::completeCommand(const std::string& word, std::vector<std::string>& names) const {
+    parser.getCommandTrie().complete(word, names);
+    for (const auto& alias : aliases) {
+        if (alias.first.compare(0, word.size(), word) == 0) {
+            names.push_back(alias.first);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+}
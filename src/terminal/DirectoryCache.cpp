@@ -0,0 +1,90 @@
+#include "terminal/DirectoryCache.h"
+#include <algorithm>
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+DirectoryCache::DirectoryCache(size_t maxDirectories)
+    : maxDirectories(std::max<size_t>(1, maxDirectories)) {
+}
+
+bool DirectoryCache::lookup(const fs::path& directory, std::string_view prefix, std::vector<Entry>& matches) {
+    matches.clear();
+    const Snapshot* current = snapshot(directory);
+    if (!current) {
+        return false;
+    }
+
+    const auto& entries = current->entries;
+    auto first = std::lower_bound(entries.begin(), entries.end(), prefix,
+                                  [](const Entry& entry, std::string_view key) { return entry.name < key; });
+    bool showHidden = !prefix.empty() && prefix[0] == '.';
+    for (auto it = first; it != entries.end() && it->name.compare(0, prefix.size(), prefix) == 0; ++it) {
+        if (showHidden || it->name[0] != '.') {
+            matches.push_back(*it);
+        }
+    }
+    return true;
+}
+
+const DirectoryCache::Snapshot* DirectoryCache::snapshot(const fs::path& directory) {
+    std::error_code ec;
+    fs::path absolute = fs::absolute(directory, ec).lexically_normal();
+    if (ec) {
+        return nullptr;
+    }
+    fs::file_time_type modified = fs::last_write_time(absolute, ec);
+    if (ec || !fs::is_directory(absolute, ec)) {
+        return nullptr;
+    }
+
+    std::string key = absolute.string();
+    auto it = snapshots.find(key);
+    if (it != snapshots.end() && it->second.modified == modified && !it->second.racy) {
+        it->second.lastUse = ++useCounter;
+        return &it->second;
+    }
+
+    Snapshot fresh;
+    if (!scan(absolute, modified, fresh)) {
+        return nullptr;
+    }
+    if (it != snapshots.end()) {
+        it->second = std::move(fresh);
+        return &it->second;
+    }
+
+    if (snapshots.size() >= maxDirectories) {
+        auto oldest = std::min_element(snapshots.begin(), snapshots.end(), [](const auto& a, const auto& b) {
+            return a.second.lastUse < b.second.lastUse;
+        });
+        snapshots.erase(oldest);
+    }
+    return &snapshots.emplace(key, std::move(fresh)).first->second;
+}
+
+bool DirectoryCache::scan(const fs::path& directory, fs::file_time_type modified, Snapshot& snapshot) {
+    std::error_code ec;
+    fs::directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        return false;
+    }
+
+    for (; it != fs::directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            return false;
+        }
+        Entry entry;
+        entry.name = it->path().filename().string();
+        entry.directory = it->is_directory(ec); // Usually answered from the listing itself
+        snapshot.entries.push_back(std::move(entry));
+    }
+    std::sort(snapshot.entries.begin(), snapshot.entries.end(),
+              [](const Entry& a, const Entry& b) { return a.name < b.name; });
+
+    snapshot.modified = modified;
+    snapshot.racy = fs::file_time_type::clock::now() - modified < std::chrono::seconds(2);
+    snapshot.lastUse = ++useCounter;
+    ++scanCount;
+    return true;
+}
@@ -1,34 +1,65 @@
 #include "terminal/FileOperations.h"
+#include "terminal/CommandIO.h"
+#include "terminal/TerminalBackend.h"
+#include "utils/Cancellation.h"
 #include <iostream>
 #include <filesystem>
 #include <fstream>
 #include <algorithm>
-#include <conio.h>
+
+namespace {
+
+// Passes a piped stream through in blocks until it ends, the destination
+// stops taking output or the job is cancelled. Unlike operator<<(streambuf*),
+// an empty input leaves the destination's state alone.
+bool copyStream(std::istream& in, std::ostream& out) {
+    char buffer[8192];
+    while (out && !Utils::Cancellation::requested()) {
+        in.read(buffer, sizeof(buffer));
+        std::streamsize count = in.gcount();
+        if (count == 0) {
+            break;
+        }
+        out.write(buffer, count);
+    }
+    return static_cast<bool>(out);
+}
+
+} // namespace
 
 FileOperations::FileOperations() {}
 
-void FileOperations::cd(const std::vector<std::string>& args) {
+bool FileOperations::cd(const std::vector<std::string>& args) {
     if (args.empty()) {
         std::cout << "Usage: cd <directory>\n";
-        return;
+        return false;
     }
     if (!Utils::changeDirectory(args[0])) {
         std::cout << "Failed to change directory\n";
+        return false;
     }
+    return true;
 }
 
-void FileOperations::ls(const std::vector<std::string>& args) {
+bool FileOperations::ls(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
     std::string path = args.empty() ? "." : args[0];
+    std::error_code error;
+    if (!std::filesystem::is_directory(path, error)) {
+        out << "Error: '" << path << "' is not a directory.\n";
+        return false;
+    }
     auto files = Utils::listDirectory(path);
     for (const auto& file : files) {
-        std::cout << file << "\n";
+        out << file << "\n";
     }
+    return true;
 }
 
-void FileOperations::copy(const std::vector<std::string>& args) {
+bool FileOperations::copy(const std::vector<std::string>& args) {
     if (args.size() != 2) {
         std::cout << "Usage: copy <source> <destination>\n";
-        return;
+        return false;
     }
 
     std::filesystem::path source_path = args[0];
@@ -38,16 +69,18 @@ void FileOperations::copy(const std::vector<std::string>& args) {
         std::filesystem::copy(source_path, dest_path, 
             std::filesystem::copy_options::overwrite_existing);
         std::cout << "File copied successfully.\n";
+        return true;
     }
     catch (const std::filesystem::filesystem_error& e) {
         std::cout << "Error copying the file: " << e.what() << "\n";
+        return false;
     }
 }
 
-void FileOperations::rename(const std::vector<std::string>& args) {
+bool FileOperations::rename(const std::vector<std::string>& args) {
     if (args.size() != 2) {
         std::cout << "Usage: rename <old_name> <new_name>\n";
-        return;
+        return false;
     }
 
     std::filesystem::path old_path = args[0];
@@ -56,26 +89,28 @@ void FileOperations::rename(const std::vector<std::string>& args) {
     try {
         if (!std::filesystem::exists(old_path)) {
             std::cout << "Error: File '" << old_path.string() << "' does not exist.\n";
-            return;
+            return false;
         }
 
         if (std::filesystem::exists(new_path)) {
             std::cout << "Error: File '" << new_path.string() << "' already exists.\n";
-            return;
+            return false;
         }
 
         std::filesystem::rename(old_path, new_path);
         std::cout << "Successfully renamed '" << old_path.string() << "' to '" << new_path.string() << "'.\n";
+        return true;
     }
     catch (const std::filesystem::filesystem_error& e) {
         std::cout << "Error renaming file: " << e.what() << "\n";
+        return false;
     }
 }
 
-void FileOperations::move(const std::vector<std::string>& args) {
+bool FileOperations::move(const std::vector<std::string>& args) {
     if (args.size() != 2) {
         std::cout << "Usage: move <source> <destination>\n";
-        return;
+        return false;
     }
 
     std::filesystem::path source_path = args[0];
@@ -84,7 +119,7 @@ void FileOperations::move(const std::vector<std::string>& args) {
     try {
         if (!std::filesystem::exists(source_path)) {
             std::cout << "Error: Source '" << source_path.string() << "' does not exist.\n";
-            return;
+            return false;
         }
 
         if (std::filesystem::is_directory(dest_path)) {
@@ -99,12 +134,13 @@ void FileOperations::move(const std::vector<std::string>& args) {
 
             if (tolower(choice) != 'y') {
                 std::cout << "Move operation cancelled.\n";
-                return;
+                return true; // Declining is not an error
             }
         }
 
         std::filesystem::rename(source_path, dest_path);
         std::cout << "Successfully moved '" << source_path.string() << "' to '" << dest_path.string() << "'.\n";
+        return true;
     }
     catch (const std::filesystem::filesystem_error& e) {
         std::cout << "Error moving file: " << e.what() << "\n";
@@ -115,17 +151,19 @@ void FileOperations::move(const std::vector<std::string>& args) {
                 std::filesystem::copy_options::recursive);
             std::filesystem::remove_all(source_path);
             std::cout << "Successfully moved using copy and delete method.\n";
+            return true;
         }
         catch (const std::filesystem::filesystem_error& e2) {
             std::cout << "Error during fallback copy-delete: " << e2.what() << "\n";
+            return false;
         }
     }
 }
 
-void FileOperations::create_directory(const std::vector<std::string>& args) {
+bool FileOperations::create_directory(const std::vector<std::string>& args) {
     if (args.empty()) {
         std::cout << "Usage: dcreate <directory_name>\n";
-        return;
+        return false;
     }
 
     std::filesystem::path dir_path = args[0];
@@ -133,24 +171,26 @@ void FileOperations::create_directory(const std::vector<std::string>& args) {
     try {
         if (std::filesystem::exists(dir_path)) {
             std::cout << "Error: Directory '" << dir_path.string() << "' already exists.\n";
-            return;
+            return false;
         }
 
         if (std::filesystem::create_directory(dir_path)) {
             std::cout << "Directory '" << dir_path.string() << "' created successfully.\n";
-        } else {
-            std::cout << "Failed to create directory.\n";
+            return true;
         }
+        std::cout << "Failed to create directory.\n";
+        return false;
     }
     catch (const std::filesystem::filesystem_error& e) {
         std::cout << "Error creating directory: " << e.what() << "\n";
+        return false;
     }
 }
 
-void FileOperations::create_file(const std::vector<std::string>& args) {
+bool FileOperations::create_file(const std::vector<std::string>& args) {
     if (args.empty()) {
         std::cout << "Usage: fcreate <filename>\n";
-        return;
+        return false;
     }
 
     std::filesystem::path file_path = args[0];
@@ -158,34 +198,37 @@ void FileOperations::create_file(const std::vector<std::string>& args) {
     try {
         if (std::filesystem::exists(file_path)) {
             std::cout << "Error: File '" << file_path.string() << "' already exists.\n";
-            return;
+            return false;
         }
 
         std::ofstream file(file_path);
         if (file.is_open()) {
             file.close();
             std::cout << "File '" << file_path.string() << "' created successfully.\n";
-        } else {
-            std::cout << "Failed to create file.\n";
+            return true;
         }
+        std::cout << "Failed to create file.\n";
+        return false;
     }
     catch (const std::filesystem::filesystem_error& e) {
         std::cout << "Error creating file: " << e.what() << "\n";
+        return false;
     }
 }
 
-void FileOperations::display_permission(const std::vector<std::string>& args) {
+bool FileOperations::display_permission(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
     if (args.empty()) {
-        std::cout << "Usage: permission <filename>\n";
-        return;
+        out << "Usage: permission <filename>\n";
+        return false;
     }
 
     std::filesystem::path file_path = args[0];
 
     try {
         if (!std::filesystem::exists(file_path)) {
-            std::cout << "Error: File '" << file_path.string() << "' does not exist.\n";
-            return;
+            out << "Error: File '" << file_path.string() << "' does not exist.\n";
+            return false;
         }
 
         std::filesystem::perms permissions = std::filesystem::status(file_path).permissions();
@@ -197,32 +240,37 @@ void FileOperations::display_permission(const std::vector<std::string>& args) {
         };
 
         std::string permission_keywords = "rwxrwxrwx";
-        std::cout << "Permissions for '" << file_path.string() << "': ";
+        out << "Permissions for '" << file_path.string() << "': ";
         
         for (int i = 0; i < 9; i++) {
-            std::cout << ((permissions & permission_collection[i]) != std::filesystem::perms::none ? 
+            out << ((permissions & permission_collection[i]) != std::filesystem::perms::none ? 
                          permission_keywords[i] : '-');
         }
-        std::cout << "\n";
+        out << "\n";
+        return true;
     }
     catch (const std::filesystem::filesystem_error& e) {
-        std::cout << "Error displaying permissions: " << e.what() << "\n";
+        out << "Error displaying permissions: " << e.what() << "\n";
+        return false;
     }
 }
 
-void FileOperations::get_current_directory(const std::vector<std::string>& args) {
+bool FileOperations::get_current_directory(const std::vector<std::string>&) {
+    std::ostream& out = CommandIO::out();
     try {
-        std::cout << "Current working directory: " << std::filesystem::current_path().string() << std::endl;
+        out << "Current working directory: " << std::filesystem::current_path().string() << std::endl;
+        return true;
     }
     catch (const std::filesystem::filesystem_error& e) {
-        std::cout << "Error getting current directory: " << e.what() << "\n";
+        out << "Error getting current directory: " << e.what() << "\n";
+        return false;
     }
 }
 
-void FileOperations::remove(const std::vector<std::string>& args) {
+bool FileOperations::remove(const std::vector<std::string>& args) {
     if (args.empty()) {
         std::cout << "Usage: del <filename/directory>\n";
-        return;
+        return false;
     }
 
     std::filesystem::path path = args[0];
@@ -230,7 +278,7 @@ void FileOperations::remove(const std::vector<std::string>& args) {
     try {
         if (!std::filesystem::exists(path)) {
             std::cout << "Error: '" << path.string() << "' does not exist.\n";
-            return;
+            return false;
         }
 
         std::cout << "Are you sure you want to delete '" << path.string() << "'? (y/n): ";
@@ -240,46 +288,54 @@ void FileOperations::remove(const std::vector<std::string>& args) {
 
         if (tolower(choice) != 'y') {
             std::cout << "Delete operation cancelled.\n";
-            return;
+            return true; // Declining is not an error
         }
 
         if (std::filesystem::remove_all(path)) {
             std::cout << "Successfully deleted '" << path.string() << "'.\n";
-        } else {
-            std::cout << "Failed to delete item.\n";
+            return true;
         }
+        std::cout << "Failed to delete item.\n";
+        return false;
     }
     catch (const std::filesystem::filesystem_error& e) {
         std::cout << "Error deleting item: " << e.what() << "\n";
+        return false;
     }
 }
 
-void FileOperations::cat(const std::vector<std::string>& args) {
+bool FileOperations::cat(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
+    std::istream* piped = CommandIO::in();
+    if (args.empty() && piped) {
+        copyStream(*piped, out); // Pass the upstream output through
+        return true;
+    }
     if (args.empty()) {
-        std::cout << "Usage: cat <filename>\n";
-        return;
+        out << "Usage: cat <filename>\n";
+        return false;
     }
 
     std::string filename = args[0];
     std::ifstream file(filename);
 
     if (!file.is_open()) {
-        std::cout << "Error: Could not open file '" << filename << "'\n";
-        return;
+        out << "Error: Could not open file '" << filename << "'\n";
+        return false;
     }
 
+    // Stops as soon as a downstream stage stops reading or the job is cancelled
     std::string line;
-    while (std::getline(file, line)) {
-        std::cout << line << "\n";
+    while (out && !Utils::Cancellation::requested() && std::getline(file, line)) {
+        out << line << "\n";
     }
-
-    file.close();
+    return true;
 }
 
-void FileOperations::write(const std::vector<std::string>& args) {
+bool FileOperations::write(const std::vector<std::string>& args) {
     if (args.empty()) {
         std::cout << "Usage: write <filename> [-a]\n";
-        return;
+        return false;
     }
 
     std::string filename = args[0];
@@ -288,27 +344,42 @@ void FileOperations::write(const std::vector<std::string>& args) {
     std::ofstream file(filename, appendMode ? std::ios::app : std::ios::out);
     if (!file.is_open()) {
         std::cout << "Error: Could not open file '" << filename << "' for writing\n";
-        return;
+        return false;
+    }
+
+    if (std::istream* piped = CommandIO::in()) {
+        if (!copyStream(*piped, file)) {
+            std::cout << "Error: Could not write to file '" << filename << "'\n";
+            return false;
+        }
+        std::cout << "Content written to file successfully.\n";
+        return true;
     }
 
-    std::cout << "Enter content (press Ctrl+Z to finish):\n";
+    std::cout << "Enter content (press Ctrl+Z or Ctrl+D to finish):\n";
+    TerminalBackend& console = TerminalBackend::console();
+    TerminalBackend::RawMode rawMode(console);
     std::string line;
-    int ch;
-    while ((ch = _getch()) != 26) { 
-        if (ch == '\r') {
-            std::cout << '\n';
+    int key;
+    while ((key = console.readKey()) != 26 && key != 4 && key != TerminalBackend::EndOfInput) {
+        if (key == TerminalBackend::Enter) {
+            console.write('\n');
             file << line << '\n';
             line.clear();
-        } else if (ch == '\b') {
+        } else if (key == TerminalBackend::Backspace) {
             if (!line.empty()) {
                 line.pop_back();
-                std::cout << "\b \b";
+                console.write("\b \b");
             }
-        } else {
-            line += static_cast<char>(ch);
-            std::cout << static_cast<char>(ch);
+        } else if (key == TerminalBackend::Tab || (key >= 32 && key <= 255)) {
+            line += static_cast<char>(key);
+            console.write(static_cast<char>(key));
+        }
+        if (!console.hasPendingInput()) {
+            console.flush(); // A pasted block is echoed in one write
         }
     }
+    console.flush();
     
     if (!line.empty()) {
         file << line << '\n';
@@ -316,12 +387,27 @@ void FileOperations::write(const std::vector<std::string>& args) {
     
     file.close();
     std::cout << "\nContent written to file successfully.\n";
+    return true;
 }
 
-void FileOperations::grep(const std::vector<std::string>& args) {
+bool FileOperations::grep(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
+    std::istream* piped = CommandIO::in();
+    if (args.size() == 1 && piped) {
+        // Filter mode, printing matching lines unchanged so stages compose
+        std::string line;
+        bool found = false;
+        while (out && !Utils::Cancellation::requested() && std::getline(*piped, line)) {
+            if (line.find(args[0]) != std::string::npos) {
+                out << line << "\n";
+                found = true;
+            }
+        }
+        return found; // As grep, no match counts as failure
+    }
     if (args.size() < 2) {
-        std::cout << "Usage: grep <pattern> <filename>\n";
-        return;
+        out << "Usage: grep <pattern> <filename>\n";
+        return false;
     }
 
     std::string pattern = args[0];
@@ -329,82 +415,92 @@ void FileOperations::grep(const std::vector<std::string>& args) {
     std::ifstream file(filename);
 
     if (!file.is_open()) {
-        std::cout << "Error: Could not open file '" << filename << "'\n";
-        return;
+        out << "Error: Could not open file '" << filename << "'\n";
+        return false;
     }
 
     std::string line;
     int lineNumber = 0;
     bool found = false;
 
-    while (std::getline(file, line)) {
+    while (out && !Utils::Cancellation::requested() && std::getline(file, line)) {
         lineNumber++;
         if (line.find(pattern) != std::string::npos) {
-            std::cout << lineNumber << ": " << line << "\n";
+            out << lineNumber << ": " << line << "\n";
             found = true;
         }
     }
 
     if (!found) {
-        std::cout << "Pattern '" << pattern << "' not found in file '" << filename << "'\n";
+        out << "Pattern '" << pattern << "' not found in file '" << filename << "'\n";
     }
-
-    file.close();
+    return found;
 }
 
-void FileOperations::head(const std::vector<std::string>& args) {
-    if (args.empty()) {
-        std::cout << "Usage: head <filename> [lines]\n";
-        return;
+bool FileOperations::head(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
+    std::istream* piped = CommandIO::in();
+    // Piped input takes only the line count, as in "cat log | head 20"
+    bool fromPipe = piped && args.size() <= 1;
+    if (args.empty() && !fromPipe) {
+        out << "Usage: head <filename> [lines]\n";
+        return false;
     }
 
-    std::string filename = args[0];
     int numLines = 10; // Default to 10 lines
+    size_t countArg = fromPipe ? 0 : 1;
 
-    if (args.size() > 1) {
+    if (args.size() > countArg) {
         try {
-            numLines = std::stoi(args[1]);
+            numLines = std::stoi(args[countArg]);
         } catch (const std::exception&) {
-            std::cout << "Invalid number of lines. Using default (10).\n";
+            out << "Invalid number of lines. Using default (10).\n";
         }
     }
 
-    std::ifstream file(filename);
-
-    if (!file.is_open()) {
-        std::cout << "Error: Could not open file '" << filename << "'\n";
-        return;
+    std::ifstream file;
+    if (!fromPipe) {
+        file.open(args[0]);
+        if (!file.is_open()) {
+            out << "Error: Could not open file '" << args[0] << "'\n";
+            return false;
+        }
     }
+    std::istream& input = fromPipe ? *piped : file;
 
+    // Checks the count first so no line past the last one is read
     std::string line;
     int lineCount = 0;
 
-    while (std::getline(file, line) && lineCount < numLines) {
-        std::cout << line << "\n";
+    while (lineCount < numLines && out && !Utils::Cancellation::requested() && std::getline(input, line)) {
+        out << line << "\n";
         lineCount++;
     }
-
-    file.close();
+    return true;
 }
 
-void FileOperations::tree(const std::vector<std::string>& args) {
+bool FileOperations::tree(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
     std::string path = args.empty() ? "." : args[0];
     int maxDepth = args.size() > 1 ? std::stoi(args[1]) : -1;
     
     try {
         if (!std::filesystem::exists(path)) {
-            std::cout << "Error: Path '" << path << "' does not exist.\n";
-            return;
+            out << "Error: Path '" << path << "' does not exist.\n";
+            return false;
         }
         
-        std::cout << path << "\n";
+        out << path << "\n";
         printDirectoryTree(path, "", maxDepth, 0);
+        return true;
     } catch (const std::exception& e) {
-        std::cout << "Error: " << e.what() << "\n";
+        out << "Error: " << e.what() << "\n";
+        return false;
     }
 }
 
 void FileOperations::printDirectoryTree(const std::string& path, const std::string& prefix, int maxDepth, int currentDepth) {
+    std::ostream& out = CommandIO::out();
     if (maxDepth != -1 && currentDepth >= maxDepth) {
         return;
     }
@@ -420,81 +516,92 @@ void FileOperations::printDirectoryTree(const std::string& path, const std::stri
             return a.path().filename().string() < b.path().filename().string();
         });
         
-        for (size_t i = 0; i < entries.size(); ++i) {
+        for (size_t i = 0; i < entries.size() && !Utils::Cancellation::requested(); ++i) {
             const auto& entry = entries[i];
             bool isLast = (i == entries.size() - 1);
             
             std::string connector = isLast ? "└── " : "├── ";
             std::string nextPrefix = isLast ? "    " : "│   ";
             
-            std::cout << prefix << connector << entry.path().filename().string() << "\n";
+            out << prefix << connector << entry.path().filename().string() << "\n";
             
             if (std::filesystem::is_directory(entry.path())) {
                 printDirectoryTree(entry.path().string(), prefix + nextPrefix, maxDepth, currentDepth + 1);
             }
         }
     } catch (const std::exception& e) {
-        std::cout << "Error accessing directory: " << e.what() << "\n";
+        out << "Error accessing directory: " << e.what() << "\n";
     }
 }
 
-void FileOperations::find(const std::vector<std::string>& args) {
+bool FileOperations::find(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
     if (args.size() < 2) {
-        std::cout << "Usage: find <directory> <pattern>\n";
-        return;
+        out << "Usage: find <directory> <pattern>\n";
+        return false;
     }
     
     std::string directory = args[0];
     std::string pattern = args[1];
     
     if (!std::filesystem::exists(directory) || !std::filesystem::is_directory(directory)) {
-        std::cout << "Error: '" << directory << "' is not a valid directory.\n";
-        return;
+        out << "Error: '" << directory << "' is not a valid directory.\n";
+        return false;
     }
     
-    std::cout << "Searching for files matching '" << pattern << "' in '" << directory << "'...\n";
-    findFiles(directory, pattern);
+    if (&out == &std::cout) { // Piped output carries the results alone
+        out << "Searching for files matching '" << pattern << "' in '" << directory << "'...\n";
+    }
+    return findFiles(directory, pattern);
 }
 
-void FileOperations::findFiles(const std::string& directory, const std::string& pattern) {
+bool FileOperations::findFiles(const std::string& directory, const std::string& pattern) {
+    std::ostream& out = CommandIO::out();
     try {
         for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+            if (!out || Utils::Cancellation::requested()) {
+                break; // A downstream stage has finished, or the job was cancelled
+            }
             std::string filename = entry.path().filename().string();
             if (filename.find(pattern) != std::string::npos) {
-                std::cout << entry.path().string() << "\n";
+                out << entry.path().string() << "\n";
             }
         }
+        return true;
     } catch (const std::exception& e) {
-        std::cout << "Error during search: " << e.what() << "\n";
+        out << "Error during search: " << e.what() << "\n";
+        return false;
     }
 }
 
-void FileOperations::stat(const std::vector<std::string>& args) {
+bool FileOperations::stat(const std::vector<std::string>& args) {
+    std::ostream& out = CommandIO::out();
     if (args.empty()) {
-        std::cout << "Usage: stat <filename>\n";
-        return;
+        out << "Usage: stat <filename>\n";
+        return false;
     }
     
     std::string filename = args[0];
     
     try {
         if (!std::filesystem::exists(filename)) {
-            std::cout << "Error: File '" << filename << "' does not exist.\n";
-            return;
+            out << "Error: File '" << filename << "' does not exist.\n";
+            return false;
         }
         
         auto fileStatus = std::filesystem::status(filename);
         auto lastWriteTime = std::filesystem::last_write_time(filename);
         auto fileSize = std::filesystem::is_regular_file(filename) ? std::filesystem::file_size(filename) : 0;
         
-        std::cout << "File: " << filename << "\n";
-        std::cout << "Size: " << fileSize << " bytes\n";
-        std::cout << "Type: " << (std::filesystem::is_directory(filename) ? "Directory" : 
+        out << "File: " << filename << "\n";
+        out << "Size: " << fileSize << " bytes\n";
+        out << "Type: " << (std::filesystem::is_directory(filename) ? "Directory" : 
                                  std::filesystem::is_regular_file(filename) ? "Regular File" : "Other") << "\n";
         
-        std::cout << "Permissions: ";
-        display_permission(std::vector<std::string>{filename});
+        out << "Permissions: ";
+        return display_permission(std::vector<std::string>{filename});
     } catch (const std::exception& e) {
-        std::cout << "Error getting file stats: " << e.what() << "\n";
+        out << "Error getting file stats: " << e.what() << "\n";
+        return false;
     }
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "terminal/JobControl.h"
+#include "terminal/CommandIO.h"
+#include "utils/Cancellation.h"
+#include <algorithm>
+#include <streambuf>
+
+namespace {
+
+thread_local bool runningJob = false;
+
+} // namespace
+
+/**
+ * @brief Unbuffered stream target that appends to a job's output
+ */
+class JobControl::OutputBuffer : public std::streambuf {
+public:
+    OutputBuffer(JobControl& control, Job& job) : control(control), job(job) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            char ch = traits_type::to_char_type(c);
+            control.append(job, &ch, 1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize size) override {
+        control.append(job, data, static_cast<size_t>(size));
+        return size;
+    }
+
+private:
+    JobControl& control;
+    Job& job;
+};
+
+JobControl::JobControl(Runner runner, size_t threadCount)
+    : runner(std::move(runner)), pool(threadCount) {
+}
+
+JobControl::~JobControl() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& [id, job] : jobs) {
+        job->cancelRequested = true;
+    }
+    // The pool is destroyed next and waits for the jobs to reach a checkpoint
+}
+
+int JobControl::start(const std::string& line) {
+    auto job = std::make_shared<Job>();
+    job->command = line;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job->id = nextId++;
+        jobs[job->id] = job;
+    }
+    pool.submit([this, job]() { run(job); });
+    return job->id;
+}
+
+void JobControl::run(const std::shared_ptr<Job>& job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (job->cancelRequested) {
+            job->state = JobState::Cancelled; // Cancelled before it started
+            changed.notify_all();
+            return;
+        }
+        job->state = JobState::Running;
+        changed.notify_all();
+    }
+
+    OutputBuffer buffer(*this, *job);
+    std::ostream out(&buffer);
+    bool succeeded = false;
+    runningJob = true;
+    {
+        Utils::Cancellation::Scope watch(&job->cancelRequested);
+        CommandIO::Scope scope(nullptr, &out);
+        try {
+            succeeded = runner(job->command);
+        } catch (const Utils::OperationCancelled&) {
+        } catch (const std::exception& e) {
+            out << "Error: " << e.what() << "\n";
+        }
+    }
+    runningJob = false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (job->cancelRequested) {
+        job->state = JobState::Cancelled;
+    } else {
+        job->state = succeeded ? JobState::Done : JobState::Failed;
+    }
+    changed.notify_all();
+}
+
+void JobControl::append(Job& job, const char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Nobody may ever look, so a chatty job is capped rather than growing without bound
+    size_t room = kMaxBufferedOutput - std::min(kMaxBufferedOutput, job.output.size());
+    size_t kept = std::min(room, size);
+    job.output.append(data, kept);
+    job.dropped += size - kept;
+    changed.notify_all();
+}
+
+std::vector<JobControl::JobInfo> JobControl::list() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<JobInfo> result;
+    result.reserve(jobs.size());
+    for (const auto& [id, job] : jobs) {
+        result.push_back({id, job->command, job->state});
+    }
+    return result;
+}
+
+bool JobControl::cancel(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    it->second->cancelRequested = true;
+    return true;
+}
+
+bool JobControl::wait(int id, std::ostream& out, JobState* state) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    std::shared_ptr<Job> job = it->second;
+
+    // Output is written with the lock released, so the job never waits on our reader
+    while (true) {
+        changed.wait(lock, [&job]() { return !job->output.empty() || finished(*job); });
+        std::string chunk;
+        chunk.swap(job->output);
+        bool done = finished(*job);
+
+        lock.unlock();
+        out << chunk;
+        out.flush();
+        lock.lock();
+
+        if (done || !out) {
+            break;
+        }
+    }
+    if (state) {
+        *state = job->state;
+    }
+    if (!finished(*job)) {
+        return true; // The reader went away; the job stays listed
+    }
+
+    jobs.erase(id);
+    lock.unlock();
+    writeStatus(out, *job);
+    return true;
+}
+
+void JobControl::reportFinished(std::ostream& out) {
+    std::vector<std::shared_ptr<Job>> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = jobs.begin(); it != jobs.end();) {
+            if (finished(*it->second)) {
+                done.push_back(it->second);
+                it = jobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (const auto& job : done) {
+        out << job->output;
+        writeStatus(out, *job);
+    }
+}
+
+int JobControl::latest() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.empty() ? 0 : jobs.rbegin()->first;
+}
+
+bool JobControl::insideJob() {
+    return runningJob;
+}
+
+const char* JobControl::stateName(JobState state) {
+    switch (state) {
+        case JobState::Queued: return "Queued";
+        case JobState::Running: return "Running";
+        case JobState::Done: return "Done";
+        case JobState::Failed: return "Failed";
+        case JobState::Cancelled: return "Cancelled";
+    }
+    return "Unknown";
+}
+
+bool JobControl::finished(const Job& job) {
+    return job.state == JobState::Done || job.state == JobState::Failed ||
+           job.state == JobState::Cancelled;
+}
+
+void JobControl::writeStatus(std::ostream& out, const Job& job) {
+    if (job.dropped > 0) {
+        out << "[" << job.id << "] " << job.dropped << " bytes of output dropped\n";
+    }
+    out << "[" << job.id << "] " << stateName(job.state) << "  " << job.command << "\n";
+}
@@ -0,0 +1,65 @@
+#include "terminal/Pipeline.h"
+#include "terminal/CommandIO.h"
+#include "utils/Cancellation.h"
+#include <memory>
+#include <thread>
+
+bool Pipeline::run(CommandParser& parser, const std::vector<PipelineStage>& stages, std::ostream& output) {
+    if (stages.empty()) {
+        return false;
+    }
+
+    const size_t count = stages.size();
+    std::vector<std::unique_ptr<ByteChannel>> channels;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        channels.push_back(std::make_unique<ByteChannel>());
+    }
+    std::vector<char> succeeded(count, 0);
+    const std::atomic<bool>* cancelled = Utils::Cancellation::current(); // Set for background jobs
+
+    auto runStage = [&](size_t i) {
+        std::unique_ptr<ChannelStreamBuf> inputBuffer;
+        std::unique_ptr<ChannelStreamBuf> outputBuffer;
+        std::unique_ptr<std::istream> input;
+        std::unique_ptr<std::ostream> piped;
+        if (i > 0) {
+            inputBuffer = std::make_unique<ChannelStreamBuf>(*channels[i - 1], false);
+            input = std::make_unique<std::istream>(inputBuffer.get());
+        }
+        if (i + 1 < count) {
+            outputBuffer = std::make_unique<ChannelStreamBuf>(*channels[i], true);
+            piped = std::make_unique<std::ostream>(outputBuffer.get());
+        }
+
+        {
+            Utils::Cancellation::Scope watch(cancelled);
+            CommandIO::Scope scope(input.get(), piped ? piped.get() : &output);
+            succeeded[i] = parser.executeCommand(stages[i].command, stages[i].args);
+        }
+
+        if (piped) {
+            piped->flush();
+            channels[i]->closeWrite();
+        }
+        if (i > 0) {
+            channels[i - 1]->closeRead(); // Unblocks and stops the stage before
+        }
+    };
+
+    // The last stage runs here, so output to the console stays on this thread
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        threads.emplace_back(runStage, i);
+    }
+    runStage(count - 1);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (char result : succeeded) {
+        if (!result) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -2,21 +2,25 @@
 #include "utils/Utils.h"
 #include "passman/PasswordManager.h"
 #include "terminal/CommandImplementation.h"
+#include "terminal/Completer.h"
+#include "terminal/CommandHistory.h"
+#include "terminal/CommandIO.h"
+#include "terminal/Pipeline.h"
+#include "terminal/TerminalBackend.h"
 #include <iostream>
 #include <filesystem>
 #include <algorithm>
-#include <conio.h>
-#include <windows.h>
-
-void setConsoleColor(WORD color) {
-    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-    SetConsoleTextAttribute(hConsole, color);
+Terminal::Terminal() : Terminal(TerminalBackend::console()) {
 }
 
-Terminal::Terminal()
+Terminal::Terminal(TerminalBackend& console)
     : running(false),
+      console(console),
       commandParser(std::make_unique<CommandParser>()),
-      commandImpl(std::make_unique<CommandImplementation>(*this)) {
+      commandImpl(std::make_unique<CommandImplementation>(*this)),
+      completer(std::make_unique<Completer>(*commandParser, aliases)),
+      history(std::make_unique<CommandHistory>()),
+      jobControl(std::make_unique<JobControl>([this](const std::string& line) { return processCommand(line); })) {
     initializeCommands();
 }
 
@@ -25,59 +29,168 @@ Terminal::~Terminal() = default;
 void Terminal::start() {
     running = true;
 
-    setConsoleColor(FOREGROUND_GREEN);
-    std::cout << "--------------------------------------------------------------------\n\n";
-    std::cout << "                  Welcome to SecureShell Terminal!                  \n\n";
-    std::cout << "--------------------------------------------------------------------\n\n";
+    console.setColor(TerminalBackend::Color::Banner);
+    console.write("--------------------------------------------------------------------\n\n");
+    console.write("                  Welcome to SecureShell Terminal!                  \n\n");
+    console.write("--------------------------------------------------------------------\n\n");
+
+    console.setColor(TerminalBackend::Color::Default);
 
-    setConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+    console.write("Type 'help' for a list of available commands.\n\n");
 
-    std::cout << "Type 'help' for a list of available commands.\n\n";
+    // Absolute, so a cd does not move where history goes
+    std::string historyPath = std::filesystem::absolute("data/shell_history").string();
+    if (!history->open(historyPath)) {
+        console.write("Command history will not be saved: cannot open '" + historyPath + "'\n\n");
+    }
+    console.flush();
 
     while (running) {
-        displayPrompt();
+        jobControl->reportFinished(std::cout);
 
         std::string input;
-        char ch;
-        while ((ch = _getch()) != '\r') {
-            if (ch == -32 || ch == 0) {
-                _getch();
-                continue;
+        if (!readLine(input)) {
+            running = false; // Input closed or stop() called
+            break;
+        }
+
+        if (!input.empty()) {
+            if (shouldRemember(input)) {
+                history->add(input);
             }
+            processCommand(input);
+        }
+    }
+}
 
-            if (ch == '\b') {
-                if (!input.empty()) {
-                    input.pop_back();
-                    std::cout << "\b \b";
-                }
-            } else {
-                input += ch;
-
-                bool isCommand = false;
-                for (const auto& cmd : commandParser->getCommandList()) {
-                    if (input == cmd.first.substr(0, input.length())) {
-                        isCommand = true;
-                        break;
-                    }
-                }
+bool Terminal::readLine(std::string& input) {
+    // How often an idle editor looks at whether stop() was called
+    const int pollMs = 100;
 
-                if (isCommand) {
-                    setConsoleColor(FOREGROUND_BLUE | FOREGROUND_GREEN);
-                } else {
-                    setConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
-                }
+    TerminalBackend::RawMode rawMode(console);
+    displayPrompt();
 
-                std::cout << ch;
-            }
+    // Follows the line through the command trie, so each key costs one step
+    CommandTrie::Cursor highlight = commandParser->getCommandTrie().cursor();
+    bool highlighted = false;
+
+    auto typeChar = [&](char c) {
+        input += c;
+        highlight.push(c);
+
+        // Only switch color when the state flips
+        if (highlight.isPrefix() != highlighted) {
+            highlighted = highlight.isPrefix();
+            console.setColor(highlighted ? TerminalBackend::Color::Command : TerminalBackend::Color::Default);
+        }
+
+        console.write(c);
+    };
+    auto eraseChar = [&]() {
+        input.pop_back();
+        highlight.pop();
+        console.write("\b \b");
+    };
+    auto replaceInput = [&](std::string_view text) {
+        while (!input.empty()) {
+            eraseChar();
+        }
+        for (char c : text) {
+            typeChar(c);
+        }
+    };
+    // For when the row was overwritten: prints the prompt again and retypes text
+    auto redraw = [&](const std::string& text) {
+        displayPrompt();
+        input.clear();
+        highlight.reset();
+        highlighted = false;
+        for (char c : text) {
+            typeChar(c);
         }
+    };
 
-        setConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
-        std::cout << std::endl;
+    // Up and down step through history; what was being typed is kept as the draft
+    size_t historyAge = 0; // 0 while editing the draft, n for the nth newest command
+    std::string draft;
 
-        if (!input.empty()) {
-            processCommand(input);
+    while (true) {
+        // Everything drawn for the keys read so far goes out as one write
+        if (!console.hasPendingInput()) {
+            console.flush();
+        }
+        int key = console.readKey(pollMs);
+        if (key == TerminalBackend::None) {
+            if (!running) {
+                return false;
+            }
+            continue;
+        }
+        if (key == TerminalBackend::EndOfInput || (key == 4 && input.empty())) { // Ctrl-D
+            console.setColor(TerminalBackend::Color::Default);
+            console.write('\n');
+            return false;
+        }
+        if (key == TerminalBackend::Enter) {
+            break;
         }
+
+        std::string_view recalled;
+        if (key == TerminalBackend::Up && history->entry(historyAge, recalled)) {
+            if (historyAge == 0) {
+                draft = input;
+            }
+            ++historyAge;
+            replaceInput(recalled);
+        } else if (key == TerminalBackend::Down && historyAge > 0) {
+            --historyAge;
+            if (historyAge == 0) {
+                replaceInput(draft);
+            } else if (history->entry(historyAge - 1, recalled)) {
+                replaceInput(recalled);
+            }
+        } else if (key == 18) { // Ctrl-R
+            std::string line = input;
+            console.setColor(TerminalBackend::Color::Default);
+            bool run = reverseSearch(line);
+            redraw(line);
+            if (run) {
+                break;
+            }
+        } else if (key == TerminalBackend::Backspace) {
+            if (!input.empty()) {
+                eraseChar();
+            }
+        } else if (key == TerminalBackend::Tab) {
+            Completion completion = completer->complete(input);
+            if (completion.line != input) {
+                // Keep what still matches and retype the rest
+                size_t keep = 0;
+                while (keep < input.size() && keep < completion.line.size() &&
+                       input[keep] == completion.line[keep]) {
+                    ++keep;
+                }
+                while (input.size() > keep) {
+                    eraseChar();
+                }
+                for (size_t i = keep; i < completion.line.size(); ++i) {
+                    typeChar(completion.line[i]);
+                }
+            } else if (completion.candidates.size() > 1) {
+                console.setColor(TerminalBackend::Color::Default);
+                console.write('\n');
+                listCandidates(completion.candidates);
+                redraw(input);
+            }
+        } else if (key >= 32 && key <= 255) {
+            typeChar(static_cast<char>(key));
+        }
+        // Other control characters and the cursor keys are ignored
     }
+
+    console.setColor(TerminalBackend::Color::Default);
+    console.write('\n');
+    return true; // Leaving raw mode flushes the newline before the command prints
 }
 
 void Terminal::stop() {
@@ -88,59 +201,322 @@ bool Terminal::isRunning() const {
     return running;
 }
 
-void Terminal::processCommand(const std::string& input) {
-    auto tokens = commandParser->parseInput(input);
-    if (tokens.empty()) return;
+bool Terminal::runLine(const std::string& line) {
+    running = true;
+    return processCommand(line);
+}
+
+bool Terminal::runScript(std::istream& script, const std::string& name) {
+    const int maxDepth = 16;
+    if (scriptDepth >= maxDepth) {
+        std::cerr << name << ": scripts nested too deeply\n";
+        return false;
+    }
+    if (scriptDepth == 0) {
+        running = true;
+    }
+    ++scriptDepth;
+
+    bool succeeded = true;
+    std::string line;
+    size_t lineNumber = 0;
+    while (running && std::getline(script, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back(); // Scripts saved with Windows line endings
+        }
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+
+        if (!processCommand(line.substr(start))) {
+            succeeded = false;
+            if (exitOnError) {
+                std::cerr << name << ":" << lineNumber << ": stopping after failed command\n";
+                break;
+            }
+        }
+    }
+
+    --scriptDepth;
+    return succeeded;
+}
+
+bool Terminal::processCommand(const std::string& input) {
+    std::string line = input;
+    if (commandParser->stripBackground(line)) {
+        return startJob(line);
+    }
+
+    auto segments = commandParser->splitPipeline(input);
+    if (segments.size() > 1) {
+        return runPipeline(segments);
+    }
 
-    std::string command = tokens[0];
-    std::vector<std::string> args(tokens.begin() + 1, tokens.end());
+    CommandLine tokens;
+    commandParser->tokenize(input, tokens);
+    if (tokens.empty()) return true;
+
+    std::string command(tokens[0]);
+    std::vector<std::string> args = tokens.strings(1);
 
     auto aliasIt = aliases.find(command);
     if (aliasIt != aliases.end()) {
         command = aliasIt->second;
     }
 
-    executeCommand(command, args);
+    return executeCommand(command, args);
+}
+
+bool Terminal::runPipeline(const std::vector<std::string>& segments) {
+    std::vector<PipelineStage> stages;
+    if (!resolveStages(segments, stages)) {
+        return false;
+    }
+    // Stages run at once, so two of these would share the shell's state unguarded
+    auto stateful = std::count_if(stages.begin(), stages.end(),
+                                  [](const PipelineStage& stage) { return changesShellState(stage.command); });
+    if (stateful > 1) {
+        std::cout << "Only one of cd, passman and source may appear in a pipeline\n";
+        return false;
+    }
+    return Pipeline::run(*commandParser, stages, CommandIO::out());
+}
+
+bool Terminal::resolveStages(const std::vector<std::string>& segments, std::vector<PipelineStage>& stages) const {
+    for (const auto& segment : segments) {
+        CommandLine tokens;
+        commandParser->tokenize(segment, tokens);
+        if (tokens.empty()) {
+            std::cout << (segments.size() > 1 ? "Syntax error: empty command in pipeline\n"
+                                              : "Syntax error: nothing to run\n");
+            return false;
+        }
+
+        PipelineStage stage;
+        stage.command = std::string(tokens[0]);
+        stage.args = tokens.strings(1);
+        auto aliasIt = aliases.find(stage.command);
+        if (aliasIt != aliases.end()) {
+            stage.command = aliasIt->second;
+        }
+
+        // Checked up front so no stage starts when another cannot
+        if (!commandParser->isValidCommand(stage.command)) {
+            std::cout << "Unknown command: " << stage.command << "\n";
+            std::cout << "Type 'help' for a list of available commands.\n";
+            return false;
+        }
+        stages.push_back(std::move(stage));
+    }
+    return true;
+}
+
+bool Terminal::startJob(const std::string& line) {
+    // Validated here so a typo is reported now rather than when the job is reaped
+    std::vector<PipelineStage> stages;
+    if (!resolveStages(commandParser->splitPipeline(line), stages)) {
+        return false;
+    }
+    for (const auto& stage : stages) {
+        if (changesShellState(stage.command)) {
+            std::cout << stage.command << " cannot run in the background\n";
+            return false;
+        }
+    }
+
+    size_t start = line.find_first_not_of(" \t");
+    size_t end = line.find_last_not_of(" \t");
+    std::string command = line.substr(start, end - start + 1);
+    int id = jobControl->start(command);
+    std::cout << "[" << id << "] " << command << "\n";
+    return true;
+}
+
+bool Terminal::changesShellState(const std::string& command) {
+    return command == "cd" || command == "passman" || command == "alias" || command == "source";
 }
 
 void Terminal::initializeCommands() {
-    commandParser->registerCommand("help", [this](const auto& args) { commandImpl->help(); });
-    commandParser->registerCommand("exit", [this](const auto& args) { commandImpl->exit(); });
-    commandParser->registerCommand("cd", [this](const auto& args) { commandImpl->cd(args); });
-    commandParser->registerCommand("ls", [this](const auto& args) { commandImpl->ls(args); });
-    commandParser->registerCommand("run", [this](const auto& args) { commandImpl->compile(args); });
-    commandParser->registerCommand("passman", [this](const auto& args) { commandImpl->passman(args); });
-    commandParser->registerCommand("copy", [this](const auto& args) { commandImpl->copy(args); });
-    commandParser->registerCommand("move", [this](const auto& args) { commandImpl->move(args); });
-    commandParser->registerCommand("rename", [this](const auto& args) { commandImpl->rename(args); });
-    commandParser->registerCommand("dcreate", [this](const auto& args) { commandImpl->create_directory(args); });
-    commandParser->registerCommand("fcreate", [this](const auto& args) { commandImpl->create_file(args); });
-    commandParser->registerCommand("remove", [this](const auto& args) { commandImpl->remove(args); });
-    commandParser->registerCommand("perm", [this](const auto& args) { commandImpl->display_permission(args); });
-    commandParser->registerCommand("curr", [this](const auto& args) { commandImpl->get_current_directory(args); });
-    commandParser->registerCommand("encrypt", [this](const auto& args) { commandImpl->encrypt(args); });
-    commandParser->registerCommand("decrypt", [this](const auto& args) { commandImpl->decrypt(args); });
-	commandParser->registerCommand("cat", [this](const auto& args) { commandImpl->cat(args); });
-    commandParser->registerCommand("write", [this](const auto& args){ commandImpl->write(args); });
-    commandParser->registerCommand("grep", [this](const auto& args) { commandImpl->grep(args); });
-    commandParser->registerCommand("head", [this](const auto& args) { commandImpl->head(args); });
-    commandParser->registerCommand("tree", [this](const auto& args) { commandImpl->tree(args); });
-    commandParser->registerCommand("find", [this](const auto& args) { commandImpl->find(args); });
-    commandParser->registerCommand("sysinfo", [this](const auto& args) { commandImpl->system_info(args); });
-    commandParser->registerCommand("stat", [this](const auto& args){ commandImpl->stat(args);});
+    commandParser->registerCommand("help", [this](const auto&) { return commandImpl->help(); });
+    commandParser->registerCommand("exit", [this](const auto&) { return commandImpl->exit(); });
+    commandParser->registerCommand("cd", [this](const auto& args) { return commandImpl->cd(args); });
+    commandParser->registerCommand("ls", [this](const auto& args) { return commandImpl->ls(args); });
+    commandParser->registerCommand("run", [this](const auto& args) { return commandImpl->compile(args); });
+    commandParser->registerCommand("passman", [this](const auto& args) { return commandImpl->passman(args); });
+    commandParser->registerCommand("copy", [this](const auto& args) { return commandImpl->copy(args); });
+    commandParser->registerCommand("move", [this](const auto& args) { return commandImpl->move(args); });
+    commandParser->registerCommand("rename", [this](const auto& args) { return commandImpl->rename(args); });
+    commandParser->registerCommand("dcreate", [this](const auto& args) { return commandImpl->create_directory(args); });
+    commandParser->registerCommand("fcreate", [this](const auto& args) { return commandImpl->create_file(args); });
+    commandParser->registerCommand("remove", [this](const auto& args) { return commandImpl->remove(args); });
+    commandParser->registerCommand("perm", [this](const auto& args) { return commandImpl->display_permission(args); });
+    commandParser->registerCommand("curr", [this](const auto& args) { return commandImpl->get_current_directory(args); });
+    commandParser->registerCommand("encrypt", [this](const auto& args) { return commandImpl->encrypt(args); });
+    commandParser->registerCommand("decrypt", [this](const auto& args) { return commandImpl->decrypt(args); });
+	commandParser->registerCommand("cat", [this](const auto& args) { return commandImpl->cat(args); });
+    commandParser->registerCommand("write", [this](const auto& args){ return commandImpl->write(args); });
+    commandParser->registerCommand("grep", [this](const auto& args) { return commandImpl->grep(args); });
+    commandParser->registerCommand("head", [this](const auto& args) { return commandImpl->head(args); });
+    commandParser->registerCommand("tree", [this](const auto& args) { return commandImpl->tree(args); });
+    commandParser->registerCommand("find", [this](const auto& args) { return commandImpl->find(args); });
+    commandParser->registerCommand("sysinfo", [this](const auto& args) { return commandImpl->system_info(args); });
+    commandParser->registerCommand("stat", [this](const auto& args){ return commandImpl->stat(args); });
+    commandParser->registerCommand("source", [this](const auto& args) { return commandImpl->source(args); });
+    commandParser->registerCommand("jobs", [this](const auto& args) { return commandImpl->jobs(args); });
+    commandParser->registerCommand("wait", [this](const auto& args) { return commandImpl->wait(args); });
+    commandParser->registerCommand("fg", [this](const auto& args) { return commandImpl->fg(args); });
+    commandParser->registerCommand("kill", [this](const auto& args) { return commandImpl->kill(args); });
 }
 
 void Terminal::displayPrompt() const {
-    setConsoleColor(FOREGROUND_GREEN | FOREGROUND_RED);
-    std::cout << std::filesystem::current_path().string();
-    std::cout << "> ";
-    setConsoleColor(FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+    console.setColor(TerminalBackend::Color::Prompt);
+    console.write(std::filesystem::current_path().string());
+    console.write("> ");
+    console.setColor(TerminalBackend::Color::Default);
+}
+
+void Terminal::listCandidates(const std::vector<std::string>& candidates) const {
+    const size_t screenWidth = 80;
+    const size_t pageRows = 20;
+
+    size_t widest = 0;
+    for (const auto& candidate : candidates) {
+        widest = std::max(widest, candidate.size());
+    }
+    size_t columnWidth = std::min(widest + 2, screenWidth);
+    size_t columns = std::max<size_t>(1, screenWidth / columnWidth);
+    size_t pageSize = columns * pageRows;
+
+    for (size_t shown = 0; shown < candidates.size();) {
+        size_t pageEnd = std::min(candidates.size(), shown + pageSize);
+        for (size_t i = shown; i < pageEnd; ++i) {
+            bool endOfRow = (i - shown + 1) % columns == 0 || i + 1 == pageEnd;
+            console.write(candidates[i]);
+            if (endOfRow) {
+                console.write('\n');
+            } else {
+                console.write(std::string(columnWidth - candidates[i].size(), ' '));
+            }
+        }
+        shown = pageEnd;
 
+        if (shown < candidates.size()) {
+            console.write("--More-- (" + std::to_string(shown) + "/" + std::to_string(candidates.size()) +
+                          ", q to stop)");
+            console.flush();
+            int key = console.readKey();
+            console.write("\r" + std::string(40, ' ') + "\r");
+            if (key == 'q' || key == 'Q' || key == TerminalBackend::Escape || key == TerminalBackend::EndOfInput) {
+                break;
+            }
+        }
+    }
+}
+
+bool Terminal::reverseSearch(std::string& line) {
+    std::string query;
+    size_t skip = 0; // Ctrl-R presses since the query last changed
+    std::string_view match;
+    bool found = false;
+
+    // The status replaces the prompt row; shorter text is padded over the longer
+    size_t drawn = std::filesystem::current_path().string().size() + 2 + line.size();
+    auto draw = [&]() {
+        std::string status = std::string(found || query.empty() ? "" : "failing ") +
+                             "(reverse-i-search)'" + query + "': " + std::string(found ? match : std::string_view());
+        console.write('\r');
+        console.write(status);
+        if (drawn > status.size()) {
+            console.write(std::string(drawn - status.size(), ' '));
+            console.write('\r');
+            console.write(status);
+        }
+        drawn = status.size();
+    };
+    auto clearRow = [&]() {
+        console.write('\r' + std::string(drawn, ' ') + '\r');
+    };
+
+    while (true) {
+        draw();
+        if (!console.hasPendingInput()) {
+            console.flush();
+        }
+        int key = console.readKey();
+        if (key == TerminalBackend::Enter) {
+            clearRow();
+            if (found) {
+                line = std::string(match);
+            }
+            return found;
+        }
+        if (key == TerminalBackend::Escape || key == 7 || key == TerminalBackend::EndOfInput) { // Esc or Ctrl-G gives the line back as it was
+            clearRow();
+            return false;
+        }
+
+        if (key == 18) {
+            if (found) {
+                ++skip;
+            }
+        } else if (key == TerminalBackend::Backspace) {
+            if (!query.empty()) {
+                query.pop_back();
+            }
+            skip = 0;
+        } else if (key >= 32 && key <= 255) {
+            query += static_cast<char>(key);
+            skip = 0;
+        } else {
+            // Arrows and other keys keep the match for editing
+            clearRow();
+            if (found) {
+                line = std::string(match);
+            }
+            return false;
+        }
+
+        found = history->search(query, skip, match);
+        if (!found && key == 18 && skip > 0) {
+            --skip; // No older match; stay on the oldest one
+            found = history->search(query, skip, match);
+        }
+    }
+}
+
+bool Terminal::shouldRemember(const std::string& line) const {
+    // A leading space keeps a line out of history
+    if (line.empty() || line[0] == ' ') {
+        return false;
+    }
+
+    // encrypt/decrypt lines carry passwords, and passman lines can carry secrets
+    // for any of its subcommands, so none of them is written to the history file
+    for (const auto& segment : commandParser->splitPipeline(line)) {
+        CommandLine tokens;
+        commandParser->tokenize(segment, tokens);
+        if (tokens.empty()) {
+            continue;
+        }
+        std::string command(tokens[0]);
+        auto aliasIt = aliases.find(command);
+        if (aliasIt != aliases.end()) {
+            command = aliasIt->second;
+        }
+        if (command == "encrypt" || command == "decrypt" || command == "passman") {
+            return false;
+        }
+    }
+    return true;
 }
 
-void Terminal::executeCommand(const std::string& command, const std::vector<std::string>& args) {
-    if (!commandParser->executeCommand(command, args)) {
+bool Terminal::executeCommand(const std::string& command, const std::vector<std::string>& args) {
+    if (!commandParser->isValidCommand(command)) {
         std::cout << "Unknown command: " << command << "\n";
         std::cout << "Type 'help' for a list of available commands.\n";
+        return false;
     }
+    return commandParser->executeCommand(command, args);
 }
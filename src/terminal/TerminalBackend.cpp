@@ -0,0 +1,284 @@
+#include "terminal/TerminalBackend.h"
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+#include <conio.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+TerminalBackend::RawMode::RawMode(TerminalBackend& backend)
+    : backend(backend), entered(backend.enterRawMode()) {
+}
+
+TerminalBackend::RawMode::~RawMode() {
+    backend.flush();
+    if (entered) {
+        backend.leaveRawMode();
+    }
+}
+
+void TerminalBackend::setColor(Color color) {
+    switch (color) {
+        case Color::Default: write("\x1b[0m"); break;
+        case Color::Banner: write("\x1b[32m"); break;
+        case Color::Prompt: write("\x1b[33m"); break;
+        case Color::Command: write("\x1b[36m"); break;
+    }
+}
+
+void TerminalBackend::flush() {
+    if (frame.empty()) {
+        return;
+    }
+    // Output commands wrote through the standard streams goes first
+    std::cout.flush();
+    std::fflush(stdout);
+    emit(frame);
+    frame.clear();
+    ++writes;
+}
+
+#ifdef _WIN32
+
+namespace {
+
+/**
+ * @brief Console keys through _getch; colors by ANSI sequence where the console supports them
+ */
+class WindowsTerminalBackend : public TerminalBackend {
+public:
+    WindowsTerminalBackend() : output(GetStdHandle(STD_OUTPUT_HANDLE)) {
+        DWORD mode = 0;
+        virtualTerminal = GetConsoleMode(output, &mode) &&
+                          SetConsoleMode(output, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+
+    int readKey(int timeoutMs) override {
+        if (timeoutMs >= 0) {
+            ULONGLONG deadline = GetTickCount64() + static_cast<ULONGLONG>(timeoutMs);
+            while (!_kbhit()) {
+                if (GetTickCount64() >= deadline) {
+                    return None;
+                }
+                Sleep(10);
+            }
+        }
+
+        int ch = _getch();
+        if (ch != 0 && ch != 0xE0) {
+            return ch;
+        }
+        switch (_getch()) { // Second byte of an extended key
+            case 72: return Up;
+            case 80: return Down;
+            case 75: return Left;
+            case 77: return Right;
+            case 71: return Home;
+            case 79: return End;
+            case 83: return Delete;
+            default: return None;
+        }
+    }
+
+    bool hasPendingInput() const override {
+        return _kbhit() != 0;
+    }
+
+    void setColor(Color color) override {
+        if (virtualTerminal) {
+            TerminalBackend::setColor(color);
+            return;
+        }
+        // Older consoles color by attribute, so the frame so far is drawn first
+        flush();
+        WORD attribute = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE;
+        switch (color) {
+            case Color::Default: break;
+            case Color::Banner: attribute = FOREGROUND_GREEN; break;
+            case Color::Prompt: attribute = FOREGROUND_GREEN | FOREGROUND_RED; break;
+            case Color::Command: attribute = FOREGROUND_BLUE | FOREGROUND_GREEN; break;
+        }
+        SetConsoleTextAttribute(output, attribute);
+    }
+
+protected:
+    bool enterRawMode() override { return false; } // _getch already reads keys unechoed
+    void leaveRawMode() override {}
+
+    void emit(std::string_view bytes) override {
+        DWORD written = 0;
+        WriteFile(output, bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr);
+    }
+
+private:
+    HANDLE output;
+    bool virtualTerminal;
+};
+
+} // namespace
+
+TerminalBackend& TerminalBackend::console() {
+    static WindowsTerminalBackend backend;
+    return backend;
+}
+
+#else
+
+namespace {
+
+// How long the rest of an escape sequence may take to arrive after the Escape
+constexpr int kSequenceTimeoutMs = 25;
+
+} // namespace
+
+TerminalBackend& TerminalBackend::console() {
+    static PosixTerminalBackend backend(STDIN_FILENO, STDOUT_FILENO);
+    return backend;
+}
+
+PosixTerminalBackend::PosixTerminalBackend(int inputFd, int outputFd)
+    : inputFd(inputFd), outputFd(outputFd), savedMode() {
+}
+
+PosixTerminalBackend::~PosixTerminalBackend() {
+    if (raw) {
+        leaveRawMode();
+    }
+}
+
+bool PosixTerminalBackend::enterRawMode() {
+    if (raw || !isatty(inputFd) || tcgetattr(inputFd, &savedMode) != 0) {
+        return false;
+    }
+
+    // Output processing and signals stay on, so '\n' and Ctrl-C behave as usual
+    termios mode = savedMode;
+    mode.c_iflag &= ~(IXON | ICRNL | INLCR);
+    mode.c_lflag &= ~(ICANON | ECHO | IEXTEN);
+    mode.c_cc[VMIN] = 1;
+    mode.c_cc[VTIME] = 0;
+    raw = tcsetattr(inputFd, TCSANOW, &mode) == 0;
+    return raw;
+}
+
+void PosixTerminalBackend::leaveRawMode() {
+    tcsetattr(inputFd, TCSANOW, &savedMode);
+    raw = false;
+}
+
+void PosixTerminalBackend::emit(std::string_view bytes) {
+    while (!bytes.empty()) {
+        ssize_t written = ::write(outputFd, bytes.data(), bytes.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        bytes.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+bool PosixTerminalBackend::fill(int timeoutMs) {
+    if (closed) {
+        return false;
+    }
+    if (start == end) {
+        start = end = 0;
+    }
+    if (end == sizeof(input)) {
+        return false;
+    }
+
+    pollfd request = {inputFd, POLLIN, 0};
+    int ready;
+    do {
+        ready = poll(&request, 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+    if (ready == 0) {
+        return false;
+    }
+
+    ssize_t count;
+    do {
+        count = ::read(inputFd, input + end, sizeof(input) - end);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        closed = true;
+        return false;
+    }
+    end += static_cast<size_t>(count);
+    return true;
+}
+
+int PosixTerminalBackend::readKey(int timeoutMs) {
+    if (start == end && !fill(timeoutMs)) {
+        return closed ? EndOfInput : None;
+    }
+
+    unsigned char c = static_cast<unsigned char>(input[start++]);
+    switch (c) {
+        case 27: return decodeEscape();
+        case '\r':
+        case '\n': return Enter;
+        case 127:
+        case '\b': return Backspace;
+        default: return c;
+    }
+}
+
+int PosixTerminalBackend::decodeEscape() {
+    // A lone Escape, unless a sequence follows straight away
+    if (start == end && !fill(kSequenceTimeoutMs)) {
+        return Escape;
+    }
+    char introducer = input[start];
+    if (introducer != '[' && introducer != 'O') {
+        return Escape; // The next key is read on its own
+    }
+    ++start;
+
+    // Parameters, then a final byte in '@'..'~', as in ESC [ A or ESC [ 3 ~ or ESC [ 1 ; 5 A
+    int number = 0;
+    bool firstParameter = true;
+    char final = 0;
+    while (final == 0) {
+        if (start == end && !fill(kSequenceTimeoutMs)) {
+            return None;
+        }
+        char c = input[start++];
+        if (c >= '@' && c <= '~') {
+            final = c;
+        } else if (c >= '0' && c <= '9' && firstParameter) {
+            number = number * 10 + (c - '0');
+        } else if (c == ';') {
+            firstParameter = false;
+        }
+    }
+
+    switch (final) {
+        case 'A': return Up;
+        case 'B': return Down;
+        case 'C': return Right;
+        case 'D': return Left;
+        case 'H': return Home;
+        case 'F': return End;
+        case '~':
+            switch (number) {
+                case 1:
+                case 7: return Home;
+                case 4:
+                case 8: return End;
+                case 3: return Delete;
+            }
+            return None;
+        default: return None;
+    }
+}
+
+#endif
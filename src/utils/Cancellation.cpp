@@ -0,0 +1,33 @@
+#include "utils/Cancellation.h"
+
+namespace Utils {
+
+namespace {
+
+thread_local const std::atomic<bool>* currentFlag = nullptr;
+
+} // namespace
+
+Cancellation::Scope::Scope(const std::atomic<bool>* flag) : previous(currentFlag) {
+    currentFlag = flag;
+}
+
+Cancellation::Scope::~Scope() {
+    currentFlag = previous;
+}
+
+const std::atomic<bool>* Cancellation::current() {
+    return currentFlag;
+}
+
+bool Cancellation::requested() {
+    return currentFlag && currentFlag->load(std::memory_order_relaxed);
+}
+
+void Cancellation::checkpoint() {
+    if (requested()) {
+        throw OperationCancelled();
+    }
+}
+
+} // namespace Utils
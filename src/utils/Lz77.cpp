@@ -0,0 +1,150 @@
+#include "utils/Lz77.h"
+#include <cstring>
+
+namespace Utils {
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxOffset = 65535;
+constexpr size_t kHashBits = 14;
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hashOf(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+void writeLength(std::vector<uint8_t>& output, size_t length) {
+    while (length >= 255) {
+        output.push_back(255);
+        length -= 255;
+    }
+    output.push_back(static_cast<uint8_t>(length));
+}
+
+void writeSequence(std::vector<uint8_t>& output, const uint8_t* literals, size_t literalCount,
+                   size_t offset, size_t matchLength) {
+    size_t token = (literalCount >= 15 ? 15 : literalCount) << 4;
+    if (matchLength > 0) {
+        size_t extra = matchLength - kMinMatch;
+        token |= extra >= 15 ? 15 : extra;
+    }
+    output.push_back(static_cast<uint8_t>(token));
+    if (literalCount >= 15) {
+        writeLength(output, literalCount - 15);
+    }
+    output.insert(output.end(), literals, literals + literalCount);
+
+    if (matchLength > 0) {
+        output.push_back(static_cast<uint8_t>(offset & 0xff));
+        output.push_back(static_cast<uint8_t>(offset >> 8));
+        if (matchLength - kMinMatch >= 15) {
+            writeLength(output, matchLength - kMinMatch - 15);
+        }
+    }
+}
+
+bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (ip == end) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // namespace
+
+void Lz77::compress(const uint8_t* input, size_t size, std::vector<uint8_t>& output) {
+    output.clear();
+    output.reserve(size + size / 255 + 16);
+
+    std::vector<uint32_t> table(size_t(1) << kHashBits, 0); // Position + 1, 0 when empty
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (size >= kMinMatch && pos + kMinMatch <= size) {
+        uint32_t sequence = read32(input + pos);
+        uint32_t& slot = table[hashOf(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos + 1);
+
+        if (candidate == 0 || pos - (candidate - 1) > kMaxOffset || read32(input + candidate - 1) != sequence) {
+            ++pos;
+            continue;
+        }
+
+        size_t match = candidate - 1;
+        size_t length = kMinMatch;
+        while (pos + length < size && input[match + length] == input[pos + length]) {
+            ++length;
+        }
+        writeSequence(output, input + anchor, pos - anchor, pos - match, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    writeSequence(output, input + anchor, size - anchor, 0, 0);
+}
+
+bool Lz77::decompress(const uint8_t* input, size_t size, size_t originalSize, std::vector<uint8_t>& output) {
+    output.resize(originalSize);
+    uint8_t* op = output.data();
+    uint8_t* const outEnd = op + originalSize;
+    const uint8_t* ip = input;
+    const uint8_t* end = input + size;
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(ip, end, literalCount)) {
+            return false;
+        }
+        if (static_cast<size_t>(end - ip) < literalCount || static_cast<size_t>(outEnd - op) < literalCount) {
+            return false;
+        }
+        std::memcpy(op, ip, literalCount);
+        op += literalCount;
+        ip += literalCount;
+
+        if (ip == end) {
+            break; // The final, literals-only sequence
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(ip, end, length)) {
+            return false;
+        }
+        length += kMinMatch;
+        if (offset == 0 || offset > static_cast<size_t>(op - output.data()) ||
+            static_cast<size_t>(outEnd - op) < length) {
+            return false;
+        }
+
+        const uint8_t* from = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, from, length);
+            op += length;
+        } else {
+            // Overlapping match: it repeats bytes it is still producing
+            for (size_t i = 0; i < length; ++i) {
+                *op++ = from[i];
+            }
+        }
+    }
+    return op == outEnd;
+}
+
+} // namespace Utils
@@ -0,0 +1,304 @@
+#include "utils/PasswordStrength.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Utils {
+
+namespace {
+
+constexpr std::array<uint8_t, 256> makeClassTable() {
+    std::array<uint8_t, 256> table{};
+    for (int c = 0; c < 256; ++c) {
+        if (c >= 'a' && c <= 'z') {
+            table[c] = PasswordStrength::Lower;
+        } else if (c >= 'A' && c <= 'Z') {
+            table[c] = PasswordStrength::Upper;
+        } else if (c >= '0' && c <= '9') {
+            table[c] = PasswordStrength::Digit;
+        } else if (c >= 0x21 && c <= 0x7e) {
+            table[c] = PasswordStrength::Symbol;
+        } else {
+            table[c] = PasswordStrength::Other;
+        }
+    }
+    return table;
+}
+
+// Up to two letters a character may stand in for, as in p@$$w0rd
+constexpr std::array<std::array<char, 2>, 256> makeLeetTable() {
+    std::array<std::array<char, 2>, 256> table{};
+    table['4'] = {'a', 0};
+    table['@'] = {'a', 0};
+    table['8'] = {'b', 0};
+    table['('] = {'c', 0};
+    table['3'] = {'e', 0};
+    table['6'] = {'g', 0};
+    table['9'] = {'g', 0};
+    table['1'] = {'i', 'l'};
+    table['!'] = {'i', 0};
+    table['|'] = {'l', 0};
+    table['0'] = {'o', 0};
+    table['$'] = {'s', 0};
+    table['5'] = {'s', 0};
+    table['7'] = {'t', 0};
+    table['+'] = {'t', 0};
+    table['2'] = {'z', 0};
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> kClassTable = makeClassTable();
+constexpr std::array<std::array<char, 2>, 256> kLeetTable = makeLeetTable();
+
+// Common passwords, words and keyboard walks in three tiers of popularity.
+// Each tier is sorted and front-coded: an uppercase letter gives how many
+// leading characters the word shares with the previous one ('A' for none)
+// and the lowercase letters and digits after it are the rest of the word.
+const char* const kTiers[] = {
+    "A000000A111111B21212C3123D321D4E5F6G7H8I9J0Bqaz2wsxA654321B66666B96969A7777777Aabc123BdminAbaseb"
+    "allAdragonAfootballAiloveyouAletmeinBoginAmasterBichaelBonkeyBustangApassw0rdFordBrincessAqazwsx"
+    "BwertyGuiopAshadowBoloBtarwarsBunshineCpermanAtrustno1Awelcome",
+    "A102030B12233B23qweB31313B47258G369B59357D753Bq2w3eG4rI5tCazxsw2A2wsx3edcA456789A741852963B89456"
+    "G123A987654321Aa1b2c3BaaaaaBbc1234DdefGgBccessBdmin123BndrewCgelFsBppleBrsenalBsdfEgFhGjklChleyB"
+    "ustinBzertyAbabyEgirlCileyCnanaCrcelonaCtmanG123BitcoinBusterCtterflyAchangemeDrlieCeeseDlseaCoc"
+    "olateBomputerCokieAdallasCnielBefaultBiamondBonaldBragon123AfamilyBlowerBoreverBreedomCiendsAgam"
+    "erBingerBoldenCogleBuestAhammerCnnahCrleyBeavenClloBockeyCttieBunterAiloveyou1BnternetAjasmineBe"
+    "nniferCssicaBordanCshuaAkillerBnightAlegendCtmein123BiverpoolBkjhgfdsaBoveElyEmeBuckyAmaggieDicC"
+    "ster123CtrixDthewCverickBerlinBichelleDkeyCnnieBnbvcxzBoneyDkey123AnicoleCnjaAorangeApassE123Ewo"
+    "rd1J23BepperBhoenixBlayerBoiuytrewqCkemonBurpleAq1w2e3Gr4BazxswedcBwe123DasdGzxcDrEtFy1H23Arange"
+    "rBobertCotAsamsungBecretBilverBoccerBpiderGmanBummerCndayAtestE123BhomasCunderBigerDgerBoorAvict"
+    "oryAwarriorBelcome1BhateverBinnerCzardAyankeesAzaq12wsxEzaq1BxcvEbFnGm",
+    "AableCoutDveBfterBgainFstBirBlbumCphaBmazingCericaBnimalCswerBprilBreaCmyCtBugustCtumnBwayAbearD"
+    "utyCforeClieveCstCtterBigCrdBlackCueBoardCdyCokCstonBrotherDwnBubbleCddyCsinessCtterAcakeCliforn"
+    "iaCmeraCnadaCptainCrbonCstleBhanceEgeCerryCickenDnaCristmasCurchBityBlassCeanCimbCoudBoffeeClleg"
+    "eDorColCrnerCuntryBrazyCeamCystalAdanceCrkCvidBecemberCltaCmonCsertDignCvilBinnerBoctorCgClphinB"
+    "reamFsCiverAeagleCrthCsterBightBlectricDphantBmeraldCpireBnergyCglandCterBscapeBuropeBveningAfan"
+    "tasyCrmerBebruaryBireCshCveBloridaCyingBorestDtuneCurBranceCidayDendCogCuitBunnyAgalaxyCrdenBeor"
+    "geCrmanyBhostBiantCrlBloryBoldCodBraceCeenBuitarAhappyCrmonyBeartCllo123BistoryBolidayCmeCneyCrs"
+    "eCuseBunter1AiceBndiaBslandAjackCmesCnuaryBesusBohnBulyCneDiorCsticeAkingCttenAladyCkeCserBemonC"
+    "tterBifeCghtConCttleBondonDgCverBuckAmarchDineDkDsDyCximumCyBemoryCtalBidnightCllerCrrorBondayDs"
+    "terConCrningCtherCuntainBusicAnatureBewyorkBightBothingCvemberBumberAoceanCtoberBfficeBliverBpen"
+    "Brange1AparisDtyBeaceDnutCopleCpsiBirateBlanetCeaseBocketCliceCwerBrettyCinceAqueenArabbitCinEbo"
+    "wBedBiverBobotCckEetCseBunningAsailorCmCndraCturdayBchoolCienceCooterBeasonCptemberCrviceCvenBha"
+    "rkBilenceCmpleCsterBkyBmileBnakeCowBoccer1CldierBpaceCringBtarEsCeelCormCrongCudentBuccessCgarCm"
+    "mer1CnCperBweetBystemAtaylorBeacherCnnisBhunder1DrsdayBimeBodayCmatoBuesdayCrtleBwitterAunitedDv"
+    "erseBserAvalleyBictorCdeoColetCrginAwalkerCterBednesdayBhiteBilliamCndowDterBolfCmanCnderCrldAye"
+    "llowBoungAzebra",
+};
+
+/**
+ * @brief Compact trie over the dictionary, built on first use
+ *
+ * Children of a node are a contiguous, sorted run of edges, so a lookup
+ * touches one small array per character.
+ */
+class DictionaryTrie {
+public:
+    struct Edge {
+        char label;
+        uint32_t child;
+    };
+
+    struct Node {
+        uint32_t firstEdge = 0;
+        uint32_t edgeCount = 0;
+        float bits = -1.0f; // Cost of the word ending here, negative if none
+    };
+
+    static const DictionaryTrie& shared() {
+        static const DictionaryTrie trie;
+        return trie;
+    }
+
+    const Node& root() const { return nodes[0]; }
+
+    const Node* child(const Node& node, char label) const {
+        for (uint32_t i = node.firstEdge; i < node.firstEdge + node.edgeCount; ++i) {
+            if (edges[i].label == label) {
+                return &nodes[edges[i].child];
+            }
+            if (edges[i].label > label) {
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    struct Word {
+        std::string text;
+        float bits;
+    };
+
+    DictionaryTrie() {
+        std::vector<Word> words;
+        size_t rank = 0;
+        for (const char* tier : kTiers) {
+            size_t first = words.size();
+            std::string previous;
+            for (const char* p = tier; *p;) {
+                std::string word = previous.substr(0, static_cast<size_t>(*p++ - 'A'));
+                while (*p && !(*p >= 'A' && *p <= 'Z')) {
+                    word.push_back(*p++);
+                }
+                words.push_back(Word{word, 0.0f});
+                previous = word;
+            }
+            // Every word in a tier is costed at the rank of the tier's last word
+            rank += words.size() - first;
+            for (size_t i = first; i < words.size(); ++i) {
+                words[i].bits = static_cast<float>(std::log2(static_cast<double>(rank)));
+            }
+        }
+        std::sort(words.begin(), words.end(), [](const Word& a, const Word& b) {
+            return a.text != b.text ? a.text < b.text : a.bits < b.bits;
+        });
+        build(words, 0, words.size(), 0);
+    }
+
+    uint32_t build(const std::vector<Word>& words, size_t begin, size_t end, size_t depth) {
+        uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        if (words[begin].text.size() == depth) {
+            nodes[index].bits = words[begin].bits;
+            while (begin < end && words[begin].text.size() == depth) {
+                ++begin; // Duplicates sort after the cheapest copy
+            }
+        }
+
+        std::vector<size_t> groups;
+        for (size_t i = begin; i < end; ++i) {
+            if (i == begin || words[i].text[depth] != words[i - 1].text[depth]) {
+                groups.push_back(i);
+            }
+        }
+        uint32_t firstEdge = static_cast<uint32_t>(edges.size());
+        nodes[index].firstEdge = firstEdge;
+        nodes[index].edgeCount = static_cast<uint32_t>(groups.size());
+        edges.resize(edges.size() + groups.size());
+
+        for (size_t g = 0; g < groups.size(); ++g) {
+            size_t groupEnd = g + 1 < groups.size() ? groups[g + 1] : end;
+            uint32_t child = build(words, groups[g], groupEnd, depth + 1);
+            edges[firstEdge + g] = Edge{words[groups[g]].text[depth], child};
+        }
+        return index;
+    }
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+};
+
+/**
+ * @brief Relaxes cost[] with every dictionary word starting at start
+ *
+ * Walks the trie depth-first, branching where a character has l33t
+ * alternatives. Each match costs the word's bits plus one bit per
+ * substituted character and up to a few bits for capitalisation.
+ */
+void matchWords(std::string_view password, size_t start, double* cost) {
+    struct Step {
+        const DictionaryTrie::Node* node;
+        size_t end;       // One past the last matched character
+        uint32_t substitutions;
+    };
+
+    const DictionaryTrie& trie = DictionaryTrie::shared();
+    Step stack[64];
+    size_t depth = 0;
+    stack[depth++] = Step{&trie.root(), start, 0};
+
+    while (depth > 0) {
+        Step step = stack[--depth];
+        if (step.node->bits >= 0.0f && step.end - start >= 3) {
+            size_t upper = 0;
+            size_t letters = 0;
+            for (size_t i = start; i < step.end; ++i) {
+                uint8_t cls = kClassTable[static_cast<unsigned char>(password[i])];
+                upper += cls == PasswordStrength::Upper;
+                letters += (cls & PasswordStrength::Letter) != 0;
+            }
+            double bits = step.node->bits + step.substitutions;
+            bool firstOnly = upper == 1 && kClassTable[static_cast<unsigned char>(password[start])] == PasswordStrength::Upper;
+            if (upper > 0) {
+                bits += firstOnly || upper == letters ? 1.0 : 1.0 + std::min(upper, letters - upper);
+            }
+            cost[step.end] = std::min(cost[step.end], cost[start] + bits);
+        }
+        if (step.end == password.size()) {
+            continue;
+        }
+
+        unsigned char c = static_cast<unsigned char>(password[step.end]);
+        char plain = kClassTable[c] == PasswordStrength::Upper ? static_cast<char>(c - 'A' + 'a') : static_cast<char>(c);
+        if (kClassTable[c] & (PasswordStrength::Letter | PasswordStrength::Digit)) {
+            if (const DictionaryTrie::Node* next = trie.child(*step.node, plain)) {
+                if (depth < 64) {
+                    stack[depth++] = Step{next, step.end + 1, step.substitutions};
+                }
+            }
+        }
+        for (char letter : kLeetTable[c]) {
+            if (letter == 0) {
+                continue;
+            }
+            if (const DictionaryTrie::Node* next = trie.child(*step.node, letter)) {
+                if (depth < 64) {
+                    stack[depth++] = Step{next, step.end + 1, step.substitutions + 1};
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+uint8_t PasswordStrength::classify(std::string_view password) {
+    uint8_t classes = 0;
+    for (char c : password) {
+        classes |= kClassTable[static_cast<unsigned char>(c)];
+    }
+    return classes;
+}
+
+double PasswordStrength::estimateEntropy(std::string_view password) {
+    constexpr size_t kInline = 64;
+    double inlineCost[kInline + 1];
+    std::vector<double> heapCost;
+    double* cost = inlineCost;
+    if (password.size() > kInline) {
+        heapCost.resize(password.size() + 1);
+        cost = heapCost.data();
+    }
+
+    uint8_t classes = classify(password);
+    double pool = (classes & Lower ? 26 : 0) + (classes & Upper ? 26 : 0) + (classes & Digit ? 10 : 0) +
+                  (classes & Symbol ? 32 : 0) + (classes & Other ? 64 : 0);
+    if (pool == 0) {
+        return 0.0;
+    }
+    double charBits = std::log2(pool);
+
+    cost[0] = 0.0;
+    for (size_t i = 1; i <= password.size(); ++i) {
+        cost[i] = HUGE_VAL;
+    }
+
+    int previousStep = 0;
+    for (size_t i = 0; i < password.size(); ++i) {
+        // Repeats and runs in either direction are predictable
+        int step = i > 0 ? static_cast<int>(static_cast<unsigned char>(password[i])) -
+                               static_cast<int>(static_cast<unsigned char>(password[i - 1]))
+                         : 2;
+        bool predictable = i > 0 && (step == 0 || ((step == 1 || step == -1) && step == previousStep));
+        previousStep = step;
+
+        cost[i + 1] = std::min(cost[i + 1], cost[i] + (predictable ? 0.0 : charBits));
+        matchWords(password, i, cost);
+    }
+    return cost[password.size()];
+}
+
+} // namespace Utils
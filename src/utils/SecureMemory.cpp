@@ -0,0 +1,238 @@
+#include "utils/SecureMemory.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace Utils {
+
+void secureWipe(void* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+#ifdef _WIN32
+    SecureZeroMemory(data, size);
+#else
+    std::memset(data, 0, size);
+    // Tell the compiler the zeroed memory may still be read
+    __asm__ __volatile__("" : : "r"(data) : "memory");
+#endif
+}
+
+SecurePool& SecurePool::shared() {
+    static SecurePool* pool = new SecurePool();
+    return *pool;
+}
+
+SecurePool::SecurePool()
+    : region(nullptr),
+      used(0),
+      locked(false),
+      freeLists{},
+      blocksInUse(0),
+      heapBlocks(0) {
+#ifdef _WIN32
+    void* memory = VirtualAlloc(nullptr, kPoolSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (memory) {
+        region = static_cast<uint8_t*>(memory);
+        locked = VirtualLock(memory, kPoolSize) != 0;
+    }
+#else
+    void* memory = mmap(nullptr, kPoolSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+        region = static_cast<uint8_t*>(memory);
+        locked = mlock(memory, kPoolSize) == 0;
+#ifdef MADV_DONTDUMP
+        madvise(memory, kPoolSize, MADV_DONTDUMP);
+#endif
+    }
+#endif
+}
+
+size_t SecurePool::classOf(size_t size) {
+    size_t index = 0;
+    size_t block = kMinBlock;
+    while (block < size) {
+        block <<= 1;
+        ++index;
+    }
+    return index;
+}
+
+bool SecurePool::owns(const void* block) const {
+    auto address = static_cast<const uint8_t*>(block);
+    return region && address >= region && address < region + kPoolSize;
+}
+
+void* SecurePool::allocate(size_t size, size_t& capacity) {
+    if (size <= kMaxBlock) {
+        size_t index = classOf(size);
+        size_t blockSize = kMinBlock << index;
+
+        std::lock_guard<std::mutex> guard(mutex);
+        void* block = freeLists[index];
+        if (block) {
+            freeLists[index] = *static_cast<void**>(block);
+            *static_cast<void**>(block) = nullptr; // Released blocks are otherwise already zero
+        } else if (region && used + blockSize <= kPoolSize) {
+            block = region + used; // Every class is a multiple of kMinBlock, keeping blocks aligned
+            used += blockSize;
+        }
+        if (block) {
+            ++blocksInUse;
+            capacity = blockSize;
+            return block;
+        }
+    }
+
+    // The region is exhausted or the request is too large for it
+    capacity = std::max(size, kMinBlock);
+    void* block = new uint8_t[capacity]();
+    std::lock_guard<std::mutex> guard(mutex);
+    ++blocksInUse;
+    ++heapBlocks;
+    return block;
+}
+
+void SecurePool::release(void* block, size_t capacity) {
+    if (!block) {
+        return;
+    }
+    secureWipe(block, capacity);
+
+    if (!owns(block)) {
+        delete[] static_cast<uint8_t*>(block);
+        std::lock_guard<std::mutex> guard(mutex);
+        --blocksInUse;
+        --heapBlocks;
+        return;
+    }
+
+    size_t index = classOf(capacity);
+    std::lock_guard<std::mutex> guard(mutex);
+    *static_cast<void**>(block) = freeLists[index];
+    freeLists[index] = block;
+    --blocksInUse;
+}
+
+SecurePool::Stats SecurePool::stats() const {
+    std::lock_guard<std::mutex> guard(mutex);
+    Stats stats;
+    stats.poolSize = region ? kPoolSize : 0;
+    stats.locked = locked;
+    stats.blocksInUse = blocksInUse;
+    stats.heapBlocks = heapBlocks;
+    return stats;
+}
+
+SecureBuffer::SecureBuffer(size_t size) {
+    resize(size);
+}
+
+SecureBuffer::~SecureBuffer() {
+    clear();
+}
+
+SecureBuffer::SecureBuffer(SecureBuffer&& other) noexcept
+    : bytes(other.bytes),
+      length(other.length),
+      reserved(other.reserved) {
+    other.bytes = nullptr;
+    other.length = 0;
+    other.reserved = 0;
+}
+
+SecureBuffer& SecureBuffer::operator=(SecureBuffer&& other) noexcept {
+    if (this != &other) {
+        clear();
+        std::swap(bytes, other.bytes);
+        std::swap(length, other.length);
+        std::swap(reserved, other.reserved);
+    }
+    return *this;
+}
+
+void SecureBuffer::resize(size_t size) {
+    if (size <= reserved) {
+        if (size < length) {
+            secureWipe(bytes + size, length - size);
+        }
+        length = size;
+        return;
+    }
+
+    size_t capacity = 0;
+    auto* grown = static_cast<uint8_t*>(SecurePool::shared().allocate(std::max(size, reserved * 2), capacity));
+    if (length > 0) {
+        std::memcpy(grown, bytes, length);
+    }
+    SecurePool::shared().release(bytes, reserved);
+    bytes = grown;
+    length = size;
+    reserved = capacity;
+}
+
+void SecureBuffer::clear() {
+    SecurePool::shared().release(bytes, reserved);
+    bytes = nullptr;
+    length = 0;
+    reserved = 0;
+}
+
+SecureString::SecureString(std::string_view text) {
+    assign(text);
+}
+
+void SecureString::assign(std::string_view text) {
+    resize(0);
+    append(text);
+}
+
+void SecureString::append(std::string_view text) {
+    size_t start = size();
+    resize(start + text.size());
+    if (!text.empty()) {
+        std::memcpy(data() + start, text.data(), text.size());
+    }
+}
+
+void SecureString::push_back(char c) {
+    size_t start = size();
+    resize(start + 1);
+    data()[start] = c;
+}
+
+void SecureString::pop_back() {
+    if (!empty()) {
+        resize(size() - 1);
+    }
+}
+
+void SecureString::resize(size_t size) {
+    if (size == 0) {
+        if (!buffer.empty()) {
+            buffer.resize(1); // Keep the block for reuse
+            data()[0] = '\0';
+        }
+        return;
+    }
+    buffer.resize(size + 1);
+    data()[size] = '\0';
+}
+
+bool SecureString::equals(std::string_view other) const {
+    if (size() != other.size()) {
+        return false;
+    }
+    unsigned char diff = 0;
+    for (size_t i = 0; i < other.size(); ++i) {
+        diff |= static_cast<unsigned char>(data()[i] ^ other[i]);
+    }
+    return diff == 0;
+}
+
+} // namespace Utils
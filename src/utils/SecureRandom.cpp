@@ -0,0 +1,229 @@
+#include "utils/SecureRandom.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <bcrypt.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/random.h>
+#endif
+#endif
+
+namespace Utils {
+
+namespace {
+
+constexpr size_t kBlockSize = 64;
+
+inline uint32_t rotl(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+inline void quarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+    a += b; d ^= a; d = rotl(d, 16);
+    c += d; b ^= c; b = rotl(b, 12);
+    a += b; d ^= a; d = rotl(d, 8);
+    c += d; b ^= c; b = rotl(b, 7);
+}
+
+// One ChaCha20 block (RFC 8439) with a zero nonce
+void chachaBlock(const uint32_t key[8], uint32_t counter, uint8_t output[kBlockSize]) {
+    const uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        counter, 0, 0, 0
+    };
+
+    uint32_t x[16];
+    std::memcpy(x, input, sizeof(x));
+    for (int round = 0; round < 10; ++round) {
+        quarterRound(x[0], x[4], x[8], x[12]);
+        quarterRound(x[1], x[5], x[9], x[13]);
+        quarterRound(x[2], x[6], x[10], x[14]);
+        quarterRound(x[3], x[7], x[11], x[15]);
+        quarterRound(x[0], x[5], x[10], x[15]);
+        quarterRound(x[1], x[6], x[11], x[12]);
+        quarterRound(x[2], x[7], x[8], x[13]);
+        quarterRound(x[3], x[4], x[9], x[14]);
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        uint32_t word = x[i] + input[i];
+        output[i * 4] = static_cast<uint8_t>(word);
+        output[i * 4 + 1] = static_cast<uint8_t>(word >> 8);
+        output[i * 4 + 2] = static_cast<uint8_t>(word >> 16);
+        output[i * 4 + 3] = static_cast<uint8_t>(word >> 24);
+    }
+}
+
+// Bumped in the child of every fork; generators compare it on each draw
+std::atomic<unsigned> forkCount{0};
+
+unsigned currentForkCount() {
+#ifndef _WIN32
+    static const bool registered = [] {
+        pthread_atfork(nullptr, nullptr, [] { forkCount.fetch_add(1, std::memory_order_relaxed); });
+        return true;
+    }();
+    (void)registered;
+#endif
+    return forkCount.load(std::memory_order_relaxed);
+}
+
+void systemRandom(uint8_t* output, size_t size) {
+#ifdef _WIN32
+    if (BCryptGenRandom(nullptr, output, static_cast<ULONG>(size), BCRYPT_USE_SYSTEM_PREFERRED_RNG) != 0) {
+        throw std::runtime_error("BCryptGenRandom failed");
+    }
+#else
+    size_t filled = 0;
+#if defined(__linux__)
+    while (filled < size) {
+        ssize_t result = ::getrandom(output + filled, size - filled, 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        filled += static_cast<size_t>(result);
+    }
+#endif
+    if (filled < size) {
+        int fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+        while (fd >= 0 && filled < size) {
+            ssize_t result = ::read(fd, output + filled, size - filled);
+            if (result <= 0) {
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            filled += static_cast<size_t>(result);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    if (filled < size) {
+        throw std::runtime_error("No system entropy source available");
+    }
+#endif
+}
+
+} // namespace
+
+SecureRandom& SecureRandom::local() {
+    static thread_local SecureRandom instance;
+    return instance;
+}
+
+SecureRandom::SecureRandom() : position(kBufferSize), forkGeneration(0) {
+    reseed();
+}
+
+SecureRandom::~SecureRandom() {
+    volatile uint8_t* bytes = buffer;
+    for (size_t i = 0; i < kBufferSize; ++i) {
+        bytes[i] = 0;
+    }
+    volatile uint32_t* words = key;
+    for (size_t i = 0; i < 8; ++i) {
+        words[i] = 0;
+    }
+}
+
+void SecureRandom::reseed() {
+    uint8_t seed[sizeof(key)];
+    systemRandom(seed, sizeof(seed));
+    std::memcpy(key, seed, sizeof(key));
+    std::memset(seed, 0, sizeof(seed));
+    std::memset(buffer, 0, sizeof(buffer));
+    forkGeneration = currentForkCount();
+    position = kBufferSize;
+}
+
+void SecureRandom::checkFork() {
+    // A forked child must not hand out the bytes its parent buffered, nor replay its stream
+    if (forkGeneration != currentForkCount()) {
+        reseed();
+    }
+}
+
+void SecureRandom::refill() {
+    for (size_t block = 0; block < kBufferSize / kBlockSize; ++block) {
+        chachaBlock(key, static_cast<uint32_t>(block), buffer + block * kBlockSize);
+    }
+
+    // Fast key erasure: the head of the block becomes the next key
+    std::memcpy(key, buffer, sizeof(key));
+    std::memset(buffer, 0, sizeof(key));
+    position = sizeof(key);
+}
+
+void SecureRandom::fill(uint8_t* output, size_t size) {
+    checkFork();
+    while (size > 0) {
+        if (position == kBufferSize) {
+            refill();
+        }
+        size_t count = std::min(size, kBufferSize - position);
+        std::memcpy(output, buffer + position, count);
+        std::memset(buffer + position, 0, count);
+        position += count;
+        output += count;
+        size -= count;
+    }
+}
+
+uint32_t SecureRandom::uniform(uint32_t bound) {
+    // Reject the top partial range so every residue is equally likely
+    uint32_t limit = static_cast<uint32_t>(0x100000000ull - (0x100000000ull % bound));
+    uint32_t value;
+    do {
+        uint8_t bytes[4];
+        fill(bytes, sizeof(bytes));
+        value = static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+                (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    } while (limit != 0 && value >= limit);
+    return value % bound;
+}
+
+void SecureRandom::sample(std::string_view charset, char* output, size_t length) {
+    if (charset.empty() || charset.size() > 256) {
+        throw std::invalid_argument("Character set must hold between 1 and 256 characters");
+    }
+
+    const uint32_t size = static_cast<uint32_t>(charset.size());
+    const uint32_t limit = 256 - (256 % size);
+    checkFork();
+    size_t written = 0;
+    while (written < length) {
+        if (position == kBufferSize) {
+            refill();
+        }
+        while (written < length && position < kBufferSize) {
+            uint32_t byte = buffer[position];
+            buffer[position++] = 0;
+            if (byte < limit) {
+                output[written++] = charset[byte % size];
+            }
+        }
+    }
+}
+
+std::string SecureRandom::sample(std::string_view charset, size_t length) {
+    std::string result(length, '\0');
+    sample(charset, &result[0], length);
+    return result;
+}
+
+} // namespace Utils
@@ -0,0 +1,188 @@
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <exception>
+
+namespace Utils {
+
+namespace {
+
+// Identifies the pool and queue of the worker running on this thread
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount) : queued(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    local.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        local.push_back(std::make_unique<WorkQueue>());
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    WorkQueue& queue = currentPool == this ? *local[currentIndex] : injected;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued.fetch_add(1);
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::takeTask(size_t index, std::function<void()>& task) {
+    auto take = [&](WorkQueue& queue, bool newest) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        if (newest) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued.fetch_sub(1);
+        return true;
+    };
+
+    bool isWorker = index < local.size();
+    if (isWorker && take(*local[index], true)) {
+        return true;
+    }
+    if (take(injected, false)) {
+        return true;
+    }
+    // Steal the oldest task, which tends to be the largest piece of work left
+    size_t start = isWorker ? index + 1 : 0;
+    for (size_t i = 0; i < local.size(); ++i) {
+        size_t victim = (start + i) % local.size();
+        if (victim != index && take(*local[victim], false)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (takeTask(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() <= 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::runPendingTask() {
+    std::function<void()> task;
+    size_t index = currentPool == this ? currentIndex : local.size();
+    if (!takeTask(index, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::parallelFor(size_t count, size_t batchSize,
+                             const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    batchSize = std::max<size_t>(1, batchSize);
+
+    // Small ranges are not worth a round trip through the queue
+    if (count <= batchSize || workers.size() <= 1) {
+        body(0, count);
+        return;
+    }
+
+    // Batches report back through one counter, so the caller can run queued
+    // tasks while it waits instead of blocking a thread the batches may need
+    struct Progress {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining = 0;
+        std::exception_ptr failure;
+    };
+    auto progress = std::make_shared<Progress>();
+    progress->remaining = (count + batchSize - 1) / batchSize;
+
+    for (size_t begin = 0; begin < count; begin += batchSize) {
+        size_t end = std::min(count, begin + batchSize);
+        enqueue([&body, progress, begin, end]() {
+            std::exception_ptr failure;
+            try {
+                body(begin, end);
+            } catch (...) {
+                failure = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(progress->mutex);
+            if (failure && !progress->failure) {
+                progress->failure = failure;
+            }
+            if (--progress->remaining == 0) {
+                progress->done.notify_all();
+            }
+        });
+    }
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(progress->mutex);
+            if (progress->remaining == 0) {
+                break;
+            }
+        }
+        if (!runPendingTask()) {
+            // Every batch left is running elsewhere; any task they queue is run by them
+            std::unique_lock<std::mutex> lock(progress->mutex);
+            progress->done.wait(lock, [&]() { return progress->remaining == 0; });
+            break;
+        }
+    }
+
+    if (progress->failure) {
+        std::rethrow_exception(progress->failure);
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace Utils
@@ -3,6 +3,13 @@
 #include <filesystem>
 #include <iostream>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace Utils {
     bool fileExists(const std::string& path) {
         return std::filesystem::exists(path);
@@ -36,4 +43,35 @@ namespace Utils {
         std::sort(files.begin(), files.end());
         return files;
     }
+
+    bool syncFile(const std::string& path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        bool flushed = FlushFileBuffers(file) != 0;
+        CloseHandle(file);
+        return flushed;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        bool flushed = ::fsync(fd) == 0;
+        ::close(fd);
+        return flushed;
+#endif
+    }
+
+    bool syncDirectory(const std::string& path) {
+#ifdef _WIN32
+        // NTFS journals its directory changes; there is no handle to flush
+        (void)path;
+        return true;
+#else
+        return syncFile(path.empty() ? "." : path);
+#endif
+    }
 }
\ No newline at end of file
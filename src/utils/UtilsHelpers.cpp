@@ -1,9 +1,66 @@
 #include "utils/Utils.h"
+#include "utils/SecureRandom.h"
+#include "utils/PasswordStrength.h"
 #include <algorithm>
 #include <sstream>
-#include <regex>
 #include <iostream>
-#include <conio.h> 
+
+#ifdef _WIN32
+#include <conio.h>
+#else
+#include <cstdio>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+
+int readPasswordKey() {
+    return _getch();
+}
+
+#else
+
+/**
+ * @brief Turns off echo and line buffering on a terminal stdin while in scope
+ */
+class NoEcho {
+public:
+    NoEcho() : active(isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0) {
+        if (active) {
+            termios mode = saved;
+            mode.c_lflag &= ~static_cast<tcflag_t>(ECHO | ICANON);
+            mode.c_cc[VMIN] = 1;
+            mode.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSANOW, &mode);
+        }
+    }
+    ~NoEcho() {
+        if (active) {
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+        }
+    }
+
+private:
+    termios saved;
+    bool active;
+};
+
+// Reports keys as _getch would: Enter as '\r' and Backspace as '\b'
+int readPasswordKey() {
+    int ch = std::getchar();
+    if (ch == EOF || ch == '\n') {
+        return '\r';
+    }
+    return ch == 127 ? '\b' : ch;
+}
+
+#endif
+
+} // namespace
+
 namespace Utils {
     std::string trim(const std::string& str) {
         size_t first = str.find_first_not_of(" \t\n\r");
@@ -24,6 +81,62 @@ namespace Utils {
         return tokens;
     }
 
+    bool isWordEscapable(char c) {
+        return c == ' ' || c == '\t' || c == '"' || c == '\'' || c == '\\' || c == '|' || c == '&';
+    }
+
+    void splitWords(std::string_view input, std::string& buffer, std::vector<std::string_view>& words) {
+        buffer.assign(input.data(), input.size());
+        words.clear();
+
+        // Unquoted text is never longer than its source, so each word is written
+        // back over the buffer it was read from; without quotes or escapes every
+        // character is copied onto itself
+        char* data = &buffer[0];
+        const size_t size = buffer.size();
+        size_t read = 0;
+        size_t write = 0;
+
+        while (true) {
+            while (read < size && (data[read] == ' ' || data[read] == '\t')) {
+                ++read;
+            }
+            if (read == size) {
+                break;
+            }
+
+            size_t start = write;
+            bool quoted = false;
+            char quote = 0;
+            for (; read < size; ++read) {
+                char c = data[read];
+                if (quote != 0) {
+                    if (c == quote) {
+                        quote = 0;
+                        continue;
+                    }
+                    if (quote == '"' && c == '\\' && read + 1 < size && (data[read + 1] == '"' || data[read + 1] == '\\')) {
+                        c = data[++read];
+                    }
+                } else if (c == ' ' || c == '\t') {
+                    break;
+                } else if (c == '"' || c == '\'') {
+                    quote = c;
+                    quoted = true;
+                    continue;
+                } else if (c == '\\' && read + 1 < size && isWordEscapable(data[read + 1])) {
+                    c = data[++read];
+                }
+                data[write++] = c;
+            }
+
+            // "" is an empty word, not nothing
+            if (write > start || quoted) {
+                words.emplace_back(data + start, write - start);
+            }
+        }
+    }
+
     std::string toLower(const std::string& str) {
         std::string result = str;
         std::transform(result.begin(), result.end(), result.begin(),
@@ -46,48 +159,39 @@ namespace Utils {
             "abcdefghijklmnopqrstuvwxyz"
             "!@#$%^&*()-=_+";
 
-        std::random_device rd;
-        std::mt19937 generator(rd());
-        std::uniform_int_distribution<size_t> distribution(0, charset.size() - 1);
-
-        std::string result;
-        result.reserve(length);
-        for (size_t i = 0; i < length; ++i) {
-            result += charset[distribution(generator)];
-        }
-        return result;
+        return SecureRandom::local().sample(charset, length);
     }
     
-    std::string readMaskedPassword() {
-        std::string password;
-        char ch;
-        while ((ch = _getch()) != '\r') {
+    SecureString readMaskedPassword() {
+        SecureString password;
+#ifndef _WIN32
+        NoEcho noEcho;
+#endif
+        std::cout.flush();
+        int ch;
+        while ((ch = readPasswordKey()) != '\r') {
             if (ch == '\b') {
                 if (!password.empty()) {
                     password.pop_back();
                     std::cout << "\b \b";
                 }
             } else if (ch >= 32 && ch <= 126) {
-                password.push_back(ch);
-                std::cout << '*';
+                password.push_back(static_cast<char>(ch));
+                std::cout << '*' << std::flush;
             }
         }
         std::cout << std::endl;
         return password;
     }
     
-    // Now enforces uppercase and lowercase letters
-    bool validatePasswordStrength(const std::string& password) {
+    // At least 8 characters with a letter, a digit and ASCII punctuation
+    bool validatePasswordStrength(std::string_view password) {
         if (password.length() < 8) {
             return false;
         }
-        
-        bool hasLetter = std::regex_search(password, std::regex("[a-zA-Z]"));
-        
-        bool hasDigit = std::regex_search(password, std::regex("[0-9]"));
-        
-        bool hasSpecial = std::regex_search(password, std::regex("[!@#$%^&*-=_+]"));
-
-        return hasLetter && hasDigit && hasSpecial;
+
+        uint8_t classes = PasswordStrength::classify(password);
+        return (classes & PasswordStrength::Letter) && (classes & PasswordStrength::Digit) &&
+               (classes & PasswordStrength::Symbol);
     }
 }
\ No newline at end of file
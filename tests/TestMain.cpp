@@ -3,8 +3,13 @@
 #include "terminal/CompileAndRunTest.cpp"
 #include "terminal/CommandParserTest.cpp"
 #include "terminal/TerminalTest.cpp"
+#ifdef _WIN32
 #include "launcher/LauncherTest.cpp"
+#endif
 #include "encryption/FileEncryptionTest.cpp"
+#include "passman/PasswordCryptoTest.cpp"
+#include "passman/EntryStoreTest.cpp"
+#include "passman/PasswordManagerTest.cpp"
 
 int main(){
     TestSuite masterSuite;
@@ -33,16 +38,61 @@ int main(){
     masterSuite.addTest("Is Valid Command Test", CommandParserTest::testIsValidCommand);
     masterSuite.addTest("Get Command List Test", CommandParserTest::testGetCommandList);
     masterSuite.addTest("Initialize Default Commands Test", CommandParserTest::testInitializeDefaultCommands);
+    masterSuite.addTest("Command Trie Cursor Test", CommandParserTest::testCommandTrieCursor);
+    masterSuite.addTest("Pipeline Streaming Test", CommandParserTest::testPipelineStreamsAndStopsEarly);
+    masterSuite.addTest("Tokenizer Quotes And Escapes Test", CommandParserTest::testTokenizerQuotesAndEscapes);
 
     masterSuite.addTest("Terminal Running State Test", TerminalTest::testTerminalRunningState);
+    masterSuite.addTest("Tab Completion Test", TerminalTest::testTabCompletion);
+    masterSuite.addTest("Script Mode Test", TerminalTest::testScriptMode);
+    masterSuite.addTest("Failing Command Status Test", TerminalTest::testFailingCommandStatus);
+    masterSuite.addTest("Background Jobs Test", TerminalTest::testBackgroundJobs);
+    masterSuite.addTest("Jobs Beside Foreground Test", TerminalTest::testJobsBesideForeground);
+    masterSuite.addTest("Command History Test", TerminalTest::testCommandHistory);
+    masterSuite.addTest("History Skips Secrets Test", TerminalTest::testHistorySkipsSecrets);
+#ifndef _WIN32
+    masterSuite.addTest("Terminal Backend Test", TerminalTest::testAnsiBackendBatchesOutput);
+#endif
 
+#ifdef _WIN32
     masterSuite.addTest("Set Console Color Test", LauncherTest::testSetConsoleColor);
     masterSuite.addTest("Get Available Drive Test", LauncherTest::testGetAvailableDrive);
     masterSuite.addTest("Process Creation Failure Test", LauncherTest::testProcessCreationFailure);
+#endif
 
     // File Encryption Tests
     masterSuite.addTest("Encrypt Decrypt File Test", FileEncryptionTest::testEncryptDecryptFile);
     masterSuite.addTest("Encrypt Decrypt With Wrong Password Test", FileEncryptionTest::testEncryptDecryptWithWrongPassword);
+
+    // Password Manager Tests
+    masterSuite.addTest("Hex Round Trip Test", PasswordCryptoTest::testHexRoundTrip);
+    masterSuite.addTest("Hex Rejects Invalid Input Test", PasswordCryptoTest::testHexRejectsInvalidInput);
+    masterSuite.addTest("Encrypt Decrypt Password Test", PasswordCryptoTest::testEncryptDecryptPassword);
+    masterSuite.addTest("Batch Crypto Test", PasswordCryptoTest::testBatchMatchesSingleCalls);
+    masterSuite.addTest("PBKDF2 Known Answer Test", PasswordCryptoTest::testPbkdf2KnownAnswer);
+    masterSuite.addTest("KDF Params Round Trip Test", PasswordCryptoTest::testKdfParamsRoundTrip);
+    masterSuite.addTest("Generated Passwords Follow Policy Test", PasswordCryptoTest::testGeneratedPasswordsFollowPolicy);
+#ifndef _WIN32
+    masterSuite.addTest("Forked Random Reseed Test", PasswordCryptoTest::testForkedChildReseeds);
+#endif
+    masterSuite.addTest("Secure String Pool Test", PasswordCryptoTest::testSecureStringReusesPool);
+    masterSuite.addTest("Password Strength Test", PasswordCryptoTest::testStrengthRulesAndEntropy);
+    masterSuite.addTest("Entry Store Case Insensitive Upsert Test", EntryStoreTest::testCaseInsensitiveUpsert);
+    masterSuite.addTest("Entry Store Erase Test", EntryStoreTest::testEraseKeepsOtherEntries);
+    masterSuite.addTest("Entry Index Query Test", EntryStoreTest::testIndexIntersectsTerms);
+    masterSuite.addTest("Domain Trie Match Tiers Test", EntryStoreTest::testDomainTrieTiers);
+    masterSuite.addTest("Entry Codec Attachments Test", EntryStoreTest::testCodecKeepsAttachments);
+    masterSuite.addTest("Passman Batch Failure Test", PasswordManagerTest::testBatchFailureFailsCommand);
+    masterSuite.addTest("Passman Import Round Trip Test", PasswordManagerTest::testImportRoundTrip);
+    masterSuite.addTest("Passman Recovery Test", PasswordManagerTest::testRecoveryRollsForward);
+    masterSuite.addTest("Passman Shared Vault Test", PasswordManagerTest::testSharedVaultAcrossInstances);
+    masterSuite.addTest("Passman History Restore Test", PasswordManagerTest::testHistoryRestore);
+    masterSuite.addTest("Passman Attachments Test", PasswordManagerTest::testAttachments);
+    masterSuite.addTest("Passman First Attach Test", PasswordManagerTest::testFirstAttachAcrossInstances);
+    masterSuite.addTest("Passman Rekey Test", PasswordManagerTest::testRekey);
+    masterSuite.addTest("Passman Audit Test", PasswordManagerTest::testAudit);
+    masterSuite.addTest("Passman Weakened KDF Test", PasswordManagerTest::testWeakenedKdfRejected);
+    masterSuite.addTest("Passman Subcommand Output Test", PasswordManagerTest::testSubcommandOutput);
     masterSuite.runAll();
 
     return 0;
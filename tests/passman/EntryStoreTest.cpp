@@ -0,0 +1,142 @@
+#include "passman/ChunkStore.h"
+#include "passman/DomainTrie.h"
+#include "passman/EntryCodec.h"
+#include "passman/EntryIndex.h"
+#include "passman/EntryStore.h"
+#include "passman/EntryTable.h"
+#include "utils/Lz77.h"
+#include "../TestFramework.h"
+#include <string>
+
+class EntryStoreTest {
+public:
+    static bool testCaseInsensitiveUpsert() {
+        passman::EntryStore store;
+        store.insert(passman::PasswordEntry{"GitHub", "alice", "secret1", "", "salt1", "", ""});
+        store.insert(passman::PasswordEntry{"github", "bob", "secret2", "", "salt2", "", ""});
+        ASSERT_EQUAL(static_cast<size_t>(1), store.size());
+
+        passman::EntryView entry;
+        ASSERT_TRUE(store.find("GITHUB", entry));
+        ASSERT_TRUE(entry.username == "bob");
+        ASSERT_TRUE(entry.encryptedPassword == "secret2");
+
+        // Re-inserting a view of the store's own entry must not read freed bytes
+        store.insert(entry);
+        ASSERT_TRUE(store.find("github", entry));
+        ASSERT_TRUE(entry.salt == "salt2");
+
+        return true;
+    }
+
+    static bool testEraseKeepsOtherEntries() {
+        passman::EntryTable table(4);
+        for (int i = 0; i < 2000; ++i) {
+            std::string service = "service" + std::to_string(i);
+            table.insert(passman::PasswordEntry{service, "user" + std::to_string(i % 3), service + "-pw", "", "s",
+                                                "", ""});
+        }
+        for (int i = 0; i < 2000; i += 2) {
+            ASSERT_TRUE(table.erase("SERVICE" + std::to_string(i)));
+        }
+        ASSERT_EQUAL(static_cast<size_t>(1000), table.size());
+
+        passman::EntryView entry;
+        for (int i = 0; i < 2000; ++i) {
+            std::string service = "service" + std::to_string(i);
+            bool found = table.find(service, entry);
+            ASSERT_TRUE(found == (i % 2 == 1));
+            if (found) {
+                ASSERT_TRUE(entry.encryptedPassword == service + "-pw");
+                ASSERT_TRUE(entry.username == "user" + std::to_string(i % 3));
+            }
+        }
+        ASSERT_FALSE(table.erase("service0"));
+
+        return true;
+    }
+
+    static bool testIndexIntersectsTerms() {
+        std::string tags;
+        ASSERT_TRUE(passman::EntryIndex::normalizeTags({"Prod", "db,prod"}, tags));
+        ASSERT_TRUE(tags == "db,prod");
+        ASSERT_FALSE(passman::EntryIndex::normalizeTags({"two words"}, tags));
+
+        passman::EntryIndex index;
+        index.add(passman::PasswordEntry{"GitHub", "Alice", "", "", "", "prod,web", ""});
+        index.add(passman::PasswordEntry{"Database", "alice", "", "", "", "db,prod", ""});
+        index.add(passman::PasswordEntry{"Mail", "bob", "", "", "", "prod", ""});
+
+        std::vector<std::string> terms;
+        std::string error;
+        ASSERT_TRUE(passman::EntryIndex::parseQuery("user=ALICE tag=prod", terms, error));
+        ASSERT_EQUAL(static_cast<size_t>(2), index.query(terms).size());
+
+        // Re-adding an entry replaces its terms
+        index.add(passman::PasswordEntry{"github", "carol", "", "", "", "prod", ""});
+        ASSERT_EQUAL(static_cast<size_t>(1), index.query(terms).size());
+        index.remove("DATABASE");
+        ASSERT_TRUE(index.query(terms).empty());
+
+        ASSERT_FALSE(passman::EntryIndex::parseQuery("owner=alice", terms, error));
+        ASSERT_FALSE(passman::EntryIndex::parseQuery("   ", terms, error));
+
+        return true;
+    }
+
+    static bool testDomainTrieTiers() {
+        std::string host;
+        ASSERT_TRUE(passman::DomainTrie::parseHost("https://bob@Login.EU.example.com:8443/path", host));
+        ASSERT_TRUE(host == "login.eu.example.com");
+        ASSERT_FALSE(passman::DomainTrie::parseHost("https://*.example.com", host));
+
+        passman::DomainTrie trie;
+        trie.insert("login.eu.example.com", 1);
+        uint32_t root = trie.insert("example.com", 2);
+        trie.insert("*.eu.example.com", 3);
+
+        std::vector<uint32_t> values;
+        ASSERT_TRUE(trie.match("login.eu.example.com", values) == passman::DomainTrie::Match::Exact);
+        ASSERT_TRUE(trie.match("mail.eu.example.com", values) == passman::DomainTrie::Match::Domain);
+        ASSERT_EQUAL(static_cast<uint32_t>(2), values[0]);
+
+        trie.erase(root, 2);
+        ASSERT_TRUE(trie.match("mail.eu.example.com", values) == passman::DomainTrie::Match::Wildcard);
+        ASSERT_EQUAL(static_cast<uint32_t>(3), values[0]);
+        ASSERT_TRUE(trie.match("eu.example.com", values) == passman::DomainTrie::Match::None);
+
+        return true;
+    }
+
+    static bool testCodecKeepsAttachments() {
+        std::string recipe(64, 'a');
+        std::vector<passman::AttachmentRef> refs;
+        ASSERT_TRUE(passman::ChunkStore::parseRefs("note:11:" + recipe + ",key.pem:0:" + recipe, refs));
+        ASSERT_EQUAL(static_cast<size_t>(2), refs.size());
+        ASSERT_TRUE(refs[1].name == "key.pem" && refs[1].size == 0);
+        ASSERT_FALSE(passman::ChunkStore::parseRefs("bad name:1:" + recipe, refs));
+        ASSERT_FALSE(passman::ChunkStore::parseRefs("note:1:short", refs));
+
+        // Attachments without tags still need the empty tags field before them
+        passman::PasswordEntry entry{"GitHub", "alice", "secret", "", "salt", "", "note:11:" + recipe};
+        std::string line;
+        passman::EntryCodec::appendLine(line, entry);
+        ASSERT_EQUAL(passman::EntryCodec::lineSize(entry), line.size());
+        passman::EntryView parsed;
+        ASSERT_TRUE(passman::EntryCodec::parseLine(std::string_view(line).substr(0, line.size() - 1), parsed));
+        ASSERT_TRUE(parsed.tags.empty() && parsed.salt == "salt" && parsed.attachments == entry.attachments);
+
+        std::string text;
+        for (int i = 0; i < 1000; ++i) {
+            text += "chunk " + std::to_string(i % 37) + ";";
+        }
+        std::vector<uint8_t> packed, unpacked;
+        Utils::Lz77::compress(reinterpret_cast<const uint8_t*>(text.data()), text.size(), packed);
+        ASSERT_TRUE(packed.size() < text.size() / 2);
+        ASSERT_TRUE(Utils::Lz77::decompress(packed.data(), packed.size(), text.size(), unpacked));
+        ASSERT_TRUE(std::string(unpacked.begin(), unpacked.end()) == text);
+        ASSERT_FALSE(Utils::Lz77::decompress(packed.data(), packed.size() / 2, text.size(), unpacked));
+
+        return true;
+    }
+};
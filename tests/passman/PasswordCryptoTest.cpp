@@ -0,0 +1,234 @@
+#include "passman/PasswordCrypto.h"
+#include "passman/HexCodec.h"
+#include "passman/PasswordKdf.h"
+#include "utils/PasswordStrength.h"
+#include "utils/SecureMemory.h"
+#include "utils/SecureRandom.h"
+#include "utils/Utils.h"
+#include "../TestFramework.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+class PasswordCryptoTest {
+public:
+    static bool testHexRoundTrip() {
+        // Long enough to cover the vector paths and the scalar tail
+        std::string bytes;
+        for (int i = 0; i < 300; ++i) {
+            bytes.push_back(static_cast<char>(i * 37));
+        }
+
+        std::string hex = passman::HexCodec::encode(bytes);
+        ASSERT_EQUAL(bytes.size() * 2, hex.size());
+        ASSERT_EQUAL(std::string("00254a6f"), hex.substr(0, 8));
+
+        std::string decoded(bytes.size(), '\0');
+        ASSERT_TRUE(passman::HexCodec::decode(hex.data(), hex.size(), reinterpret_cast<uint8_t*>(&decoded[0])));
+        ASSERT_TRUE(decoded == bytes);
+
+        std::string upper = "DEADBEEF";
+        uint8_t out[4];
+        ASSERT_TRUE(passman::HexCodec::decode(upper.data(), upper.size(), out));
+        ASSERT_EQUAL(0xEF, static_cast<int>(out[3]));
+
+        return true;
+    }
+
+    static bool testHexRejectsInvalidInput() {
+        uint8_t out[32];
+        std::string odd = "abc";
+        ASSERT_FALSE(passman::HexCodec::decode(odd.data(), odd.size(), out));
+
+        std::string badTail = "0011223344556677889900112233445566778899aabbccddeeff00112233445g";
+        ASSERT_FALSE(passman::HexCodec::decode(badTail.data(), badTail.size(), out));
+
+        std::string badVector = "zz11223344556677889900112233445566778899aabbccddeeff001122334455";
+        ASSERT_FALSE(passman::HexCodec::decode(badVector.data(), badVector.size(), out));
+
+        return true;
+    }
+
+    static bool testEncryptDecryptPassword() {
+        passman::PasswordCrypto crypto;
+        const std::string key = crypto.customHash("Master!123", "salt");
+        const std::string password = "correct horse battery staple";
+
+        std::string encrypted = crypto.encryptPassword(password, key);
+        ASSERT_EQUAL(password.size() * 2, encrypted.size());
+        ASSERT_EQUAL(password, crypto.decryptPassword(encrypted, key));
+        ASSERT_EQUAL(std::string(""), crypto.decryptPassword("not hex!", key));
+
+        return true;
+    }
+
+    static bool testBatchMatchesSingleCalls() {
+        passman::PasswordCrypto crypto;
+        const std::string key = crypto.customHash("Master!123", "salt");
+        std::vector<std::string> passwords = {"", "a", "hunter2", std::string(100, 'x'), "P@ssw0rd!"};
+        std::vector<std::string_view> inputs(passwords.begin(), passwords.end());
+
+        passman::CryptoBatch encrypted;
+        crypto.encryptMany(inputs, key, encrypted);
+        ASSERT_EQUAL(passwords.size(), encrypted.size());
+        for (size_t i = 0; i < passwords.size(); ++i) {
+            ASSERT_EQUAL(crypto.encryptPassword(passwords[i], key), std::string(encrypted[i]));
+        }
+
+        std::vector<std::string_view> ciphertexts;
+        for (size_t i = 0; i < encrypted.size(); ++i) {
+            ciphertexts.push_back(encrypted[i]);
+        }
+        passman::CryptoBatch decrypted;
+        ASSERT_TRUE(crypto.decryptMany(ciphertexts, key, decrypted));
+        for (size_t i = 0; i < passwords.size(); ++i) {
+            ASSERT_EQUAL(passwords[i], std::string(decrypted[i]));
+        }
+
+        return true;
+    }
+
+    static bool testPbkdf2KnownAnswer() {
+        // RFC 7914 section 11 test vector
+        uint8_t derived[32];
+        passman::PasswordKdf::pbkdf2("password", "salt", 4096, derived, sizeof(derived));
+        std::string hex = passman::HexCodec::encode(std::string(derived, derived + sizeof(derived)));
+        ASSERT_EQUAL(std::string("c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a"), hex);
+
+        passman::KdfParams params;
+        params.iterations = 1000;
+        auto first = passman::PasswordKdf::derive("Master!123", "salt", params);
+        auto second = passman::PasswordKdf::derive("Master!123", "salt", params);
+        ASSERT_EQUAL(first.verifier, second.verifier);
+        ASSERT_TRUE(first.verifier != first.encryptionKey);
+
+        return true;
+    }
+
+    static bool testKdfParamsRoundTrip() {
+        passman::KdfParams params;
+        params.iterations = 250000;
+        passman::KdfParams parsed;
+        ASSERT_TRUE(passman::KdfParams::parse(params.toString(), parsed));
+        ASSERT_EQUAL(250000u, parsed.iterations);
+
+        ASSERT_TRUE(passman::KdfParams::parse("", parsed));
+        ASSERT_TRUE(parsed.isLegacy());
+        ASSERT_FALSE(passman::KdfParams::parse("scrypt:12", parsed));
+
+        // Counts below the floor would make an edited master.txt cheap to attack
+        ASSERT_FALSE(passman::KdfParams::parse("pbkdf2-sha256:1", parsed));
+        ASSERT_FALSE(passman::KdfParams::parse("pbkdf2-sha256:99999", parsed));
+        ASSERT_FALSE(passman::KdfParams::parse("pbkdf2-sha256:-600000", parsed));
+        ASSERT_FALSE(passman::KdfParams::parse("pbkdf2-sha256:600000x", parsed));
+        ASSERT_TRUE(passman::KdfParams::parse("pbkdf2-sha256:100000", parsed));
+
+        return true;
+    }
+
+    static bool testGeneratedPasswordsFollowPolicy() {
+        passman::PasswordCrypto crypto;
+        passman::PasswordPolicy policy;
+        ASSERT_TRUE(passman::PasswordPolicy::parse("strong", policy));
+        ASSERT_FALSE(passman::PasswordPolicy::parse("weak", policy));
+
+        std::string lines;
+        crypto.generatePasswords(1000, 12, policy, lines);
+        ASSERT_EQUAL(static_cast<size_t>(1000 * 13), lines.size());
+        for (size_t i = 0; i < 1000; ++i) {
+            ASSERT_EQUAL('\n', lines[i * 13 + 12]);
+            ASSERT_TRUE(policy.accepts(std::string_view(&lines[i * 13], 12)));
+        }
+
+        ASSERT_TRUE(passman::PasswordPolicy::parse("pin", policy));
+        std::string pin = Utils::SecureRandom::local().sample(policy.charset, 64);
+        ASSERT_EQUAL(std::string::npos, pin.find_first_not_of("0123456789"));
+        ASSERT_TRUE(crypto.generateSalt() != crypto.generateSalt());
+
+        return true;
+    }
+
+#ifndef _WIN32
+    static bool testForkedChildReseeds() {
+        // Leave bytes buffered, which a child would otherwise hand out again
+        uint8_t warmup[16];
+        Utils::SecureRandom::local().fill(warmup, sizeof(warmup));
+
+        int fds[2];
+        ASSERT_TRUE(pipe(fds) == 0);
+        pid_t child = fork();
+        if (child == 0) {
+            uint8_t bytes[32];
+            Utils::SecureRandom::local().fill(bytes, sizeof(bytes));
+            ssize_t written = write(fds[1], bytes, sizeof(bytes));
+            _exit(written == static_cast<ssize_t>(sizeof(bytes)) ? 0 : 1);
+        }
+        close(fds[1]);
+        uint8_t parentBytes[32];
+        Utils::SecureRandom::local().fill(parentBytes, sizeof(parentBytes));
+        uint8_t childBytes[32];
+        ssize_t received = read(fds[0], childBytes, sizeof(childBytes));
+        close(fds[0]);
+        int status = 0;
+        waitpid(child, &status, 0);
+
+        ASSERT_TRUE(child > 0);
+        ASSERT_EQUAL(static_cast<ssize_t>(sizeof(childBytes)), received);
+        ASSERT_TRUE(std::memcmp(parentBytes, childBytes, sizeof(parentBytes)) != 0);
+        return true;
+    }
+#endif
+
+    static bool testSecureStringReusesPool() {
+        size_t before = Utils::SecurePool::shared().stats().blocksInUse;
+        {
+            Utils::SecureString secret("hunter2");
+            secret.append("-and-more");
+            ASSERT_TRUE(secret == "hunter2-and-more");
+            ASSERT_EQUAL(static_cast<size_t>(16), secret.size());
+            ASSERT_TRUE(secret.c_str()[secret.size()] == '\0');
+
+            Utils::SecureString moved(std::move(secret));
+            ASSERT_TRUE(secret.empty());
+            ASSERT_TRUE(moved.equals("hunter2-and-more"));
+            ASSERT_FALSE(moved.equals("hunter2-and-mord"));
+        }
+        ASSERT_EQUAL(before, Utils::SecurePool::shared().stats().blocksInUse);
+
+        // A released block is wiped and handed out again for the same size class
+        const char* first;
+        {
+            Utils::SecureString a("short secret");
+            first = a.c_str();
+        }
+        Utils::SecureString b;
+        b.resize(3);
+        ASSERT_TRUE(b.c_str() == first);
+        ASSERT_TRUE(b[0] == '\0' && b[1] == '\0' && b[2] == '\0');
+
+        return true;
+    }
+
+    static bool testStrengthRulesAndEntropy() {
+        // '*-=' used to be a regex range that counted digits as special characters
+        ASSERT_FALSE(Utils::validatePasswordStrength("abcdefg1"));
+        ASSERT_TRUE(Utils::validatePasswordStrength("abcdefg1("));
+        ASSERT_FALSE(Utils::validatePasswordStrength("a1!"));
+
+        // Dictionary words stay weak however they are spelled
+        double leet = Utils::PasswordStrength::estimateEntropy("P@ssw0rd");
+        double walk = Utils::PasswordStrength::estimateEntropy("1qaz2wsx");
+        double random = Utils::PasswordStrength::estimateEntropy("x7#Kq9!mZ2vL");
+        ASSERT_TRUE(leet < 15.0);
+        ASSERT_TRUE(walk < 15.0);
+        ASSERT_TRUE(random > 60.0);
+        ASSERT_TRUE(Utils::PasswordStrength::estimateEntropy("aaaaaaaaaaaa") < 10.0);
+
+        return true;
+    }
+};
@@ -0,0 +1,592 @@
+#include "passman/PasswordAuditor.h"
+#include "passman/PasswordManager.h"
+#include "passman/PasswordManagerOperations.h"
+#include "passman/PasswordTransfer.h"
+#include "terminal/CommandIO.h"
+#include "terminal/CommandParser.h"
+#include "terminal/FileOperations.h"
+#include "terminal/Pipeline.h"
+#include "../TestFramework.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PasswordManagerTest {
+public:
+    static bool testBatchFailureFailsCommand() {
+        const std::string dir = freshVault("passman_batch_test/");
+        ScriptedPassword scripted(kMasterPassword);
+        PasswordManagerOperations operations(dir);
+        ASSERT_TRUE(std::getenv("SECURESHELL_PASSMAN_PASSWORD") == nullptr ||
+                    *std::getenv("SECURESHELL_PASSMAN_PASSWORD") == '\0'); // Children must not inherit it
+
+        std::ofstream(dir + "mixed.txt") << "add github.com alice Tr0ub4dor&3\nrm no-such-service\n";
+        ASSERT_FALSE(operations.passman({"batch", dir + "mixed.txt"}));
+        ASSERT_TRUE(operations.passman({"get", "github.com", "username"})); // The good line still ran
+
+        std::ofstream(dir + "clean.txt") << "# comment\npassman add gitlab.com bob C0rrect-horse\n";
+        ASSERT_TRUE(operations.passman({"batch", dir + "clean.txt"}));
+        ASSERT_FALSE(operations.passman({"no-such-subcommand"}));
+
+        // Batch lines are split with the shell's own quoting rules
+        std::ofstream(dir + "quoted.txt") << "add \"my site\" carol\\ smith \"pa ss\\\"w\\\\ord\"\r\n"
+                                             "add 'it''s.org' dave 'a\\b'\n";
+        ASSERT_TRUE(operations.passman({"batch", dir + "quoted.txt"}));
+        passman::PasswordManager manager(dir);
+        ASSERT_TRUE(manager.authenticate(kMasterPassword));
+        ASSERT_EQUAL(manager.getEntry("my site").username, std::string("carol smith"));
+        ASSERT_TRUE(manager.getPassword("my site").view() == "pa ss\"w\\ord");
+        ASSERT_TRUE(manager.getPassword("its.org").view() == "a\\b");
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testImportRoundTrip() {
+        const std::string dir = freshVault("passman_import_test/");
+        passman::PasswordManager manager(dir);
+        ASSERT_TRUE(manager.authenticate(kMasterPassword));
+        passman::PasswordTransfer transfer(manager, 2);
+        passman::TransferStats stats;
+        std::string error;
+
+        // Passwords are stored encrypted and may hold anything; the other fields may not split a vault line
+        std::ofstream(dir + "in.csv") << "name,url,username,password\n"
+                                         "github.com,https://github.com/login,alice,\"p|a,s\"\"s\nword\"\n"
+                                         "pipe|name,,bob,secret1\n"
+                                         "example.org,,\"carol\ndave\",secret2\n"
+                                         "gitlab.com,https://gitlab.com/?a=1|2,erin,secret3\n"
+                                         "ok.net,,frank,secret4\n";
+        ASSERT_TRUE(transfer.importFile(dir + "in.csv", passman::TransferFormat::Csv, stats, error));
+        ASSERT_EQUAL(stats.processed, 2u);
+        ASSERT_EQUAL(stats.skipped, 3u);
+
+        std::ofstream(dir + "in.json") << "[{\"name\": \"json.io\", \"username\": \"gina\\nx\", \"password\": \"a\"},"
+                                          " {\"name\": \"a|b\", \"password\": \"b\"},"
+                                          " {\"name\": \"json.dev\", \"username\": \"hal\", \"password\": \"c|\\n\"}]";
+        ASSERT_TRUE(transfer.importFile(dir + "in.json", passman::TransferFormat::Json, stats, error));
+        ASSERT_EQUAL(stats.processed, 1u);
+        ASSERT_EQUAL(stats.skipped, 2u);
+        ASSERT_FALSE(manager.addEntry("bad|service", "user", "pw"));
+        ASSERT_FALSE(manager.addEntry("service", "bad\nuser", "pw"));
+
+        // Every record survives a reload and an export and import through both formats
+        std::vector<std::string> original = records(manager);
+        ASSERT_EQUAL(original.size(), 3u);
+        passman::PasswordManager reloaded(dir);
+        ASSERT_TRUE(reloaded.authenticate(kMasterPassword));
+        ASSERT_TRUE(records(reloaded) == original);
+
+        for (auto format : {passman::TransferFormat::Csv, passman::TransferFormat::Json}) {
+            const std::string file = dir + (format == passman::TransferFormat::Csv ? "out.csv" : "out.json");
+            ASSERT_TRUE(transfer.exportFile(file, format, stats, error));
+            ASSERT_EQUAL(stats.processed, 3u);
+
+            const std::string copyDir = freshVault("passman_import_copy/");
+            passman::PasswordManager copy(copyDir);
+            ASSERT_TRUE(copy.authenticate(kMasterPassword));
+            passman::PasswordTransfer copyTransfer(copy);
+            ASSERT_TRUE(copyTransfer.importFile(file, format, stats, error));
+            ASSERT_EQUAL(stats.skipped, 0u);
+            ASSERT_TRUE(records(copy) == original);
+            std::filesystem::remove_all(copyDir);
+        }
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testRecoveryRollsForward() {
+        const std::string dir = freshVault("passman_recovery_test/");
+        passman::PasswordManager writer(dir);
+        ASSERT_TRUE(writer.authenticate(kMasterPassword));
+        ASSERT_TRUE(writer.addEntry("before.com", "alice", "first"));
+
+        std::vector<std::string> files = {dir + "master.txt"};
+        for (const auto& item : std::filesystem::directory_iterator(dir + "vault")) {
+            files.push_back(dir + "vault/" + item.path().filename().string());
+        }
+        std::vector<std::string> previous;
+        for (const auto& path : files) {
+            previous.push_back(readFile(path));
+        }
+        ASSERT_TRUE(writer.addEntry("after.com", "bob", "second"));
+
+        // Opened before the crash, so only its loads can roll the commit forward
+        passman::PasswordManager reader(dir);
+
+        // Crash after the journal: the new files are staged, the old ones still published
+        std::ofstream journal(dir + "commit.journal");
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::filesystem::rename(files[i], files[i] + ".tmp");
+            std::ofstream(files[i], std::ios::binary) << previous[i];
+            journal << "publish " << files[i] << "\n";
+        }
+        journal.close();
+
+        ASSERT_TRUE(reader.authenticate(kMasterPassword));
+        ASSERT_FALSE(reader.getEntry("after.com").service.empty());
+        ASSERT_FALSE(reader.getEntry("before.com").service.empty());
+        ASSERT_FALSE(std::filesystem::exists(dir + "commit.journal"));
+        for (const auto& path : files) {
+            ASSERT_FALSE(std::filesystem::exists(path + ".tmp"));
+        }
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testSharedVaultAcrossInstances() {
+        const std::string dir = freshVault("passman_shared_test/");
+        passman::PasswordManager first(dir);
+        passman::PasswordManager second(dir);
+        ASSERT_TRUE(first.authenticate(kMasterPassword));
+        ASSERT_TRUE(second.authenticate(kMasterPassword));
+
+        std::vector<passman::PasswordRecord> records;
+        for (int i = 0; i < 64; ++i) {
+            records.push_back({"site" + std::to_string(i) + ".com", "user", "pw" + std::to_string(i), ""});
+        }
+        ASSERT_TRUE(first.addEntries(records));
+        ASSERT_TRUE(second.refresh());
+        ASSERT_EQUAL(second.size(), 64u);
+
+        // A change rewrites only the shard holding the entry
+        std::vector<std::string> before = shardContents(dir);
+        ASSERT_TRUE(second.updateEntry("site7.com", "admin", "changed"));
+        std::vector<std::string> after = shardContents(dir);
+        ASSERT_EQUAL(before.size(), after.size());
+        size_t rewritten = 0;
+        for (size_t i = 0; i < before.size(); ++i) {
+            rewritten += before[i] != after[i] ? 1 : 0;
+        }
+        ASSERT_EQUAL(rewritten, 1u);
+
+        // A batch holds the exclusive lock, so a commit from another instance waits for it
+        first.beginBatch();
+        ASSERT_TRUE(first.addEntry("batched.com", "carol", "pw"));
+        std::atomic<bool> committed{false};
+        std::thread other([&]() {
+            second.addEntry("waiting.com", "dave", "pw");
+            committed = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        bool waited = !committed;
+        bool batchSaved = first.commitBatch();
+        other.join();
+        ASSERT_TRUE(waited);
+        ASSERT_TRUE(batchSaved);
+
+        // Each commit started from the latest vault, so no change was lost
+        passman::PasswordManager third(dir);
+        ASSERT_TRUE(third.authenticate(kMasterPassword));
+        ASSERT_EQUAL(third.size(), 66u);
+        ASSERT_TRUE(third.getPassword("site7.com").view() == "changed");
+        ASSERT_TRUE(first.refresh());
+        ASSERT_FALSE(first.getEntry("waiting.com").service.empty());
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testHistoryRestore() {
+        const std::string dir = freshVault("passman_history_test/");
+        passman::PasswordManager manager(dir);
+        ASSERT_TRUE(manager.authenticate(kMasterPassword));
+        ASSERT_TRUE(manager.addEntry("github.com", "alice", "first"));
+        ASSERT_TRUE(manager.updateEntry("github.com", "alice", "second"));
+        ASSERT_TRUE(manager.removeEntry("github.com"));
+
+        std::vector<passman::HistoryVersion> versions;
+        ASSERT_TRUE(manager.getHistory("github.com", versions));
+        ASSERT_EQUAL(versions.size(), 3u);
+        ASSERT_TRUE(versions[0].removed);
+        ASSERT_TRUE(versions[0].generation > versions[1].generation);
+        ASSERT_TRUE(versions[1].generation > versions[2].generation);
+        uint64_t original = versions[2].generation;
+
+        // Another instance reads the same history, and its restore is recorded as a new version
+        passman::PasswordManager other(dir);
+        ASSERT_TRUE(other.authenticate(kMasterPassword));
+        ASSERT_FALSE(other.restoreVersion("github.com", versions[0].generation + 100));
+        ASSERT_TRUE(other.restoreVersion("github.com", original));
+        ASSERT_TRUE(other.getPassword("github.com").view() == "first");
+
+        ASSERT_TRUE(manager.refresh());
+        ASSERT_TRUE(manager.getPassword("github.com").view() == "first");
+        ASSERT_TRUE(manager.getHistory("github.com", versions));
+        ASSERT_EQUAL(versions.size(), 4u);
+        ASSERT_FALSE(versions[0].removed);
+
+        // Restoring the removal removes the entry again
+        uint64_t removal = versions[1].generation;
+        ASSERT_TRUE(manager.restoreVersion("github.com", removal));
+        ASSERT_TRUE(manager.getEntry("github.com").service.empty());
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testAttachments() {
+        const std::string dir = freshVault("passman_attach_test/");
+        passman::PasswordManager manager(dir);
+        ASSERT_TRUE(manager.authenticate(kMasterPassword));
+        ASSERT_TRUE(manager.addEntry("github.com", "alice", "pw"));
+
+        const std::string data = sampleData(300 * 1024);
+        passman::ChunkWriteStats stats;
+        std::istringstream input(data);
+        ASSERT_TRUE(manager.attach("github.com", "keys.bin", input, &stats));
+        ASSERT_TRUE(stats.newChunks > 0);
+        ASSERT_EQUAL(stats.chunks, stats.newChunks);
+
+        // Chunks are content-addressed, so the same bytes again store nothing new
+        std::istringstream again(data);
+        ASSERT_TRUE(manager.attach("github.com", "copy.bin", again, &stats));
+        ASSERT_EQUAL(stats.newChunks, 0u);
+
+        std::istringstream rejected(data);
+        ASSERT_FALSE(manager.attach("missing.com", "keys.bin", rejected));
+        ASSERT_FALSE(manager.attach("github.com", "bad/name", rejected));
+
+        std::vector<passman::AttachmentRef> refs;
+        ASSERT_TRUE(manager.listAttachments("github.com", refs));
+        ASSERT_EQUAL(refs.size(), 2u);
+        ASSERT_EQUAL(refs[0].size, static_cast<uint64_t>(data.size()));
+
+        // Another instance reads them back intact
+        passman::PasswordManager other(dir);
+        ASSERT_TRUE(other.authenticate(kMasterPassword));
+        std::ostringstream extracted;
+        ASSERT_TRUE(other.extract("github.com", "keys.bin", extracted));
+        ASSERT_TRUE(extracted.str() == data);
+
+        ASSERT_TRUE(other.detach("github.com", "copy.bin"));
+        ASSERT_TRUE(manager.refresh());
+        std::ostringstream detached;
+        ASSERT_FALSE(manager.extract("github.com", "copy.bin", detached));
+        std::ostringstream kept;
+        ASSERT_TRUE(manager.extract("github.com", "keys.bin", kept));
+        ASSERT_TRUE(kept.str() == data);
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testFirstAttachAcrossInstances() {
+        const std::string dir = freshVault("passman_attach_race_test/");
+        {
+            passman::PasswordManager setup(dir);
+            ASSERT_TRUE(setup.authenticate(kMasterPassword));
+            ASSERT_TRUE(setup.addEntry("github.com", "alice", "pw"));
+        }
+        std::filesystem::create_directories(dir + "chunks");
+        std::ofstream(dir + "chunks/key.tmp12345") << "crashed write";
+
+        // Each instance opens the store for the first time at once; only one content key may win
+        const size_t count = 4;
+        std::vector<std::unique_ptr<passman::PasswordManager>> managers;
+        for (size_t i = 0; i < count; ++i) {
+            managers.push_back(std::make_unique<passman::PasswordManager>(dir));
+            ASSERT_TRUE(managers.back()->authenticate(kMasterPassword));
+        }
+        std::vector<std::string> data;
+        for (size_t i = 0; i < count; ++i) {
+            data.push_back(sampleData(20 * 1024 + i));
+        }
+        std::atomic<size_t> attached{0};
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([&, i]() {
+                std::istringstream input(data[i]);
+                if (managers[i]->attach("github.com", "file" + std::to_string(i), input)) {
+                    ++attached;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQUAL(attached.load(), count);
+        ASSERT_FALSE(std::filesystem::exists(dir + "chunks/key.tmp12345"));
+
+        passman::PasswordManager reader(dir);
+        ASSERT_TRUE(reader.authenticate(kMasterPassword));
+        for (size_t i = 0; i < count; ++i) {
+            std::ostringstream extracted;
+            ASSERT_TRUE(reader.extract("github.com", "file" + std::to_string(i), extracted));
+            ASSERT_TRUE(extracted.str() == data[i]);
+        }
+        std::filesystem::remove_all(dir);
+
+        // An instance whose vault key went stale must not create a key under it
+        const std::string staleDir = freshVault("passman_attach_stale_test/");
+        passman::PasswordManager stale(staleDir);
+        passman::PasswordManager rekeyer(staleDir);
+        ASSERT_TRUE(stale.authenticate(kMasterPassword));
+        ASSERT_TRUE(rekeyer.authenticate(kMasterPassword));
+        ASSERT_TRUE(rekeyer.addEntry("github.com", "alice", "pw"));
+        ASSERT_TRUE(stale.refresh());
+        ASSERT_TRUE(rekeyer.changeMasterPassword(kMasterPassword, "N3w-master-passw0rd"));
+        std::istringstream input(data[0]);
+        ASSERT_FALSE(stale.attach("github.com", "late.bin", input));
+        ASSERT_FALSE(std::filesystem::exists(staleDir + "chunks/key"));
+
+        std::filesystem::remove_all(staleDir);
+        return true;
+    }
+
+    static bool testRekey() {
+        const std::string dir = freshVault("passman_rekey_test/");
+        const char* newPassword = "N3w-master-passw0rd";
+        passman::PasswordManager manager(dir);
+        ASSERT_TRUE(manager.authenticate(kMasterPassword));
+
+        std::vector<passman::PasswordRecord> entries;
+        for (int i = 0; i < 40; ++i) {
+            entries.push_back({"site" + std::to_string(i) + ".com", "user", "pw" + std::to_string(i), ""});
+        }
+        ASSERT_TRUE(manager.addEntries(entries));
+        ASSERT_TRUE(manager.updateEntry("site0.com", "user", "pw0-new"));
+        const std::string data = sampleData(64 * 1024);
+        std::istringstream input(data);
+        ASSERT_TRUE(manager.attach("site1.com", "note.txt", input));
+        std::vector<std::string> before = records(manager);
+
+        passman::PasswordManager other(dir);
+        ASSERT_TRUE(other.authenticate(kMasterPassword));
+
+        ASSERT_FALSE(manager.changeMasterPassword("not-the-password", newPassword));
+
+        // An attachment key that cannot be staged aborts the change before anything is published
+        std::filesystem::create_directory(dir + "chunks/key.tmp");
+        ASSERT_FALSE(manager.changeMasterPassword(kMasterPassword, newPassword));
+        std::filesystem::remove_all(dir + "chunks/key.tmp");
+        {
+            passman::PasswordManager unchanged(dir);
+            ASSERT_TRUE(unchanged.authenticate(kMasterPassword));
+            std::ostringstream extracted;
+            ASSERT_TRUE(unchanged.extract("site1.com", "note.txt", extracted));
+        }
+
+        // So does a history bucket that cannot be staged
+        std::vector<std::string> buckets;
+        for (const auto& item : std::filesystem::directory_iterator(dir + "history")) {
+            buckets.push_back(item.path().string());
+        }
+        std::filesystem::create_directory(buckets.front() + ".tmp");
+        ASSERT_FALSE(manager.changeMasterPassword(kMasterPassword, newPassword));
+        std::filesystem::remove_all(buckets.front() + ".tmp");
+        for (const auto& bucket : buckets) {
+            ASSERT_FALSE(std::filesystem::exists(bucket + ".tmp"));
+        }
+        ASSERT_FALSE(std::filesystem::exists(dir + "chunks/key.tmp"));
+
+        ASSERT_TRUE(manager.changeMasterPassword(kMasterPassword, newPassword));
+        ASSERT_FALSE(std::filesystem::exists(dir + "chunks/key.tmp"));
+        ASSERT_TRUE(records(manager) == before);
+
+        // The other instance's cached key no longer opens the vault
+        other.refresh();
+        ASSERT_FALSE(other.isUnlocked());
+        ASSERT_FALSE(other.authenticate(kMasterPassword));
+        ASSERT_TRUE(other.authenticate(newPassword));
+        ASSERT_TRUE(records(other) == before);
+
+        // Attachments and the history were re-keyed along with the entries
+        std::ostringstream extracted;
+        ASSERT_TRUE(other.extract("site1.com", "note.txt", extracted));
+        ASSERT_TRUE(extracted.str() == data);
+        std::vector<passman::HistoryVersion> versions;
+        ASSERT_TRUE(other.getHistory("site0.com", versions));
+        ASSERT_TRUE(versions.size() >= 2);
+        ASSERT_TRUE(other.restoreVersion("site0.com", versions.back().generation));
+        ASSERT_TRUE(other.getPassword("site0.com").view() == "pw0");
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testAudit() {
+        const std::string dir = freshVault("passman_audit_test/");
+        passman::PasswordManager manager(dir);
+        ASSERT_TRUE(manager.authenticate(kMasterPassword));
+        ASSERT_TRUE(manager.addEntries({{"a.com", "alice", "password1", ""},
+                                        {"b.com", "bob", "password1", ""},
+                                        {"c.com", "carol", "x8#Qv!29pLm$Tz7&Rw", ""}}));
+
+        passman::PasswordAuditor auditor(manager);
+        passman::AuditReport report;
+        std::vector<std::string> weak;
+        ASSERT_TRUE(auditor.run([&](const passman::AuditFinding& finding) { weak.push_back(finding.service); },
+                                report));
+        std::sort(weak.begin(), weak.end());
+        ASSERT_EQUAL(report.entries, 3u);
+        ASSERT_EQUAL(report.weak, 2u);
+        ASSERT_TRUE(weak == std::vector<std::string>({"a.com", "b.com"}));
+        ASSERT_EQUAL(report.reused.size(), 1u);
+        std::sort(report.reused[0].begin(), report.reused[0].end());
+        ASSERT_TRUE(report.reused[0] == std::vector<std::string>({"a.com", "b.com"}));
+
+        manager.lock();
+        ASSERT_FALSE(auditor.run(nullptr, report));
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testWeakenedKdfRejected() {
+        const std::string dir = freshVault("passman_kdf_test/");
+        {
+            passman::PasswordManager manager(dir);
+            ASSERT_TRUE(manager.authenticate(kMasterPassword));
+            ASSERT_TRUE(manager.addEntry("github.com", "alice", "pw"));
+        }
+
+        // Lowering the recorded iteration count must not unlock, nor pass for a fresh install
+        std::string master = readFile(dir + "master.txt");
+        size_t colon = master.rfind(':');
+        ASSERT_TRUE(colon != std::string::npos);
+        std::ofstream(dir + "master.txt", std::ios::trunc) << master.substr(0, colon + 1) << "1";
+
+        passman::PasswordManager tampered(dir);
+        ASSERT_TRUE(tampered.hasMasterPassword());
+        ASSERT_FALSE(tampered.authenticate(kMasterPassword));
+        ASSERT_FALSE(tampered.initialize(kMasterPassword));
+        ASSERT_FALSE(shardContents(dir).empty());
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+    static bool testSubcommandOutput() {
+        const std::string dir = freshVault("passman_output_test/");
+        ScriptedPassword scripted(kMasterPassword);
+        PasswordManagerOperations operations(dir);
+
+        std::ostringstream added;
+        ASSERT_TRUE(operations.passman({"add", "github.com", "alice", "Tr0ub4dor&3"}, added));
+        ASSERT_TRUE(operations.passman({"add", "gitlab.com", "bob", "C0rrect-horse"}, added));
+        std::ostringstream listed;
+        ASSERT_TRUE(operations.passman({"ls"}, listed));
+        ASSERT_EQUAL(std::string("github.com\ngitlab.com\n"), listed.str());
+        std::ostringstream username;
+        ASSERT_TRUE(operations.passman({"get", "gitlab.com", "username"}, username));
+        ASSERT_EQUAL(std::string("bob\n"), username.str());
+        std::ostringstream generated;
+        ASSERT_TRUE(operations.passman({"gen", "20", "--count", "3"}, generated));
+        ASSERT_EQUAL(static_cast<size_t>(3 * 21), generated.str().size());
+
+        // Wired the way the shell wires it, passman feeds the next pipeline stage
+        CommandParser parser;
+        FileOperations files;
+        parser.registerCommand("passman", [&operations](const std::vector<std::string>& args) {
+            return operations.passman(args, CommandIO::out());
+        });
+        parser.registerCommand("grep", [&files](const std::vector<std::string>& args) { return files.grep(args); });
+        parser.registerCommand("head", [&files](const std::vector<std::string>& args) { return files.head(args); });
+
+        std::ostringstream filtered;
+        ASSERT_TRUE(Pipeline::run(parser, {{"passman", {"ls"}}, {"grep", {"lab"}}}, filtered));
+        ASSERT_EQUAL(std::string("gitlab.com\n"), filtered.str());
+        std::ostringstream firstTwo;
+        ASSERT_TRUE(Pipeline::run(parser, {{"passman", {"gen", "12", "--count", "100000"}}, {"head", {"2"}}}, firstTwo));
+        ASSERT_EQUAL(static_cast<size_t>(2 * 13), firstTwo.str().size());
+
+        std::filesystem::remove_all(dir);
+        return true;
+    }
+
+private:
+    static constexpr const char* kMasterPassword = "Master-passw0rd!";
+
+    /**
+     * @brief Supplies the master password to PasswordManagerOperations while in scope
+     */
+    class ScriptedPassword {
+    public:
+        explicit ScriptedPassword(const char* password) { set(password); }
+        ~ScriptedPassword() { set(""); }
+
+    private:
+        static void set(const char* password) {
+#ifdef _WIN32
+            _putenv_s("SECURESHELL_PASSMAN_PASSWORD", password);
+#else
+            setenv("SECURESHELL_PASSMAN_PASSWORD", password, 1);
+#endif
+        }
+    };
+
+    /**
+     * @brief Returns every decrypted entry as one sorted string each, for comparing vaults
+     */
+    static std::vector<std::string> records(const passman::PasswordManager& manager) {
+        std::vector<std::string> flattened;
+        manager.forEachDecrypted([&](const std::vector<passman::PasswordRecord>& batch) {
+            for (const auto& record : batch) {
+                flattened.push_back(record.service + '\x1f' + record.username + '\x1f' + record.password + '\x1f' +
+                                    record.serviceLink);
+            }
+        });
+        std::sort(flattened.begin(), flattened.end());
+        return flattened;
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * @brief Returns the bytes of every shard file, in shard order
+     */
+    static std::vector<std::string> shardContents(const std::string& dir) {
+        std::vector<std::string> paths;
+        for (const auto& item : std::filesystem::directory_iterator(dir + "vault")) {
+            if (item.path().extension() == ".dat") {
+                paths.push_back(item.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        std::vector<std::string> contents;
+        for (const auto& path : paths) {
+            contents.push_back(readFile(path));
+        }
+        return contents;
+    }
+
+    /**
+     * @brief Returns size bytes that do not compress, the same on every call
+     */
+    static std::string sampleData(size_t size) {
+        std::string data(size, '\0');
+        uint32_t state = 12345;
+        for (auto& byte : data) {
+            state = state * 1103515245u + 12345u;
+            byte = static_cast<char>(state >> 24);
+        }
+        return data;
+    }
+
+    /**
+     * @brief Creates an empty vault under dir with the cheapest allowed KDF
+     */
+    static std::string freshVault(const std::string& dir) {
+        std::filesystem::remove_all(dir);
+        passman::PasswordManager manager(dir);
+        manager.setUnlockTarget(std::chrono::milliseconds(1));
+        manager.initialize(kMasterPassword);
+        return dir;
+    }
+};
@@ -1,5 +1,11 @@
 #include "terminal/CommandParser.h"
+#include "terminal/CommandIO.h"
+#include "terminal/FileOperations.h"
+#include "terminal/Pipeline.h"
 #include "../TestFramework.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <functional>
@@ -12,6 +18,7 @@ public:
 
         parser.registerCommand("test", [&commandExecuted](const std::vector<std::string>& args) {
             commandExecuted = true;
+            return true;
         });
 
         ASSERT_TRUE(parser.isValidCommand("test"));
@@ -32,6 +39,7 @@ public:
             if (!args.empty()) {
                 capturedArg = args[0];
             }
+            return true;
         });
 
         std::vector<std::string> args = {"hello"};
@@ -48,7 +56,7 @@ public:
     static bool testExecuteCommandWithException() {
         CommandParser parser;
 
-        parser.registerCommand("fail", [](const std::vector<std::string>& args) {
+        parser.registerCommand("fail", [](const std::vector<std::string>&) -> bool {
             throw std::runtime_error("Test exception");
         });
 
@@ -70,7 +78,7 @@ public:
 
         ASSERT_TRUE(!parser.isValidCommand("nonexistent"));
 
-        parser.registerCommand("newcommand", [](const std::vector<std::string>&) {});
+        parser.registerCommand("newcommand", [](const std::vector<std::string>&) { return true; });
         ASSERT_TRUE(parser.isValidCommand("newcommand"));
 
         return true;
@@ -100,7 +108,7 @@ public:
         ASSERT_TRUE(hasHelp);
         ASSERT_TRUE(hasExit);
 
-        parser.registerCommand("newcmd", [](const std::vector<std::string>&) {});
+        parser.registerCommand("newcmd", [](const std::vector<std::string>&) { return true; });
         commandList = parser.getCommandList();
 
         bool hasNewCmd = false;
@@ -152,4 +160,116 @@ public:
 
         return true;
     }
+
+    static bool testCommandTrieCursor() {
+        CommandParser parser;
+        parser.registerCommand("decode", [](const std::vector<std::string>&) { return true; });
+
+        const CommandTrie& trie = parser.getCommandTrie();
+        ASSERT_TRUE(trie.contains("decrypt"));
+        ASSERT_TRUE(trie.contains("decode"));
+        ASSERT_TRUE(trie.hasPrefix("dec"));
+        ASSERT_FALSE(trie.contains("dec"));
+        ASSERT_FALSE(trie.hasPrefix("dx"));
+
+        CommandTrie::Cursor cursor = trie.cursor();
+        for (char c : std::string("lsx")) {
+            cursor.push(c);
+        }
+        ASSERT_FALSE(cursor.isPrefix());
+        cursor.pop();
+        ASSERT_TRUE(cursor.isCommand());
+        cursor.pop();
+        ASSERT_TRUE(cursor.isPrefix());
+        ASSERT_FALSE(cursor.isCommand());
+
+        return true;
+    }
+
+    static bool testPipelineStreamsAndStopsEarly() {
+        CommandParser parser;
+        FileOperations files;
+        parser.registerCommand("cat", [&files](const std::vector<std::string>& args) { return files.cat(args); });
+        parser.registerCommand("grep", [&files](const std::vector<std::string>& args) { return files.grep(args); });
+        parser.registerCommand("head", [&files](const std::vector<std::string>& args) { return files.head(args); });
+
+        // Would never finish if head returning did not stop it
+        parser.registerCommand("yes", [](const std::vector<std::string>&) {
+            std::ostream& out = CommandIO::out();
+            while (out) {
+                out << "y\n";
+            }
+            return true;
+        });
+
+        auto split = parser.splitPipeline("grep \"a|b\" log.txt | head 2");
+        ASSERT_EQUAL(static_cast<size_t>(2), split.size());
+
+        const std::string testFile = "pipeline_test.log";
+        {
+            std::ofstream log(testFile);
+            for (int i = 0; i < 50000; ++i) {
+                log << "line " << i << (i % 2 ? " ERROR" : " ok") << "\n";
+            }
+        }
+
+        std::ostringstream output;
+        bool ran = Pipeline::run(parser, {{"cat", {testFile}}, {"grep", {"ERROR"}}, {"head", {"3"}}}, output);
+        ASSERT_TRUE(ran);
+        ASSERT_EQUAL("line 1 ERROR\nline 3 ERROR\nline 5 ERROR\n", output.str());
+
+        std::ostringstream endless;
+        ASSERT_TRUE(Pipeline::run(parser, {{"yes", {}}, {"head", {"2"}}}, endless));
+        ASSERT_EQUAL("y\ny\n", endless.str());
+
+        // An upstream stage with no output must not leave the final stream failed
+        parser.registerCommand("write", [&files](const std::vector<std::string>& args) { return files.write(args); });
+        parser.registerCommand("nothing", [](const std::vector<std::string>&) { return true; });
+        std::ostringstream empty;
+        ASSERT_TRUE(Pipeline::run(parser, {{"nothing", {}}, {"cat", {}}}, empty));
+        ASSERT_TRUE(empty.good());
+        ASSERT_TRUE(Pipeline::run(parser, {{"nothing", {}}, {"cat", {}}, {"cat", {}}}, empty));
+        empty << "still writable";
+        ASSERT_EQUAL("still writable", empty.str());
+
+        std::ostringstream written;
+        ASSERT_TRUE(Pipeline::run(parser, {{"nothing", {}}, {"write", {testFile}}}, written));
+        ASSERT_TRUE(std::filesystem::exists(testFile));
+        ASSERT_EQUAL(static_cast<std::uintmax_t>(0), std::filesystem::file_size(testFile));
+
+        std::filesystem::remove(testFile);
+        return true;
+    }
+
+    static bool testTokenizerQuotesAndEscapes() {
+        CommandParser parser;
+        CommandLine line;
+
+        parser.tokenize("  cat\tnotes.txt  ", line);
+        ASSERT_EQUAL(static_cast<size_t>(2), line.size());
+        ASSERT_TRUE(line[0] == "cat" && line[1] == "notes.txt");
+
+        // Double quotes allow \" inside, single quotes take everything literally
+        parser.tokenize(R"(grep "say \"hi\"" 'a "b" \n' my\ file.txt "")", line);
+        ASSERT_EQUAL(static_cast<size_t>(5), line.size());
+        ASSERT_TRUE(line[1] == "say \"hi\"");
+        ASSERT_TRUE(line[2] == "a \"b\" \\n");
+        ASSERT_TRUE(line[3] == "my file.txt");
+        ASSERT_TRUE(line[4].empty());
+
+        // Backslashes before ordinary characters stay, as in Windows paths
+        auto tokens = parser.parseInput(R"(cd C:\Users\me a\\b)");
+        ASSERT_EQUAL(static_cast<size_t>(3), tokens.size());
+        ASSERT_EQUAL(std::string(R"(C:\Users\me)"), tokens[1]);
+        ASSERT_EQUAL(std::string(R"(a\b)"), tokens[2]);
+
+        // Quoted or escaped '|' and '&' do not split or background the line
+        ASSERT_EQUAL(static_cast<size_t>(1), parser.splitPipeline(R"(grep 'a|b' x \| y)").size());
+        std::string background = "find 'R&D' \\&";
+        ASSERT_FALSE(parser.stripBackground(background));
+        background = "find 'R&D' &";
+        ASSERT_TRUE(parser.stripBackground(background));
+        return true;
+    }
 };
+
@@ -1,12 +1,33 @@
 #include "terminal/Terminal.h"
+#include "terminal/Completer.h"
+#include "terminal/CommandIO.h"
+#include "terminal/CommandHistory.h"
+#include "terminal/TerminalBackend.h"
+#include "utils/Cancellation.h"
+#include <atomic>
 #include "../TestFramework.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <thread>
 #include <chrono>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 class TerminalTest {
 public:
     static bool testTerminalRunningState() {
+#ifdef _WIN32
         Terminal terminal;
+#else
+        // Keys come from a pipe nobody writes to, as closed input would end the loop
+        int keys[2];
+        ASSERT_TRUE(pipe(keys) == 0);
+        PosixTerminalBackend console(keys[0], STDOUT_FILENO);
+        Terminal terminal(console);
+#endif
 
         ASSERT_TRUE(!terminal.isRunning());
 
@@ -26,6 +47,298 @@ public:
 
         ASSERT_TRUE(!terminal.isRunning());
 
+#ifndef _WIN32
+        close(keys[0]);
+        close(keys[1]);
+#endif
+        return true;
+    }
+
+    static bool testTabCompletion() {
+        CommandParser parser;
+        std::unordered_map<std::string, std::string> aliases = {{"encode", "encrypt"}};
+        Completer completer(parser, aliases);
+
+        ASSERT_EQUAL("passman ", completer.complete("pas").line);
+        Completion ambiguous = completer.complete("enc");
+        ASSERT_EQUAL("enc", ambiguous.line);
+        ASSERT_EQUAL(static_cast<size_t>(2), ambiguous.candidates.size());
+
+        const std::string testDir = "completion_dir";
+        std::filesystem::remove_all(testDir);
+        std::filesystem::create_directories(testDir + "/sub folder");
+        std::ofstream(testDir + "/notes.txt") << "x";
+        std::ofstream(testDir + "/notebook.md") << "x";
+
+        ASSERT_EQUAL("cat completion_dir/", completer.complete("cat completion_d").line);
+        ASSERT_EQUAL("cat completion_dir/note", completer.complete("cat completion_dir/n").line);
+        ASSERT_EQUAL("cat completion_dir/notes.txt ", completer.complete("cat completion_dir/notes").line);
+        ASSERT_EQUAL("cd \"completion_dir/sub folder/", completer.complete("cd completion_dir/su").line);
+
+        std::filesystem::remove_all(testDir);
+        ASSERT_TRUE(completer.complete("cat completion_dir/n").candidates.empty());
+
+        return true;
+    }
+
+    static bool testScriptMode() {
+        const std::string testDir = "script_dir";
+        std::filesystem::remove_all(testDir);
+
+        Terminal terminal;
+        std::istringstream script("# comment\n\n  dcreate script_dir\r\nnosuchcommand\nfcreate script_dir/a.txt\n");
+        ASSERT_FALSE(terminal.runScript(script, "script"));
+        ASSERT_TRUE(std::filesystem::exists(testDir + "/a.txt"));
+
+        // Stops at the unknown command, so b.txt is never created
+        std::ofstream(testDir + "/nested.ssh") << "nosuchcommand\nfcreate script_dir/b.txt\n";
+        Terminal strict;
+        strict.setExitOnError(true);
+        std::istringstream outer("source script_dir/nested.ssh\nfcreate script_dir/c.txt\n");
+        ASSERT_FALSE(strict.runScript(outer, "outer"));
+        ASSERT_FALSE(std::filesystem::exists(testDir + "/b.txt"));
+        ASSERT_FALSE(std::filesystem::exists(testDir + "/c.txt"));
+
+        ASSERT_TRUE(strict.runLine("fcreate script_dir/d.txt"));
+        ASSERT_TRUE(std::filesystem::exists(testDir + "/d.txt"));
+
+        std::filesystem::remove_all(testDir);
+        return true;
+    }
+
+    static bool testFailingCommandStatus() {
+        const std::string testDir = "status_dir";
+        std::filesystem::remove_all(testDir);
+        std::filesystem::create_directories(testDir);
+
+        // What "SecureShell -c" turns into its exit status
+        Terminal terminal;
+        ASSERT_FALSE(terminal.runLine("cat status_dir/nonexistent.txt"));
+        ASSERT_FALSE(terminal.runLine("cd status_dir/missing"));
+        ASSERT_FALSE(terminal.runLine("copy status_dir/nonexistent.txt status_dir/copy.txt"));
+        ASSERT_FALSE(terminal.runLine("cat status_dir/nonexistent.txt | head 1"));
+        ASSERT_TRUE(terminal.runLine("fcreate status_dir/a.txt"));
+        ASSERT_TRUE(terminal.runLine("cat status_dir/a.txt"));
+
+        // With -e a failing built-in stops the script, as an unknown command does
+        Terminal strict;
+        strict.setExitOnError(true);
+        std::istringstream script("cat status_dir/nonexistent.txt\nfcreate status_dir/b.txt\n");
+        ASSERT_FALSE(strict.runScript(script, "script"));
+        ASSERT_FALSE(std::filesystem::exists(testDir + "/b.txt"));
+
+        std::filesystem::remove_all(testDir);
         return true;
     }
+
+    static bool testBackgroundJobs() {
+        // More nested parallelFor calls than workers; waiting callers run batches themselves
+        Utils::ThreadPool pool(2);
+        std::atomic<long> total{0};
+        std::vector<std::future<void>> nested;
+        for (int i = 0; i < 6; ++i) {
+            nested.push_back(pool.submit([&pool, &total]() {
+                pool.parallelFor(1000, 10, [&total](size_t begin, size_t end) {
+                    total += static_cast<long>(end - begin);
+                });
+            }));
+        }
+        for (auto& task : nested) {
+            task.get();
+        }
+        ASSERT_EQUAL(total.load(), 6000L);
+
+        JobControl control([](const std::string& line) {
+            if (line == "spin") {
+                while (!Utils::Cancellation::requested()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                return false;
+            }
+            CommandIO::out() << "ran " << line << "\n";
+            return true;
+        }, 2);
+
+        std::vector<int> ids;
+        for (int i = 0; i < 6; ++i) {
+            ids.push_back(control.start("batch" + std::to_string(i)));
+        }
+        for (int id : ids) {
+            std::ostringstream out;
+            ASSERT_TRUE(control.wait(id, out));
+            ASSERT_TRUE(out.str().find("ran batch") == 0);
+            ASSERT_TRUE(out.str().find("Done") != std::string::npos);
+        }
+
+        int spinner = control.start("spin");
+        ASSERT_TRUE(control.cancel(spinner));
+        std::ostringstream out;
+        ASSERT_TRUE(control.wait(spinner, out));
+        ASSERT_TRUE(out.str().find("Cancelled  spin") != std::string::npos);
+        ASSERT_FALSE(control.wait(spinner, out)); // Forgotten once waited for
+        ASSERT_TRUE(control.list().empty());
+
+        // A trailing '&' is checked up front and runs the line as a job
+        Terminal terminal;
+        ASSERT_FALSE(terminal.runLine("nosuchcommand &"));
+        ASSERT_TRUE(terminal.runLine("dcreate jobs_dir &"));
+        int id = terminal.getJobControl().latest();
+        std::ostringstream status;
+        ASSERT_TRUE(terminal.getJobControl().wait(id, status));
+        ASSERT_TRUE(std::filesystem::exists("jobs_dir"));
+        std::filesystem::remove_all("jobs_dir");
+
+        // wait reports how the job ended; bad ids are user errors, not exceptions
+        ASSERT_TRUE(terminal.runLine("cat no_such_job_file.txt &"));
+        ASSERT_FALSE(terminal.runLine("wait " + std::to_string(terminal.getJobControl().latest())));
+        ASSERT_TRUE(terminal.runLine("dcreate jobs_dir &"));
+        ASSERT_TRUE(terminal.runLine("wait %" + std::to_string(terminal.getJobControl().latest())));
+        std::filesystem::remove_all("jobs_dir");
+        ASSERT_FALSE(terminal.runLine("wait 999"));
+        ASSERT_FALSE(terminal.runLine("kill x1"));
+        ASSERT_FALSE(terminal.runLine("fg"));
+        return true;
+    }
+
+    static bool testJobsBesideForeground() {
+        const std::string testDir = "jobs_beside_dir";
+        std::filesystem::remove_all(testDir);
+        std::filesystem::create_directories(testDir);
+        std::ofstream(testDir + "/notes.txt") << "alpha\nbeta\n";
+
+        Terminal terminal;
+        std::vector<int> ids;
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(terminal.runLine("cat " + testDir + "/notes.txt | grep beta &"));
+            ids.push_back(terminal.getJobControl().latest());
+            // Foreground work while the jobs are still running
+            ASSERT_TRUE(terminal.runLine("fcreate " + testDir + "/fg" + std::to_string(i) + ".txt"));
+            ASSERT_TRUE(terminal.runLine("ls " + testDir));
+        }
+        for (int id : ids) {
+            std::ostringstream out;
+            ASSERT_TRUE(terminal.getJobControl().wait(id, out));
+            ASSERT_TRUE(out.str().find("beta") != std::string::npos);
+            ASSERT_TRUE(out.str().find("Done") != std::string::npos);
+        }
+
+        // Commands that change shared state stay in the foreground, and never two at once
+        int before = terminal.getJobControl().latest();
+        ASSERT_FALSE(terminal.runLine("passman ls &"));
+        ASSERT_FALSE(terminal.runLine("cd " + testDir + " &"));
+        ASSERT_FALSE(terminal.runLine("source " + testDir + "/notes.txt &"));
+        ASSERT_FALSE(terminal.runLine("ls | cat " + testDir + "/notes.txt | grep a | source x &"));
+        ASSERT_EQUAL(before, terminal.getJobControl().latest());
+        ASSERT_FALSE(terminal.runLine("cd " + testDir + " | source x"));
+
+        std::filesystem::remove_all(testDir);
+        return true;
+    }
+
+    static bool testCommandHistory() {
+        const std::string path = "history_test/shell_history";
+        std::filesystem::remove_all("history_test");
+        std::filesystem::create_directories("history_test");
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << "cat notes.txt\r\n\ngrep TODO notes.txt\nls\ngrep TODO notes.txt\ncd src"; // No final newline
+        }
+
+        std::string_view line;
+        {
+            CommandHistory history;
+            ASSERT_TRUE(history.open(path));
+            ASSERT_TRUE(history.entry(0, line) && line == "cd src");
+            ASSERT_TRUE(history.entry(4, line) && line == "cat notes.txt");
+            ASSERT_FALSE(history.entry(5, line));
+
+            history.add("grep FIXME main.cpp");
+            history.add("grep FIXME main.cpp"); // Repeats are not kept
+            ASSERT_TRUE(history.entry(0, line) && line == "grep FIXME main.cpp");
+            ASSERT_TRUE(history.entry(1, line) && line == "cd src");
+
+            // Newest first; the second TODO line is found once, as it repeats the first
+            ASSERT_TRUE(history.search("grep", 0, line) && line == "grep FIXME main.cpp");
+            ASSERT_TRUE(history.search("grep", 1, line) && line == "grep TODO notes.txt");
+            ASSERT_TRUE(history.search("notes", 1, line) && line == "cat notes.txt");
+            ASSERT_FALSE(history.search("notes", 2, line));
+            ASSERT_FALSE(history.search("make", 0, line));
+        }
+
+        // The added line was appended after the unfinished last one
+        CommandHistory reopened;
+        ASSERT_TRUE(reopened.open(path));
+        ASSERT_TRUE(reopened.entry(0, line) && line == "grep FIXME main.cpp");
+        ASSERT_TRUE(reopened.entry(1, line) && line == "cd src");
+        ASSERT_TRUE(reopened.search("FIXME", 0, line) && line == "grep FIXME main.cpp");
+
+        std::filesystem::remove_all("history_test");
+        return true;
+    }
+
+    static bool testHistorySkipsSecrets() {
+        Terminal terminal;
+        ASSERT_TRUE(terminal.shouldRemember("cat notes.txt | grep TODO"));
+        ASSERT_FALSE(terminal.shouldRemember(" cat notes.txt"));
+        ASSERT_FALSE(terminal.shouldRemember("encrypt a.txt a.enc hunter2"));
+
+        // Every passman line is kept out, wherever it sits in a pipeline
+        ASSERT_FALSE(terminal.shouldRemember("passman add github.com alice Tr0ub4dor&3"));
+        ASSERT_FALSE(terminal.shouldRemember("passman note github.com \"recovery codes 1234\""));
+        ASSERT_FALSE(terminal.shouldRemember("passman ls | grep git"));
+        ASSERT_FALSE(terminal.shouldRemember("cat codes.txt | passman note github.com &"));
+
+        terminal.aliases["pm"] = "passman";
+        ASSERT_FALSE(terminal.shouldRemember("pm add github.com alice Tr0ub4dor&3"));
+        return true;
+    }
+
+#ifndef _WIN32
+    static bool testAnsiBackendBatchesOutput() {
+        int keys[2];
+        int screen[2];
+        ASSERT_TRUE(pipe(keys) == 0 && pipe(screen) == 0);
+        {
+            PosixTerminalBackend backend(keys[0], screen[1]);
+
+            // Escape sequences decode to the same keys as the Windows console's
+            const std::string typed = "ab\x1b[A\x1b[3~\x7f\n";
+            ASSERT_TRUE(write(keys[1], typed.data(), typed.size()) == static_cast<ssize_t>(typed.size()));
+            ASSERT_EQUAL('a', backend.readKey());
+            ASSERT_TRUE(backend.hasPendingInput()); // Read in one go
+            ASSERT_EQUAL('b', backend.readKey());
+            ASSERT_EQUAL(TerminalBackend::Up, backend.readKey());
+            ASSERT_EQUAL(TerminalBackend::Delete, backend.readKey());
+            ASSERT_EQUAL(TerminalBackend::Backspace, backend.readKey());
+            ASSERT_EQUAL(TerminalBackend::Enter, backend.readKey());
+            ASSERT_EQUAL(TerminalBackend::None, backend.readKey(10));
+
+            // A line of typing and its colors reach the screen in a single write
+            for (char c : std::string("encrypt")) {
+                backend.setColor(TerminalBackend::Color::Command);
+                backend.write(c);
+            }
+            backend.setColor(TerminalBackend::Color::Default);
+            ASSERT_EQUAL(0u, backend.writeCount());
+            backend.flush();
+            ASSERT_EQUAL(1u, backend.writeCount());
+            backend.flush(); // Nothing new to send
+            ASSERT_EQUAL(1u, backend.writeCount());
+
+            char drawn[256] = {};
+            ssize_t size = read(screen[0], drawn, sizeof(drawn));
+            ASSERT_TRUE(size > 0);
+            std::string frame(drawn, static_cast<size_t>(size));
+            ASSERT_TRUE(frame.find('e') < frame.find('t') && frame.substr(frame.size() - 4) == "\x1b[0m");
+
+            close(keys[1]);
+            ASSERT_EQUAL(TerminalBackend::EndOfInput, backend.readKey());
+        }
+        close(keys[0]);
+        close(screen[0]);
+        close(screen[1]);
+        return true;
+    }
+#endif
 };
+